@@ -0,0 +1,175 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "async-file-utils.h"
+#include "file-utils.h"
+
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QVariant>
+#include <QIcon>
+
+#include <functional>
+
+using namespace Peony;
+
+struct CachedResult {
+    QVariant value;
+    qint64 time;
+};
+
+static QMutex global_cache_mutex;
+static QCache<QString, CachedResult> *global_cache = nullptr;
+static QThreadPool *global_pool = nullptr;
+
+template <typename T>
+static QFuture<T> readyFuture(const T &value)
+{
+    QFutureInterface<T> interface;
+    interface.reportStarted();
+    interface.reportResult(value);
+    interface.reportFinished();
+    return interface.future();
+}
+
+/*!
+ * \brief cachedRun
+ * \param operation
+ * \param uri
+ * \param query, the blocking query which runs in the io pool.
+ * \return a finished future if the result of operation on uri is cached.
+ */
+template <typename T>
+static QFuture<T> cachedRun(const char *operation, const QString &uri, const std::function<T()> &query)
+{
+    QString key = QString(operation) + "\n" + uri;
+    {
+        QMutexLocker locker(&global_cache_mutex);
+        if (!global_cache) {
+            global_cache = new QCache<QString, CachedResult>(PEONY_ASYNC_FILE_UTILS_CACHE_SIZE);
+            global_pool = new QThreadPool;
+            global_pool->setMaxThreadCount(PEONY_ASYNC_FILE_UTILS_THREADS);
+        }
+        if (auto cached = global_cache->object(key)) {
+            if (QDateTime::currentMSecsSinceEpoch() - cached->time <= PEONY_ASYNC_FILE_UTILS_CACHE_TIMEOUT)
+                return readyFuture<T>(cached->value.value<T>());
+            global_cache->remove(key);
+        }
+    }
+
+    return QtConcurrent::run(global_pool, [=]() {
+        T result = query();
+        auto cached = new CachedResult;
+        cached->value = QVariant::fromValue(result);
+        cached->time = QDateTime::currentMSecsSinceEpoch();
+        QMutexLocker locker(&global_cache_mutex);
+        global_cache->insert(key, cached);
+        return result;
+    });
+}
+
+AsyncFileUtils::AsyncFileUtils()
+{
+
+}
+
+QFuture<QString> AsyncFileUtils::getFileDisplayName(const QString &uri)
+{
+    return cachedRun<QString>("display-name", uri, [=]() {
+        return FileUtils::getFileDisplayName(uri);
+    });
+}
+
+QFuture<QStringList> AsyncFileUtils::getFileIconNames(const QString &uri)
+{
+    return cachedRun<QStringList>("icon-names", uri, [=]() {
+        return FileUtils::getFileIconNames(uri);
+    });
+}
+
+QFuture<QString> AsyncFileUtils::getTargetUri(const QString &uri)
+{
+    return cachedRun<QString>("target-uri", uri, [=]() {
+        return FileUtils::getTargetUri(uri);
+    });
+}
+
+QFuture<bool> AsyncFileUtils::isFileDirectory(const QString &uri)
+{
+    return cachedRun<bool>("is-directory", uri, [=]() {
+        return FileUtils::isFileDirectory(uri);
+    });
+}
+
+QFuture<bool> AsyncFileUtils::isFileUnmountable(const QString &uri)
+{
+    return cachedRun<bool>("is-unmountable", uri, [=]() {
+        return FileUtils::isFileUnmountable(uri);
+    });
+}
+
+QFuture<bool> AsyncFileUtils::isMountRoot(const QString &uri)
+{
+    return cachedRun<bool>("is-mount-root", uri, [=]() {
+        return FileUtils::isMountRoot(uri);
+    });
+}
+
+QFuture<AsyncFileUtils::VolumeInfo> AsyncFileUtils::queryVolumeInfo(const QString &volumeUri, const QString &volumeDisplayName)
+{
+    return cachedRun<VolumeInfo>("volume-info", volumeUri, [=]() {
+        VolumeInfo info;
+        info.valid = FileUtils::queryVolumeInfo(volumeUri, info.volume_name, info.unix_device_name, volumeDisplayName);
+        return info;
+    });
+}
+
+QString AsyncFileUtils::validIconName(const QStringList &iconNames)
+{
+    for (auto iconName : iconNames) {
+        if (!QIcon::fromTheme(iconName).isNull())
+            return iconName;
+    }
+    return iconNames.isEmpty()? nullptr: iconNames.first();
+}
+
+void AsyncFileUtils::clearCache(const QString &uri)
+{
+    QMutexLocker locker(&global_cache_mutex);
+    if (!global_cache)
+        return;
+
+    if (uri.isNull()) {
+        global_cache->clear();
+        return;
+    }
+
+    for (auto key : global_cache->keys()) {
+        if (key.endsWith("\n" + uri))
+            global_cache->remove(key);
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef ASYNCFILEUTILS_H
+#define ASYNCFILEUTILS_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <QMetaType>
+
+/*!
+ * \brief PEONY_ASYNC_FILE_UTILS_THREADS
+ * <br>
+ * The max count of queries running at the same time in the io pool of AsyncFileUtils.
+ * </br>
+ */
+#ifndef PEONY_ASYNC_FILE_UTILS_THREADS
+#define PEONY_ASYNC_FILE_UTILS_THREADS 4
+#endif
+
+/*!
+ * \brief PEONY_ASYNC_FILE_UTILS_CACHE_SIZE
+ * <br>
+ * The max count of query results cached by AsyncFileUtils.
+ * </br>
+ */
+#ifndef PEONY_ASYNC_FILE_UTILS_CACHE_SIZE
+#define PEONY_ASYNC_FILE_UTILS_CACHE_SIZE 1024
+#endif
+
+/*!
+ * \brief PEONY_ASYNC_FILE_UTILS_CACHE_TIMEOUT
+ * <br>
+ * Cached results older than this milliseconds are queried again.
+ * </br>
+ */
+#ifndef PEONY_ASYNC_FILE_UTILS_CACHE_TIMEOUT
+#define PEONY_ASYNC_FILE_UTILS_CACHE_TIMEOUT 5000
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The AsyncFileUtils class
+ * <br>
+ * AsyncFileUtils is the asynchronous counterpart of the BLOCKING methods of FileUtils.
+ * The queries run in a small io thread pool and their results are cached for a while,
+ * so a slow or dead mount never blocks the ui thread.
+ * </br>
+ * <br>
+ * Use then() to handle a result in ui thread. If the result is cached, the callback
+ * is called immediately, otherwise it is called when the query finished, as long as
+ * the context object is alive.
+ * </br>
+ * \note Do not use the cached results for the states which are just changed, such
+ * as the target uri of a volume which is just mounted, call clearCache() first.
+ * \see FileUtils, GioWatchdog.
+ */
+class PEONYCORESHARED_EXPORT AsyncFileUtils
+{
+public:
+    struct VolumeInfo {
+        bool valid = false;
+        QString volume_name;
+        QString unix_device_name;
+    };
+
+    static QFuture<QString> getFileDisplayName(const QString &uri);
+    /*!
+     * \brief getFileIconNames
+     * \param uri
+     * \return the icon names of uri, use validIconName() to choose one in ui thread.
+     * \see FileUtils::getFileIconNames().
+     */
+    static QFuture<QStringList> getFileIconNames(const QString &uri);
+    static QFuture<QString> getTargetUri(const QString &uri);
+    static QFuture<bool> isFileDirectory(const QString &uri);
+    static QFuture<bool> isFileUnmountable(const QString &uri);
+    static QFuture<bool> isMountRoot(const QString &uri);
+    static QFuture<VolumeInfo> queryVolumeInfo(const QString &volumeUri, const QString &volumeDisplayName = nullptr);
+
+    /*!
+     * \brief validIconName
+     * \param iconNames
+     * \return the first icon name which exists in current icon theme.
+     * \note QIcon::fromTheme() is not thread safe, this method must be used in ui thread.
+     */
+    static QString validIconName(const QStringList &iconNames);
+
+    /*!
+     * \brief clearCache
+     * \param uri
+     * <br>
+     * Drop the cached results of uri, or all results if uri is null.
+     * </br>
+     */
+    static void clearCache(const QString &uri = nullptr);
+
+    template <typename T, typename Callback>
+    static void then(const QFuture<T> &future, QObject *context, Callback callback) {
+        if (future.isFinished()) {
+            callback(future.result());
+            return;
+        }
+        auto watcher = new QFutureWatcher<T>(context);
+        QObject::connect(watcher, &QFutureWatcherBase::finished, context, [=]() {
+            callback(watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(future);
+    }
+
+private:
+    AsyncFileUtils();
+};
+
+}
+
+Q_DECLARE_METATYPE(Peony::AsyncFileUtils::VolumeInfo)
+
+#endif // ASYNCFILEUTILS_H
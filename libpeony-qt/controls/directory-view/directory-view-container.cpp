@@ -30,7 +30,9 @@
 
 #include "directory-view-factory-manager.h"
 
+#include "file-item-model.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "search-vfs-manager.h"
 
 #include <QVBoxLayout>
 #include <QAction>
@@ -357,6 +359,17 @@ void DirectoryViewContainer::refresh()
 {
     if (!m_view)
         return;
+
+    //cached search results might be out of date, search again.
+    if (m_current_uri.startsWith("search://"))
+        SearchVFSManager::getInstance()->clearHistoryOne(m_current_uri);
+
+    //refresh current directory incrementally, the selections and the
+    //scroll position of view are kept.
+    if (m_model->getRootUri() == m_current_uri) {
+        m_model->refresh();
+        return;
+    }
     m_view->beginLocationChange();
 }
 
@@ -31,6 +31,7 @@
 #include "file-utils.h"
 
 #include "global-settings.h"
+#include "thumbnail-manager.h"
 
 #include <QMouseEvent>
 
@@ -91,6 +92,14 @@ IconView::IconView(QWidget *parent) : QListView(parent)
     m_renameTimer = new QTimer(this);
     m_renameTimer->setInterval(3000);
     m_editValid = false;
+
+    //one frame, compress the scrolling and inserting.
+    m_visible_thumbnails_timer.setSingleShot(true);
+    m_visible_thumbnails_timer.setInterval(16);
+    connect(&m_visible_thumbnails_timer, &QTimer::timeout, this, &IconView::updateVisibleThumbnails);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
 }
 
 IconView::~IconView()
@@ -320,6 +329,7 @@ void IconView::resizeEvent(QResizeEvent *e)
     //but I have to reset the index widget in view's resize.
     QListView::resizeEvent(e);
     setIndexWidget(m_last_index, nullptr);
+    m_visible_thumbnails_timer.start();
 }
 
 void IconView::wheelEvent(QWheelEvent *e)
@@ -371,6 +381,32 @@ void IconView::slotRename()
 
 }
 
+void IconView::updateVisibleThumbnails()
+{
+    if (!m_sort_filter_proxy_model)
+        return;
+
+    //items are laid on grid, sample twice per grid so that no item is missed.
+    QSize step = gridSize().isValid()? gridSize(): iconSize();
+    int stepX = qMax(1, step.width()/2);
+    int stepY = qMax(1, step.height()/2);
+
+    QSet<QString> visibleUris;
+    auto rect = viewport()->rect();
+    for (int y = 0; y < rect.height(); y += stepY) {
+        for (int x = 0; x < rect.width(); x += stepX) {
+            auto index = indexAt(QPoint(x, y));
+            if (index.isValid())
+                visibleUris<<index.data(FileItemModel::UriRole).toString();
+        }
+    }
+
+    auto scrolledAwayUris = m_visible_uris - visibleUris;
+    ThumbnailManager::getInstance()->cancelThumbnails(scrolledAwayUris.toList());
+    ThumbnailManager::getInstance()->prioritizeThumbnails(visibleUris.toList());
+    m_visible_uris = visibleUris;
+}
+
 bool IconView::getIgnore_mouse_move_event() const
 {
     return m_ignore_mouse_move_event;
@@ -388,6 +424,14 @@ void IconView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
 
     setModel(m_sort_filter_proxy_model);
 
+    m_visible_uris.clear();
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::rowsInserted, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
+    connect(m_sort_filter_proxy_model, &QAbstractItemModel::layoutChanged, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
+
     //edit trigger
     connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection) {
         qDebug()<<"selection changed";
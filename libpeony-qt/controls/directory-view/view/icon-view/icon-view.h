@@ -32,6 +32,7 @@
 
 #include <QListView>
 #include <QTimer>
+#include <QSet>
 
 namespace Peony {
 
@@ -157,9 +158,19 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+    /*!
+     * \brief updateVisibleThumbnails
+     * <br>
+     * Let ThumbnailManager generate the thumbnails of visible items first,
+     * and cancel the jobs of items scrolled away.
+     * </br>
+     */
+    void updateVisibleThumbnails();
 
 private:
     QTimer m_repaint_timer;
+    QTimer m_visible_thumbnails_timer;
+    QSet<QString> m_visible_uris;
 
     bool  m_editValid;
     bool  m_ctrl_key_pressed;
@@ -31,6 +31,7 @@
 #include "list-view-style.h"
 
 #include "global-settings.h"
+#include "thumbnail-manager.h"
 
 #include <QHeaderView>
 
@@ -84,6 +85,13 @@ ListView::ListView(QWidget *parent) : QTreeView(parent)
     m_renameTimer = new QTimer(this);
     m_renameTimer->setInterval(3000);
     m_editValid = false;
+
+    m_visible_thumbnails_timer.setSingleShot(true);
+    m_visible_thumbnails_timer.setInterval(16);
+    connect(&m_visible_thumbnails_timer, &QTimer::timeout, this, &ListView::updateVisibleThumbnails);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
 }
 
 void ListView::scrollTo(const QModelIndex &index, QAbstractItemView::ScrollHint hint)
@@ -111,6 +119,14 @@ void ListView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
     m_proxy_model = proxyModel;
     m_proxy_model->setSourceModel(m_model);
     setModel(proxyModel);
+
+    m_visible_uris.clear();
+    connect(m_proxy_model, &QAbstractItemModel::rowsInserted, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
+    connect(m_proxy_model, &QAbstractItemModel::layoutChanged, this, [=]() {
+        m_visible_thumbnails_timer.start();
+    });
     //adjust columns layout.
     adjustColumnsSize();
 
@@ -360,6 +376,28 @@ void ListView::resizeEvent(QResizeEvent *e)
         m_last_size = size();
         adjustColumnsSize();
     }
+    m_visible_thumbnails_timer.start();
+}
+
+void ListView::updateVisibleThumbnails()
+{
+    if (!m_proxy_model)
+        return;
+
+    //walk the visible rows from the first one, indexBelow() also steps into
+    //the children of expanded items.
+    QSet<QString> visibleUris;
+    int bottom = viewport()->height();
+    auto index = indexAt(QPoint(0, 0));
+    while (index.isValid() && visualRect(index).top() < bottom) {
+        visibleUris<<index.data(FileItemModel::UriRole).toString();
+        index = indexBelow(index);
+    }
+
+    auto scrolledAwayUris = m_visible_uris - visibleUris;
+    ThumbnailManager::getInstance()->cancelThumbnails(scrolledAwayUris.toList());
+    ThumbnailManager::getInstance()->prioritizeThumbnails(visibleUris.toList());
+    m_visible_uris = visibleUris;
 }
 
 void ListView::updateGeometries()
@@ -30,6 +30,7 @@
 #include "directory-view-widget.h"
 
 #include <QTimer>
+#include <QSet>
 
 namespace Peony {
 
@@ -131,6 +132,11 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+    /*!
+     * \brief updateVisibleThumbnails
+     * \see IconView::updateVisibleThumbnails().
+     */
+    void updateVisibleThumbnails();
 private:
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
@@ -147,6 +153,9 @@ private:
 
     QSize m_last_size;
 
+    QTimer m_visible_thumbnails_timer;
+    QSet<QString> m_visible_uris;
+
     const int BOTTOM_STATUS_MARGIN = 36;
 };
 
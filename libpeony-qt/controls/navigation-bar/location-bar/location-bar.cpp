@@ -22,8 +22,9 @@
 
 #include "location-bar.h"
 
-#include "path-bar-model.h"
+#include "path-completion-engine.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 
 #include "search-vfs-uri-parser.h"
 
@@ -137,8 +138,8 @@ void LocationBar::setRootUri(const QString &uri)
     while (!tmp.isEmpty()) {
         uris.prepend(tmp);
         QUrl url = tmp;
-        //FIXME: replace BLOCKING api in ui thread.
-        if (FileUtils::isMountRoot(tmp))
+        //only local files report unix::is-mountpoint, do not query remote files.
+        if (url.isLocalFile() && FileUtils::isMountRoot(tmp))
             break;
 
 //        if (url.path() == QStandardPaths::writableLocation(QStandardPaths::HomeLocation)) {
@@ -178,14 +179,12 @@ void LocationBar::addButton(const QString &uri, bool setIcon, bool setMenu)
     button->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
     button->setPopupMode(QToolButton::MenuButtonPopup);
 
-    //FIXME: replace BLOCKING api in ui thread.
-    auto displayName = FileUtils::getFileDisplayName(uri);
     m_buttons.insert(uri, button);
     if (m_current_uri.startsWith("search://")) {
         QString nameRegexp = SearchVFSUriParser::getSearchUriNameRegexp(m_current_uri);
         QString targetDirectory = SearchVFSUriParser::getSearchUriTargetDirectory(m_current_uri);
         button->setIcon(QIcon::fromTheme("edit-find-symbolic"));
-        displayName = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
+        QString displayName = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
         button->setText(displayName);
         button->setFixedWidth(button->sizeHint().width());
         return;
@@ -195,36 +194,28 @@ void LocationBar::addButton(const QString &uri, bool setIcon, bool setMenu)
 
     auto parent = FileUtils::getParentUri(uri);
     if (setIcon) {
-        //FIXME: replace BLOCKING api in ui thread.
-        QIcon icon = QIcon::fromTheme(Peony::FileUtils::getFileIconName(uri), QIcon::fromTheme("folder"));
-        button->setIcon(icon);
+        button->setIcon(QIcon::fromTheme("folder"));
+        AsyncFileUtils::then(AsyncFileUtils::getFileIconNames(uri), button, [=](const QStringList &iconNames) {
+            button->setIcon(QIcon::fromTheme(AsyncFileUtils::validIconName(iconNames), QIcon::fromTheme("folder")));
+        });
     }
 
     if (!url.fileName().isEmpty()) {
         if (FileUtils::getParentUri(uri).isNull()) {
             setMenu = false;
         }
-        button->setText(url.fileName());
+        button->setText(elideText(url.fileName()));
     } else {
-        if (uri == "file:///") {
-            auto text = FileUtils::getFileDisplayName("computer:///root.link");
-            if (text.isNull()) {
-                text = tr("File System");
-            }
-            button->setText(text);
-        } else {
-            button->setText(displayName);
-        }
-    }
-
-    //if button text is too long, elide it
-    displayName = button->text();
-    if (displayName.length() > ELIDE_TEXT_LENGTH)
-    {
-        int  charWidth = fontMetrics().averageCharWidth();
-        displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
+        //the root of a file system, show the uri until its display name is queried.
+        QString displayNameUri = uri == "file:///"? "computer:///root.link": uri;
+        button->setText(elideText(uri == "file:///"? tr("File System"): uri));
+        AsyncFileUtils::then(AsyncFileUtils::getFileDisplayName(displayNameUri), button, [=](const QString &displayName) {
+            if (displayName.isEmpty())
+                return;
+            button->setText(elideText(displayName));
+            doLayout();
+        });
     }
-    button->setText(displayName);
 
     connect(button, &QToolButton::clicked, [=]() {
         //this->setRootUri(uri);
@@ -232,35 +223,24 @@ void LocationBar::addButton(const QString &uri, bool setIcon, bool setMenu)
     });
 
     if (setMenu) {
-        Peony::PathBarModel m;
-        m.setRootUri(uri);
-        m.sort(0);
-
-        auto suburis = m.stringList();
-        if (!suburis.isEmpty()) {
-            QMenu *menu = new QMenu(this);
-            QList<QAction *> actions;
-            for (auto uri : suburis) {
-                QUrl url = uri;
-                QString tmp = uri;
-                displayName = url.fileName();
-                if (displayName.length() > ELIDE_TEXT_LENGTH)
-                {
-                    int  charWidth = fontMetrics().averageCharWidth();
-                    displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
-                }
-                QAction *action = new QAction(displayName, this);
-                actions<<action;
-                connect(action, &QAction::triggered, [=]() {
-                    Q_EMIT groupChangedRequest(tmp);
-                });
-            }
-            menu->addActions(actions);
-
-            button->setMenu(menu);
+        //the sub directories are listed asynchronously, the menu is set when they are ready.
+        auto engine = PathCompletionEngine::getInstance();
+        QStringList suburis;
+        QHash<QString, QString> displayNames;
+        if (engine->getListing(uri, suburis, displayNames)) {
+            setButtonMenu(button, suburis);
         } else {
-            // no subdir directory should not display an indicator arrow.
-            button->setPopupMode(QToolButton::InstantPopup);
+            connect(engine, &PathCompletionEngine::listingReady, button, [=](const QString &listingUri) {
+                QStringList suburis;
+                QHash<QString, QString> displayNames;
+                if (listingUri == uri && engine->getListing(uri, suburis, displayNames))
+                    setButtonMenu(button, suburis);
+            });
+            connect(engine, &PathCompletionEngine::listingFailed, button, [=](const QString &listingUri) {
+                if (listingUri == uri)
+                    setButtonMenu(button, QStringList());
+            });
+            engine->requestListing(uri);
         }
     }
 
@@ -290,6 +270,45 @@ void LocationBar::addButton(const QString &uri, bool setIcon, bool setMenu)
     });
 }
 
+void LocationBar::setButtonMenu(QToolButton *button, const QStringList &subUris)
+{
+    if (subUris.isEmpty()) {
+        // no subdir directory should not display an indicator arrow.
+        button->setPopupMode(QToolButton::InstantPopup);
+        return;
+    }
+
+    //the listing might be ready again after it changed.
+    if (auto oldMenu = button->menu())
+        oldMenu->deleteLater();
+
+    QMenu *menu = new QMenu(this);
+    QList<QAction *> actions;
+    for (auto uri : subUris) {
+        QUrl url = uri;
+        QString tmp = uri;
+        QAction *action = new QAction(elideText(url.fileName()), this);
+        actions<<action;
+        connect(action, &QAction::triggered, [=]() {
+            Q_EMIT groupChangedRequest(tmp);
+        });
+    }
+    menu->addActions(actions);
+
+    button->setMenu(menu);
+}
+
+QString LocationBar::elideText(const QString &text)
+{
+    //if button text is too long, elide it
+    if (text.length() > ELIDE_TEXT_LENGTH)
+    {
+        int  charWidth = fontMetrics().averageCharWidth();
+        return fontMetrics().elidedText(text, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
+    }
+    return text;
+}
+
 void LocationBar::mousePressEvent(QMouseEvent *e)
 {
     //eat this event.
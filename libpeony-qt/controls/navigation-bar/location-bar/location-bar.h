@@ -61,6 +61,9 @@ protected:
     void doLayout();
 
 private:
+    void setButtonMenu(QToolButton *button, const QStringList &subUris);
+    QString elideText(const QString &text);
+
     QString m_current_uri;
     QLineEdit *m_styled_edit;
     QHBoxLayout *m_layout;
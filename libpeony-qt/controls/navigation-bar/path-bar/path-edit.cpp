@@ -40,6 +40,14 @@ PathEdit::PathEdit(QWidget *parent) : QLineEdit(parent)
     m_completer = new PathCompleter(this);
     m_completer->setModel(m_model);
     m_completer->setCaseSensitivity(Qt::CaseInsensitive);
+    //the items of model are sorted, the completer finds the prefix by binary search.
+    m_completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
+
+    //the completions are listed asynchronously, show them once they are ready.
+    connect(m_model, &PathBarModel::updated, this, [=]() {
+        if (this->hasFocus())
+            m_completer->complete();
+    });
 
     setLayoutDirection(Qt::LeftToRight);
 
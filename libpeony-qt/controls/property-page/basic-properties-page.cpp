@@ -22,6 +22,7 @@
 
 #include "basic-properties-page.h"
 #include "thumbnail-manager.h"
+#include "thumbnail-notifier.h"
 
 #include <QVBoxLayout>
 #include <QFrame>
@@ -60,8 +61,8 @@ BasicPropertiesPage::BasicPropertiesPage(const QStringList &uris, QWidget *paren
         m_watcher->connect(m_watcher.get(), &FileWatcher::locationChanged, this, &BasicPropertiesPage::onSingleFileChanged);
         m_watcher->startMonitor();
 
-        m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///");
-        connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
+        m_thumbnail_notifier = std::make_shared<ThumbnailNotifier>();
+        connect(m_thumbnail_notifier.get(), &ThumbnailNotifier::thumbnailUpdated, this, [=](const QString &uri){
             auto icon = ThumbnailManager::getInstance()->tryGetThumbnail(uri);
             m_icon->setIcon(icon);
             //QMessageBox::information(0, 0, "icon updated");
@@ -228,7 +229,7 @@ void BasicPropertiesPage::onSingleFileChanged(const QString &oldUri, const QStri
     FileInfoJob *j = new FileInfoJob(m_info);
     j->setAutoDelete();
     j->querySync();
-    ThumbnailManager::getInstance()->createThumbnail(m_info->uri(), m_thumbnail_watcher);
+    ThumbnailManager::getInstance()->createThumbnail(m_info, m_thumbnail_notifier);
 
     auto icon = QIcon::fromTheme(m_info->iconName(), QIcon::fromTheme("text-x-generic"));
     auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(m_info->uri());
@@ -241,7 +242,7 @@ void BasicPropertiesPage::onSingleFileChanged(const QString &oldUri, const QStri
     //auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(m_info->uri());
     if (thumbnail.isNull())
     {
-        ThumbnailManager::getInstance()->createThumbnail(m_info->uri(), m_thumbnail_watcher);
+        ThumbnailManager::getInstance()->createThumbnail(m_info, m_thumbnail_notifier);
     }
     //qDebug() << "set Icon:" <<thumbnail.isNull() <<thumbnail;
     m_icon->setIcon(thumbnail.isNull()? icon: thumbnail);
@@ -38,6 +38,7 @@ namespace Peony {
 
 class FileInfo;
 class FileWatcher;
+class ThumbnailNotifier;
 class FileCountOperation;
 
 /*!
@@ -67,7 +68,7 @@ private:
     QVBoxLayout *m_layout = nullptr;
     std::shared_ptr<FileInfo> m_info;
     std::shared_ptr<FileWatcher> m_watcher;
-    std::shared_ptr<FileWatcher> m_thumbnail_watcher;
+    std::shared_ptr<ThumbnailNotifier> m_thumbnail_notifier;
 
     void updateCountInfo();
 
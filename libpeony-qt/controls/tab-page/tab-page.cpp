@@ -27,6 +27,7 @@
 #include "directory-view-widget.h"
 #include "file-info.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 
 #include "file-launch-manager.h"
 
@@ -78,18 +79,8 @@ void TabPage::addPage(const QString &uri)
     container->switchViewType(DirectoryViewFactoryManager2::getInstance()->getDefaultViewId());
     container->getView()->setDirectoryUri(uri);
     container->getView()->beginLocationChange();
-    //FIXME: replace BLOCKING api in ui thread.
-    auto displayName = FileUtils::getFileDisplayName(uri);
-    if (displayName.length() > ELIDE_TEXT_LENGTH)
-    {
-        int  charWidth = fontMetrics().averageCharWidth();
-        displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
-    }
-
-    //FIXME: replace BLOCKING api in ui thread.
-    addTab(container,
-           QIcon::fromTheme(FileUtils::getFileIconName(uri), QIcon::fromTheme("folder")),
-           displayName);
+    addTab(container, QIcon::fromTheme("folder"), FileUtils::getUriBaseName(uri));
+    updateTabInfo(container, uri);
 
     rebindContainer();
 }
@@ -137,12 +128,28 @@ void TabPage::rebindContainer()
 void TabPage::refreshCurrentTabText()
 {
     auto uri = getActivePage()->getCurrentUri();
-    //FIXME: replace BLOCKING api in ui thread.
-    setTabText(currentIndex(), FileUtils::getFileDisplayName(uri));
-    //FIXME: replace BLOCKING api in ui thread.
-    setTabIcon(currentIndex(),
-               QIcon::fromTheme(FileUtils::getFileIconName(uri),
-                                QIcon::fromTheme("folder")));
+    updateTabInfo(getActivePage(), uri);
+}
+
+void TabPage::updateTabInfo(DirectoryViewContainer *page, const QString &uri)
+{
+    //the page might be moved, closed or changed its location before the infos are queried.
+    AsyncFileUtils::then(AsyncFileUtils::getFileDisplayName(uri), page, [=](QString displayName) {
+        if (page->getCurrentUri() != uri)
+            return;
+        if (displayName.length() > ELIDE_TEXT_LENGTH)
+        {
+            int  charWidth = fontMetrics().averageCharWidth();
+            displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
+        }
+        setTabText(indexOf(page), displayName);
+    });
+
+    AsyncFileUtils::then(AsyncFileUtils::getFileIconNames(uri), page, [=](const QStringList &iconNames) {
+        if (page->getCurrentUri() != uri)
+            return;
+        setTabIcon(indexOf(page), QIcon::fromTheme(AsyncFileUtils::validIconName(iconNames), QIcon::fromTheme("folder")));
+    });
 }
 
 void TabPage::stopLocationChange()
@@ -61,6 +61,17 @@ protected:
     void rebindContainer();
 
 private:
+    /*!
+     * \brief updateTabInfo
+     * \param page
+     * \param uri
+     * <br>
+     * Query the display name and icon of uri asynchronously, and update the tab
+     * of page if it still shows uri.
+     * </br>
+     */
+    void updateTabInfo(DirectoryViewContainer *page, const QString &uri);
+
     QTimer m_double_click_limiter;
 
     const int ELIDE_TEXT_LENGTH = 16;
@@ -0,0 +1,136 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "directory-snapshot.h"
+#include "file-enumerator.h"
+#include "file-info.h"
+
+#include <QStringList>
+
+#include <algorithm>
+
+using namespace Peony;
+
+static bool entry_less_than(const DirectorySnapshot::Entry &entry, const QString &uri)
+{
+    return entry.uri < uri;
+}
+
+DirectorySnapshot::DirectorySnapshot(const QString &uri)
+{
+    m_uri = uri;
+}
+
+bool DirectorySnapshot::take(GCancellable *cancellable)
+{
+    m_valid = false;
+    m_entries.clear();
+
+    if (m_uri.isEmpty())
+        return false;
+
+    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
+
+    //enumerate the target of special files, the same as FileEnumerator.
+    GFileInfo *targetInfo = g_file_query_info(file,
+                                              G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+                                              G_FILE_QUERY_INFO_NONE,
+                                              cancellable,
+                                              nullptr);
+    if (targetInfo) {
+        char *targetUri = g_file_info_get_attribute_as_string(targetInfo, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        if (targetUri) {
+            g_object_unref(file);
+            file = g_file_new_for_uri(targetUri);
+            g_free(targetUri);
+        }
+        g_object_unref(targetInfo);
+    }
+
+    GError *err = nullptr;
+    GFileEnumerator *enumerator = g_file_enumerate_children(file,
+                                  PEONY_DIRECTORY_SNAPSHOT_ATTRIBUTES,
+                                  G_FILE_QUERY_INFO_NONE,
+                                  cancellable,
+                                  &err);
+    g_object_unref(file);
+    if (!enumerator) {
+        g_error_free(err);
+        return false;
+    }
+
+    //a failed next_file() also returns nullptr, it must not be taken as the end
+    //of directory, or the children not read would be diffed out.
+    GFileInfo *info = g_file_enumerator_next_file(enumerator, cancellable, &err);
+    while (info) {
+        Entry entry;
+        entry.uri = FileEnumerator::childUri(enumerator, info);
+        entry.size = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+        entry.modifiedTime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        entry.fileId = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_ID_FILE);
+        m_entries<<entry;
+
+        g_object_unref(info);
+        info = g_file_enumerator_next_file(enumerator, cancellable, &err);
+    }
+
+    m_valid = !err && !g_cancellable_is_cancelled(cancellable);
+    if (err)
+        g_error_free(err);
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry &a, const Entry &b) {
+        return a.uri < b.uri;
+    });
+
+    return m_valid;
+}
+
+const QStringList DirectorySnapshot::uris()
+{
+    QStringList l;
+    l.reserve(m_entries.count());
+    for (auto entry : m_entries) {
+        l<<entry.uri;
+    }
+    return l;
+}
+
+const DirectorySnapshot::Entry *DirectorySnapshot::find(const QString &uri)
+{
+    auto it = std::lower_bound(m_entries.constBegin(), m_entries.constEnd(), uri, entry_less_than);
+    if (it == m_entries.constEnd() || it->uri != uri)
+        return nullptr;
+    return it;
+}
+
+bool DirectorySnapshot::isChanged(const Entry &entry, const std::shared_ptr<FileInfo> &info)
+{
+    if (!info)
+        return true;
+
+    return info->modifiedTime() != entry.modifiedTime
+            || info->size() != entry.size
+            || info->fileID() != entry.fileId;
+}
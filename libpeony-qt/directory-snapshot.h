@@ -0,0 +1,119 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef DIRECTORYSNAPSHOT_H
+#define DIRECTORYSNAPSHOT_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+#include <gio/gio.h>
+
+#define PEONY_DIRECTORY_SNAPSHOT_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+    G_FILE_ATTRIBUTE_ID_FILE
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The DirectorySnapshot class
+ * <br>
+ * DirectorySnapshot is the state of a directory's children at a moment,
+ * every child is recorded with its uri (name), modified time, size and file id
+ * (inode). It only queries these attributes, so taking a snapshot is a cheap
+ * stat sweep compared with enumerating the full infos.
+ * </br>
+ * <br>
+ * Refreshing a directory takes a new snapshot and compares it with current
+ * children, only the children added, removed or changed need to be updated.
+ * </br>
+ * \note take() is blocking, call it in a worker thread.
+ * \see FileItem::onUpdateDirectoryRequest().
+ */
+class PEONYCORESHARED_EXPORT DirectorySnapshot
+{
+public:
+    struct Entry {
+        QString uri;
+        quint64 modifiedTime = 0;
+        quint64 size = 0;
+        QString fileId;
+    };
+
+    explicit DirectorySnapshot(const QString &uri = nullptr);
+
+    /*!
+     * \brief take
+     * \param cancellable
+     * \return true if all the children of directory are enumerated.
+     * \note if the enumeration fails or is cancelled halfway, the snapshot is
+     * not valid and the entries are incomplete, it must not be diffed.
+     */
+    bool take(GCancellable *cancellable = nullptr);
+
+    const QString uri() {
+        return m_uri;
+    }
+    bool isValid() {
+        return m_valid;
+    }
+    /*!
+     * \brief entries
+     * \return the entries sorted by uri.
+     */
+    const QVector<Entry> &entries() {
+        return m_entries;
+    }
+    const QStringList uris();
+
+    /*!
+     * \brief find
+     * \param uri
+     * \return the entry of uri, or nullptr if it is not in the snapshot.
+     */
+    const Entry *find(const QString &uri);
+
+    /*!
+     * \brief isChanged
+     * \param entry
+     * \param info
+     * \return true if info is out of date compared with entry.
+     */
+    static bool isChanged(const Entry &entry, const std::shared_ptr<FileInfo> &info);
+
+private:
+    QString m_uri;
+    bool m_valid = false;
+    QVector<Entry> m_entries;
+};
+
+}
+
+#endif // DIRECTORYSNAPSHOT_H
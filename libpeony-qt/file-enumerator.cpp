@@ -22,6 +22,7 @@
 
 #include "file-enumerator.h"
 #include "file-info.h"
+#include "file-info-job.h"
 #include "file-info-manager.h"
 
 #include "mount-operation.h"
@@ -29,6 +30,8 @@
 #include "gerror-wrapper.h"
 
 #include "file-utils.h"
+#include "async-file-utils.h"
+#include "gio-watchdog.h"
 #include "peony-search-vfs-file.h"
 
 //play audio lib head file
@@ -46,6 +49,18 @@
 #define PEONY_FIND_NEXT_FILES_BATCH_SIZE 100
 #endif
 
+#ifndef PEONY_FIND_FIRST_FILES_BATCH_SIZE
+#define PEONY_FIND_FIRST_FILES_BATCH_SIZE 32
+#endif
+
+#ifndef PEONY_FIRST_PAINT_DEADLINE
+#define PEONY_FIRST_PAINT_DEADLINE 100
+#endif
+
+#ifndef PEONY_CHILDREN_UPDATE_INTERVAL
+#define PEONY_CHILDREN_UPDATE_INTERVAL 1000
+#endif
+
 using namespace Peony;
 
 FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
@@ -57,6 +72,10 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
 
     m_cache_uris = new QStringList();
 
+    m_first_batch_size = PEONY_FIND_FIRST_FILES_BATCH_SIZE;
+    m_batch_size = PEONY_FIND_NEXT_FILES_BATCH_SIZE;
+    m_first_paint_deadline = PEONY_FIRST_PAINT_DEADLINE;
+
     m_idle = new QTimer(this);
     m_idle->setSingleShot(false);
 
@@ -67,17 +86,13 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
     });
 
     connect(this, &FileEnumerator::enumerateFinished, this, [=](){
-        *m_children_uris<<*m_cache_uris;
-        childrenUpdated(*m_cache_uris);
-        m_cache_uris->clear();
+        flushCachedChildren();
         m_idle->stop();
     });
 
-    connect(m_idle, &QTimer::timeout, this, [=](){
-        *m_children_uris<<*m_cache_uris;
-        childrenUpdated(*m_cache_uris);
-        m_cache_uris->clear();
-    });
+    //make sure the cached children won't wait too long before being shown,
+    //even if a batch is not full yet.
+    connect(m_idle, &QTimer::timeout, this, &FileEnumerator::flushCachedChildren);
 }
 
 /*!
@@ -182,12 +197,61 @@ void FileEnumerator::cancel()
     m_cancellable = g_cancellable_new();
 
     m_children_uris->clear();
+    m_cache_uris->clear();
+    m_enumerated_infos.clear();
 
     Q_EMIT enumerateFinished(false);
 }
 
+const QString FileEnumerator::childUri(GFileEnumerator *enumerator, GFileInfo *info)
+{
+    GFile *child = g_file_enumerator_get_child(enumerator, info);
+    char *uri = g_file_get_uri(child);
+    char *path = g_file_get_path(child);
+    g_object_unref(child);
+
+    QString childUri = uri;
+    //the children of vfs which have a local path are presented as local files.
+    if (path && !QUrl(childUri).isLocalFile()) {
+        childUri = QString("file://%1").arg(path);
+    }
+
+    g_free(path);
+    g_free(uri);
+    return childUri;
+}
+
+void FileEnumerator::cacheEnumeratedInfo(const QString &uri, GFileInfo *info)
+{
+    if (!m_enumerate_with_info)
+        return;
+
+    //some vfs only supply names of children, they must be queried later.
+    if (!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME))
+        return;
+
+    m_enumerated_infos.insert(uri, FileInfo::fromGFileInfo(uri, info));
+}
+
+void FileEnumerator::flushCachedChildren()
+{
+    if (m_cache_uris->isEmpty())
+        return;
+
+    *m_children_uris<<*m_cache_uris;
+    Q_EMIT childrenUpdated(*m_cache_uris);
+    m_cache_uris->clear();
+
+    if (!m_first_batch_sent) {
+        //first paint done, the rest children can be sent in larger batches.
+        m_first_batch_sent = true;
+        m_idle->setInterval(PEONY_CHILDREN_UPDATE_INTERVAL);
+    }
+}
+
 void FileEnumerator::prepare()
 {
+    PEONY_WATCH_GIO_CALL(m_uri);
     GError *err = nullptr;
     GFileEnumerator *enumerator = g_file_enumerate_children(m_root_file,
                                   G_FILE_ATTRIBUTE_STANDARD_NAME,
@@ -214,16 +278,20 @@ void FileEnumerator::prepare()
 
 GFile *FileEnumerator::enumerateTargetFile()
 {
-    //FIXME: replace BLOCKING api in ui thread.
+    //enumerateSync() is expected to be called in threads, the watchdog logs
+    //the calls in ui thread.
+    PEONY_WATCH_GIO_CALL(m_uri);
     GFileInfo *info = g_file_query_info(m_root_file,
                                         G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
                                         G_FILE_QUERY_INFO_NONE,
-                                        nullptr,
+                                        m_cancellable,
                                         nullptr);
     char *uri = nullptr;
-    uri = g_file_info_get_attribute_as_string(info,
-            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
-    g_object_unref(info);
+    if (info) {
+        uri = g_file_info_get_attribute_as_string(info,
+                G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        g_object_unref(info);
+    }
 
     GFile *target = nullptr;
     if (uri) {
@@ -238,12 +306,13 @@ GFile *FileEnumerator::enumerateTargetFile()
 
 void FileEnumerator::enumerateSync()
 {
-    m_idle->start(1000);
+    m_first_batch_sent = false;
+    m_idle->start(m_first_paint_deadline);
 
     GFile *target = enumerateTargetFile();
 
     GFileEnumerator *enumerator = g_file_enumerate_children(target,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                  m_enumerate_with_info? PEONY_FILE_INFO_QUERY_ATTRIBUTES: G_FILE_ATTRIBUTE_STANDARD_NAME,
                                   G_FILE_QUERY_INFO_NONE,
                                   m_cancellable,
                                   nullptr);
@@ -278,41 +347,25 @@ void FileEnumerator::handleError(GError *err)
     switch (err->code) {
     case G_IO_ERROR_NOT_DIRECTORY: {
         auto uri = g_file_get_uri(m_root_file);
-        //FIXME: replace BLOCKING api in ui thread.
-        auto targetUri = FileUtils::getTargetUri(uri);
+        QString rootUri = uri;
         if (uri) {
             g_free(uri);
         }
-        if (!targetUri.isEmpty()) {
-            prepared(nullptr, targetUri);
-            return;
-        }
-
-        bool isMountable = false;
-        //FIXME: replace BLOCKING api in ui thread.
-        GFileInfo *file_mount_info = g_file_query_info(m_root_file, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT,
-                                     G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
-
-        if (file_mount_info) {
-            isMountable = g_file_info_get_attribute_boolean(file_mount_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
-            g_object_unref(file_mount_info);
-        }
+        AsyncFileUtils::then(AsyncFileUtils::getTargetUri(rootUri), this, [=](const QString &targetUri) {
+            if (!targetUri.isEmpty()) {
+                Q_EMIT prepared(nullptr, targetUri);
+                return;
+            }
 
-        if (isMountable) {
-            g_file_mount_mountable(m_root_file,
-                                   G_MOUNT_MOUNT_NONE,
-                                   nullptr,
-                                   m_cancellable,
-                                   GAsyncReadyCallback(mount_mountable_callback),
-                                   this);
-        } else {
-            g_file_mount_enclosing_volume(m_root_file,
-                                          G_MOUNT_MOUNT_NONE,
-                                          nullptr,
-                                          m_cancellable,
-                                          GAsyncReadyCallback(mount_enclosing_volume_callback),
-                                          this);
-        }
+            //mount it when we know if it is mountable.
+            g_file_query_info_async(m_root_file,
+                                    G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                    G_PRIORITY_DEFAULT,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(query_mountable_callback),
+                                    this);
+        });
         break;
     }
     case G_IO_ERROR_NOT_MOUNTED:
@@ -353,12 +406,13 @@ void FileEnumerator::handleError(GError *err)
 
 void FileEnumerator::enumerateAsync()
 {
-    m_idle->start(1000);
+    m_first_batch_sent = false;
+    m_idle->start(m_first_paint_deadline);
 
     //auto uri = g_file_get_uri(m_root_file);
     //auto path = g_file_get_path(m_root_file);
     g_file_enumerate_children_async(m_root_file,
-                                    G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    m_enumerate_with_info? PEONY_FILE_INFO_QUERY_ATTRIBUTES: G_FILE_ATTRIBUTE_STANDARD_NAME,
                                     G_FILE_QUERY_INFO_NONE,
                                     G_PRIORITY_DEFAULT,
                                     m_cancellable,
@@ -370,38 +424,60 @@ void FileEnumerator::enumerateAsync()
 void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
 {
     GFileInfo *info = nullptr;
-    GFile *child = nullptr;
     info = g_file_enumerator_next_file(enumerator, m_cancellable, nullptr);
     if (!info) {
         Q_EMIT enumerateFinished(false);
         return;
     }
     while (info) {
-        child = g_file_enumerator_get_child(enumerator, info);
-        char *uri = g_file_get_uri(child);
-        char *path = g_file_get_path(child);
-        g_object_unref(child);
-
-        QUrl url = QUrl(QString(uri));
-        //qDebug()<<uri;
-        if (path && !url.isLocalFile()) {
-            QString localUri = QString("file://%1").arg(path);
-            *m_children_uris<<localUri;
-            g_free(path);
-        } else {
-            if (path) {
-                g_free(path);
-            }
-            *m_children_uris<<uri;
-        }
+        auto uri = childUri(enumerator, info);
+        *m_children_uris<<uri;
+        cacheEnumeratedInfo(uri, info);
 
-        g_free(uri);
         g_object_unref(info);
         info = g_file_enumerator_next_file(enumerator, m_cancellable, nullptr);
     }
     Q_EMIT enumerateFinished(true);
 }
 
+GAsyncReadyCallback FileEnumerator::query_mountable_callback(GFile *file,
+        GAsyncResult *res,
+        FileEnumerator *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *file_mount_info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        //the enumerator might have been deleted.
+        bool cancelled = err->code == G_IO_ERROR_CANCELLED;
+        g_error_free(err);
+        if (cancelled)
+            return nullptr;
+    }
+
+    bool isMountable = false;
+    if (file_mount_info) {
+        isMountable = g_file_info_get_attribute_boolean(file_mount_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
+        g_object_unref(file_mount_info);
+    }
+
+    if (isMountable) {
+        g_file_mount_mountable(p_this->m_root_file,
+                               G_MOUNT_MOUNT_NONE,
+                               nullptr,
+                               p_this->m_cancellable,
+                               GAsyncReadyCallback(mount_mountable_callback),
+                               p_this);
+    } else {
+        g_file_mount_enclosing_volume(p_this->m_root_file,
+                                      G_MOUNT_MOUNT_NONE,
+                                      nullptr,
+                                      p_this->m_cancellable,
+                                      GAsyncReadyCallback(mount_enclosing_volume_callback),
+                                      p_this);
+    }
+    return nullptr;
+}
+
 GAsyncReadyCallback FileEnumerator::mount_mountable_callback(GFile *file,
         GAsyncResult *res,
         FileEnumerator *p_this)
@@ -528,9 +604,10 @@ GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *fi
             Q_EMIT p_this->enumerateFinished(false);
         return nullptr;
     }
-    //
+    //ask for a small batch first, so that the view can be painted as soon as possible.
+    p_this->m_requested_count = p_this->m_first_batch_size;
     g_file_enumerator_next_files_async(enumerator,
-                                       PEONY_FIND_NEXT_FILES_BATCH_SIZE,
+                                       p_this->m_requested_count,
                                        G_PRIORITY_DEFAULT,
                                        p_this->m_cancellable,
                                        GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
@@ -574,39 +651,29 @@ GAsyncReadyCallback FileEnumerator::enumerator_next_files_async_ready_callback(G
     }
 
     GList *l = files;
-    QStringList uriList;
     int files_count = 0;
     while (l) {
         GFileInfo *info = static_cast<GFileInfo*>(l->data);
-        GFile *file = g_file_enumerator_get_child(enumerator, info);
-        char *uri = g_file_get_uri(file);
-        char *path = g_file_get_path(file);
-        g_object_unref(file);
-        //qDebug()<<uri;
-
-        QUrl url = QUrl(QString(uri));
-
-        if (path && !url.isLocalFile()) {
-            QString localUri = QString("file://%1").arg(path);
-            uriList<<localUri;
-            *(p_this->m_cache_uris)<<localUri;
-            g_free(path);
-        } else {
-            uriList<<uri;
-            *(p_this->m_cache_uris)<<uri;
-        }
+        auto uri = childUri(enumerator, info);
+        *(p_this->m_cache_uris)<<uri;
+        p_this->cacheEnumeratedInfo(uri, info);
 
-        g_free(uri);
         files_count++;
         l = l->next;
     }
     g_list_free_full(files, g_object_unref);
-    //Q_EMIT p_this->childrenUpdated(uriList);
 
-    if (files_count == PEONY_FIND_NEXT_FILES_BATCH_SIZE) {
+    //the first batch is sent immediately, the later ones are sent
+    //when the cache is full or the update interval timeout.
+    if (!p_this->m_first_batch_sent || p_this->m_cache_uris->count() >= p_this->m_batch_size) {
+        p_this->flushCachedChildren();
+    }
+
+    if (files_count == p_this->m_requested_count) {
         //have next files, countinue.
+        p_this->m_requested_count = p_this->m_batch_size;
         g_file_enumerator_next_files_async(enumerator,
-                                           PEONY_FIND_NEXT_FILES_BATCH_SIZE,
+                                           p_this->m_requested_count,
                                            G_PRIORITY_DEFAULT,
                                            p_this->m_cancellable,
                                            GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
@@ -24,6 +24,7 @@
 #define FILEENUMERATOR_H
 
 #include <QObject>
+#include <QHash>
 #include "peony-core_global.h"
 
 #include <memory>
@@ -98,6 +99,72 @@ public:
         m_auto_delete = true;
     }
 
+    /*!
+     * \brief setFirstBatchSize
+     * \param size, how many children the first async request asks for.
+     * <br>
+     * The first batch is sent by childrenUpdated() as soon as it arrives,
+     * so a small size let the view paint something quickly even in a
+     * directory holding hundreds of thousands of files.
+     * </br>
+     */
+    void setFirstBatchSize(int size) {
+        m_first_batch_size = qMax(1, size);
+    }
+    /*!
+     * \brief setBatchSize
+     * \param size, how many children are requested and sent at once after
+     * the first batch.
+     */
+    void setBatchSize(int size) {
+        m_batch_size = qMax(1, size);
+    }
+    /*!
+     * \brief setFirstPaintDeadline
+     * \param msec, the longest time enumerated children can stay cached
+     * before the first childrenUpdated() is sent. After first paint, the
+     * cached children are flushed once per batch or per update interval.
+     */
+    void setFirstPaintDeadline(int msec) {
+        m_first_paint_deadline = msec;
+    }
+
+    /*!
+     * \brief setEnumerateWithInfo
+     * \param withInfo
+     * <br>
+     * If true, enumerator will query the full attributes of FileInfoJob while
+     * enumerating, and fill the children's infos with the enumerated results.
+     * This saves a query for each child, which is a network round trip for
+     * remote files.
+     * </br>
+     * \see getEnumeratedInfo().
+     */
+    void setEnumerateWithInfo(bool withInfo = true) {
+        m_enumerate_with_info = withInfo;
+    }
+    bool isEnumerateWithInfo() {
+        return m_enumerate_with_info;
+    }
+    /*!
+     * \brief getEnumeratedInfo
+     * \param uri, uri of a child.
+     * \return the info filled while enumerating, or nullptr if the info
+     * was not enumerated with the full attributes. Some vfs such as search:///
+     * only supply the name of children, their infos still need be queried.
+     */
+    std::shared_ptr<FileInfo> getEnumeratedInfo(const QString &uri) {
+        return m_enumerated_infos.value(uri);
+    }
+
+    /*!
+     * \brief childUri
+     * \param enumerator
+     * \param info, an info returned by enumerator.
+     * \return the uri of child in the form of enumerated children.
+     */
+    static const QString childUri(GFileEnumerator *enumerator, GFileInfo *info);
+
 Q_SIGNALS:
     /*!
      * \brief prepared
@@ -171,6 +238,18 @@ protected:
      */
     GFile *enumerateTargetFile();
 
+    /*!
+     * \brief query_mountable_callback
+     * \param file
+     * \param res
+     * \param p_this
+     * \return
+     * \see handleError().
+     */
+    static GAsyncReadyCallback query_mountable_callback(GFile *file,
+            GAsyncResult *res,
+            FileEnumerator *p_this);
+
     /*!
      * \brief mount_mountable_callback
      * \param file
@@ -219,6 +298,22 @@ protected:
             GAsyncResult *res,
             FileEnumerator *p_this);
 
+    /*!
+     * \brief flushCachedChildren
+     * <br>
+     * Move the cached uris into children list and send them with childrenUpdated().
+     * </br>
+     */
+    void flushCachedChildren();
+
+    /*!
+     * \brief cacheEnumeratedInfo
+     * \param uri
+     * \param info, enumerated GFileInfo of child.
+     * \note only works when enumerate with info.
+     */
+    void cacheEnumeratedInfo(const QString &uri, GFileInfo *info);
+
 private:
     QString m_uri;
 
@@ -231,6 +326,15 @@ private:
     QTimer *m_idle;
 
     bool m_auto_delete = false;
+
+    int m_first_batch_size;
+    int m_batch_size;
+    int m_first_paint_deadline;
+    int m_requested_count = 0;
+    bool m_first_batch_sent = false;
+
+    bool m_enumerate_with_info = false;
+    QHash<QString, std::shared_ptr<FileInfo>> m_enumerated_infos;
 };
 
 }
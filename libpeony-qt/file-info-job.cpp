@@ -26,7 +26,9 @@
 #include "file-meta-info.h"
 
 #include "file-info-manager.h"
+#include "file-info-store.h"
 #include "file-label-model.h"
+#include "gio-watchdog.h"
 
 #include <gio/gdesktopappinfo.h>
 
@@ -38,6 +40,8 @@
 
 using namespace Peony;
 
+static QString get_app_name(const QString &desktopfp);
+
 FileInfoJob::FileInfoJob(std::shared_ptr<FileInfo> info, QObject *parent) : QObject(parent)
 {
     m_info = info;
@@ -58,31 +62,15 @@ FileInfoJob::FileInfoJob(const QString &uri, QObject *parent) : QObject (parent)
 /*!
  * \brief FileInfoJob::~FileInfoJob
  * <br>
- * For FileInfo having a handle shared by all classes instance,
- * the shared data first is created in a global hash hold by
- * Peony::FileInfoManager instance. This makes shared_ptr
- * ref count always more than 1.
- * </br>
- * <br>
- * At this class we aslo hold a shared data from global hash
- * (though we aslo change its content here).
- * When info job instance in destructor, it means shared data
- * use count will reduce 1 soon. If current use count is 2,
- * that means there won't be another holder expect global hash.
- * So we can remove the last shared_ptr in the hash, then FileInfo
- * instance will be removed automaticly.
+ * Peony::FileInfoManager only holds weak references and a bounded LRU cache
+ * of infos, so the shared info will be released by manager when no one holds
+ * it. We don't need remove it from manager here.
  * </br>
- * \see FileInfo::~FileInfo(), FileEnumerator::~FileEnumerator().
+ * \see FileInfo::~FileInfo(), FileInfoManager.
  */
 FileInfoJob::~FileInfoJob()
 {
     g_object_unref(m_cancellable);
-
-    //qDebug()<<"~Job"<<m_info.use_count();
-    if (m_info.use_count() <= 2) {
-        Peony::FileInfoManager *mgr = Peony::FileInfoManager::getInstance();
-        mgr->remove(m_info);
-    }
 }
 
 void FileInfoJob::cancel()
@@ -103,10 +91,11 @@ bool FileInfoJob::querySync()
             deleteLater();
         return false;
     }
+    PEONY_WATCH_GIO_CALL(info->uri());
     GError *err = nullptr;
 
     auto _info = g_file_query_info(info->m_file,
-                                   "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                                   PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                                    G_FILE_QUERY_INFO_NONE,
                                    nullptr,
                                    &err);
@@ -166,7 +155,7 @@ void FileInfoJob::queryAsync()
         return;
     }
     g_file_query_info_async(info->m_file,
-                            "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                            PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                             G_FILE_QUERY_INFO_NONE,
                             G_PRIORITY_DEFAULT,
                             m_cancellable,
@@ -188,42 +177,60 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     } else {
         return;
     }
+    updateInfoContents(info, new_info);
+//    m_info->m_mutex.unlock();
+}
+
+void FileInfoJob::updateInfoContents(FileInfo *info, GFileInfo *new_info)
+{
+    //the attributes are kept in the record of info, fill a copy and write it at once.
+    auto store = FileInfoManager::getInstance()->getStore();
+    auto contents = store->record(info->record());
+
+    //a directory or a volume stays what it was found to be.
+    quint32 flags = contents.flags & (FileInfoStore::IsDir|FileInfoStore::IsVolume|FileInfoStore::IsRemote|FileInfoStore::IsValid);
+    auto setFlag = [&](FileInfoStore::RecordFlag flag, bool on) {
+        if (on)
+            flags |= flag;
+    };
+
     GFileType type = g_file_info_get_file_type (new_info);
     switch (type) {
     case G_FILE_TYPE_DIRECTORY:
         //qDebug()<<"dir";
-        info->m_is_dir = true;
+        flags |= FileInfoStore::IsDir;
         break;
     case G_FILE_TYPE_MOUNTABLE:
         //qDebug()<<"mountable";
-        info->m_is_volume = true;
+        flags |= FileInfoStore::IsVolume;
         break;
     default:
         break;
     }
 
-    info->m_is_symbol_link = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
+    setFlag(FileInfoStore::IsSymbolLink, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK));
     if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ)) {
-        info->m_can_read = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+        setFlag(FileInfoStore::CanRead, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ));
     } else {
         // we assume an unknow access file is readable.
-        info->m_can_read = true;
+        flags |= FileInfoStore::CanRead;
     }
-    info->m_can_write = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE);
-    info->m_can_excute = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE);
-    info->m_can_delete = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE);
-    info->m_can_trash = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH);
-    info->m_can_rename = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME);
-
-    info->m_can_mount = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
-    info->m_can_unmount = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT);
-    info->m_can_eject = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_EJECT);
-    info->m_can_start = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_START);
-    info->m_can_stop = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_STOP);
-
-    info->m_is_virtual = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL);
-
-    info->m_display_name = QString (g_file_info_get_display_name(new_info));
+    setFlag(FileInfoStore::CanWrite, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE));
+    setFlag(FileInfoStore::CanExecute, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE));
+    setFlag(FileInfoStore::CanDelete, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE));
+    setFlag(FileInfoStore::CanTrash, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH));
+    setFlag(FileInfoStore::CanRename, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME));
+
+    setFlag(FileInfoStore::CanMount, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT));
+    setFlag(FileInfoStore::CanUnmount, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT));
+    setFlag(FileInfoStore::CanEject, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_EJECT));
+    setFlag(FileInfoStore::CanStart, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_START));
+    setFlag(FileInfoStore::CanStop, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_STOP));
+
+    setFlag(FileInfoStore::IsVirtual, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL));
+    contents.flags = flags;
+
+    contents.displayName = QString (g_file_info_get_display_name(new_info));
     GIcon *g_icon = g_file_info_get_icon (new_info);
     if (G_IS_ICON(g_icon)) {
         const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_icon));
@@ -232,7 +239,7 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
             while (*p) {
                 QIcon icon = QIcon::fromTheme(*p);
                 if (!icon.isNull()) {
-                    info->m_icon_name = QString (*p);
+                    contents.iconName = QString (*p);
                     break;
                 } else {
                     p++;
@@ -247,55 +254,33 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
     if (G_IS_ICON(g_symbolic_icon)) {
         const gchar* const* symbolic_icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_symbolic_icon));
         if (symbolic_icon_names)
-            info->m_symbolic_icon_name = QString (*symbolic_icon_names);
+            contents.symbolicIconName = QString (*symbolic_icon_names);
         //g_object_unref(g_symbolic_icon);
     }
 
-    char* name = g_file_get_path(info->m_file);
-    info->m_path = name;
-    if (NULL != name) {
-        g_free(name);
-    }
-    info->m_file_id = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_ID_FILE);
+    contents.fileId = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_ID_FILE);
 
-    info->m_content_type = g_file_info_get_content_type (new_info);
-    if (info->m_content_type == nullptr) {
+    //mime type is interned by the store.
+    contents.mimeType = g_file_info_get_content_type (new_info);
+    if (contents.mimeType == nullptr) {
         if (g_file_info_has_attribute(new_info, "standard::fast-content-type")) {
-            info->m_content_type = g_file_info_get_attribute_string(new_info, "standard::fast-content-type");
+            contents.mimeType = g_file_info_get_attribute_string(new_info, "standard::fast-content-type");
         }
     }
 
-    info->m_size = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
-    info->m_modified_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
-    info->m_access_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
-
-    info->m_mime_type_string = info->m_content_type;
-    if (!info->m_mime_type_string.isEmpty()) {
-        char *content_type = g_content_type_get_description (info->m_mime_type_string.toUtf8().constData());
-        info->m_file_type = content_type;
-        g_free (content_type);
-        content_type = nullptr;
-    }
-
-    char *size_full = g_format_size_full(info->m_size, G_FORMAT_SIZE_DEFAULT);
-    info->m_file_size = size_full;
-    g_free(size_full);
+    contents.size = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+    contents.modifiedTime = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    contents.accessTime = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
 
-    QDateTime date = QDateTime::fromMSecsSinceEpoch(info->m_modified_time*1000);
-    info->m_modified_date = date.toString(Qt::SystemLocaleShortDate);
-
-    date = QDateTime::fromMSecsSinceEpoch(info->m_access_time*1000);
-    info->m_access_date = date.toString(Qt::SystemLocaleShortDate);
-
-    m_info->m_meta_info = FileMetaInfo::fromGFileInfo(m_info->uri(), new_info);
+    info->m_meta_info = FileMetaInfo::fromGFileInfo(info->uri(), new_info);
     // update peony qt color list after meta info updated.
-    m_info->m_colors = FileLabelModel::getGlobalModel()->getFileColors(m_info->uri());
+    info->m_colors = FileLabelModel::getGlobalModel()->getFileColors(info->uri());
 
-    if (info->isDesktopFile()) {
+    if ((flags & FileInfoStore::CanExecute) && info->uri().endsWith(".desktop")) {
         QUrl url = info->uri();
         GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(url.path().toUtf8());
         if (!desktop_info) {
-            m_info->m_mutex.unlock();
+            store->setRecord(info->record(), contents);
             info->updated();
             return;
         }
@@ -308,20 +293,20 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
         auto key = "Name[" +  QLocale::system().name() + "]";
         auto string = g_desktop_app_info_get_string(desktop_info, key.toUtf8().constData());
 #endif
-        qDebug() << "get name string:"<<string <<info->uri()<<info->displayName();
+        qDebug() << "get name string:"<<string <<info->uri()<<contents.displayName;
         if (string) {
-            info->m_display_name = string;
+            contents.displayName = string;
             g_free(string);
         } else {
-            QString path = "/usr/share/applications/" + info->displayName();
-            auto name = getAppName(path);
+            QString path = "/usr/share/applications/" + contents.displayName;
+            auto name = get_app_name(path);
             if (name.length() > 0)
-                info->m_display_name = name;
+                contents.displayName = name;
             else
             {
                 string = g_desktop_app_info_get_string(desktop_info, "Name");
                 if (string) {
-                    info->m_display_name = string;
+                    contents.displayName = string;
                     g_free(string);
                 }
             }
@@ -329,11 +314,16 @@ void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
         g_object_unref(desktop_info);
     }
 
+    store->setRecord(info->record(), contents);
     Q_EMIT info->updated();
-//    m_info->m_mutex.unlock();
 }
 
 QString FileInfoJob::getAppName(QString desktopfp)
+{
+    return get_app_name(desktopfp);
+}
+
+static QString get_app_name(const QString &desktopfp)
 {
     GError** error=nullptr;
     GKeyFileFlags flags=G_KEY_FILE_NONE;
@@ -30,6 +30,14 @@
 #include <memory>
 #include <gio/gio.h>
 
+/*!
+ * \brief PEONY_FILE_INFO_QUERY_ATTRIBUTES
+ * The attributes FileInfoJob queried for a FileInfo. FileEnumerator uses the same
+ * attributes when it enumerates with infos, so that the enumerated GFileInfo can
+ * fill a FileInfo directly.
+ */
+#define PEONY_FILE_INFO_QUERY_ATTRIBUTES "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE
+
 namespace Peony {
 
 class FileInfo;
@@ -123,6 +131,18 @@ protected:
 
 private:
     void refreshInfoContents(GFileInfo *new_info);
+    /*!
+     * \brief updateInfoContents
+     * \param info
+     * \param new_info, a GFileInfo queried with PEONY_FILE_INFO_QUERY_ATTRIBUTES.
+     * <br>
+     * Fill the info with a GFileInfo. This is shared by FileInfoJob and
+     * FileInfo::fromGFileInfo(), which fills infos from enumerated results
+     * without another query.
+     * </br>
+     */
+    static void updateInfoContents(FileInfo *info, GFileInfo *new_info);
+
     std::shared_ptr<FileInfo> m_info;
 
     quint64 m_file_size_uint = 0;
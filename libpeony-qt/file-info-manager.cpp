@@ -21,23 +21,33 @@
  */
 
 #include "file-info-manager.h"
-#include "thumbnail-manager.h"
-#include <QMap>
 #include <QDebug>
 
+/*!
+ * \brief FILE_INFO_EXTRA_SIZE
+ * estimated size of the QObject private data, GFile handle and other
+ * heap data of a FileInfo, besides of the object itself and uri.
+ */
+#define FILE_INFO_EXTRA_SIZE 512
+
+/*!
+ * \brief EXPIRED_CHECK_INTERVAL
+ * remove the expired references of a shard every this many insertions.
+ */
+#define EXPIRED_CHECK_INTERVAL 1024
+
 using namespace Peony;
 
 static FileInfoManager* global_file_info_manager = nullptr;
-static QMap<QString, std::weak_ptr<FileInfo>> *global_info_list = nullptr;
 
 FileInfoManager::FileInfoManager()
 {
-    global_info_list = new QMap<QString, std::weak_ptr<FileInfo>>();
+
 }
 
 FileInfoManager::~FileInfoManager()
 {
-    delete global_info_list;
+
 }
 
 FileInfoManager *FileInfoManager::getInstance()
@@ -49,19 +59,41 @@ FileInfoManager *FileInfoManager::getInstance()
 
 std::shared_ptr<FileInfo> FileInfoManager::findFileInfoByUri(QString uri)
 {
-    Q_ASSERT(global_info_list);
-    return global_info_list->value(uri).lock();//.lock();
+    //evicted infos must be released after shard unlocked,
+    //FileInfo's destructor might call other managers.
+    QList<std::shared_ptr<FileInfo>> evicted;
+
+    auto shard = shardOf(uri);
+    QMutexLocker locker(&shard->mutex);
+    auto info = shard->infos.value(uri).lock();
+    if (info) {
+        m_hit_count++;
+        touch(shard, info, evicted);
+    } else {
+        m_miss_count++;
+    }
+    return info;
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileInfo> info)
 {
-    Q_ASSERT(global_info_list);
+    QList<std::shared_ptr<FileInfo>> evicted;
 
-    if (global_info_list->value(info->uri()).lock()) {
+    auto shard = shardOf(info->uri());
+    QMutexLocker locker(&shard->mutex);
+    auto existedInfo = shard->infos.value(info->uri()).lock();
+    if (existedInfo) {
         //qDebug()<<"has info yet"<<info->uri();
-        info = global_info_list->value(info->uri()).lock();
-    } else {
-        global_info_list->insert(info->uri(), info);
+        touch(shard, existedInfo, evicted);
+        return existedInfo;
+    }
+
+    shard->infos.insert(info->uri(), info);
+    touch(shard, info, evicted);
+
+    shard->inserted_count++;
+    if (shard->inserted_count % EXPIRED_CHECK_INTERVAL == 0) {
+        removeExpired(shard);
     }
 
     return info;
@@ -69,34 +101,137 @@ std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileIn
 
 void FileInfoManager::removeFileInfobyUri(QString uri)
 {
-    return;
-    Q_ASSERT(global_info_list);
-    global_info_list->remove(uri);
+    remove(uri);
 }
 
 void FileInfoManager::clear()
 {
-    return;
-    Q_ASSERT(global_info_list);
-    global_info_list->clear();
+    QList<std::shared_ptr<FileInfo>> released;
+
+    for (auto &shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        for (auto cachedInfo : shard.lru) {
+            released<<cachedInfo.info;
+        }
+        shard.lru.clear();
+        shard.lru_index.clear();
+        shard.cached_size = 0;
+        removeExpired(&shard);
+    }
 }
 
 void FileInfoManager::remove(QString uri)
 {
-    return;
-    ThumbnailManager::getInstance()->releaseThumbnail(uri);
-    Q_ASSERT(global_info_list);
-    global_info_list->remove(uri);
+    std::shared_ptr<FileInfo> released;
+
+    auto shard = shardOf(uri);
+    QMutexLocker locker(&shard->mutex);
+    auto iter = shard->lru_index.find(uri);
+    if (iter != shard->lru_index.end()) {
+        auto cachedInfo = iter.value();
+        released = cachedInfo->info;
+        shard->cached_size -= cachedInfo->size;
+        shard->lru.erase(cachedInfo);
+        shard->lru_index.erase(iter);
+    }
+
+    if (shard->infos.value(uri).expired()) {
+        shard->infos.remove(uri);
+    }
 }
 
 void FileInfoManager::remove(std::shared_ptr<FileInfo> info)
 {
-    return;
-    Q_ASSERT(global_info_list);
+    if (!info)
+        return;
     this->remove(info->uri());
 }
 
+void FileInfoManager::setMemoryBudget(qint64 bytes)
+{
+    m_memory_budget = qMax(qint64(0), bytes);
+
+    QList<std::shared_ptr<FileInfo>> evicted;
+    for (auto &shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        evict(&shard, evicted);
+    }
+}
+
+qint64 FileInfoManager::cachedMemory()
+{
+    qint64 bytes = 0;
+    for (auto &shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        bytes += shard.cached_size;
+    }
+    return bytes;
+}
+
 void FileInfoManager::showState()
 {
-    qDebug()<<global_info_list->keys().count()<<global_info_list->values().count();
+    int count = 0;
+    int cachedCount = 0;
+    for (auto &shard : m_shards) {
+        QMutexLocker locker(&shard.mutex);
+        count += shard.infos.count();
+        cachedCount += shard.lru.size();
+    }
+    qDebug()<<"infos:"<<count<<"cached:"<<cachedCount<<"cached memory:"<<cachedMemory()
+            <<"hit:"<<hitCount()<<"miss:"<<missCount()<<"eviction:"<<evictionCount();
+}
+
+FileInfoManager::Shard *FileInfoManager::shardOf(const QString &uri)
+{
+    return &m_shards[qHash(uri) % PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
+}
+
+void FileInfoManager::touch(Shard *shard, const std::shared_ptr<FileInfo> &info, QList<std::shared_ptr<FileInfo>> &evicted)
+{
+    auto iter = shard->lru_index.find(info->uri());
+    if (iter != shard->lru_index.end()) {
+        shard->lru.splice(shard->lru.begin(), shard->lru, iter.value());
+        return;
+    }
+
+    CachedInfo cachedInfo;
+    cachedInfo.info = info;
+    cachedInfo.size = estimateSize(info.get());
+    shard->lru.push_front(cachedInfo);
+    shard->lru_index.insert(info->uri(), shard->lru.begin());
+    shard->cached_size += cachedInfo.size;
+
+    evict(shard, evicted);
+}
+
+void FileInfoManager::evict(Shard *shard, QList<std::shared_ptr<FileInfo>> &evicted)
+{
+    qint64 budget = m_memory_budget/PEONY_FILE_INFO_MANAGER_SHARD_COUNT;
+    while (shard->cached_size > budget && !shard->lru.empty()) {
+        auto &cachedInfo = shard->lru.back();
+        evicted<<cachedInfo.info;
+        shard->cached_size -= cachedInfo.size;
+        shard->lru_index.remove(cachedInfo.info->uri());
+        shard->lru.pop_back();
+        m_eviction_count++;
+    }
+}
+
+void FileInfoManager::removeExpired(Shard *shard)
+{
+    auto iter = shard->infos.begin();
+    while (iter != shard->infos.end()) {
+        if (iter.value().expired()) {
+            iter = shard->infos.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+qint64 FileInfoManager::estimateSize(FileInfo *info)
+{
+    //uri is the only string never changed after info created, the strings
+    //in its record of FileInfoStore are usually no longer than uri.
+    return sizeof(FileInfo) + FILE_INFO_EXTRA_SIZE + 2 * info->uri().size() * sizeof(QChar);
 }
@@ -24,8 +24,21 @@
 #define FILEINFOMANAGER_H
 
 #include "file-info.h"
+#include "file-info-store.h"
 
 #include <QMutex>
+#include <QHash>
+
+#include <list>
+#include <atomic>
+
+#ifndef PEONY_FILE_INFO_MANAGER_SHARD_COUNT
+#define PEONY_FILE_INFO_MANAGER_SHARD_COUNT 16
+#endif
+
+#ifndef PEONY_FILE_INFO_CACHE_MEMORY_BUDGET
+#define PEONY_FILE_INFO_CACHE_MEMORY_BUDGET (16*1024*1024)
+#endif
 
 namespace Peony {
 
@@ -33,53 +46,150 @@ namespace Peony {
  * \brief The FileInfoManager class
  * <br>
  * This is a class used to share FileInfo instances acrossing various members.
- * It is a single instance class with a hash table that cached all infos.
+ * It is a single instance class with hash tables that cached all infos.
  * We generally would not operate directly on instance of this class,
  * because FileInfo class provides an interface for this class.
  * use FileInfo::fromUri(), FileInfo::fromPath() or FileInfo::fromGFile()
  * for getting the corresponding shared data.
  * </br>
- * \note The memory management is based on std smart pointer, but it is not regular.
- * Because hash table always hold a use count of shared data. If you want to use
- * shared data of this class instance, you should remenmber this point:
- * When releasing your info resources, you aslo need to add an additional judgment that whether
- * there is no other member but you and manager instance hold this shared data.
- * If true, you should aslo remove the element in manager's hash for really releasing resources.
- * Otherwise, it might cause an one-time memory leak.
- * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::~FileInfo(), FileInfoJob::~FileInfoJob(),
- * FileEnumerator::~FileEnumerator().
- * \bug
- * Even though I try my best to make share the file info data, it seems that the info is not be shared
- * sometimes. Maybe there were some wrong in other classes?
+ * <br>
+ * The infos are sharded by the hash of their uris, every shard has its own lock,
+ * so that the ui, thumbnail and file operation threads don't wait each other.
+ * The hash tables only hold weak references, an info is alive as long as someone
+ * holds it. Besides, every shard keeps the recently used infos alive in a LRU list,
+ * so that re-entering a directory could reuse them. The LRU lists are bounded by
+ * a memory budget, the least recently used infos are evicted when it is exceeded.
+ * </br>
+ * \note You don't need remove an info from manager when releasing it any more,
+ * the expired references are cleaned automaticly.
+ * \see FileInfo, FileInfoJob, FileEnumerator; setMemoryBudget().
  */
 class PEONYCORESHARED_EXPORT FileInfoManager
 {
     friend class FileInfo;
 public:
     static FileInfoManager *getInstance();
-    std::shared_ptr<FileInfo> findFileInfoByUri(QString uri); //{return global_info_list->value(uri);}
+    std::shared_ptr<FileInfo> findFileInfoByUri(QString uri);
+    /*!
+     * \brief clear
+     * <br>
+     * Drop all the cached references and expired entries. The infos still
+     * held by others keep shared.
+     * </br>
+     */
     void clear();
+    /*!
+     * \brief remove
+     * \param uri
+     * <br>
+     * Drop the cached reference of uri, for example, when the file was deleted.
+     * The info will be released once no one holds it.
+     * </br>
+     */
     void remove(QString uri);
     void remove(std::shared_ptr<FileInfo> info);
 
+    /*!
+     * \brief lock
+     * \deprecated every method of manager is synchronized by shard locks,
+     * you don't need lock the manager for finding or inserting infos.
+     */
     void lock() {
-        m_mutex.tryLock();
+        m_mutex.lock();
     }
+    /*!
+     * \brief unlock
+     * \deprecated
+     * \see lock().
+     */
     void unlock() {
         m_mutex.unlock();
     }
 
+    /*!
+     * \brief setMemoryBudget
+     * \param bytes, estimated memory the cached infos could use.
+     */
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() {
+        return m_memory_budget;
+    }
+
+    quint64 hitCount() {
+        return m_hit_count;
+    }
+    quint64 missCount() {
+        return m_miss_count;
+    }
+    quint64 evictionCount() {
+        return m_eviction_count;
+    }
+    /*!
+     * \brief cachedMemory
+     * \return estimated bytes of the infos kept alive by LRU lists.
+     */
+    qint64 cachedMemory();
+
     void showState();
 
+    /*!
+     * \brief getStore
+     * \return the record store which keeps the attributes of all infos.
+     * \see FileInfoStore.
+     */
+    FileInfoStore *getStore() {
+        return &m_store;
+    }
+
 protected:
-    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info); //{global_info_list->insert(info->uri(), info);}
-    void removeFileInfobyUri(QString uri); //{global_info_list->remove(uri);}
+    /*!
+     * \brief insertFileInfo
+     * \param info
+     * \return the shared info. If another info of the same uri was inserted
+     * by other thread, it will be returned instead of info.
+     */
+    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info);
+    void removeFileInfobyUri(QString uri);
 
 private:
     FileInfoManager();
     ~FileInfoManager();
 
+    struct CachedInfo {
+        std::shared_ptr<FileInfo> info;
+        qint64 size;
+    };
+
+    struct Shard {
+        QMutex mutex;
+        QHash<QString, std::weak_ptr<FileInfo>> infos;
+        std::list<CachedInfo> lru;
+        QHash<QString, std::list<CachedInfo>::iterator> lru_index;
+        qint64 cached_size = 0;
+        int inserted_count = 0;
+    };
+
+    Shard *shardOf(const QString &uri);
+    /*!
+     * \brief touch
+     * move info to the front of shard's LRU list, and collect the evicted infos.
+     * \note shard must be locked.
+     */
+    void touch(Shard *shard, const std::shared_ptr<FileInfo> &info, QList<std::shared_ptr<FileInfo>> &evicted);
+    void evict(Shard *shard, QList<std::shared_ptr<FileInfo>> &evicted);
+    void removeExpired(Shard *shard);
+
+    static qint64 estimateSize(FileInfo *info);
+
+    Shard m_shards[PEONY_FILE_INFO_MANAGER_SHARD_COUNT];
+    qint64 m_memory_budget = PEONY_FILE_INFO_CACHE_MEMORY_BUDGET;
+
+    std::atomic<quint64> m_hit_count{0};
+    std::atomic<quint64> m_miss_count{0};
+    std::atomic<quint64> m_eviction_count{0};
+
     QMutex m_mutex;
+    FileInfoStore m_store;
 };
 
 }
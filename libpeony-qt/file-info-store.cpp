@@ -0,0 +1,388 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-info-store.h"
+
+#include <QSet>
+#include <QMutex>
+#include <QDateTime>
+
+#include <gio/gio.h>
+
+using namespace Peony;
+
+static QMutex global_strings_mutex;
+static QSet<QString> *global_interned_strings = nullptr;
+static QHash<QString, QString> *global_type_descriptions = nullptr;
+
+FileInfoStore::FileInfoStore()
+{
+    //record id 0 of interned strings is always empty string.
+    m_strings<<QString();
+    m_string_ids.insert(QString(), 0);
+}
+
+FileInfoStore::~FileInfoStore()
+{
+
+}
+
+int FileInfoStore::acquire(const QString &uri)
+{
+    QWriteLocker locker(&m_lock);
+    int record = findRecordLocked(uri);
+    if (record >= 0) {
+        m_ref_counts[record]++;
+        return record;
+    }
+
+    if (!m_free_records.isEmpty()) {
+        record = m_free_records.takeLast();
+        m_uris[record] = uri;
+        m_icon_ids[record] = 0;
+        m_symbolic_icon_ids[record] = 0;
+        m_mime_ids[record] = 0;
+        m_type_ids[record] = 0;
+        m_sizes[record] = 0;
+        m_modified_times[record] = 0;
+        m_access_times[record] = 0;
+        //a file of unknown access is assumed readable.
+        m_flags[record] = CanRead;
+        m_ref_counts[record] = 1;
+    } else {
+        record = m_uris.count();
+        m_uris<<uri;
+        m_display_names<<QString();
+        m_file_ids<<QString();
+        m_icon_ids<<0;
+        m_symbolic_icon_ids<<0;
+        m_mime_ids<<0;
+        m_type_ids<<0;
+        m_sizes<<0;
+        m_modified_times<<0;
+        m_access_times<<0;
+        m_flags<<CanRead;
+        m_ref_counts<<1;
+    }
+    m_record_index.insert(qHash(uri), record);
+    return record;
+}
+
+void FileInfoStore::release(int record)
+{
+    QWriteLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return;
+
+    m_ref_counts[record]--;
+    if (m_ref_counts.at(record) > 0)
+        return;
+
+    m_record_index.remove(qHash(m_uris.at(record)), record);
+    //free the string data, the slot will be reused by next record.
+    m_uris[record] = QString();
+    m_display_names[record] = QString();
+    m_file_ids[record] = QString();
+    m_free_records<<record;
+}
+
+int FileInfoStore::findRecord(const QString &uri)
+{
+    QReadLocker locker(&m_lock);
+    return findRecordLocked(uri);
+}
+
+int FileInfoStore::findRecordLocked(const QString &uri)
+{
+    //the uris of the same hash are told apart by the uri column.
+    uint hash = qHash(uri);
+    auto iter = m_record_index.constFind(hash);
+    while (iter != m_record_index.constEnd() && iter.key() == hash) {
+        if (m_uris.at(iter.value()) == uri)
+            return iter.value();
+        ++iter;
+    }
+    return -1;
+}
+
+const FileInfoStore::Record FileInfoStore::record(int record)
+{
+    Record contents;
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return contents;
+
+    contents.displayName = m_display_names.at(record);
+    contents.iconName = m_strings.at(m_icon_ids.at(record));
+    contents.symbolicIconName = m_strings.at(m_symbolic_icon_ids.at(record));
+    contents.mimeType = m_strings.at(m_mime_ids.at(record));
+    contents.fileId = m_file_ids.at(record);
+    contents.size = m_sizes.at(record);
+    contents.modifiedTime = m_modified_times.at(record);
+    contents.accessTime = m_access_times.at(record);
+    contents.flags = m_flags.at(record);
+    return contents;
+}
+
+void FileInfoStore::setRecord(int record, const Record &contents)
+{
+    QWriteLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return;
+
+    m_display_names[record] = contents.displayName;
+    m_file_ids[record] = contents.fileId;
+    m_icon_ids[record] = internStringId(contents.iconName);
+    m_symbolic_icon_ids[record] = internStringId(contents.symbolicIconName);
+    m_mime_ids[record] = internStringId(contents.mimeType);
+    m_type_ids[record] = typeDescriptionId(m_mime_ids.at(record));
+    m_sizes[record] = contents.size;
+    m_modified_times[record] = contents.modifiedTime;
+    m_access_times[record] = contents.accessTime;
+
+    quint32 flags = contents.flags & ~IsDesktopFile;
+    if ((flags & CanExecute) && m_uris.at(record).endsWith(".desktop"))
+        flags |= IsDesktopFile;
+    m_flags[record] = flags;
+}
+
+void FileInfoStore::setFlag(int record, RecordFlag flag, bool on)
+{
+    QWriteLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return;
+
+    if (on) {
+        m_flags[record] |= flag;
+    } else {
+        m_flags[record] &= ~flag;
+    }
+}
+
+const QString FileInfoStore::uri(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_uris.at(record);
+}
+
+const QString FileInfoStore::displayName(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_display_names.at(record);
+}
+
+const QString FileInfoStore::iconName(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_strings.at(m_icon_ids.at(record));
+}
+
+const QString FileInfoStore::symbolicIconName(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_strings.at(m_symbolic_icon_ids.at(record));
+}
+
+const QString FileInfoStore::mimeType(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_strings.at(m_mime_ids.at(record));
+}
+
+const QString FileInfoStore::fileId(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_file_ids.at(record);
+}
+
+quint64 FileInfoStore::size(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return 0;
+    return m_sizes.at(record);
+}
+
+quint64 FileInfoStore::modifiedTime(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return 0;
+    return m_modified_times.at(record);
+}
+
+quint64 FileInfoStore::accessTime(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return 0;
+    return m_access_times.at(record);
+}
+
+quint32 FileInfoStore::flags(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return 0;
+    return m_flags.at(record);
+}
+
+const QString FileInfoStore::fileType(int record)
+{
+    QReadLocker locker(&m_lock);
+    if (!isValidRecord(record))
+        return nullptr;
+    return m_strings.at(m_type_ids.at(record));
+}
+
+const QString FileInfoStore::fileSize(int record)
+{
+    return formatSize(size(record));
+}
+
+const QString FileInfoStore::modifiedDate(int record)
+{
+    return formatTime(modifiedTime(record));
+}
+
+const QString FileInfoStore::accessDate(int record)
+{
+    return formatTime(accessTime(record));
+}
+
+int FileInfoStore::count()
+{
+    QReadLocker locker(&m_lock);
+    return m_record_index.count();
+}
+
+qint64 FileInfoStore::memoryUsage()
+{
+    QReadLocker locker(&m_lock);
+    qint64 bytes = 0;
+    int capacity = m_uris.capacity();
+    bytes += capacity * (3 * sizeof(QString) + 5 * sizeof(quint32) + 3 * sizeof(quint64) + sizeof(int));
+    for (int i = 0; i < m_uris.count(); i++) {
+        bytes += m_uris.at(i).capacity() * sizeof(QChar);
+        bytes += m_display_names.at(i).capacity() * sizeof(QChar);
+        bytes += m_file_ids.at(i).capacity() * sizeof(QChar);
+    }
+    for (auto string : m_strings) {
+        bytes += sizeof(QString) + string.capacity() * sizeof(QChar);
+    }
+    //hash nodes of uri index, roughly key + value + next pointer + hash.
+    bytes += m_record_index.count() * (sizeof(uint) + sizeof(int) + sizeof(void *) + sizeof(uint));
+    return bytes;
+}
+
+quint32 FileInfoStore::internStringId(const QString &string)
+{
+    if (string.isEmpty())
+        return 0;
+
+    auto id = m_string_ids.value(string, 0);
+    if (id > 0)
+        return id;
+
+    id = m_strings.count();
+    m_strings<<internString(string);
+    m_string_ids.insert(m_strings.last(), id);
+    return id;
+}
+
+quint32 FileInfoStore::typeDescriptionId(quint32 mimeId)
+{
+    if (mimeId == 0)
+        return 0;
+
+    auto iter = m_type_description_ids.constFind(mimeId);
+    if (iter != m_type_description_ids.constEnd())
+        return iter.value();
+
+    //only the first record of a mime type resolves the description.
+    quint32 id = internStringId(typeDescription(m_strings.at(mimeId)));
+    m_type_description_ids.insert(mimeId, id);
+    return id;
+}
+
+const QString FileInfoStore::internString(const QString &string)
+{
+    if (string.isNull())
+        return string;
+
+    QMutexLocker locker(&global_strings_mutex);
+    if (!global_interned_strings)
+        global_interned_strings = new QSet<QString>;
+
+    auto iter = global_interned_strings->constFind(string);
+    if (iter != global_interned_strings->constEnd())
+        return *iter;
+
+    global_interned_strings->insert(string);
+    return string;
+}
+
+const QString FileInfoStore::formatSize(quint64 size)
+{
+    char *size_full = g_format_size_full(size, G_FORMAT_SIZE_DEFAULT);
+    QString fileSize = size_full;
+    g_free(size_full);
+    return fileSize;
+}
+
+const QString FileInfoStore::formatTime(quint64 time)
+{
+    QDateTime date = QDateTime::fromMSecsSinceEpoch(time*1000);
+    return date.toString(Qt::SystemLocaleShortDate);
+}
+
+const QString FileInfoStore::typeDescription(const QString &mimeType)
+{
+    if (mimeType.isEmpty())
+        return nullptr;
+
+    QMutexLocker locker(&global_strings_mutex);
+    if (!global_type_descriptions)
+        global_type_descriptions = new QHash<QString, QString>;
+
+    auto iter = global_type_descriptions->constFind(mimeType);
+    if (iter != global_type_descriptions->constEnd())
+        return iter.value();
+
+    char *content_type = g_content_type_get_description (mimeType.toUtf8().constData());
+    QString description = content_type;
+    g_free (content_type);
+    global_type_descriptions->insert(mimeType, description);
+    return description;
+}
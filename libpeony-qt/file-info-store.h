@@ -0,0 +1,231 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILEINFOSTORE_H
+#define FILEINFOSTORE_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMultiHash>
+#include <QReadWriteLock>
+
+namespace Peony {
+
+/*!
+ * \brief The FileInfoStore class
+ * <br>
+ * FileInfoStore owns the attributes of all file infos. A record is not a
+ * QObject, every attribute of records is kept in its own column (struct of
+ * arrays), so reading a record in FileItemModel::data() is an array index
+ * rather than chasing pointers of several objects. Mime types, type
+ * descriptions and icon names are interned, the boolean attributes are bits
+ * of flags, times and sizes are numbers, and the strings for display, such as
+ * size and date, are formatted only when they are asked.
+ * </br>
+ * <br>
+ * FileInfo is a handle of its record, it acquires the record of its uri when
+ * it is created and releases it when it is deleted. The accessors of FileInfo
+ * read the columns, and FileInfoJob writes a whole record at once. The infos
+ * of the same uri share one record. The index is keyed by the hash of uri.
+ * </br>
+ * \see FileInfo, FileInfoManager::getStore(), FileItemModel::data().
+ */
+class PEONYCORESHARED_EXPORT FileInfoStore
+{
+public:
+    enum RecordFlag {
+        IsDir = 1 << 0,
+        IsVolume = 1 << 1,
+        IsSymbolLink = 1 << 2,
+        IsVirtual = 1 << 3,
+        CanRead = 1 << 4,
+        CanWrite = 1 << 5,
+        CanExecute = 1 << 6,
+        IsDesktopFile = 1 << 7,
+        CanDelete = 1 << 8,
+        CanTrash = 1 << 9,
+        CanRename = 1 << 10,
+        CanMount = 1 << 11,
+        CanUnmount = 1 << 12,
+        CanEject = 1 << 13,
+        CanStart = 1 << 14,
+        CanStop = 1 << 15,
+        IsRemote = 1 << 16,
+        IsValid = 1 << 17
+    };
+
+    /*!
+     * \brief The Record struct
+     * <br>
+     * The contents of a record, it is used to read or write all the attributes
+     * of a file at once. IsDesktopFile is decided by the store.
+     * </br>
+     */
+    struct Record {
+        QString displayName;
+        QString iconName;
+        QString symbolicIconName;
+        QString mimeType;
+        QString fileId;
+        quint64 size = 0;
+        quint64 modifiedTime = 0;
+        quint64 accessTime = 0;
+        quint32 flags = CanRead;
+    };
+
+    explicit FileInfoStore();
+    ~FileInfoStore();
+
+    /*!
+     * \brief acquire
+     * \param uri
+     * \return the record id of uri, a new empty record is created if there is
+     * no record yet.
+     * \note every acquire() should be paired with a release().
+     */
+    int acquire(const QString &uri);
+    void release(int record);
+
+    int findRecord(const QString &uri);
+
+    const Record record(int record);
+    void setRecord(int record, const Record &contents);
+    void setFlag(int record, RecordFlag flag, bool on = true);
+
+    const QString uri(int record);
+    const QString displayName(int record);
+    const QString iconName(int record);
+    const QString symbolicIconName(int record);
+    const QString mimeType(int record);
+    const QString fileId(int record);
+    quint64 size(int record);
+    quint64 modifiedTime(int record);
+    quint64 accessTime(int record);
+    quint32 flags(int record);
+    bool testFlag(int record, RecordFlag flag) {
+        return flags(record) & flag;
+    }
+
+    const QString fileType(int record);
+    const QString fileSize(int record);
+    const QString modifiedDate(int record);
+    const QString accessDate(int record);
+
+    int count();
+    /*!
+     * \brief memoryUsage
+     * \return estimated bytes used by records and interned strings.
+     */
+    qint64 memoryUsage();
+
+    /*!
+     * \brief forEachRecord
+     * \param records
+     * \param from
+     * \param to
+     * \param func, called as func(i, displayName, mimeType, size, modifiedTime)
+     * for every records[i] in [from, to).
+     * <br>
+     * All the records are read under one read lock, it is used to scan lots
+     * of records in worker threads, such as filtering.
+     * </br>
+     */
+    template<typename Func>
+    void forEachRecord(const QVector<int> &records, int from, int to, Func func) {
+        QReadLocker locker(&m_lock);
+        for (int i = from; i < to; i++) {
+            int record = records.at(i);
+            if (!isValidRecord(record)) {
+                func(i, QString(), QString(), 0, 0);
+                continue;
+            }
+            func(i,
+                 m_display_names.at(record),
+                 m_strings.at(m_mime_ids.at(record)),
+                 m_sizes.at(record),
+                 m_modified_times.at(record));
+        }
+    }
+
+    /*!
+     * \brief internString
+     * \param string
+     * \return a shared copy of string, all the interned strings which are equal
+     * share the same data.
+     * \note it is used for mime types and icon names which are repeated in most files.
+     */
+    static const QString internString(const QString &string);
+    static const QString formatSize(quint64 size);
+    static const QString formatTime(quint64 time);
+    /*!
+     * \brief typeDescription
+     * \param mimeType
+     * \return the description of mime type, it is cached once generated.
+     * \note it takes a global lock, the descriptions are resolved when the
+     * infos are updated and read from FileInfo::fileType() or the records.
+     */
+    static const QString typeDescription(const QString &mimeType);
+
+private:
+    quint32 internStringId(const QString &string);
+    quint32 typeDescriptionId(quint32 mimeId);
+    int findRecordLocked(const QString &uri);
+    bool isValidRecord(int record) {
+        return record >= 0 && record < m_ref_counts.count() && m_ref_counts.at(record) > 0;
+    }
+
+    QReadWriteLock m_lock;
+
+    QMultiHash<uint, int> m_record_index;
+    QVector<int> m_free_records;
+
+    QVector<QString> m_uris;
+    QVector<QString> m_display_names;
+    QVector<QString> m_file_ids;
+    QVector<quint32> m_icon_ids;
+    QVector<quint32> m_symbolic_icon_ids;
+    QVector<quint32> m_mime_ids;
+    QVector<quint32> m_type_ids;
+    QVector<quint64> m_sizes;
+    QVector<quint64> m_modified_times;
+    QVector<quint64> m_access_times;
+    QVector<quint32> m_flags;
+    QVector<int> m_ref_counts;
+
+    QVector<QString> m_strings;
+    QHash<QString, quint32> m_string_ids;
+    /*!
+     * \brief m_type_description_ids
+     * <br>
+     * The string id of the type description of every interned mime type, indexed
+     * by the mime type's string id, so a description is resolved once per mime type.
+     * </br>
+     */
+    QHash<quint32, quint32> m_type_description_ids;
+};
+
+}
+
+#endif // FILEINFOSTORE_H
@@ -24,6 +24,7 @@
 
 #include "file-info-manager.h"
 #include "file-info-job.h"
+#include "file-info-store.h"
 #include "file-meta-info.h"
 
 #include "thumbnail-manager.h"
@@ -34,14 +35,18 @@
 
 using namespace Peony;
 
+static FileInfoStore *store()
+{
+    return FileInfoManager::getInstance()->getStore();
+}
+
 FileInfo::FileInfo(QObject *parent) : QObject (parent)
 {
-    m_cancellable = g_cancellable_new();
+
 }
 
 FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
 {
-    m_cancellable = g_cancellable_new();
     /*!
      * \note
      * In qt program we alwas handle file's uri format as unicode,
@@ -50,19 +55,16 @@ FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
      * this would help me avoid some problem, such as the uri path completion
      * bug in PathBarModel enumeration.
      */
-    m_uri = uri;
-    m_file = g_file_new_for_uri(uri.toUtf8().data());
-    m_parent = g_file_get_parent(m_file);
-    m_is_remote = !g_file_is_native(m_file);
+    setUri(uri);
     GFileType type = g_file_query_file_type(m_file, G_FILE_QUERY_INFO_NONE, nullptr);
     switch (type) {
     case G_FILE_TYPE_DIRECTORY:
         //qDebug()<<"dir";
-        m_is_dir = true;
+        setFlag(FileInfoStore::IsDir);
         break;
     case G_FILE_TYPE_MOUNTABLE:
         //qDebug()<<"mountable";
-        m_is_volume = true;
+        setFlag(FileInfoStore::IsVolume);
         break;
     default:
         break;
@@ -75,51 +77,64 @@ FileInfo::~FileInfo()
     //qDebug()<<"~FileInfo"<<m_uri;
     disconnect();
 
-    g_object_unref(m_cancellable);
-    g_object_unref(m_file);
+    if (m_file)
+        g_object_unref(m_file);
 
     if (m_target_file)
         g_object_unref(m_target_file);
-    if (m_parent)
-        g_object_unref(m_parent);
 
+    store()->release(m_record);
     m_uri = nullptr;
 }
 
+void FileInfo::setUri(const QString &uri)
+{
+    m_uri = uri;
+    m_file = g_file_new_for_uri(uri.toUtf8().constData());
+    m_record = store()->acquire(uri);
+    setFlag(FileInfoStore::IsRemote, !g_file_is_native(m_file));
+}
+
+quint32 FileInfo::flags()
+{
+    return store()->flags(m_record);
+}
+
+void FileInfo::setFlag(quint32 flag, bool on)
+{
+    store()->setFlag(m_record, FileInfoStore::RecordFlag(flag), on);
+}
+
 std::shared_ptr<FileInfo> FileInfo::fromUri(QString uri, bool addToHash)
 {
     addToHash = true;
     FileInfoManager *info_manager = FileInfoManager::getInstance();
-    info_manager->lock();
     std::shared_ptr<FileInfo> info = info_manager->findFileInfoByUri(uri);
     if (info != nullptr) {
-        info_manager->unlock();
         return info;
     } else {
         std::shared_ptr<FileInfo> newly_info = std::make_shared<FileInfo>();
 
-        newly_info->m_uri = uri;
-        newly_info->m_file = g_file_new_for_uri(uri.toUtf8().data());
+        newly_info->setUri(uri);
 
-        newly_info->m_parent = g_file_get_parent(newly_info->m_file);
-        newly_info->m_is_remote = !g_file_is_native(newly_info->m_file);
         GFileType type = g_file_query_file_type(newly_info->m_file, G_FILE_QUERY_INFO_NONE, nullptr);
         switch (type) {
         case G_FILE_TYPE_DIRECTORY:
             //qDebug()<<"dir";
-            newly_info->m_is_dir = true;
+            newly_info->setFlag(FileInfoStore::IsDir);
             break;
         case G_FILE_TYPE_MOUNTABLE:
             //qDebug()<<"mountable";
-            newly_info->m_is_volume = true;
+            newly_info->setFlag(FileInfoStore::IsVolume);
             break;
         default:
             break;
         }
+        //another thread might insert the same uri while we querying,
+        //in that case the existed one is returned.
         if (addToHash) {
             newly_info = info_manager->insertFileInfo(newly_info);
         }
-        info_manager->unlock();
         return newly_info;
     }
 }
@@ -138,6 +153,216 @@ std::shared_ptr<FileInfo> FileInfo::fromGFile(GFile *file, bool addToHash)
     return fromUri(uri, addToHash);
 }
 
+std::shared_ptr<FileInfo> FileInfo::fromGFileInfo(const QString &uri, GFileInfo *gInfo)
+{
+    FileInfoManager *info_manager = FileInfoManager::getInstance();
+    std::shared_ptr<FileInfo> info = info_manager->findFileInfoByUri(uri);
+    if (!info) {
+        //do not query file type here, gInfo will tell us.
+        info = std::make_shared<FileInfo>();
+        info->setUri(uri);
+        info = info_manager->insertFileInfo(info);
+    }
+
+    FileInfoJob::updateInfoContents(info.get(), gInfo);
+    return info;
+}
+
+bool FileInfo::isDir()
+{
+    return (flags() & FileInfoStore::IsDir) || type() == "inode/directory";
+}
+
+bool FileInfo::isVolume()
+{
+    return flags() & FileInfoStore::IsVolume;
+}
+
+bool FileInfo::isSymbolLink()
+{
+    return flags() & FileInfoStore::IsSymbolLink;
+}
+
+bool FileInfo::isVirtual()
+{
+    return flags() & FileInfoStore::IsVirtual;
+}
+
+bool FileInfo::isValid()
+{
+    return flags() & FileInfoStore::IsValid;
+}
+
+QString FileInfo::displayName()
+{
+    return store()->displayName(m_record);
+}
+
+QString FileInfo::iconName()
+{
+    return store()->iconName(m_record);
+}
+
+QString FileInfo::symbolicIconName()
+{
+    return store()->symbolicIconName(m_record);
+}
+
+QString FileInfo::fileID()
+{
+    return store()->fileId(m_record);
+}
+
+QString FileInfo::mimeType()
+{
+    return store()->mimeType(m_record);
+}
+
+QString FileInfo::fileType()
+{
+    return store()->fileType(m_record);
+}
+
+QString FileInfo::filePath()
+{
+    if (!m_file)
+        return nullptr;
+
+    char *path = g_file_get_path(m_file);
+    QString filePath = path;
+    g_free(path);
+    return filePath;
+}
+
+QString FileInfo::fileSize()
+{
+    return store()->fileSize(m_record);
+}
+
+QString FileInfo::modifiedDate()
+{
+    return store()->modifiedDate(m_record);
+}
+
+QString FileInfo::accessDate()
+{
+    return store()->accessDate(m_record);
+}
+
+QString FileInfo::type()
+{
+    return store()->mimeType(m_record);
+}
+
+quint64 FileInfo::size()
+{
+    return store()->size(m_record);
+}
+
+quint64 FileInfo::modifiedTime()
+{
+    return store()->modifiedTime(m_record);
+}
+
+quint64 FileInfo::accessTime()
+{
+    return store()->accessTime(m_record);
+}
+
+bool FileInfo::canRead()
+{
+    return flags() & FileInfoStore::CanRead;
+}
+
+bool FileInfo::canWrite()
+{
+    return flags() & FileInfoStore::CanWrite;
+}
+
+bool FileInfo::canExecute()
+{
+    return flags() & FileInfoStore::CanExecute;
+}
+
+bool FileInfo::canDelete()
+{
+    return flags() & FileInfoStore::CanDelete;
+}
+
+bool FileInfo::canTrash()
+{
+    return flags() & FileInfoStore::CanTrash;
+}
+
+bool FileInfo::canRename()
+{
+    return flags() & FileInfoStore::CanRename;
+}
+
+bool FileInfo::canMount()
+{
+    return flags() & FileInfoStore::CanMount;
+}
+
+bool FileInfo::canUnmount()
+{
+    return flags() & FileInfoStore::CanUnmount;
+}
+
+bool FileInfo::canEject()
+{
+    return flags() & FileInfoStore::CanEject;
+}
+
+bool FileInfo::canStart()
+{
+    return flags() & FileInfoStore::CanStart;
+}
+
+bool FileInfo::canStop()
+{
+    return flags() & FileInfoStore::CanStop;
+}
+
+bool FileInfo::isDesktopFile()
+{
+    return flags() & FileInfoStore::IsDesktopFile;
+}
+
+bool FileInfo::isPdfFile()
+{
+    return mimeType().contains("pdf");
+}
+
+bool FileInfo::isImageFile()
+{
+    return mimeType().startsWith("image/");
+}
+
+bool FileInfo::isEmptyInfo()
+{
+    return displayName() == nullptr;
+}
+
+FileInfo::AccessFlags FileInfo::accesses()
+{
+    quint32 recordFlags = flags();
+    auto flags = AccessFlags();
+    if (recordFlags & FileInfoStore::CanRead)
+        flags |= Readable;
+    if (recordFlags & FileInfoStore::CanWrite)
+        flags |= Writeable;
+    if (recordFlags & FileInfoStore::CanExecute)
+        flags |= Executable;
+    if (recordFlags & FileInfoStore::CanDelete)
+        flags |= Deleteable;
+    if (recordFlags & FileInfoStore::CanTrash)
+        flags |= Trashable;
+    if (recordFlags & FileInfoStore::CanRename)
+        flags |= Renameable;
+    return flags;
+}
+
 /*******
 函数功能：判断文件是否是视频文件
 一般的视频文件都是 video/*,但是有些视频文件比较特殊
@@ -151,14 +376,15 @@ h264:   application/octet-stream
 **/
 bool FileInfo::isVideoFile()
 {
-    if (nullptr != m_mime_type_string)
+    QString mimeType = this->mimeType();
+    if (nullptr != mimeType)
     {
-        if (m_mime_type_string.startsWith("video")
-            || m_mime_type_string.endsWith("vnd.trolltech.linguist")
-            || m_mime_type_string.endsWith("vnd.adobe.flash.movie")
-            || m_mime_type_string.endsWith("vnd.rn-realmedia")
-            || m_mime_type_string.endsWith("vnd.ms-asf")
-            || m_mime_type_string.endsWith("octet-stream"))
+        if (mimeType.startsWith("video")
+            || mimeType.endsWith("vnd.trolltech.linguist")
+            || mimeType.endsWith("vnd.adobe.flash.movie")
+            || mimeType.endsWith("vnd.rn-realmedia")
+            || mimeType.endsWith("vnd.ms-asf")
+            || mimeType.endsWith("octet-stream"))
         {
             return true;
         }
@@ -178,11 +404,12 @@ bool FileInfo::isOfficeFile()
 {
     int idx = 0;
     QString mtype = nullptr;
+    QString mimeType = this->mimeType();
 
     for (idx = 0; office_mime_types[idx] != "end"; idx++)
     {
         mtype = office_mime_types[idx];
-        if (m_mime_type_string.contains(mtype))
+        if (mimeType.contains(mtype))
         {
             return true;
         }
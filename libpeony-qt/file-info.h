@@ -98,6 +98,11 @@ static char *office_mime_types[] = {
  * and FileInfoJob need hold a shared_ptr reference, too.
  * This will help to reduce the risk of memory leaks.
  * </br>
+ * <br>
+ * FileInfo is a thin handle, the attributes of file are kept in its record of
+ * FileInfoStore and updated by FileInfoJob.
+ * </br>
+ * \see FileInfoStore.
  */
 class PEONYCORESHARED_EXPORT FileInfo : public QObject
 {
@@ -143,158 +148,90 @@ public:
      * \deprecated
      */
     static std::shared_ptr<FileInfo> fromGFile(GFile *file, bool addToHash = true);
+    /*!
+     * \brief fromGFileInfo
+     * \param uri
+     * \param gInfo, a GFileInfo holding the attributes FileInfoJob queries,
+     * for example, one enumerated by FileEnumerator.
+     * \return the shared info, whose contents are filled with gInfo.
+     * \note This method does not query the file system for the attributes, they
+     * are all read from gInfo. The exception is a .desktop file, whose localized
+     * name is read from the desktop entry with g_desktop_app_info_new_from_filename(),
+     * the same as FileInfoJob does. The desktop entries are small local files,
+     * but it is still i/o in the calling thread.
+     */
+    static std::shared_ptr<FileInfo> fromGFileInfo(const QString &uri, GFileInfo *gInfo);
 
     QString uri() {
         return m_uri;
     }
-    bool isDir() {
-        return m_is_dir || m_content_type == "inode/directory";
-    }
-    bool isVolume() {
-        return m_is_volume;
-    }
-    bool isSymbolLink() {
-        return m_is_symbol_link;
-    }
-    bool isVirtual() {
-        return m_is_virtual;
-    }
-    bool isValid()
-    {
-        return m_is_valid;
-    }
-
-    QString displayName() {
-        return m_display_name;
-    }
-    QString iconName() {
-        return m_icon_name;
-    }
-    QString symbolicIconName() {
-        return m_symbolic_icon_name;
-    }
-    QString fileID() {
-        return m_file_id;
-    }
-    QString mimeType() {
-        return m_mime_type_string;
-    }
-    QString fileType() {
-        return m_file_type;
-    }
+    /*!
+     * \brief record
+     * \return the record of this info in FileInfoStore, or -1 if the info has
+     * no uri.
+     * \note the attributes of file are kept in the record, the accessors below
+     * read them from the store.
+     */
+    int record() {
+        return m_record;
+    }
+    bool isDir();
+    bool isVolume();
+    bool isSymbolLink();
+    bool isVirtual();
+    bool isValid();
+
+    QString displayName();
+    QString iconName();
+    QString symbolicIconName();
+    QString fileID();
+    QString mimeType();
+    /*!
+     * \brief fileType
+     * \return description of the file's mime type.
+     * \note formatted strings, such as type, size and dates, are not kept in info,
+     * they are generated when asked.
+     */
+    QString fileType();
 
-    QString filePath() {
-        return m_path;
-    }
+    QString filePath();
 
-    QString fileSize() {
-        return m_file_size;
-    }
-    QString modifiedDate() {
-        return m_modified_date;
-    }
-    QString accessDate() {
-        return m_access_date;
-    }
+    QString fileSize();
+    QString modifiedDate();
+    QString accessDate();
 
-    QString type() {
-        return m_content_type;
-    }
-    quint64 size() {
-        return m_size;
-    }
-    quint64 modifiedTime() {
-        return m_modified_time;
-    }
-    quint64 accessTime() {
-        return m_access_time;
-    }
+    QString type();
+    quint64 size();
+    quint64 modifiedTime();
+    quint64 accessTime();
 
     QList<QColor> getColors() {
         return m_colors;
     }
 
-    bool canRead() {
-        return m_can_read;
-    }
-    bool canWrite() {
-        return m_can_write;
-    }
-    bool canExecute() {
-        return m_can_excute;
-    }
-    bool canDelete() {
-        return m_can_delete;
-    }
-    bool canTrash() {
-        return m_can_trash;
-    }
-    bool canRename() {
-        return m_can_rename;
-    }
-
-    bool canMount() {
-        return m_can_mount;
-    }
-    bool canUnmount() {
-        return m_can_unmount;
-    }
-    bool canEject() {
-        return m_can_eject;
-    }
-    bool canStart() {
-        return m_can_start;
-    }
-    bool canStop() {
-        return m_can_stop;
-    }
-
-    bool isDesktopFile() {
-        return m_can_excute && m_uri.endsWith(".desktop");
-    }
+    bool canRead();
+    bool canWrite();
+    bool canExecute();
+    bool canDelete();
+    bool canTrash();
+    bool canRename();
 
-    bool isPdfFile(){
-        return m_mime_type_string.contains("pdf");
+    bool canMount();
+    bool canUnmount();
+    bool canEject();
+    bool canStart();
+    bool canStop();
 
-    }
-
-    bool isImageFile(){
-        return m_mime_type_string.startsWith("image/");
-    }
+    bool isDesktopFile();
 
+    bool isPdfFile();
+    bool isImageFile();
     bool isVideoFile();
     bool isOfficeFile();
 
-    bool isEmptyInfo() {
-        return m_display_name == nullptr;
-    }
+    bool isEmptyInfo();
 
-    AccessFlags accesses() {
-        auto flags = AccessFlags();
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 7, 0))
-        flags.setFlag(Readable, m_can_read);
-        flags.setFlag(Writeable, m_can_write);
-        flags.setFlag(Executable, m_can_excute);
-        flags.setFlag(Deleteable, m_can_delete);
-        flags.setFlag(Trashable, m_can_trash);
-        flags.setFlag(Renameable, m_can_rename);
-        return flags;
-#else
-        flags = 0;
-        if (m_can_read)
-            flags |= Readable;
-        if (m_can_write)
-            flags |= Writeable;
-        if (m_can_excute)
-            flags |= Executable;
-        if (m_can_delete)
-            flags |= Deleteable;
-        if (m_can_trash)
-            flags |= Trashable;
-        if (m_can_rename)
-            flags |= Renameable;
-#endif
-    }
+    AccessFlags accesses();
 
     GFile *gFileHandle() {
         return m_file;
@@ -307,64 +244,25 @@ Q_SIGNALS:
     void updated();
 
 private:
-    QString m_uri = nullptr;
-    bool m_is_valid = false;
-    bool m_is_dir = false;
-    bool m_is_volume = false;
-    bool m_is_remote = false;
-    bool m_is_symbol_link = false;
-    bool m_is_virtual = false;
-
-    bool m_is_loaded = false;
-
-    QString m_display_name = nullptr;
-    QString m_icon_name = nullptr;
-    QString m_symbolic_icon_name = nullptr;
-    QString m_file_id = nullptr;
-    QString m_path = nullptr;
-    QString m_content_type = nullptr;
-    guint64 m_size = 0;
-    guint64 m_modified_time = 0;
-    guint64 m_access_time = 0;
-
     /*!
-     * \deprecated
-     * \brief m_mime_type_string
-     * \see m_content_type
+     * \brief setUri
+     * \param uri
+     * <br>
+     * Set the uri of an empty info and acquire its record in FileInfoStore.
+     * </br>
      */
-    QString m_mime_type_string = nullptr;
-    QString m_file_type = nullptr;
-    QString m_file_size = nullptr;
-    QString m_modified_date = nullptr;
-    QString m_access_date = nullptr;
-
-    //access
-    bool m_can_read = true;
-    bool m_can_write = false;
-    bool m_can_excute = false;
-    bool m_can_delete = false;
-    bool m_can_trash = false;
-    bool m_can_rename = false;
-
-    bool m_can_mount = false;
-    bool m_can_unmount = false;
-    bool m_can_eject = false;
-
-    bool m_can_start = false;
-    bool m_can_stop = false;
+    void setUri(const QString &uri);
+    quint32 flags();
+    void setFlag(quint32 flag, bool on = true);
+
+    QString m_uri = nullptr;
+    int m_record = -1;
 
     //FIXME: should i use smart pointer wrap these data?
     GFile *m_file = nullptr;
-    GFile *m_parent = nullptr;
 
     GFile *m_target_file = nullptr;
 
-    /*!
-     * \brief m_cancellable
-     * This cancellable is used in async query file info in FileInfoJob instance.
-     */
-    GCancellable *m_cancellable = nullptr;
-
     //QIcon m_thumbnail;
     std::shared_ptr<FileMetaInfo> m_meta_info = nullptr;
 
@@ -0,0 +1,311 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-meta-info-writer.h"
+
+#include <QTimer>
+#include <QCoreApplication>
+#include <QDebug>
+
+//the queue is flushed after it has been idle for a while.
+#ifndef PEONY_META_INFO_FLUSH_DELAY
+#define PEONY_META_INFO_FLUSH_DELAY 300
+#endif
+
+//do not wait for idle if there are too many pending attributes.
+#ifndef PEONY_META_INFO_MAX_PENDING
+#define PEONY_META_INFO_MAX_PENDING 1000
+#endif
+
+using namespace Peony;
+
+/*!
+ * \brief The InFlightWrite struct
+ * <br>
+ * the user data of an async write, the attributes are kept in writer until the
+ * write finished.
+ * </br>
+ */
+struct Peony::InFlightWrite {
+    FileMetaInfoWriter *writer;
+    QString uri;
+    quint64 id;
+};
+
+FileMetaInfoWriter *FileMetaInfoWriter::getInstance()
+{
+    //the writer is used by job threads too, the initialization of a local static
+    //is thread safe.
+    static FileMetaInfoWriter *global_instance = new FileMetaInfoWriter;
+    return global_instance;
+}
+
+FileMetaInfoWriter::FileMetaInfoWriter(QObject *parent) : QObject(parent)
+{
+    m_cancellable = g_cancellable_new();
+
+    m_flush_timer = new QTimer(this);
+    m_flush_timer->setSingleShot(true);
+    m_flush_timer->setInterval(PEONY_META_INFO_FLUSH_DELAY);
+    connect(m_flush_timer, &QTimer::timeout, this, &FileMetaInfoWriter::flush);
+
+    if (qApp) {
+        //the writer might be created in a job thread at first time.
+        moveToThread(qApp->thread());
+        connect(qApp, &QCoreApplication::aboutToQuit, this, &FileMetaInfoWriter::flushSync, Qt::DirectConnection);
+    }
+}
+
+FileMetaInfoWriter::~FileMetaInfoWriter()
+{
+    flushSync();
+    g_object_unref(m_cancellable);
+}
+
+void FileMetaInfoWriter::setAttribute(const QString &uri, const QString &key, const QString &value)
+{
+    m_mutex.lock();
+    auto &attributes = m_pending_attributes[uri];
+    if (!attributes.contains(key))
+        m_pending_count++;
+    //repeated writes only keep the last value.
+    attributes.insert(key, value.isNull()? QString(""): value);
+    int pendingCount = m_pending_count;
+    m_mutex.unlock();
+
+    if (pendingCount >= PEONY_META_INFO_MAX_PENDING) {
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    } else {
+        scheduleFlush();
+    }
+}
+
+void FileMetaInfoWriter::removeAttribute(const QString &uri, const QString &key)
+{
+    m_mutex.lock();
+    auto &attributes = m_pending_attributes[uri];
+    if (!attributes.contains(key))
+        m_pending_count++;
+    //null string means removing.
+    attributes.insert(key, QString());
+    m_mutex.unlock();
+
+    scheduleFlush();
+}
+
+const QHash<QString, QString> FileMetaInfoWriter::pendingAttributes(const QString &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    //the writes in flight are applied in order, then the queued attributes.
+    QHash<QString, QString> attributes;
+    for (auto write : m_in_flight_attributes.value(uri)) {
+        for (auto iter = write.second.constBegin(); iter != write.second.constEnd(); ++iter) {
+            attributes.insert(iter.key(), iter.value());
+        }
+    }
+    auto queued = m_pending_attributes.value(uri);
+    for (auto iter = queued.constBegin(); iter != queued.constEnd(); ++iter) {
+        attributes.insert(iter.key(), iter.value());
+    }
+    return attributes;
+}
+
+int FileMetaInfoWriter::pendingCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending_count;
+}
+
+void FileMetaInfoWriter::flush()
+{
+    m_flush_timer->stop();
+
+    //the attributes are moved to the in flight writes, so that pendingAttributes()
+    //still has them until gvfsd-metadata stored them.
+    QList<QPair<InFlightWrite *, QHash<QString, QString>>> writes;
+    m_mutex.lock();
+    for (auto iter = m_pending_attributes.constBegin(); iter != m_pending_attributes.constEnd(); ++iter) {
+        auto write = new InFlightWrite;
+        write->writer = this;
+        write->uri = iter.key();
+        write->id = ++m_last_write_id;
+        m_in_flight_attributes[iter.key()]<<qMakePair(write->id, iter.value());
+        writes<<qMakePair(write, iter.value());
+    }
+    m_pending_attributes.clear();
+    m_pending_count = 0;
+    m_mutex.unlock();
+
+    for (auto pair : writes) {
+        auto write = pair.first;
+        GFile *file = g_file_new_for_uri(write->uri.toUtf8().constData());
+        GFileInfo *info = createFileInfo(pair.second);
+        g_file_set_attributes_async(file,
+                                    info,
+                                    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                    G_PRIORITY_LOW,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(set_attributes_callback),
+                                    write);
+        g_object_unref(info);
+        g_object_unref(file);
+    }
+}
+
+/*!
+ * \brief FileMetaInfoWriter::flushSync
+ * <br>
+ * The async writes are finished in the main loop, which will not run again at
+ * shutdown. They are cancelled and their attributes are written here with the
+ * queued ones, so every attribute set before is stored when this returns.
+ * Writing an attribute which has been stored again is harmless.
+ * </br>
+ */
+void FileMetaInfoWriter::flushSync()
+{
+    m_flush_timer->stop();
+    g_cancellable_cancel(m_cancellable);
+
+    m_mutex.lock();
+    QHash<QString, QHash<QString, QString>> pendingAttributes;
+    for (auto iter = m_in_flight_attributes.constBegin(); iter != m_in_flight_attributes.constEnd(); ++iter) {
+        auto &attributes = pendingAttributes[iter.key()];
+        for (auto write : iter.value()) {
+            for (auto attr = write.second.constBegin(); attr != write.second.constEnd(); ++attr) {
+                attributes.insert(attr.key(), attr.value());
+            }
+        }
+    }
+    m_in_flight_attributes.clear();
+    m_mutex.unlock();
+
+    //the queued attributes are newer.
+    auto queuedAttributes = takePendingAttributes();
+    for (auto iter = queuedAttributes.constBegin(); iter != queuedAttributes.constEnd(); ++iter) {
+        auto &attributes = pendingAttributes[iter.key()];
+        for (auto attr = iter.value().constBegin(); attr != iter.value().constEnd(); ++attr) {
+            attributes.insert(attr.key(), attr.value());
+        }
+    }
+
+    for (auto iter = pendingAttributes.constBegin(); iter != pendingAttributes.constEnd(); ++iter) {
+        GFile *file = g_file_new_for_uri(iter.key().toUtf8().constData());
+        GFileInfo *info = createFileInfo(iter.value());
+        GError *err = nullptr;
+        if (g_file_set_attributes_from_info(file, info, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, &err)) {
+            m_flushed_count += iter.value().count();
+        } else {
+            m_failed_count += iter.value().count();
+        }
+        if (err) {
+            qDebug()<<err->message;
+            g_error_free(err);
+        }
+        g_object_unref(info);
+        g_object_unref(file);
+    }
+}
+
+const QHash<QString, QHash<QString, QString>> FileMetaInfoWriter::takePendingAttributes()
+{
+    QMutexLocker locker(&m_mutex);
+    auto pendingAttributes = m_pending_attributes;
+    m_pending_attributes.clear();
+    m_pending_count = 0;
+    return pendingAttributes;
+}
+
+void FileMetaInfoWriter::scheduleFlush()
+{
+    //restart the timer in its thread, the writes might come from other threads.
+    QMetaObject::invokeMethod(m_flush_timer, "start", Qt::QueuedConnection);
+}
+
+GFileInfo *FileMetaInfoWriter::createFileInfo(const QHash<QString, QString> &attributes)
+{
+    GFileInfo *info = g_file_info_new();
+    for (auto iter = attributes.constBegin(); iter != attributes.constEnd(); ++iter) {
+        auto key = iter.key().toUtf8();
+        if (iter.value().isNull()) {
+            //an invalid attribute unsets the metadata.
+            g_file_info_set_attribute(info, key.constData(), G_FILE_ATTRIBUTE_TYPE_INVALID, nullptr);
+        } else {
+            g_file_info_set_attribute_string(info, key.constData(), iter.value().toUtf8().constData());
+        }
+    }
+    return info;
+}
+
+void FileMetaInfoWriter::set_attributes_callback(GObject *source, GAsyncResult *res, InFlightWrite *write)
+{
+    auto p_this = write->writer;
+    GFileInfo *info = nullptr;
+    GError *err = nullptr;
+    bool successed = g_file_set_attributes_finish(G_FILE(source), res, &info, &err);
+
+    //stop overlaying the attributes of this write, the newer ones are kept.
+    p_this->m_mutex.lock();
+    auto iter = p_this->m_in_flight_attributes.find(write->uri);
+    if (iter != p_this->m_in_flight_attributes.end()) {
+        auto &writes = iter.value();
+        for (int i = 0; i < writes.count(); i++) {
+            if (writes.at(i).first == write->id) {
+                writes.removeAt(i);
+                break;
+            }
+        }
+        if (writes.isEmpty())
+            p_this->m_in_flight_attributes.erase(iter);
+    }
+    p_this->m_mutex.unlock();
+    delete write;
+
+    //cancelled by flushSync(), which writes the attributes again.
+    if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_error_free(err);
+        if (info)
+            g_object_unref(info);
+        return;
+    }
+
+    int count = 0;
+    if (info) {
+        char **attributes = g_file_info_list_attributes(info, nullptr);
+        if (attributes) {
+            count = g_strv_length(attributes);
+            g_strfreev(attributes);
+        }
+        g_object_unref(info);
+    }
+
+    if (successed) {
+        p_this->m_flushed_count += count;
+    } else {
+        p_this->m_failed_count += count;
+    }
+
+    if (err) {
+        qDebug()<<err->message;
+        g_error_free(err);
+    }
+}
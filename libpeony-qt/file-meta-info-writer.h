@@ -0,0 +1,146 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEMETAINFOWRITER_H
+#define FILEMETAINFOWRITER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include <gio/gio.h>
+#include <peony-core_global.h>
+
+class QTimer;
+
+namespace Peony {
+
+struct InFlightWrite;
+
+/*!
+ * \brief The FileMetaInfoWriter class
+ * <br>
+ * FileMetaInfoWriter is the write-behind queue of gvfs metadata. Writing a
+ * metadata attribute is a d-bus round trip to gvfsd-metadata, so
+ * FileMetaInfo does not write it directly. The attributes are queued here,
+ * repeated writes of the same key only keep the last value, and all the
+ * pending attributes of a file are written with one
+ * g_file_set_attributes_async() once the queue is idle.
+ * </br>
+ * <br>
+ * The attributes of a write are kept until its callback, so that a query
+ * during the write still sees them. The queue and the writes in flight are
+ * flushed synchronously before application quits.
+ * </br>
+ * \note the methods are thread safe, the async writes are started in the
+ * thread of the writer (ui thread).
+ */
+class PEONYCORESHARED_EXPORT FileMetaInfoWriter : public QObject
+{
+    Q_OBJECT
+public:
+    static FileMetaInfoWriter *getInstance();
+
+    /*!
+     * \brief setAttribute
+     * \param uri
+     * \param key, the full attribute name, such as "metadata::xxx".
+     * \param value
+     */
+    void setAttribute(const QString &uri, const QString &key, const QString &value);
+    void removeAttribute(const QString &uri, const QString &key);
+
+    /*!
+     * \brief pendingAttributes
+     * \param uri
+     * \return the attributes of uri not written yet, including the writes in
+     * flight, a null string means the attribute will be removed.
+     * <br>
+     * A FileMetaInfo queried before the queue flushed has old values, it uses
+     * this to keep the values have been set.
+     * </br>
+     */
+    const QHash<QString, QString> pendingAttributes(const QString &uri);
+
+    int pendingCount();
+    int flushedCount() {
+        return m_flushed_count.load();
+    }
+    int failedCount() {
+        return m_failed_count.load();
+    }
+
+public Q_SLOTS:
+    /*!
+     * \brief flush
+     * <br>
+     * Start async writes of all pending attributes.
+     * </br>
+     */
+    void flush();
+    /*!
+     * \brief flushSync
+     * <br>
+     * Write all pending attributes and the writes in flight, and wait them
+     * finished, used at shutdown.
+     * </br>
+     */
+    void flushSync();
+
+private:
+    explicit FileMetaInfoWriter(QObject *parent = nullptr);
+    ~FileMetaInfoWriter();
+
+    const QHash<QString, QHash<QString, QString>> takePendingAttributes();
+    void scheduleFlush();
+
+    static GFileInfo *createFileInfo(const QHash<QString, QString> &attributes);
+    static void set_attributes_callback(GObject *source, GAsyncResult *res, InFlightWrite *write);
+
+    QMutex m_mutex;
+    QHash<QString, QHash<QString, QString>> m_pending_attributes;
+    int m_pending_count = 0;
+
+    /*!
+     * \brief m_in_flight_attributes
+     * <br>
+     * the attributes of started async writes keyed by uri, in the order they
+     * were started, with the id of each write.
+     * </br>
+     */
+    QHash<QString, QList<QPair<quint64, QHash<QString, QString>>>> m_in_flight_attributes;
+    quint64 m_last_write_id = 0;
+    GCancellable *m_cancellable = nullptr;
+
+    QTimer *m_flush_timer = nullptr;
+
+    QAtomicInt m_flushed_count;
+    QAtomicInt m_failed_count;
+};
+
+}
+
+#endif // FILEMETAINFOWRITER_H
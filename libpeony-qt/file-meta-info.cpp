@@ -22,6 +22,7 @@
 
 #include "file-meta-info.h"
 #include "file-info-manager.h"
+#include "file-meta-info-writer.h"
 
 #include <QDebug>
 
@@ -51,7 +52,7 @@ FileMetaInfo::FileMetaInfo(const QString &uri, GFileInfo *g_info)
                 char *string = g_file_info_get_attribute_as_string(g_info, metainfo_attributes[i]);
                 if (string) {
                     auto var = QVariant(string);
-                    this->setMetaInfoVariant(metainfo_attributes[i], var);
+                    m_meta_hash.insert(metainfo_attributes[i], var);
                     //qDebug()<<"======"<<m_uri<<metainfo_attributes[i]<<var.toString();
                     g_free(string);
                 }
@@ -59,6 +60,16 @@ FileMetaInfo::FileMetaInfo(const QString &uri, GFileInfo *g_info)
             g_strfreev(metainfo_attributes);
         }
     }
+
+    //the attributes set but not written yet are newer than the queried.
+    auto pendingAttributes = FileMetaInfoWriter::getInstance()->pendingAttributes(m_uri);
+    for (auto iter = pendingAttributes.constBegin(); iter != pendingAttributes.constEnd(); ++iter) {
+        if (iter.value().isNull()) {
+            m_meta_hash.remove(iter.key());
+        } else {
+            m_meta_hash.insert(iter.key(), iter.value());
+        }
+    }
 }
 
 void FileMetaInfo::setMetaInfoInt(const QString &key, int value)
@@ -87,32 +98,15 @@ void FileMetaInfo::setMetaInfoVariant(const QString &key, const QVariant &value)
     if (!key.startsWith("metadata::"))
         realKey = "metadata::" + key;
 
+    //do not write the metadata which is not changed.
+    auto oldValue = m_meta_hash.value(realKey);
+    if (oldValue.isValid() && oldValue.toString() == value.toString())
+        return;
+
     m_meta_hash.remove(realKey);
     m_meta_hash.insert(realKey, value);
-    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
-    GFileInfo *info = g_file_info_new();
-    std::string tmp = realKey.toStdString();
-    auto data = value.toString().toUtf8().data();
-    g_file_info_set_attribute(info, tmp.c_str(), G_FILE_ATTRIBUTE_TYPE_STRING, (gpointer)data);
-    //FIXME: should i add callback?
-//    g_file_set_attributes_async(file,
-//                                info,
-//                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-//                                0,
-//                                nullptr,
-//                                nullptr,
-//                                nullptr);
-    //qDebug()<<tmp.c_str()<<value;
-    GError *err = nullptr;
-    g_file_set_attribute(file, tmp.c_str(), G_FILE_ATTRIBUTE_TYPE_STRING, (gpointer)data,
-                         G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, &err);
-
-    if (err) {
-        qDebug()<<err->message;
-        g_error_free(err);
-    }
-    g_object_unref(info);
-    g_object_unref(file);
+    //writing metadata is a d-bus call, it is queued and written when idle.
+    FileMetaInfoWriter::getInstance()->setAttribute(m_uri, realKey, value.toString());
 //    m_mutex.unlock();
 }
 
@@ -152,27 +146,6 @@ void FileMetaInfo::removeMetaInfo(const QString &key)
     if (!key.startsWith("metadata::"))
         realKey = "metadata::" + key;
     m_meta_hash.remove(realKey);
-    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
-    g_file_set_attribute(file,
-                         realKey.toUtf8().constData(),
-                         G_FILE_ATTRIBUTE_TYPE_INVALID,
-                         nullptr,
-                         G_FILE_QUERY_INFO_NONE,
-                         nullptr,
-                         nullptr);
-//    GFileInfo *info = g_file_info_new();
-//    std::string tmp = realKey.toStdString();
-//    //g_file_info_set_attribute(info, realKey.toUtf8(), G_FILE_ATTRIBUTE_TYPE_INVALID, nullptr);
-//    g_file_info_remove_attribute(info, realKey.toUtf8());
-//    //FIXME: should i add callback?
-//    g_file_set_attributes_async(file,
-//                                info,
-//                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-//                                0,
-//                                nullptr,
-//                                nullptr,
-//                                nullptr);
-//    g_object_unref(info);
-    g_object_unref(file);
+    FileMetaInfoWriter::getInstance()->removeAttribute(m_uri, realKey);
 //    m_mutex.unlock();
 }
@@ -0,0 +1,134 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-monitor-registry.h"
+
+#include <QDebug>
+
+using namespace Peony;
+
+static FileMonitorRegistry *global_instance = nullptr;
+
+FileMonitorRegistry *FileMonitorRegistry::getInstance()
+{
+    if (!global_instance)
+        global_instance = new FileMonitorRegistry;
+    return global_instance;
+}
+
+GFileMonitor *FileMonitorRegistry::acquire(GFile *file, MonitorType type, GError **error)
+{
+    if (!file)
+        return nullptr;
+
+    char *uri = g_file_get_uri(file);
+    MonitorKey key(uri, type);
+    g_free(uri);
+
+    QMutexLocker locker(&m_mutex);
+    auto it = m_monitors.find(key);
+    if (it != m_monitors.end()) {
+        it->subscribers++;
+        return it->monitor;
+    }
+
+    GFileMonitor *monitor = nullptr;
+    if (type == FileMonitor) {
+        monitor = g_file_monitor_file(file, G_FILE_MONITOR_WATCH_MOVES, nullptr, error);
+    } else {
+        monitor = g_file_monitor_directory(file, G_FILE_MONITOR_NONE, nullptr, error);
+    }
+
+    //failed monitors are not cached, the file might support monitoring later
+    //(for example, a remote directory is mounted).
+    if (!monitor)
+        return nullptr;
+
+    MonitorEntry entry;
+    entry.monitor = monitor;
+    entry.subscribers = 1;
+    m_monitors.insert(key, entry);
+    m_keys.insert(monitor, key);
+    return monitor;
+}
+
+void FileMonitorRegistry::release(GFileMonitor *monitor)
+{
+    if (!monitor)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    auto key = m_keys.value(monitor);
+    auto it = m_monitors.find(key);
+    if (it == m_monitors.end() || it->monitor != monitor) {
+        qWarning()<<"release a monitor not acquired from registry";
+        return;
+    }
+
+    it->subscribers--;
+    if (it->subscribers > 0)
+        return;
+
+    m_monitors.erase(it);
+    m_keys.remove(monitor);
+    g_file_monitor_cancel(monitor);
+    g_object_unref(monitor);
+}
+
+int FileMonitorRegistry::activeMonitorCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_monitors.count();
+}
+
+int FileMonitorRegistry::subscriberCount(const QString &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_monitors.value(MonitorKey(uri, FileMonitor)).subscribers
+            + m_monitors.value(MonitorKey(uri, DirectoryMonitor)).subscribers;
+}
+
+QList<FileMonitorRegistry::MonitorDiagnostics> FileMonitorRegistry::diagnostics()
+{
+    QList<MonitorDiagnostics> l;
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_monitors.constBegin(); it != m_monitors.constEnd(); it++) {
+        MonitorDiagnostics d;
+        d.uri = it.key().first;
+        d.type = MonitorType(it.key().second);
+        d.subscribers = it->subscribers;
+        l<<d;
+    }
+    return l;
+}
+
+void FileMonitorRegistry::printDiagnostics()
+{
+    auto l = diagnostics();
+    int subscribers = 0;
+    for (auto d : l) {
+        subscribers += d.subscribers;
+        qDebug()<<(d.type == FileMonitor? "file monitor": "directory monitor")<<d.uri<<"subscribers:"<<d.subscribers;
+    }
+    qDebug()<<"active monitors:"<<l.count()<<"subscribers:"<<subscribers;
+}
@@ -0,0 +1,106 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEMONITORREGISTRY_H
+#define FILEMONITORREGISTRY_H
+
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QList>
+
+#include <gio/gio.h>
+#include "peony-core_global.h"
+
+namespace Peony {
+
+/*!
+ * \brief The FileMonitorRegistry class
+ * <br>
+ * FileMonitorRegistry shares GFileMonitor handles between FileWatchers.
+ * Every opened tab, the desktop and the side bar watch the same directories
+ * again and again, and each GFileMonitor costs an inotify watch and dispatches
+ * the same events once more. The registry keeps one monitor for a uri and a
+ * monitor type, and counts its subscribers. The subscribers connect their own
+ * handlers to the shared monitor, so that the events are multiplexed by gobject
+ * signal emission, and the monitor is cancelled when the last subscriber
+ * released it.
+ * </br>
+ * \note the returned monitor is owned by registry, do not unref it, use
+ * release() instead.
+ */
+class PEONYCORESHARED_EXPORT FileMonitorRegistry
+{
+public:
+    enum MonitorType {
+        FileMonitor,
+        DirectoryMonitor
+    };
+
+    struct MonitorDiagnostics {
+        QString uri;
+        MonitorType type;
+        int subscribers;
+    };
+
+    static FileMonitorRegistry *getInstance();
+
+    /*!
+     * \brief acquire
+     * \param file
+     * \param type, FileMonitor watches moves of the file itself,
+     * DirectoryMonitor watches its children.
+     * \param error
+     * \return a shared monitor of file, or nullptr if the file doesn't support
+     * monitoring.
+     */
+    GFileMonitor *acquire(GFile *file, MonitorType type, GError **error = nullptr);
+    void release(GFileMonitor *monitor);
+
+    int activeMonitorCount();
+    int subscriberCount(const QString &uri);
+    /*!
+     * \brief diagnostics
+     * \return all the active monitors and their subscriber counts.
+     * \see printDiagnostics().
+     */
+    QList<MonitorDiagnostics> diagnostics();
+    void printDiagnostics();
+
+private:
+    explicit FileMonitorRegistry() {}
+
+    typedef QPair<QString, int> MonitorKey;
+    struct MonitorEntry {
+        GFileMonitor *monitor = nullptr;
+        int subscribers = 0;
+    };
+
+    QMutex m_mutex;
+    QHash<MonitorKey, MonitorEntry> m_monitors;
+    QHash<GFileMonitor *, MonitorKey> m_keys;
+};
+
+}
+
+#endif // FILEMONITORREGISTRY_H
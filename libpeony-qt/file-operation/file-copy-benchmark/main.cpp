@@ -0,0 +1,189 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * This benchmark measures the throughput of copying a tree of local files.
+ *
+ * Two data sets are generated in the work directory: one large file and many
+ * small files. Each set is copied by FileCopyOperation, which uses the kernel
+ * copy and the concurrent small file copying, and the --gio mode copies them
+ * file by file with g_file_copy() like the operation did before. The page cache
+ * is flushed before each copy and the time includes syncing the copied data.
+ *
+ * usage: file-copy-benchmark [--gio] [--large-mb 10240] [--small-count 100000] [--small-kb 4] work-dir
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+#include <QDebug>
+
+#include <unistd.h>
+#include <gio/gio.h>
+
+#include <file-copy-operation.h>
+
+static void generate_file(const QString &path, qint64 size)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    static QByteArray block;
+    if (block.isEmpty()) {
+        block.resize(1024 * 1024);
+        for (int i = 0; i < block.size(); i++) {
+            block[i] = char(qrand());
+        }
+    }
+
+    qint64 written = 0;
+    while (written < size) {
+        qint64 len = qMin(qint64(block.size()), size - written);
+        file.write(block.constData(), len);
+        written += len;
+    }
+}
+
+static void gio_copy_recursively(GFile *src, GFile *dest)
+{
+    if (g_file_query_file_type(src, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr) != G_FILE_TYPE_DIRECTORY) {
+        g_file_copy(src, dest, GFileCopyFlags(G_FILE_COPY_NOFOLLOW_SYMLINKS | G_FILE_COPY_ALL_METADATA),
+                    nullptr, nullptr, nullptr, nullptr);
+        return;
+    }
+
+    g_file_make_directory(dest, nullptr, nullptr);
+    GFileEnumerator *e = g_file_enumerate_children(src, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                                   G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
+    if (!e)
+        return;
+
+    GFileInfo *info = nullptr;
+    while ((info = g_file_enumerator_next_file(e, nullptr, nullptr))) {
+        GFile *child = g_file_enumerator_get_child(e, info);
+        GFile *destChild = g_file_get_child(dest, g_file_info_get_name(info));
+        gio_copy_recursively(child, destChild);
+        g_object_unref(destChild);
+        g_object_unref(child);
+        g_object_unref(info);
+    }
+    g_file_enumerator_close(e, nullptr, nullptr);
+    g_object_unref(e);
+}
+
+static void drop_caches()
+{
+    sync();
+    QFile dropCaches("/proc/sys/vm/drop_caches");
+    if (dropCaches.open(QIODevice::WriteOnly)) {
+        dropCaches.write("3");
+    } else {
+        qInfo()<<"can not drop page cache, run as root for cold cache results";
+    }
+}
+
+static void benchmark(const QString &name, const QString &srcDir, qint64 totalSize, int fileCount, const QString &workDir, bool gio)
+{
+    QString destDir = workDir + "/dest";
+    QDir(destDir).removeRecursively();
+    QDir().mkpath(destDir);
+    drop_caches();
+
+    QElapsedTimer timer;
+    timer.start();
+    if (gio) {
+        GFile *src = g_file_new_for_path(srcDir.toUtf8().constData());
+        GFile *dest = g_file_new_for_path((destDir + "/" + QFileInfo(srcDir).fileName()).toUtf8().constData());
+        gio_copy_recursively(src, dest);
+        g_object_unref(dest);
+        g_object_unref(src);
+    } else {
+        Peony::FileCopyOperation op(QStringList()<<QUrl::fromLocalFile(srcDir).toString(),
+                                    QUrl::fromLocalFile(destDir).toString());
+        op.run();
+    }
+    sync();
+    qint64 elapsed = qMax(timer.elapsed(), qint64(1));
+
+    qInfo()<<name<<(gio? "gio": "peony")<<"mode:"<<fileCount<<"files,"<<totalSize/1024/1024<<"MB";
+    qInfo()<<"time      :"<<elapsed<<"ms";
+    qInfo()<<"throughput:"<<qreal(totalSize)/1024/1024/elapsed*1000<<"MB/s,"
+           <<qreal(fileCount)/elapsed*1000<<"files/s";
+
+    QDir(destDir).removeRecursively();
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    auto args = a.arguments();
+    args.removeFirst();
+    bool gio = args.removeAll("--gio") > 0;
+
+    qint64 largeSize = qint64(10240) * 1024 * 1024;
+    int smallCount = 100000;
+    qint64 smallSize = 4 * 1024;
+    while (args.count() > 1 && args.first().startsWith("--")) {
+        auto option = args.takeFirst();
+        auto value = args.takeFirst();
+        if (option == "--large-mb")
+            largeSize = value.toLongLong() * 1024 * 1024;
+        else if (option == "--small-count")
+            smallCount = value.toInt();
+        else if (option == "--small-kb")
+            smallSize = value.toLongLong() * 1024;
+    }
+
+    if (args.isEmpty()) {
+        qInfo()<<"usage: file-copy-benchmark [--gio] [--large-mb 10240] [--small-count 100000] [--small-kb 4] work-dir";
+        return 0;
+    }
+
+    QString workDir = QDir(args.first()).absolutePath();
+    QString largeDir = workDir + "/large";
+    QString smallDir = workDir + "/small";
+
+    //the data sets are kept in the work directory for the next runs.
+    if (!QFile::exists(largeDir + "/large.bin") || QFileInfo(largeDir + "/large.bin").size() != largeSize) {
+        qInfo()<<"generating large file...";
+        QDir().mkpath(largeDir);
+        generate_file(largeDir + "/large.bin", largeSize);
+    }
+    if (QDir(smallDir).entryList(QDir::Files | QDir::Hidden).count() != smallCount) {
+        qInfo()<<"generating small files...";
+        QDir(smallDir).removeRecursively();
+        QDir().mkpath(smallDir);
+        for (int i = 0; i < smallCount; i++) {
+            generate_file(QString("%1/%2.bin").arg(smallDir).arg(i), smallSize);
+        }
+    }
+
+    benchmark("1 large file", largeDir, largeSize, 1, workDir, gio);
+    benchmark("small files", smallDir, smallSize * smallCount, smallCount, workDir, gio);
+
+    return 0;
+}
@@ -24,6 +24,8 @@
 
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "file-node-tree-builder.h"
+#include "local-file-copier.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
@@ -33,6 +35,8 @@
 
 #include "clipboard-utils.h"
 #include <QProcess>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <QDebug>
 
 using namespace Peony;
@@ -293,19 +297,21 @@ fallback_retry:
         //assume that make dir finished anyway
         m_current_offset += node->size();
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
-        for (auto child : *(node->children())) {
-            copyRecursively(child);
+        if (m_builder) {
+            m_builder->waitForChildren(node);
+            updatePreparedState();
         }
+        copyNodes(*(node->children()));
     } else {
         GError *err = nullptr;
         GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        LocalFileCopier::copyWithFallback(sourceFile.get()->get(),
+                                          destFile.get()->get(),
+                                          m_default_copy_flag,
+                                          getCancellable().get()->get(),
+                                          GFileProgressCallback(progress_callback),
+                                          this,
+                                          &err);
 
         if (err) {
             FileOperationError except;
@@ -357,25 +363,25 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopier::copyWithFallback(sourceFile.get()->get(),
+                                                  destFile.get()->get(),
+                                                  GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                                  getCancellable().get()->get(),
+                                                  GFileProgressCallback(progress_callback),
+                                                  this,
+                                                  nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                LocalFileCopier::copyWithFallback(sourceFile.get()->get(),
+                                                  destFile.get()->get(),
+                                                  GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                                  getCancellable().get()->get(),
+                                                  GFileProgressCallback(progress_callback),
+                                                  this,
+                                                  nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
@@ -496,24 +502,39 @@ void FileCopyOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
-    goffset *total_size = new goffset(0);
+    //the transfer starts while the source tree is still building,
+    //a directory is copied once its children were found.
+    FileNodeTreeBuilder builder(m_reporter);
+    m_builder = &builder;
+    m_prepared = false;
 
+    QUrl destDirUrl = m_dest_dir_uri;
+    bool destInSource = false;
     QList<FileNode*> nodes;
     for (auto uri : m_source_uris) {
         FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
+        builder.start(node);
         nodes << node;
+        QUrl srcUrl = uri;
+        if (srcUrl == destDirUrl || srcUrl.isParentOf(destDirUrl))
+            destInSource = true;
     }
+    //the copied files must not be found by the builder.
+    if (destInSource)
+        builder.waitForFinished();
+    updatePreparedState();
 
-    Q_EMIT operationPrepared();
+    QThreadPool smallFilePool;
+    smallFilePool.setMaxThreadCount(PEONY_SMALL_FILE_COPY_THREADS);
+    m_small_file_pool = &smallFilePool;
 
-    m_total_szie = *total_size;
-    delete total_size;
+    copyNodes(nodes);
+
+    builder.waitForFinished();
+    updatePreparedState();
+    m_builder = nullptr;
+    m_small_file_pool = nullptr;
 
-    for (auto node : nodes) {
-        copyRecursively(node);
-    }
     Q_EMIT operationProgressed();
 
     if (isCancelled()) {
@@ -574,6 +595,101 @@ void FileCopyOperation::run()
     //notifyFileWatcherOperationFinished();
 }
 
+void FileCopyOperation::copyNodes(const QList<FileNode *> &nodes)
+{
+    QList<FileNode *> smallFiles;
+    if (m_small_file_pool && m_dest_dir_uri.startsWith("file://")) {
+        for (auto node : nodes) {
+            if (!node->isFolder() && node->size() <= PEONY_SMALL_FILE_SIZE && node->uri().startsWith("file://"))
+                smallFiles<<node;
+        }
+    }
+
+    QSet<FileNode *> copiedFiles;
+    if (smallFiles.count() > 1)
+        copiedFiles = copySmallFiles(smallFiles);
+
+    for (auto node : nodes) {
+        if (copiedFiles.contains(node))
+            continue;
+        copyRecursively(node);
+    }
+}
+
+QSet<FileNode *> FileCopyOperation::copySmallFiles(const QList<FileNode *> &nodes)
+{
+    struct SmallFileJob {
+        FileNode *node;
+        QString destUri;
+        bool copied;
+    };
+
+    QVector<SmallFileJob> jobs;
+    for (auto node : nodes) {
+        jobs<<SmallFileJob{node, node->resolveDestFileUri(m_dest_dir_uri), false};
+    }
+
+    SmallFileJob *data = jobs.data();
+    int count = jobs.count();
+    QAtomicInt next(0);
+    GCancellable *cancellable = getCancellable().get()->get();
+    GFileCopyFlags flags = m_default_copy_flag;
+
+    //the workers only copy, the nodes are updated in this thread.
+    auto copyJobs = [=, &next]() {
+        int i;
+        while ((i = next.fetchAndAddOrdered(1)) < count) {
+            if (g_cancellable_is_cancelled(cancellable))
+                return;
+            GFile *src = g_file_new_for_uri(data[i].node->uri().toUtf8().constData());
+            GFile *dest = g_file_new_for_uri(data[i].destUri.toUtf8().constData());
+            data[i].copied = LocalFileCopier::copy(src, dest, flags, cancellable, nullptr, nullptr, nullptr);
+            g_object_unref(src);
+            g_object_unref(dest);
+        }
+    };
+
+    QList<QFuture<void>> futures;
+    int workerCount = qMin(count, m_small_file_pool->maxThreadCount());
+    for (int i = 0; i < workerCount; i++) {
+        futures<<QtConcurrent::run(m_small_file_pool, copyJobs);
+    }
+    for (auto future : futures) {
+        future.waitForFinished();
+    }
+
+    //failed files are left unhandled, copyRecursively() will retry them
+    //with the normal error handling.
+    QSet<FileNode *> copiedFiles;
+    for (auto job : jobs) {
+        if (!job.copied)
+            continue;
+        job.node->setDestUri(job.destUri);
+        job.node->setState(FileNode::Handled);
+        m_current_offset += job.node->size();
+        Q_EMIT operationProgressedOne(job.node->uri(), job.node->destUri(), job.node->size());
+        copiedFiles<<job.node;
+        m_current_src_uri = job.node->uri();
+        m_current_dest_dir_uri = job.destUri;
+    }
+
+    if (!copiedFiles.isEmpty()) {
+        auto fileIconName = FileUtils::getFileIconName(m_current_src_uri, false);
+        Q_EMIT FileProgressCallback(m_current_src_uri, m_current_dest_dir_uri, fileIconName, m_current_offset, m_total_szie);
+    }
+
+    return copiedFiles;
+}
+
+void FileCopyOperation::updatePreparedState()
+{
+    m_total_szie = m_builder->totalSize();
+    if (!m_prepared && m_builder->isFinished()) {
+        m_prepared = true;
+        Q_EMIT operationPrepared();
+    }
+}
+
 void FileCopyOperation::cancel()
 {
     if (m_reporter)
@@ -27,10 +27,28 @@
 
 #include "file-operation.h"
 
+/*!
+ * \brief PEONY_SMALL_FILE_SIZE
+ * <br>
+ * Local files not larger than this are copied by several threads at the same time,
+ * copying them is bound by the latency of metadata rather than the bandwidth.
+ * </br>
+ */
+#ifndef PEONY_SMALL_FILE_SIZE
+#define PEONY_SMALL_FILE_SIZE (1024 * 1024)
+#endif
+
+#ifndef PEONY_SMALL_FILE_COPY_THREADS
+#define PEONY_SMALL_FILE_COPY_THREADS 4
+#endif
+
+class QThreadPool;
+
 namespace Peony {
 
 class FileNodeReporter;
 class FileNode;
+class FileNodeTreeBuilder;
 
 /*!
  * \brief The FileCopyOperation class
@@ -63,6 +81,16 @@ protected:
      * \see FileMoveOperation::copyRecursively()
      */
     void copyRecursively(FileNode *node);
+    /*!
+     * \brief copyNodes
+     * \param nodes, the sibling nodes to copy.
+     * <br>
+     * Small local files in nodes are copied concurrently first, then the others
+     * and the files failed in concurrent copying are copied by copyRecursively().
+     * </br>
+     */
+    void copyNodes(const QList<FileNode *> &nodes);
+    QSet<FileNode *> copySmallFiles(const QList<FileNode *> &nodes);
     /*!
      * \brief rollbackNodeRecursively
      * \param node
@@ -72,6 +100,14 @@ protected:
      * understand.
      */
     void rollbackNodeRecursively(FileNode *node);
+    /*!
+     * \brief updatePreparedState
+     * <br>
+     * The source tree is still building while copying, update the total size
+     * and send operationPrepared() once the builder finished.
+     * </br>
+     */
+    void updatePreparedState();
 
 private:
     /*!
@@ -103,6 +139,9 @@ private:
                                          G_FILE_COPY_ALL_METADATA);
 
     FileNodeReporter *m_reporter = nullptr;
+    FileNodeTreeBuilder *m_builder = nullptr;
+    QThreadPool *m_small_file_pool = nullptr;
+    bool m_prepared = false;
 
     /*!
      * \brief m_prehandle_hash
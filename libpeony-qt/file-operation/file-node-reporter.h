@@ -24,6 +24,7 @@
 #define FILENODEREPORTER_H
 
 #include <QObject>
+#include <QMutex>
 #include <memory>
 
 #include "peony-core_global.h"
@@ -46,7 +47,15 @@ public:
     explicit FileNodeReporter(QObject *parent = nullptr);
     ~FileNodeReporter();
 
+    /*!
+     * \brief sendNodeFound
+     * <br>
+     * Nodes might be found by several FileNodeTreeBuilder threads, the emission
+     * is serialized so that direct connected receivers are not re-entered.
+     * </br>
+     */
     void sendNodeFound(const QString &uri, const qint64 &offset) {
+        QMutexLocker locker(&m_mutex);
         Q_EMIT nodeFound(uri, offset);
     }
 
@@ -75,6 +84,7 @@ Q_SIGNALS:
 
 private:
     bool m_cancelled = false;
+    QMutex m_mutex;
 };
 
 }
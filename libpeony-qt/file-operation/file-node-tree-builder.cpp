@@ -0,0 +1,191 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-node-tree-builder.h"
+#include "file-node.h"
+#include "file-node-reporter.h"
+#include "file-enumerator.h"
+
+#include <QtConcurrent>
+
+using namespace Peony;
+
+FileNodeTreeBuilder::FileNodeTreeBuilder(FileNodeReporter *reporter)
+{
+    m_reporter = reporter;
+    m_cancellable = g_cancellable_new();
+    m_pool.setMaxThreadCount(PEONY_FILE_NODE_SCAN_THREADS);
+}
+
+FileNodeTreeBuilder::~FileNodeTreeBuilder()
+{
+    cancel();
+    waitForFinished();
+    m_pool.waitForDone();
+    g_object_unref(m_cancellable);
+}
+
+void FileNodeTreeBuilder::start(FileNode *root)
+{
+    QMutexLocker locker(&m_mutex);
+    m_total_size += root->size();
+    if (root->isFolder() && !isCancelled())
+        enqueue(root);
+}
+
+void FileNodeTreeBuilder::waitForChildren(FileNode *node)
+{
+    m_mutex.lock();
+    if (m_queued_nodes.remove(node)) {
+        //the directory is still waiting for a reader, read it here.
+        //the queued task's running slot is taken over, and released only
+        //after the children have been queued by readDirectory().
+        m_mutex.unlock();
+        readDirectory(node);
+        m_mutex.lock();
+        m_running_count--;
+        m_condition.wakeAll();
+        m_mutex.unlock();
+        return;
+    }
+    while (m_pending_nodes.contains(node)) {
+        m_condition.wait(&m_mutex);
+    }
+    m_mutex.unlock();
+}
+
+void FileNodeTreeBuilder::waitForFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_running_count > 0) {
+        m_condition.wait(&m_mutex);
+    }
+}
+
+bool FileNodeTreeBuilder::isFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running_count == 0;
+}
+
+goffset FileNodeTreeBuilder::totalSize()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_total_size;
+}
+
+void FileNodeTreeBuilder::cancel()
+{
+    g_cancellable_cancel(m_cancellable);
+}
+
+bool FileNodeTreeBuilder::isCancelled()
+{
+    if (m_reporter && m_reporter->isOperationCancelled())
+        return true;
+    return g_cancellable_is_cancelled(m_cancellable);
+}
+
+void FileNodeTreeBuilder::enqueue(FileNode *node)
+{
+    //m_mutex must be locked by caller.
+    m_queued_nodes.insert(node);
+    m_pending_nodes.insert(node);
+    m_running_count++;
+    QtConcurrent::run(&m_pool, [=]() {
+        runQueued(node);
+    });
+}
+
+void FileNodeTreeBuilder::runQueued(FileNode *node)
+{
+    m_mutex.lock();
+    bool stolen = !m_queued_nodes.remove(node);
+    m_mutex.unlock();
+
+    //a stolen directory is still being read by waitForChildren(),
+    //which releases the running slot once its children are queued.
+    if (stolen)
+        return;
+
+    readDirectory(node);
+
+    m_mutex.lock();
+    m_running_count--;
+    m_condition.wakeAll();
+    m_mutex.unlock();
+}
+
+void FileNodeTreeBuilder::readDirectory(FileNode *node)
+{
+    QList<FileNode *> children;
+    goffset size = 0;
+
+    GFile *dir = g_file_new_for_uri(node->uri().toUtf8().constData());
+    GFileEnumerator *e = nullptr;
+    if (!isCancelled()) {
+        //use G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS to avoid unnecessary recursion.
+        e = g_file_enumerate_children(dir,
+                                      G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                      G_FILE_ATTRIBUTE_STANDARD_TYPE ","
+                                      G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                      m_cancellable,
+                                      nullptr);
+    }
+    g_object_unref(dir);
+
+    if (e) {
+        GFileInfo *info = nullptr;
+        while (!isCancelled() && (info = g_file_enumerator_next_file(e, m_cancellable, nullptr))) {
+            auto uri = FileEnumerator::childUri(e, info);
+            FileNode *child = nullptr;
+            auto type = g_file_info_get_file_type(info);
+            if (!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_SIZE) ||
+                    type == G_FILE_TYPE_UNKNOWN || type == G_FILE_TYPE_SYMBOLIC_LINK) {
+                //some vfs do not supply the type or size, and the size of a link
+                //is the size of its target, so they are queried separately.
+                child = new FileNode(uri, node, m_reporter);
+            } else {
+                child = new FileNode(uri, node, type == G_FILE_TYPE_DIRECTORY, g_file_info_get_size(info), m_reporter);
+            }
+            size += child->size();
+            children<<child;
+            g_object_unref(info);
+        }
+        g_file_enumerator_close(e, nullptr, nullptr);
+        g_object_unref(e);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    *node->m_children = children;
+    m_total_size += size;
+    if (!isCancelled()) {
+        for (auto child : children) {
+            if (child->isFolder())
+                enqueue(child);
+        }
+    }
+    m_pending_nodes.remove(node);
+    m_condition.wakeAll();
+}
@@ -0,0 +1,129 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILENODETREEBUILDER_H
+#define FILENODETREEBUILDER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QSet>
+#include <gio/gio.h>
+
+#include "peony-core_global.h"
+
+/*!
+ * \brief PEONY_FILE_NODE_SCAN_THREADS
+ * <br>
+ * The max count of directories which are read at the same time by one builder.
+ * Enumerating is io bound, so it could be greater than the cpu count.
+ * </br>
+ */
+#ifndef PEONY_FILE_NODE_SCAN_THREADS
+#define PEONY_FILE_NODE_SCAN_THREADS 8
+#endif
+
+namespace Peony {
+
+class FileNode;
+class FileNodeReporter;
+
+/*!
+ * \brief The FileNodeTreeBuilder class
+ * <br>
+ * This class builds the children tree of FileNode instances with a pool of directory
+ * readers. Every directory is enumerated once, and the type and size of the children are
+ * taken from the enumerated infos, so there is no extra query for each file.
+ * </br>
+ * <br>
+ * The children of a directory node are published all at once when its directory was read,
+ * before that FileNode::children() of the node is empty. A consumer which wants to handle
+ * the tree while it is building, such as FileCopyOperation, should call waitForChildren()
+ * before walking the children of a directory. If the directory has not been picked up by
+ * the pool yet, the consumer reads it in its own thread instead of waiting in the queue.
+ * </br>
+ * <br>
+ * Every found node is reported by FileNodeReporter::sendNodeFound() from the reader threads,
+ * and the builder stops reading once the reporter is cancelled.
+ * </br>
+ * \note The builder does not own the nodes. It must be destroyed before the root nodes,
+ * the destructor waits for all running readers.
+ * \see FileNode::findChildrenRecursively().
+ */
+class PEONYCORESHARED_EXPORT FileNodeTreeBuilder
+{
+public:
+    explicit FileNodeTreeBuilder(FileNodeReporter *reporter = nullptr);
+    ~FileNodeTreeBuilder();
+
+    /*!
+     * \brief start
+     * \param root
+     * <br>
+     * Start building the tree of root asynchronously, a builder can build several roots.
+     * </br>
+     */
+    void start(FileNode *root);
+
+    /*!
+     * \brief waitForChildren
+     * \param node
+     * <br>
+     * Block until the direct children of node are all found.
+     * It returns immediately if node is not a directory handled by this builder.
+     * </br>
+     */
+    void waitForChildren(FileNode *node);
+    void waitForFinished();
+    bool isFinished();
+
+    /*!
+     * \brief totalSize
+     * \return the total size of the nodes found so far.
+     */
+    goffset totalSize();
+
+    void cancel();
+
+private:
+    bool isCancelled();
+    void enqueue(FileNode *node);
+    void runQueued(FileNode *node);
+    void readDirectory(FileNode *node);
+
+    FileNodeReporter *m_reporter = nullptr;
+    GCancellable *m_cancellable = nullptr;
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+
+    QSet<FileNode *> m_queued_nodes;
+    QSet<FileNode *> m_pending_nodes;
+    int m_running_count = 0;
+    goffset m_total_size = 0;
+};
+
+}
+
+#endif // FILENODETREEBUILDER_H
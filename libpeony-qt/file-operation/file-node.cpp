@@ -24,6 +24,7 @@
 #include "file-utils.h"
 #include "file-info.h"
 #include "file-node-reporter.h"
+#include "file-node-tree-builder.h"
 
 #include <QUrl>
 
@@ -60,6 +61,23 @@ FileNode::FileNode(QString uri, FileNode *parent, FileNodeReporter *reporter)
     m_children = new QList<FileNode*>();
 }
 
+FileNode::FileNode(const QString &uri, FileNode *parent, bool isFolder, goffset size, FileNodeReporter *reporter)
+{
+    m_uri = uri;
+    m_parent = parent;
+    m_reporter = reporter;
+    m_basename = m_uri.split("/").last();
+    m_dest_basename = m_basename;
+    m_is_folder = isFolder;
+    m_size = size;
+
+    if (m_reporter) {
+        m_reporter->sendNodeFound(m_uri, m_size);
+    }
+
+    m_children = new QList<FileNode*>();
+}
+
 FileNode::~FileNode() {
     qDebug()<<"delete node:"<<m_uri;
     m_uri.clear();
@@ -82,14 +100,10 @@ void FileNode::findChildrenRecursively()
 
     if (!m_is_folder)
         return;
-    else {
-        auto uris = FileUtils::getChildrenUris(m_uri);
-        for (auto uri: uris) {
-            FileNode *node = new FileNode(uri, this, m_reporter);
-            m_children->append(node);
-            node->findChildrenRecursively();
-        }
-    }
+
+    FileNodeTreeBuilder builder(m_reporter);
+    builder.start(this);
+    builder.waitForFinished();
 }
 
 void FileNode::computeTotalSize(goffset *offset)
@@ -59,6 +59,7 @@ class FileNodeReporter;
 class PEONYCORESHARED_EXPORT FileNode
 {
     friend class FileNodeReporter;
+    friend class FileNodeTreeBuilder;
 public:
     enum State {
         Unhandled,
@@ -69,9 +70,24 @@ public:
     };
 
     FileNode(QString uri, FileNode* parent, FileNodeReporter *reporter = nullptr);
+    /*!
+     * \brief FileNode
+     * <br>
+     * Create a node with the type and size which is already known, for example
+     * from an enumerated GFileInfo. It does not query the file again.
+     * </br>
+     */
+    FileNode(const QString &uri, FileNode *parent, bool isFolder, goffset size, FileNodeReporter *reporter = nullptr);
     ~FileNode();
 
-    //FIXME: do i need add cancel function?
+    /*!
+     * \brief findChildrenRecursively
+     * <br>
+     * Build the whole children tree with a FileNodeTreeBuilder and wait until
+     * it finished. The enumeration stops when the reporter is cancelled.
+     * </br>
+     * \see FileNodeTreeBuilder.
+     */
     void findChildrenRecursively();
     void computeTotalSize(goffset *offset);
 
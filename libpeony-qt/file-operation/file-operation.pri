@@ -6,6 +6,8 @@ PKGCONFIG += gio-unix-2.0
 
 HEADERS += \
     $$PWD/file-node.h                           \
+    $$PWD/file-node-tree-builder.h              \
+    $$PWD/local-file-copier.h                   \
     $$PWD/file-operation.h                      \
     $$PWD/file-node-reporter.h                  \
     $$PWD/file-link-operation.h                 \
@@ -27,6 +29,8 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/file-node.cpp                         \
+    $$PWD/file-node-tree-builder.cpp            \
+    $$PWD/local-file-copier.cpp                 \
     $$PWD/file-operation.cpp                    \
     $$PWD/file-node-reporter.cpp                \
     $$PWD/file-link-operation.cpp               \
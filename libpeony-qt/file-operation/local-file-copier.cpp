@@ -0,0 +1,307 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "local-file-copier.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
+using namespace Peony;
+
+static const int supported_flags = G_FILE_COPY_OVERWRITE |
+                                   G_FILE_COPY_NOFOLLOW_SYMLINKS |
+                                   G_FILE_COPY_ALL_METADATA;
+
+static void set_not_supported(GError **error)
+{
+    g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "local copy is not supported");
+}
+
+static void set_error_from_errno(GError **error, int errsv, const char *path)
+{
+    g_set_error(error, G_IO_ERROR, g_io_error_from_errno(errsv), "%s: %s", path, g_strerror(errsv));
+}
+
+static ssize_t copy_file_range_compat(int in_fd, int out_fd, size_t len)
+{
+#ifdef __NR_copy_file_range
+    //call the syscall directly, glibc only has a wrapper since 2.27.
+    return syscall(__NR_copy_file_range, in_fd, nullptr, out_fd, nullptr, len, 0);
+#else
+    (void)in_fd;
+    (void)out_fd;
+    (void)len;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+gboolean LocalFileCopier::copy(GFile *source,
+                               GFile *destination,
+                               GFileCopyFlags flags,
+                               GCancellable *cancellable,
+                               GFileProgressCallback progress_callback,
+                               gpointer progress_callback_data,
+                               GError **error)
+{
+    if (flags & ~supported_flags) {
+        set_not_supported(error);
+        return FALSE;
+    }
+
+    char *src_path = g_file_get_path(source);
+    char *dest_path = g_file_get_path(destination);
+    if (!src_path || !dest_path) {
+        g_free(src_path);
+        g_free(dest_path);
+        set_not_supported(error);
+        return FALSE;
+    }
+
+    gboolean ret = FALSE;
+    bool created = false;
+    int in_fd = -1;
+    int out_fd = -1;
+    struct stat src_stat;
+    struct stat dest_stat;
+    goffset size = 0;
+    goffset copied = 0;
+    char *buffer = nullptr;
+    char *tmp_path = nullptr;
+    enum {
+        CopyFileRange,
+        SendFile,
+        ReadWrite
+    } method = CopyFileRange;
+
+    if (g_cancellable_set_error_if_cancelled(cancellable, error))
+        goto out;
+
+    in_fd = open(src_path, O_RDONLY | O_CLOEXEC | ((flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? O_NOFOLLOW: 0));
+    if (in_fd < 0) {
+        //a symbolic link should be copied as link, let gio do that.
+        if (errno == ELOOP)
+            set_not_supported(error);
+        else
+            set_error_from_errno(error, errno, src_path);
+        goto out;
+    }
+    if (fstat(in_fd, &src_stat) < 0) {
+        set_error_from_errno(error, errno, src_path);
+        goto out;
+    }
+    if (!S_ISREG(src_stat.st_mode)) {
+        set_not_supported(error);
+        goto out;
+    }
+    size = src_stat.st_size;
+
+    if (flags & G_FILE_COPY_OVERWRITE) {
+        //never write into the existing destination, it might be the source itself or a
+        //symbolic link pointing anywhere. copy to a temporary file beside it and rename()
+        //it over the destination once the copy is complete, which replaces a link itself.
+        if (lstat(dest_path, &dest_stat) == 0) {
+            if (!S_ISREG(dest_stat.st_mode) && !S_ISLNK(dest_stat.st_mode)) {
+                //let gio report directories and special files as it does.
+                set_not_supported(error);
+                goto out;
+            }
+            if (dest_stat.st_dev == src_stat.st_dev && dest_stat.st_ino == src_stat.st_ino) {
+                g_set_error(error, G_IO_ERROR, G_IO_ERROR_EXISTS, "%s: %s", dest_path, "source and destination are the same file");
+                goto out;
+            }
+        } else if (errno != ENOENT) {
+            set_error_from_errno(error, errno, dest_path);
+            goto out;
+        }
+
+        char *dirname = g_path_get_dirname(dest_path);
+        char *basename = g_path_get_basename(dest_path);
+        tmp_path = g_strdup_printf("%s/.%s.XXXXXX", dirname, basename);
+        g_free(dirname);
+        g_free(basename);
+
+        //mkostemp() creates the file with O_EXCL, it never follows a link.
+        out_fd = mkostemp(tmp_path, O_CLOEXEC);
+        if (out_fd < 0) {
+            set_error_from_errno(error, errno, dest_path);
+            g_free(tmp_path);
+            tmp_path = nullptr;
+            goto out;
+        }
+        fchmod(out_fd, src_stat.st_mode & 0777);
+    } else {
+        out_fd = open(dest_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, src_stat.st_mode & 0777);
+        created = out_fd >= 0;
+        if (out_fd < 0) {
+            set_error_from_errno(error, errno, dest_path);
+            goto out;
+        }
+    }
+
+    //reflink shares the extents, the copy is instant and takes no space.
+    if (size > 0 && ioctl(out_fd, FICLONE, in_fd) == 0) {
+        copied = size;
+        if (progress_callback)
+            progress_callback(copied, size, progress_callback_data);
+    } else if (size > 0) {
+        if (fallocate(out_fd, 0, 0, size) < 0 && errno == ENOSPC) {
+            set_error_from_errno(error, errno, dest_path);
+            goto out;
+        }
+    }
+
+    while (copied < size) {
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+            goto out;
+
+        size_t chunk = size_t(MIN(goffset(PEONY_LOCAL_COPY_CHUNK_SIZE), size - copied));
+        ssize_t n = -1;
+        if (method == CopyFileRange) {
+            n = copy_file_range_compat(in_fd, out_fd, chunk);
+            if ((n < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) || n == 0) {
+                //old kernel, cross filesystem copy or a filesystem which copies nothing,
+                //the file offsets are kept.
+                method = SendFile;
+                continue;
+            }
+        } else if (method == SendFile) {
+            n = sendfile(out_fd, in_fd, nullptr, chunk);
+            if ((n < 0 && (errno == ENOSYS || errno == EINVAL)) || n == 0) {
+                method = ReadWrite;
+                continue;
+            }
+        } else {
+            if (!buffer)
+                buffer = static_cast<char *>(g_malloc(PEONY_LOCAL_COPY_BUFFER_SIZE));
+            n = read(in_fd, buffer, MIN(chunk, size_t(PEONY_LOCAL_COPY_BUFFER_SIZE)));
+            if (n == 0) {
+                //nothing is left to fall back to, the source was truncated while copying.
+                g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s: %s", src_path, "file was truncated while copying");
+                goto out;
+            }
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                set_error_from_errno(error, errno, src_path);
+                goto out;
+            }
+            ssize_t written = 0;
+            while (written < n) {
+                ssize_t w = write(out_fd, buffer + written, size_t(n - written));
+                if (w < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    set_error_from_errno(error, errno, dest_path);
+                    goto out;
+                }
+                written += w;
+            }
+        }
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            set_error_from_errno(error, errno, dest_path);
+            goto out;
+        }
+
+        copied += n;
+        if (progress_callback)
+            progress_callback(copied, size, progress_callback_data);
+    }
+
+    if (close(out_fd) < 0) {
+        out_fd = -1;
+        set_error_from_errno(error, errno, dest_path);
+        goto out;
+    }
+    out_fd = -1;
+
+    if (tmp_path) {
+        if (rename(tmp_path, dest_path) < 0) {
+            set_error_from_errno(error, errno, dest_path);
+            goto out;
+        }
+        g_free(tmp_path);
+        tmp_path = nullptr;
+    }
+
+    //the same attributes as g_file_copy() copies, errors are not fatal.
+    g_file_copy_attributes(source, destination,
+                           GFileCopyFlags(flags & (G_FILE_COPY_ALL_METADATA | G_FILE_COPY_NOFOLLOW_SYMLINKS)),
+                           cancellable, nullptr);
+
+    if (progress_callback && size == 0)
+        progress_callback(0, 0, progress_callback_data);
+
+    created = false;
+    ret = TRUE;
+
+out:
+    g_free(buffer);
+    if (out_fd >= 0)
+        close(out_fd);
+    if (in_fd >= 0)
+        close(in_fd);
+    if (created)
+        unlink(dest_path);
+    if (tmp_path) {
+        unlink(tmp_path);
+        g_free(tmp_path);
+    }
+    g_free(src_path);
+    g_free(dest_path);
+    return ret;
+}
+
+gboolean LocalFileCopier::copyWithFallback(GFile *source,
+                                           GFile *destination,
+                                           GFileCopyFlags flags,
+                                           GCancellable *cancellable,
+                                           GFileProgressCallback progress_callback,
+                                           gpointer progress_callback_data,
+                                           GError **error)
+{
+    GError *err = nullptr;
+    if (copy(source, destination, flags, cancellable, progress_callback, progress_callback_data, &err))
+        return TRUE;
+
+    if (!g_error_matches(err, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED)) {
+        g_propagate_error(error, err);
+        return FALSE;
+    }
+    g_error_free(err);
+
+    return g_file_copy(source, destination, flags, cancellable,
+                       progress_callback, progress_callback_data, error);
+}
@@ -0,0 +1,107 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef LOCALFILECOPIER_H
+#define LOCALFILECOPIER_H
+
+#include <gio/gio.h>
+
+#include "peony-core_global.h"
+
+/*!
+ * \brief PEONY_LOCAL_COPY_CHUNK_SIZE
+ * <br>
+ * The bytes copied by one kernel copy call, the progress is reported after each chunk.
+ * </br>
+ */
+#ifndef PEONY_LOCAL_COPY_CHUNK_SIZE
+#define PEONY_LOCAL_COPY_CHUNK_SIZE (8 * 1024 * 1024)
+#endif
+
+/*!
+ * \brief PEONY_LOCAL_COPY_BUFFER_SIZE
+ * <br>
+ * The buffer used by the read()/write() fallback, when the kernel copy calls copy nothing.
+ * </br>
+ */
+#ifndef PEONY_LOCAL_COPY_BUFFER_SIZE
+#define PEONY_LOCAL_COPY_BUFFER_SIZE (256 * 1024)
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The LocalFileCopier class
+ * <br>
+ * This class copies a regular file between two local paths inside the kernel.
+ * It tries to share the extents with FICLONE first, which is instant on btrfs and xfs,
+ * then copy_file_range(), then sendfile(), then plain read() and write(). Each method falls
+ * back to the next one when it is not supported or copies nothing, and the source is only
+ * considered truncated when read() reaches its end too, which is reported as an error.
+ * The destination is preallocated with fallocate()
+ * so that a large file is not fragmented and a full disk is found before copying.
+ * </br>
+ * <br>
+ * copy() has the same semantic as g_file_copy(), the errors are reported in G_IO_ERROR domain,
+ * so the caller can handle them with the same code. If the files are not local, or the source
+ * is not a regular file, it returns G_IO_ERROR_NOT_SUPPORTED without touching the destination,
+ * and the caller should fall back to g_file_copy().
+ * </br>
+ * <br>
+ * With G_FILE_COPY_OVERWRITE the existing destination is never opened, the file is copied
+ * to a hidden temporary file in the same directory and renamed over the destination when
+ * the copy succeeded, so a failed copy keeps the old file and a symbolic link is replaced
+ * rather than followed.
+ * </br>
+ * \note Only G_FILE_COPY_OVERWRITE, G_FILE_COPY_NOFOLLOW_SYMLINKS and G_FILE_COPY_ALL_METADATA
+ * are supported, other flags are treated as not supported.
+ */
+class PEONYCORESHARED_EXPORT LocalFileCopier
+{
+public:
+    static gboolean copy(GFile *source,
+                         GFile *destination,
+                         GFileCopyFlags flags,
+                         GCancellable *cancellable,
+                         GFileProgressCallback progress_callback,
+                         gpointer progress_callback_data,
+                         GError **error);
+
+    /*!
+     * \brief copyWithFallback
+     * <br>
+     * Try copy() and use g_file_copy() if the local copy is not supported.
+     * </br>
+     */
+    static gboolean copyWithFallback(GFile *source,
+                                     GFile *destination,
+                                     GFileCopyFlags flags,
+                                     GCancellable *cancellable,
+                                     GFileProgressCallback progress_callback,
+                                     gpointer progress_callback_data,
+                                     GError **error);
+};
+
+}
+
+#endif // LOCALFILECOPIER_H
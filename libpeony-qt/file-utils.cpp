@@ -21,6 +21,8 @@
  */
 
 #include "file-utils.h"
+#include "gio-watchdog.h"
+
 #include <QUrl>
 #include <QFileInfo>
 #include <QFileInfoList>
@@ -95,6 +97,7 @@ GFileWrapperPtr FileUtils::resolveRelativePath(const GFileWrapperPtr &dir, const
 
 bool FileUtils::getFileHasChildren(const GFileWrapperPtr &file)
 {
+    PEONY_WATCH_GIO_CALL(nullptr);
     GFileType type = g_file_query_file_type(file.get()->get(),
                                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                             nullptr);
@@ -111,6 +114,7 @@ bool FileUtils::getFileIsFolder(const GFileWrapperPtr &file)
 
 bool FileUtils::getFileIsFolder(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     GFileType type = g_file_query_file_type(file.get()->get(),
                                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
@@ -120,6 +124,7 @@ bool FileUtils::getFileIsFolder(const QString &uri)
 
 bool FileUtils::getFileIsSymbolicLink(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     GFileType type = g_file_query_file_type(file.get()->get(),
                                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
@@ -129,6 +134,7 @@ bool FileUtils::getFileIsSymbolicLink(const QString &uri)
 
 QStringList FileUtils::getChildrenUris(const QString &directoryUri)
 {
+    PEONY_WATCH_GIO_CALL(directoryUri);
     QStringList uris;
 
     GError *err = nullptr;
@@ -199,6 +205,7 @@ QString FileUtils::getNonSuffixedBaseNameFromUri(const QString &uri)
 
 QString FileUtils::getFileDisplayName(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
                               G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME,
@@ -212,48 +219,56 @@ QString FileUtils::getFileDisplayName(const QString &uri)
 
 QString FileUtils::getFileIconName(const QString &uri, bool checkValid)
 {
+    auto icon_names = getFileIconNames(uri);
+    if (icon_names.isEmpty())
+        return nullptr;
+
+    if (checkValid) {
+        for (auto icon_name : icon_names) {
+            QIcon icon = QIcon::fromTheme(icon_name);
+            if (!icon.isNull()) {
+                return icon_name;
+            }
+        }
+    }
+    return icon_names.first();
+}
+
+QStringList FileUtils::getFileIconNames(const QString &uri)
+{
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
                               G_FILE_ATTRIBUTE_STANDARD_ICON,
                               G_FILE_QUERY_INFO_NONE,
                               nullptr,
                               nullptr));
+    QStringList icon_names;
     if (!G_IS_FILE_INFO (info.get()->get()))
-        return nullptr;
+        return icon_names;
     GIcon *g_icon = g_file_info_get_icon (info.get()->get());
-    QString icon_name;
     //do not unref the GIcon from info.
     if (G_IS_ICON(g_icon)) {
-        const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_icon));
-        if (icon_names) {
-            auto p = icon_names;
-            if (*p)
-                icon_name = QString (*p);
-            if (checkValid) {
-                while (*p) {
-                    QIcon icon = QIcon::fromTheme(*p);
-                    if (!icon.isNull()) {
-                        icon_name = QString (*p);
-                        break;
-                    } else {
-                        p++;
-                    }
-                }
+        const gchar* const* names = G_IS_THEMED_ICON(g_icon)? g_themed_icon_get_names(G_THEMED_ICON (g_icon)): nullptr;
+        if (names) {
+            for (auto p = names; *p; p++) {
+                icon_names<<QString (*p);
             }
         }else {
             //if it's a bootable-media,maybe we can get the icon from the mount directory.
             char *bootableIcon = g_icon_to_string(g_icon);
             if(bootableIcon){
-                icon_name = QString(bootableIcon);
+                icon_names<<QString(bootableIcon);
                 g_free(bootableIcon);
             }
         }
     }
-    return icon_name;
+    return icon_names;
 }
 
 GErrorWrapperPtr FileUtils::getEnumerateError(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     GError *err = nullptr;
     auto enumerator = wrapGFileEnumerator(g_file_enumerate_children(file.get()->get(),
@@ -269,6 +284,7 @@ GErrorWrapperPtr FileUtils::getEnumerateError(const QString &uri)
 
 QString FileUtils::getTargetUri(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
     auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
                               G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
@@ -281,6 +297,7 @@ QString FileUtils::getTargetUri(const QString &uri)
 
 bool FileUtils::isMountPoint(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     bool flag = false;                      // The uri is a mount point
 
     GFile* file = g_file_new_for_uri(uri.toUtf8().constData());
@@ -352,8 +369,17 @@ const QString FileUtils::getOriginalUri(const QString &uri)
     return originalUri;
 }
 
+const QString FileUtils::normalizedUri(const QString &uri)
+{
+    QUrl url = uri;
+    if (!url.isValid())
+        return uri;
+    return url.adjusted(QUrl::NormalizePathSegments|QUrl::StripTrailingSlash).toString(QUrl::FullyDecoded);
+}
+
 bool FileUtils::isFileExsit(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     bool exist = false;
     GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
     exist = g_file_query_exists(file, nullptr);
@@ -382,6 +408,7 @@ const QStringList FileUtils::toDisplayUris(const QStringList &args)
 
 bool FileUtils::isMountRoot(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
     GFileInfo *info = g_file_query_info(file,
                                         "unix::is-mountpoint",
@@ -399,6 +426,7 @@ bool FileUtils::isMountRoot(const QString &uri)
 
 bool FileUtils::queryVolumeInfo(const QString &volumeUri, QString &volumeName, QString &unixDeviceName, const QString &volumeDisplayName)
 {
+    PEONY_WATCH_GIO_CALL(volumeUri);
     if (!volumeUri.startsWith("computer:///"))
         return false;
 
@@ -440,6 +468,7 @@ bool FileUtils::queryVolumeInfo(const QString &volumeUri, QString &volumeName, Q
 
 bool FileUtils::isFileDirectory(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     bool isFolder = false;
     GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
     isFolder = g_file_query_file_type(file,
@@ -451,6 +480,7 @@ bool FileUtils::isFileDirectory(const QString &uri)
 
 bool FileUtils::isFileUnmountable(const QString &uri)
 {
+    PEONY_WATCH_GIO_CALL(uri);
     GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
     GFileInfo *info = g_file_query_info(file, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
     g_object_unref(file);
@@ -31,6 +31,7 @@
 #include "gerror-wrapper.h"
 
 #include <QString>
+#include <QStringList>
 
 namespace Peony {
 
@@ -53,6 +54,7 @@ public:
     NO_BLOCKING static QString getNonSuffixedBaseNameFromUri(const QString &uri);
     BLOCKING static QString getFileDisplayName(const QString &uri);
     BLOCKING static QString getFileIconName(const QString &uri, bool checkValid = true);
+    BLOCKING static QStringList getFileIconNames(const QString &uri);
 
     BLOCKING static GErrorWrapperPtr getEnumerateError(const QString &uri);
     BLOCKING static QString getTargetUri(const QString &uri);
@@ -63,6 +65,17 @@ public:
 
     NO_BLOCKING static const QString getParentUri(const QString &uri);
     NO_BLOCKING static const QString getOriginalUri(const QString &uri);
+    /*!
+     * \brief normalizedUri
+     * \param uri
+     * \return the decoded uri without redundant separators, "." and "..".
+     * <br>
+     * The same file might be reported with differently encoded uris, such as
+     * "%20" and " ". Use the normalized uri as the key of uri indexes instead
+     * of comparing GFiles one by one.
+     * </br>
+     */
+    NO_BLOCKING static const QString normalizedUri(const QString &uri);
 
     BLOCKING static bool isFileExsit(const QString &uri);
 
@@ -21,12 +21,16 @@
  */
 
 #include "file-watcher.h"
+#include "file-monitor-registry.h"
 #include "gerror-wrapper.h"
 
 #include "file-label-model.h"
 
 #include <QUrl>
+#include <QTimer>
+#include <QMetaMethod>
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "file-operation-manager.h"
 
 #include <QDebug>
@@ -35,47 +39,30 @@ using namespace Peony;
 
 FileWatcher::FileWatcher(QString uri, QObject *parent) : QObject(parent)
 {
-    if (uri.startsWith("thumbnail://"))
-        return;
-
     m_uri = uri;
     m_target_uri = uri;
     m_file = g_file_new_for_uri(uri.toUtf8().constData());
     m_cancellable = g_cancellable_new();
 
+    m_coalesce_timer = new QTimer(this);
+    m_coalesce_timer->setSingleShot(true);
+    m_coalesce_timer->setInterval(PEONY_FILE_WATCHER_COALESCE_INTERVAL);
+    connect(m_coalesce_timer, &QTimer::timeout, this, &FileWatcher::flushChildEvents);
+
     connect(FileLabelModel::getGlobalModel(), &FileLabelModel::fileLabelChanged, this, [=](const QString &uri) {
         auto parentUri = FileUtils::getParentUri(uri);
         if (parentUri == m_uri || parentUri == m_target_uri) {
+            Q_EMIT filesChanged(QStringList()<<uri);
             Q_EMIT fileChanged(uri);
             qDebug()<<"file label changed"<<uri;
         }
     });
 
+    acquireMonitors();
+
     //monitor target file if existed.
     prepare();
 
-    GError *err1 = nullptr;
-    m_monitor = g_file_monitor_file(m_file,
-                                    G_FILE_MONITOR_WATCH_MOVES,
-                                    m_cancellable,
-                                    &err1);
-    if (err1) {
-        qDebug()<<err1->code<<err1->message;
-        g_error_free(err1);
-        m_support_monitor = false;
-    }
-
-    GError *err2 = nullptr;
-    m_dir_monitor = g_file_monitor_directory(m_file,
-                    G_FILE_MONITOR_NONE,
-                    m_cancellable,
-                    &err2);
-    if (err2) {
-        qDebug()<<err2->code<<err2->message;
-        g_error_free(err2);
-        m_support_monitor = false;
-    }
-
     FileOperationManager::getInstance()->registerFileWatcher(this);
 }
 
@@ -90,10 +77,7 @@ FileWatcher::~FileWatcher()
 
     if (m_cancellable)
         g_object_unref(m_cancellable);
-    if (m_dir_monitor)
-        g_object_unref(m_dir_monitor);
-    if (m_monitor)
-        g_object_unref(m_monitor);
+    releaseMonitors();
     if (m_file)
         g_object_unref(m_file);
 }
@@ -102,8 +86,8 @@ FileWatcher::~FileWatcher()
  * \brief FileWatcher::prepare
  * <br>
  * If file handle has target uri, we need monitor file that target uri point to.
- * FileWatcher::prepare() just query if there is a target uri of current file handle,
- * and it asumed that everything is no problem. If you want to use
+ * FileWatcher::prepare() queries the target uri of current file handle in thread,
+ * the file handle itself is monitored until the target uri is known. If you want to use
  * a file watcher instance, I recommend you call a file enumerator class instance
  * with FileEnumerator::prepare() and wait it finished first.
  * </br>
@@ -111,24 +95,22 @@ FileWatcher::~FileWatcher()
  */
 void FileWatcher::prepare()
 {
-    //FIXME: replace BLOCKING api in ui thread.
-    GFileInfo *info = g_file_query_info(m_file,
-                                        G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        m_cancellable,
-                                        nullptr);
-
-    char *uri = g_file_info_get_attribute_as_string(info,
-                G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
-
-    if (uri) {
+    QString uri = m_uri;
+    AsyncFileUtils::then(AsyncFileUtils::getTargetUri(uri), this, [=](const QString &targetUri) {
+        //the location might be changed before the query finished.
+        if (targetUri.isEmpty() || uri != m_uri || targetUri == m_target_uri)
+            return;
+
+        bool started = m_file_handle > 0 || m_dir_handle > 0;
+        stopMonitor();
+        releaseMonitors();
         g_object_unref(m_file);
-        m_file = g_file_new_for_uri(uri);
-        m_target_uri = uri;
-        g_free(uri);
-    }
-
-    g_object_unref(info);
+        m_file = g_file_new_for_uri(targetUri.toUtf8().constData());
+        m_target_uri = targetUri;
+        acquireMonitors();
+        if (started)
+            startMonitor();
+    });
 }
 
 void FileWatcher::cancel()
@@ -144,8 +126,10 @@ void FileWatcher::startMonitor()
 {
     //make sure only connect once in a watcher.
     stopMonitor();
-    m_file_handle = g_signal_connect(m_monitor, "changed", G_CALLBACK(file_changed_callback), this);
-    m_dir_handle = g_signal_connect(m_dir_monitor, "changed", G_CALLBACK(dir_changed_callback), this);
+    if (m_monitor)
+        m_file_handle = g_signal_connect(m_monitor, "changed", G_CALLBACK(file_changed_callback), this);
+    if (m_dir_monitor)
+        m_dir_handle = g_signal_connect(m_dir_monitor, "changed", G_CALLBACK(dir_changed_callback), this);
 }
 
 void FileWatcher::stopMonitor()
@@ -160,6 +144,139 @@ void FileWatcher::stopMonitor()
     }
 }
 
+/*!
+ * \brief FileWatcher::acquireMonitors
+ * <br>
+ * The monitors are shared with other watchers of the same file, each watcher
+ * only connects its own handlers in startMonitor().
+ * </br>
+ * \see FileMonitorRegistry.
+ */
+void FileWatcher::acquireMonitors()
+{
+    m_support_monitor = true;
+    auto registry = FileMonitorRegistry::getInstance();
+
+    GError *err1 = nullptr;
+    m_monitor = registry->acquire(m_file, FileMonitorRegistry::FileMonitor, &err1);
+    if (err1) {
+        qDebug()<<err1->code<<err1->message;
+        g_error_free(err1);
+        m_support_monitor = false;
+    }
+
+    GError *err2 = nullptr;
+    m_dir_monitor = registry->acquire(m_file, FileMonitorRegistry::DirectoryMonitor, &err2);
+    if (err2) {
+        qDebug()<<err2->code<<err2->message;
+        g_error_free(err2);
+        m_support_monitor = false;
+    }
+}
+
+void FileWatcher::releaseMonitors()
+{
+    auto registry = FileMonitorRegistry::getInstance();
+    registry->release(m_monitor);
+    m_monitor = nullptr;
+    registry->release(m_dir_monitor);
+    m_dir_monitor = nullptr;
+}
+
+void FileWatcher::setCoalesceInterval(int msec)
+{
+    m_coalesce_timer->setInterval(msec);
+}
+
+/*!
+ * \brief FileWatcher::queueChildEvent
+ * <br>
+ * The timer is not restarted by later events, so that a continuous burst is
+ * still emitted once per window.
+ * </br>
+ */
+void FileWatcher::queueChildEvent(const QString &uri, GFileMonitorEvent event_type)
+{
+    if (!m_coalesce_timer->isActive())
+        m_coalesce_timer->start();
+
+    if (m_rescan_requested)
+        return;
+
+    auto iter = m_pending_events.find(uri);
+    if (iter == m_pending_events.end()) {
+        m_pending_uris<<uri;
+        m_pending_events.insert(uri, qMakePair(event_type, event_type));
+    } else if (event_type != G_FILE_MONITOR_EVENT_CHANGED) {
+        //a change of created or deleted file is meaningless.
+        iter.value().second = event_type;
+    }
+
+    if (m_pending_events.count() > m_rescan_threshold) {
+        if (isSignalConnected(QMetaMethod::fromSignal(&FileWatcher::requestUpdateDirectory))) {
+            m_rescan_requested = true;
+            m_pending_uris.clear();
+            m_pending_events.clear();
+        }
+    }
+}
+
+void FileWatcher::flushChildEvents()
+{
+    if (m_rescan_requested) {
+        m_rescan_requested = false;
+        Q_EMIT requestUpdateDirectory();
+        return;
+    }
+
+    QStringList createdUris;
+    QStringList deletedUris;
+    QStringList changedUris;
+    for (auto uri : m_pending_uris) {
+        auto iter = m_pending_events.find(uri);
+        if (iter == m_pending_events.end())
+            continue;
+
+        auto events = iter.value();
+        m_pending_events.erase(iter);
+        switch (events.second) {
+        case G_FILE_MONITOR_EVENT_CREATED:
+            //a replaced file is aslo emitted as created, the item will be updated.
+            createdUris<<uri;
+            break;
+        case G_FILE_MONITOR_EVENT_DELETED:
+            //created and deleted in the window, nothing happened.
+            if (events.first != G_FILE_MONITOR_EVENT_CREATED)
+                deletedUris<<uri;
+            break;
+        default:
+            changedUris<<uri;
+            break;
+        }
+    }
+    m_pending_uris.clear();
+    m_pending_events.clear();
+
+    if (!deletedUris.isEmpty()) {
+        Q_EMIT filesDeleted(deletedUris);
+        for (auto uri : deletedUris) {
+            Q_EMIT fileDeleted(uri);
+        }
+    }
+    if (!createdUris.isEmpty()) {
+        Q_EMIT filesCreated(createdUris);
+        for (auto uri : createdUris) {
+            Q_EMIT fileCreated(uri);
+        }
+    }
+    if (!changedUris.isEmpty()) {
+        Q_EMIT filesChanged(changedUris);
+        for (auto uri : changedUris) {
+            Q_EMIT fileChanged(uri);
+        }
+    }
+}
+
 void FileWatcher::forceChangeMonitorDirectory(const QString &uri)
 {
     changeMonitorUri(uri);
@@ -172,43 +289,26 @@ void FileWatcher::changeMonitorUri(QString uri)
     stopMonitor();
     cancel();
 
+    //the pending events belong to old location.
+    m_coalesce_timer->stop();
+    m_rescan_requested = false;
+    m_pending_uris.clear();
+    m_pending_events.clear();
+
     m_uri = uri;
     m_target_uri = uri;
     if (m_file)
         g_object_unref(m_file);
-    if (m_monitor)
-        g_object_unref(m_monitor);
-    if (m_dir_monitor)
-        g_object_unref(m_dir_monitor);
+    releaseMonitors();
 
     m_file = g_file_new_for_uri(uri.toUtf8().constData());
 
-    prepare();
-
-    GError *err1 = nullptr;
-    m_monitor = g_file_monitor_file(m_file,
-                                    G_FILE_MONITOR_WATCH_MOVES,
-                                    m_cancellable,
-                                    &err1);
-    if (err1) {
-        m_support_monitor = false;
-        qDebug()<<err1->code<<err1->message;
-        g_error_free(err1);
-    }
-
-    GError *err2 = nullptr;
-    m_dir_monitor = g_file_monitor_directory(m_file,
-                    G_FILE_MONITOR_NONE,
-                    m_cancellable,
-                    &err2);
-    if (err2) {
-        m_support_monitor = false;
-        qDebug()<<err2->code<<err2->message;
-        g_error_free(err2);
-    }
+    acquireMonitors();
 
     startMonitor();
 
+    prepare();
+
     Q_EMIT locationChanged(oldUri, m_uri);
 }
 
@@ -276,30 +376,17 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
         if (p_this->m_montor_children_change) {
             char *uri = g_file_get_uri(file);
             QString changedFileUri = uri;
-            //qDebug()<<uri;
-            //QUrl url = changedFileUri;
-            //changedFileUri = url.toDisplayString();
             g_free(uri);
-            Q_EMIT p_this->fileChanged(changedFileUri);
+            p_this->queueChildEvent(changedFileUri, G_FILE_MONITOR_EVENT_CHANGED);
         }
         break;
     }
-    case G_FILE_MONITOR_EVENT_CREATED: {
-        char *uri = g_file_get_uri(file);
-        QString createdFileUri = uri;
-        //QUrl url = createdFileUri;
-        //createdFileUri = url.toDisplayString();
-        g_free(uri);
-        Q_EMIT p_this->fileCreated(createdFileUri);
-        break;
-    }
+    case G_FILE_MONITOR_EVENT_CREATED:
     case G_FILE_MONITOR_EVENT_DELETED: {
         char *uri = g_file_get_uri(file);
-        QString deletedFileUri = uri;
-        //QUrl url = deletedFileUri;
-        //deletedFileUri = url.toDisplayString();
+        QString fileUri = uri;
         g_free(uri);
-        Q_EMIT p_this->fileDeleted(deletedFileUri);
+        p_this->queueChildEvent(fileUri, event_type);
         break;
     }
     case G_FILE_MONITOR_EVENT_UNMOUNTED: {
@@ -24,11 +24,24 @@
 #define FILEWATCHER_H
 
 #include <QObject>
+#include <QHash>
+#include <QPair>
+#include <QStringList>
 
 #include "peony-core_global.h"
 
 #include <gio/gio.h>
 
+#ifndef PEONY_FILE_WATCHER_COALESCE_INTERVAL
+#define PEONY_FILE_WATCHER_COALESCE_INTERVAL 100
+#endif
+
+#ifndef PEONY_FILE_WATCHER_RESCAN_THRESHOLD
+#define PEONY_FILE_WATCHER_RESCAN_THRESHOLD 1000
+#endif
+
+class QTimer;
+
 namespace Peony {
 
 /*!
@@ -41,6 +54,17 @@ namespace Peony {
  * its monitors. If you delete the path (or trash), it will be deleted
  * automaticly later.
  * </br>
+ * <br>
+ * The GFileMonitor handles are shared by all the watchers of the same file
+ * through FileMonitorRegistry, so that opening a directory in many tabs costs
+ * only one inotify watch.
+ * </br>
+ * <br>
+ * The events of children are coalesced in a short window, a file created and
+ * deleted in the window is dropped, and repeated changes of a file are emitted
+ * once. If too many files changed in a window, the watcher gives up the events
+ * and requests a rescan of the directory instead.
+ * </br>
  * \bug
  * FileWatcher can't monitor some special directory, such as a sftp:// server.
  * It will cause the model can not stay in sync with filesystem. This bug is the
@@ -85,6 +109,25 @@ public:
         return m_support_monitor;
     }
 
+    /*!
+     * \brief setCoalesceInterval
+     * \param msec, the window of coalescing children events, default is
+     * PEONY_FILE_WATCHER_COALESCE_INTERVAL.
+     */
+    void setCoalesceInterval(int msec);
+    /*!
+     * \brief setRescanThreshold
+     * \param count
+     * \details
+     * If there are more than count pending events in a window, and
+     * requestUpdateDirectory() is connected, the events are dropped and
+     * requestUpdateDirectory() is emitted once. Otherwise the events are
+     * emitted as usual.
+     */
+    void setRescanThreshold(int count) {
+        m_rescan_threshold = count;
+    }
+
 Q_SIGNALS:
     void locationChanged(const QString &oldUri, const QString &newUri);
     void directoryDeleted(const QString &uri);
@@ -93,6 +136,17 @@ Q_SIGNALS:
     void fileDeleted(const QString &uri);
     void fileChanged(const QString &uri);
 
+    /*!
+     * \brief filesCreated
+     * \param uris
+     * \details
+     * The batched signals are emitted once per coalescing window, before the
+     * single file signals of the same events.
+     */
+    void filesCreated(const QStringList &uris);
+    void filesDeleted(const QStringList &uris);
+    void filesChanged(const QStringList &uris);
+
     /*!
      * \brief requestUpdateDirectory
      * \note
@@ -100,8 +154,6 @@ Q_SIGNALS:
      */
     void requestUpdateDirectory();
 
-    void thumbnailUpdated(const QString &uri);
-
 public Q_SLOTS:
     void cancel();
 
@@ -122,6 +174,12 @@ protected:
 
     void changeMonitorUri(QString uri);
 
+    void acquireMonitors();
+    void releaseMonitors();
+
+    void queueChildEvent(const QString &uri, GFileMonitorEvent event_type);
+    void flushChildEvents();
+
 private:
     QString m_uri = nullptr;
     QString m_target_uri = nullptr;
@@ -148,6 +206,21 @@ private:
     gulong m_dir_handle = 0;
 
     bool m_support_monitor = true;
+
+    QTimer *m_coalesce_timer = nullptr;
+    int m_rescan_threshold = PEONY_FILE_WATCHER_RESCAN_THRESHOLD;
+    bool m_rescan_requested = false;
+    /*!
+     * \brief m_pending_uris
+     * the uris of pending events in the order of their first events, every uri
+     * appears once, m_pending_events decides if and how it is emitted.
+     */
+    QStringList m_pending_uris;
+    /*!
+     * \brief m_pending_events
+     * the first and the last event of an uri in current window.
+     */
+    QHash<QString, QPair<GFileMonitorEvent, GFileMonitorEvent>> m_pending_events;
 };
 
 }
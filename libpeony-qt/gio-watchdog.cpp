@@ -0,0 +1,66 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "gio-watchdog.h"
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+
+using namespace Peony;
+
+GioWatchdog::GioWatchdog(const char *function, const QString &uri)
+{
+    if (!isEnabled())
+        return;
+
+    auto app = QCoreApplication::instance();
+    if (!app || QThread::currentThread() != app->thread())
+        return;
+
+    m_function = function;
+    m_uri = uri;
+    m_watching = true;
+    m_timer.start();
+}
+
+GioWatchdog::~GioWatchdog()
+{
+    if (!m_watching)
+        return;
+
+    auto elapsed = m_timer.elapsed();
+    if (elapsed > PEONY_GIO_WATCHDOG_THRESHOLD) {
+        qWarning()<<"blocking gio call in ui thread:"<<m_function<<m_uri<<elapsed<<"ms";
+    }
+}
+
+bool GioWatchdog::isEnabled()
+{
+#ifdef QT_DEBUG
+    static bool enabled = true;
+#else
+    static bool enabled = qEnvironmentVariableIsSet("PEONY_GIO_WATCHDOG");
+#endif
+    return enabled;
+}
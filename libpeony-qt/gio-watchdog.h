@@ -0,0 +1,83 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef GIOWATCHDOG_H
+#define GIOWATCHDOG_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QElapsedTimer>
+
+/*!
+ * \brief PEONY_GIO_WATCHDOG_THRESHOLD
+ * <br>
+ * The milliseconds a gio call could take in ui thread before it is logged,
+ * about one frame at 60 fps.
+ * </br>
+ */
+#ifndef PEONY_GIO_WATCHDOG_THRESHOLD
+#define PEONY_GIO_WATCHDOG_THRESHOLD 16
+#endif
+
+/*!
+ * \brief PEONY_WATCH_GIO_CALL
+ * <br>
+ * Watch the rest of current scope, which usually is a BLOCKING method.
+ * </br>
+ */
+#define PEONY_WATCH_GIO_CALL(uri) Peony::GioWatchdog gio_watchdog(Q_FUNC_INFO, uri)
+
+namespace Peony {
+
+/*!
+ * \brief The GioWatchdog class
+ * <br>
+ * GioWatchdog logs the blocking gio calls which take longer than
+ * PEONY_GIO_WATCHDOG_THRESHOLD milliseconds in ui thread, they are the
+ * candidates to be replaced by AsyncFileUtils.
+ * </br>
+ * <br>
+ * The watchdog is enabled in debug builds, or when the environment variable
+ * PEONY_GIO_WATCHDOG is set. The calls in other threads are never logged.
+ * </br>
+ * \see AsyncFileUtils.
+ */
+class PEONYCORESHARED_EXPORT GioWatchdog
+{
+public:
+    explicit GioWatchdog(const char *function, const QString &uri = nullptr);
+    ~GioWatchdog();
+
+    static bool isEnabled();
+
+private:
+    const char *m_function = nullptr;
+    QString m_uri;
+    QElapsedTimer m_timer;
+    bool m_watching = false;
+};
+
+}
+
+#endif // GIOWATCHDOG_H
@@ -0,0 +1,274 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-item-filter.h"
+#include "file-item-proxy-filter-sort-model.h"
+#include "file-info-store.h"
+
+#include <QDateTime>
+#include <QtConcurrent>
+
+#include <limits>
+
+//rows are tested in chunks, a chunk should be a multiple of 64, so that one
+//word of bitmap is never written by two threads.
+#ifndef PEONY_FILTER_CHUNK_SIZE
+#define PEONY_FILTER_CHUNK_SIZE 4096
+#endif
+
+#define SIZE_BASE quint64(1000)
+
+using namespace Peony;
+
+typedef FileItemProxyFilterSortModel Proxy;
+
+static bool is_all(const QList<int> &conditions)
+{
+    return conditions.isEmpty() || conditions.contains(0);
+}
+
+static bool is_subset(const QList<int> &conditions, const QList<int> &others)
+{
+    if (is_all(others))
+        return true;
+    if (is_all(conditions))
+        return false;
+    for (auto condition : conditions) {
+        if (!others.contains(condition))
+            return false;
+    }
+    return true;
+}
+
+static quint64 secs_of(const QDate &date)
+{
+    return QDateTime(date, QTime(0, 0)).toMSecsSinceEpoch()/1000;
+}
+
+/*!
+ * \brief type_mask_of
+ * \param mimeType
+ * \return the FilterFileType bits the mime type belongs to, it is the same as
+ * the old string checks of FileItemProxyFilterSortModel::checkFileTypeFilter().
+ */
+static int type_mask_of(const QString &mimeType)
+{
+    int mask = 0;
+    if (mimeType == "inode/directory")
+        mask |= 1 << Proxy::FILE_FOLDER;
+    if (mimeType.contains("image/"))
+        mask |= 1 << Proxy::PICTURE;
+    if (mimeType.contains("video/"))
+        mask |= 1 << Proxy::VIDEO;
+    if (mimeType.contains("text/"))
+        mask |= 1 << Proxy::TXT_FILE;
+    if (mimeType.contains("application/wps-office"))
+        mask |= 1 << Proxy::WPS_FILE;
+    if (mimeType.contains("audio/"))
+        mask |= 1 << Proxy::AUDIO;
+    if (mask == 0)
+        mask |= 1 << Proxy::OTHERS;
+    return mask;
+}
+
+FileItemFilter::FileItemFilter()
+{
+
+}
+
+void FileItemFilter::compile(bool showHidden, const QList<int> &fileTypes, const QList<int> &modifyTimes, const QList<int> &fileSizes, const QStringList &nameKeys)
+{
+    m_show_hidden = showHidden;
+    m_file_types = fileTypes;
+    m_modify_times = modifyTimes;
+    m_file_sizes = fileSizes;
+    m_name_keys = nameKeys;
+
+    m_type_mask = 0;
+    if (!is_all(fileTypes)) {
+        for (auto type : fileTypes) {
+            m_type_mask |= 1 << type;
+        }
+    }
+
+    m_time_ranges.clear();
+    if (!is_all(modifyTimes)) {
+        auto today = QDate::currentDate();
+        auto monday = today.addDays(1 - today.dayOfWeek());
+        auto firstDayOfMonth = QDate(today.year(), today.month(), 1);
+        auto firstDayOfYear = QDate(today.year(), 1, 1);
+        for (auto time : modifyTimes) {
+            switch (time) {
+            case Proxy::TODAY:
+                m_time_ranges<<TimeRange{secs_of(today), secs_of(today.addDays(1))};
+                break;
+            case Proxy::THIS_WEEK:
+                m_time_ranges<<TimeRange{secs_of(monday), secs_of(monday.addDays(7))};
+                break;
+            case Proxy::THIS_MONTH:
+                m_time_ranges<<TimeRange{secs_of(firstDayOfMonth), secs_of(firstDayOfMonth.addMonths(1))};
+                break;
+            case Proxy::THIS_YEAR:
+                m_time_ranges<<TimeRange{secs_of(firstDayOfYear), secs_of(firstDayOfYear.addYears(1))};
+                break;
+            case Proxy::YEAR_AGO:
+                m_time_ranges<<TimeRange{0, secs_of(firstDayOfYear)};
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    m_size_ranges.clear();
+    if (!is_all(fileSizes)) {
+        for (auto size : fileSizes) {
+            switch (size) {
+            case Proxy::TINY: //[0-16K)
+                m_size_ranges<<SizeRange{0, 16 * SIZE_BASE - 1};
+                break;
+            case Proxy::SMALL: //[16k-1M]
+                m_size_ranges<<SizeRange{16 * SIZE_BASE, SIZE_BASE * SIZE_BASE};
+                break;
+            case Proxy::MEDIUM: //(1M-100M]
+                m_size_ranges<<SizeRange{SIZE_BASE * SIZE_BASE + 1, 100 * SIZE_BASE * SIZE_BASE};
+                break;
+            case Proxy::BIG: //(100M-1G]
+                m_size_ranges<<SizeRange{100 * SIZE_BASE * SIZE_BASE + 1, SIZE_BASE * SIZE_BASE * SIZE_BASE};
+                break;
+            case Proxy::LARGE: //>1G
+                m_size_ranges<<SizeRange{SIZE_BASE * SIZE_BASE * SIZE_BASE + 1, std::numeric_limits<quint64>::max()};
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+bool FileItemFilter::accepts(const QString &displayName, const QString &mimeType, quint64 size, quint64 modifiedTime) const
+{
+    if (!m_show_hidden && displayName.startsWith('.'))
+        return false;
+
+    if (m_type_mask != 0 && !(type_mask_of(mimeType) & m_type_mask))
+        return false;
+
+    if (!is_all(m_modify_times)) {
+        bool accepted = false;
+        for (auto range : m_time_ranges) {
+            if (modifiedTime >= range.begin && modifiedTime < range.end) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+            return false;
+    }
+
+    if (!is_all(m_file_sizes)) {
+        bool accepted = false;
+        for (auto range : m_size_ranges) {
+            if (size >= range.min && size <= range.max) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+            return false;
+    }
+
+    if (!m_name_keys.isEmpty()) {
+        bool accepted = false;
+        for (auto key : m_name_keys) {
+            if (displayName.contains(key)) {
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+            return false;
+    }
+
+    return true;
+}
+
+bool FileItemFilter::accepts(FileInfoStore *store, int record) const
+{
+    return accepts(store->displayName(record), store->mimeType(record), store->size(record), store->modifiedTime(record));
+}
+
+bool FileItemFilter::isNarrowerThan(const FileItemFilter &other) const
+{
+    if (m_show_hidden && !other.m_show_hidden)
+        return false;
+
+    if (other.m_type_mask != 0 && (m_type_mask == 0 || (m_type_mask & ~other.m_type_mask)))
+        return false;
+
+    if (!is_subset(m_modify_times, other.m_modify_times))
+        return false;
+
+    if (!is_subset(m_file_sizes, other.m_file_sizes))
+        return false;
+
+    if (!other.m_name_keys.isEmpty()) {
+        if (m_name_keys.isEmpty())
+            return false;
+        for (auto key : m_name_keys) {
+            if (!other.m_name_keys.contains(key))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+QVector<quint64> FileItemFilter::evaluate(FileInfoStore *store, const QVector<int> &records, const QVector<quint64> &candidates) const
+{
+    int count = records.count();
+    QVector<quint64> bitmap((count + 63)/64, 0);
+    quint64 *words = bitmap.data();
+
+    auto evaluateChunk = [=, &records, &candidates](int from) {
+        int to = qMin(from + PEONY_FILTER_CHUNK_SIZE, count);
+        store->forEachRecord(records, from, to, [=, &candidates](int i, const QString &displayName, const QString &mimeType, quint64 size, quint64 modifiedTime) {
+            if (!candidates.isEmpty() && !testBit(candidates, i))
+                return;
+            if (accepts(displayName, mimeType, size, modifiedTime))
+                words[i/64] |= quint64(1) << (i%64);
+        });
+    };
+
+    if (count <= PEONY_FILTER_CHUNK_SIZE) {
+        evaluateChunk(0);
+        return bitmap;
+    }
+
+    QVector<int> chunks;
+    for (int from = 0; from < count; from += PEONY_FILTER_CHUNK_SIZE) {
+        chunks<<from;
+    }
+    QtConcurrent::blockingMap(chunks, evaluateChunk);
+    return bitmap;
+}
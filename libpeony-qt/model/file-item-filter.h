@@ -0,0 +1,129 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEITEMFILTER_H
+#define FILEITEMFILTER_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+
+namespace Peony {
+
+class FileInfoStore;
+
+/*!
+ * \brief The FileItemFilter class
+ * <br>
+ * FileItemFilter is the compiled form of the filter conditions of
+ * FileItemProxyFilterSortModel, including hidden files, file types, modified
+ * times, sizes and name keys. The conditions are translated to masks and time
+ * ranges once, then a record is tested without any allocation.
+ * </br>
+ * <br>
+ * A filter is immutable while evaluating, so it can be used in worker threads.
+ * evaluate() tests a batch of FileInfoStore records in parallel chunks and
+ * returns a bitmap of the accepted rows.
+ * </br>
+ * \note the label conditions are not included, FileLabelModel only can be
+ * used in ui thread.
+ */
+class PEONYCORESHARED_EXPORT FileItemFilter
+{
+public:
+    explicit FileItemFilter();
+
+    /*!
+     * \brief compile
+     * \param showHidden
+     * \param fileTypes, FileItemProxyFilterSortModel::FilterFileType values.
+     * \param modifyTimes, FileItemProxyFilterSortModel::FilterFileModifyTime values.
+     * \param fileSizes, FileItemProxyFilterSortModel::FilterFileSize values.
+     * \param nameKeys
+     * <br>
+     * An empty list or a list contains 0 (ALL_XXX) means all files are accepted
+     * by that kind of condition. The items of a list are or-ed, and the kinds
+     * of conditions are and-ed.
+     * </br>
+     */
+    void compile(bool showHidden,
+                 const QList<int> &fileTypes,
+                 const QList<int> &modifyTimes,
+                 const QList<int> &fileSizes,
+                 const QStringList &nameKeys);
+
+    bool accepts(const QString &displayName, const QString &mimeType, quint64 size, quint64 modifiedTime) const;
+    bool accepts(FileInfoStore *store, int record) const;
+
+    /*!
+     * \brief isNarrowerThan
+     * \param other
+     * \return true if every file accepted by this filter is also accepted by
+     * other, so only the rows other accepted need to be tested again.
+     */
+    bool isNarrowerThan(const FileItemFilter &other) const;
+
+    /*!
+     * \brief evaluate
+     * \param store
+     * \param records, the records of rows.
+     * \param candidates, bitmap of rows to test, the other rows are rejected
+     * directly. An empty bitmap means all rows.
+     * \return bitmap of accepted rows, row i is the bit (i%64) of word (i/64).
+     */
+    QVector<quint64> evaluate(FileInfoStore *store, const QVector<int> &records, const QVector<quint64> &candidates = QVector<quint64>()) const;
+
+    static bool testBit(const QVector<quint64> &bitmap, int row) {
+        return bitmap.at(row/64) & (quint64(1) << (row%64));
+    }
+
+private:
+    struct TimeRange {
+        quint64 begin;
+        quint64 end;
+    };
+
+    struct SizeRange {
+        quint64 min;
+        quint64 max;
+    };
+
+    bool m_show_hidden = false;
+
+    int m_type_mask = 0;
+    QVector<TimeRange> m_time_ranges;
+    QVector<SizeRange> m_size_ranges;
+    QStringList m_name_keys;
+
+    //the source conditions, used to compare filters.
+    QList<int> m_file_types;
+    QList<int> m_modify_times;
+    QList<int> m_file_sizes;
+};
+
+}
+
+#endif // FILEITEMFILTER_H
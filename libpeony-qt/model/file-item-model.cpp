@@ -23,6 +23,7 @@
 #include "file-item-model.h"
 #include "file-item.h"
 #include "file-info.h"
+#include "file-info-manager.h"
 
 #include "file-operation-manager.h"
 #include "file-move-operation.h"
@@ -39,6 +40,9 @@
 #include <QUrl>
 
 #include <QTimer>
+#include <QHash>
+
+#include <algorithm>
 
 #include <QDebug>
 
@@ -75,6 +79,16 @@ void FileItemModel::setRootUri(const QString &uri)
     setRootItem(item);
 }
 
+void FileItemModel::refresh()
+{
+    //the watcher is created when the children are found.
+    if (!m_root_item || !m_root_item->m_watcher) {
+        setRootUri(getRootUri());
+        return;
+    }
+    m_root_item->refreshChildren(true);
+}
+
 void FileItemModel::setRootItem(FileItem *item)
 {
     beginResetModel();
@@ -108,68 +122,154 @@ FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
 
 QModelIndex FileItemModel::firstColumnIndex(FileItem *item)
 {
+    int row = rowOf(item);
+    if (row < 0)
+        return QModelIndex();
+    return createIndex(row, 0, item);
+}
+
+QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
+{
+    int row = rowOf(item);
+    if (row < 0)
+        return QModelIndex();
+    return createIndex(row, columnCount(QModelIndex()) - 1, item);
+}
+
+int FileItemModel::rowOf(FileItem *item)
+{
+    //the root item is not a row of the model.
+    if (!item || item == m_root_item)
+        return -1;
+
     //root children
-    if (item->m_parent == nullptr) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, 0, item);
-            }
+    auto siblings = item->m_parent? item->m_parent->m_children: m_root_item->m_children;
+    int row = item->m_row;
+    if (row >= 0 && row < siblings->count() && siblings->at(row) == item)
+        return row;
+
+    //the rows were shifted by insertions or removals, search outwards from
+    //the old row and only refresh the hints of the siblings passed by, so
+    //the cost is the shifted distance rather than the count of siblings.
+    int count = siblings->count();
+    int start = qBound(0, row, count - 1);
+    for (int distance = 0; start - distance >= 0 || start + distance < count; distance++) {
+        int lower = start - distance;
+        if (lower >= 0) {
+            auto sibling = siblings->at(lower);
+            sibling->m_row = lower;
+            if (sibling == item)
+                return lower;
         }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, 0, item);
+        int upper = start + distance;
+        if (distance > 0 && upper < count) {
+            auto sibling = siblings->at(upper);
+            sibling->m_row = upper;
+            if (sibling == item)
+                return upper;
         }
-        return QModelIndex();
     }
+
+    item->m_row = -1;
+    return -1;
 }
 
-QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
+void FileItemModel::notifyDataChanged(FileItem *item, bool firstColumnOnly)
 {
-    if (!item->m_parent) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, Other, item);
-            }
+    if (!item)
+        return;
+
+    m_request_count++;
+    if (item->m_changed_flags == 0)
+        m_changed_items<<item;
+    item->m_changed_flags |= firstColumnOnly? 1: 2;
+
+    if (!m_flush_scheduled) {
+        m_flush_scheduled = true;
+        QTimer::singleShot(0, this, &FileItemModel::flushDataChanged);
+    }
+}
+
+void FileItemModel::flushDataChanged()
+{
+    m_flush_scheduled = false;
+
+    //rows are grouped by parent, first column changes and whole row changes
+    //are merged separately.
+    QHash<FileItem *, QVector<int>> firstColumnRows;
+    QHash<FileItem *, QVector<int>> wholeRows;
+    for (auto item : m_changed_items) {
+        //the item has been deleted.
+        if (!item)
+            continue;
+
+        int flags = item->m_changed_flags;
+        item->m_changed_flags = 0;
+        int row = rowOf(item);
+        if (row < 0)
+            continue;
+
+        if (flags & 2) {
+            wholeRows[item->m_parent]<<row;
+        } else {
+            firstColumnRows[item->m_parent]<<row;
         }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, Other, item);
+    }
+    m_changed_items.clear();
+
+    for (auto it = wholeRows.begin(); it != wholeRows.end(); it++) {
+        auto parent = it.key()? it.key()->firstColumnIndex(): QModelIndex();
+        emitMergedDataChanged(parent, it.value(), columnCount(parent) - 1);
+    }
+    for (auto it = firstColumnRows.begin(); it != firstColumnRows.end(); it++) {
+        auto parent = it.key()? it.key()->firstColumnIndex(): QModelIndex();
+        emitMergedDataChanged(parent, it.value(), 0);
+    }
+
+    //instrumentation, the rates are updated every second.
+    if (!m_rate_timer.isValid())
+        m_rate_timer.start();
+    if (m_rate_timer.elapsed() >= 1000) {
+        qint64 elapsed = m_rate_timer.restart();
+        m_requests_per_second = m_request_count*1000/elapsed;
+        m_signals_per_second = m_signal_count*1000/elapsed;
+        m_request_count = 0;
+        m_signal_count = 0;
+    }
+}
+
+void FileItemModel::emitMergedDataChanged(const QModelIndex &parent, QVector<int> &rows, int lastColumn)
+{
+    std::sort(rows.begin(), rows.end());
+    int i = 0;
+    while (i < rows.count()) {
+        int first = rows.at(i);
+        int last = first;
+        while (i + 1 < rows.count() && rows.at(i + 1) <= last + 1) {
+            i++;
+            last = rows.at(i);
         }
-        return QModelIndex();
+        i++;
+
+        m_signal_count++;
+        Q_EMIT dataChanged(index(first, 0, parent), index(last, lastColumn, parent));
     }
 }
 
 const QModelIndex FileItemModel::indexFromUri(const QString &uri)
 {
     //FIXME: support recursively finding?
-    for (auto child : *m_root_item->m_children) {
-        GFile *left = g_file_new_for_uri(child->uri().toUtf8().constData());
-        GFile *right = g_file_new_for_uri(uri.toUtf8().constData());
-        bool equal = g_file_equal(left, right);
-        g_object_unref(left);
-        g_object_unref(right);
-        if (equal) {
-            return child->firstColumnIndex();
-        }
-    }
-    return QModelIndex();
+    auto child = m_root_item->getChildFromUri(uri);
+    if (!child)
+        return QModelIndex();
+    return child->firstColumnIndex();
 }
 
 QModelIndex FileItemModel::parent(const QModelIndex &child) const
 {
     FileItem *childItem = static_cast<FileItem*>(child.internalPointer());
     //root children
-    if (childItem->m_parent == nullptr)
+    if (childItem->m_parent == nullptr || childItem->m_parent == m_root_item)
         return QModelIndex();
     return childItem->m_parent->firstColumnIndex();
 }
@@ -199,6 +299,9 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     }
 
     FileItem *item = static_cast<FileItem*>(index.internalPointer());
+    //read the record of info directly, it follows m_info when it is replaced.
+    auto store = FileInfoManager::getInstance()->getStore();
+    int record = item->m_info->record();
 
     // we have to add uri role to every valid index, so that we can ensure
     // that we can open the file/directory correctly.
@@ -213,7 +316,7 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             return QVariant(Qt::AlignHCenter | Qt::AlignBaseline);
         }
         case Qt::DisplayRole: {
-            return QVariant(item->m_info->displayName());
+            return QVariant(store->displayName(record));
         }
         case Qt::DecorationRole: {
             /*
@@ -224,16 +327,16 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             */
             auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(item->m_info->uri());
             if (!thumbnail.isNull()) {
-                if (item->m_info->uri().endsWith(".desktop") && !item->m_info->canExecute()) {
-                    return QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+                if (item->m_info->uri().endsWith(".desktop") && !store->testFlag(record, FileInfoStore::CanExecute)) {
+                    return QIcon::fromTheme(store->iconName(record), QIcon::fromTheme("text-x-generic"));
                 }
                 return thumbnail;
             }
-            QIcon icon = QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+            QIcon icon = QIcon::fromTheme(store->iconName(record), QIcon::fromTheme("text-x-generic"));
             return QVariant(icon);
         }
         case Qt::ToolTipRole: {
-            return QVariant(item->m_info->displayName());
+            return QVariant(store->displayName(record));
         }
         default:
             return QVariant();
@@ -242,7 +345,7 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     case ModifiedDate: {
         switch (role) {
         case Qt::DisplayRole:
-            return QVariant(item->m_info->modifiedDate());
+            return QVariant(store->modifiedDate(record));
         default:
             return QVariant();
         }
@@ -250,10 +353,10 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     case FileType:
         switch (role) {
         case Qt::DisplayRole: {
-            if (item->m_info->isSymbolLink()) {
-                return QVariant(tr("Symbol Link, ") + item->m_info->fileType());
+            if (store->testFlag(record, FileInfoStore::IsSymbolLink)) {
+                return QVariant(tr("Symbol Link, ") + store->fileType(record));
             }
-            return QVariant(item->m_info->fileType());
+            return QVariant(store->fileType(record));
         }
         default:
             return QVariant();
@@ -267,7 +370,7 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
                 }
                 return QVariant();
             }
-            return QVariant(item->m_info->fileSize());
+            return QVariant(store->fileSize(record));
         }
         default:
             return QVariant();
@@ -467,15 +570,9 @@ bool FileItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action, i
             destDirUri = parentItem->m_info->uri();
         }
     } else {
-        //FIXME: for a mounted volume (for example, computer:///),
-        //we have to set the dest dir uri as its mount point.
-        //maybe i should do this when set model root item.
+        //a mounted volume (for example, in computer:///) is replaced by its
+        //mount point when the root item is enumerated, see FileItem::findChildrenAsync().
         destDirUri = m_root_item->m_info->uri();
-        //FIXME: replace BLOCKING api in ui thread.
-        auto targetUri = FileUtils::getTargetUri(destDirUri);
-        if (!targetUri.isEmpty()) {
-            destDirUri = targetUri;
-        }
     }
 
     //if destDirUri was not set, do not execute a drop.
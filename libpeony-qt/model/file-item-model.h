@@ -24,6 +24,9 @@
 #define FILEITEMMODEL_H
 
 #include <QAbstractItemModel>
+#include <QPointer>
+#include <QVector>
+#include <QElapsedTimer>
 #include "peony-core_global.h"
 
 namespace Peony {
@@ -107,6 +110,15 @@ public:
 
     const QString getRootUri();
     void setRootUri(const QString &uri);
+    /*!
+     * \brief refresh
+     * <br>
+     * Refresh the root directory incrementally, the model is only reset
+     * if the root item has not finished finding children.
+     * </br>
+     * \see FileItem::refreshChildren().
+     */
+    void refresh();
     /*!
      * \brief setRootItem
      * \param item, the directory should be shown in view.
@@ -139,9 +151,50 @@ public:
      * \note Every index's internal data at same row is the same item.
      */
     QModelIndex lastColumnIndex(FileItem *item);
+    /*!
+     * \brief rowOf
+     * \param item
+     * \return the row of item in its parent, or -1 if it is not in model.
+     * <br>
+     * Every item remembers its row. The row is checked before used, and if it
+     * is shifted by insertion or removal, the item is searched outwards from
+     * the old row and the siblings passed by are renumbered on the way. The
+     * cost is the distance the row was shifted, so removing rows one by one
+     * does not renumber the whole directory each time. The root item is not
+     * a row and always returns -1 without scanning.
+     * </br>
+     */
+    int rowOf(FileItem *item);
 
     const QModelIndex indexFromUri(const QString &uri);
 
+    /*!
+     * \brief notifyDataChanged
+     * \param item
+     * \param firstColumnOnly, thumbnail changes only need to update the icon.
+     * <br>
+     * Changed items are collected and emitted once per event loop tick, the
+     * contiguous rows of a parent are merged into one dataChanged() signal.
+     * Use this instead of emitting dataChanged() for each item.
+     * </br>
+     */
+    void notifyDataChanged(FileItem *item, bool firstColumnOnly = false);
+
+    /*!
+     * \brief dataChangedRequestsPerSecond
+     * \return notifyDataChanged() calls in the last second.
+     */
+    int dataChangedRequestsPerSecond() {
+        return m_requests_per_second;
+    }
+    /*!
+     * \brief dataChangedSignalsPerSecond
+     * \return dataChanged() signals emitted in the last second.
+     */
+    int dataChangedSignalsPerSecond() {
+        return m_signals_per_second;
+    }
+
     QModelIndex index(int row, int column, const QModelIndex &parent) const override;
     QModelIndex parent(const QModelIndex &child) const override;
 
@@ -262,10 +315,24 @@ public Q_SLOTS:
 
     void setRootIndex(const QModelIndex &index);
 
+protected Q_SLOTS:
+    void flushDataChanged();
+
 private:
+    void emitMergedDataChanged(const QModelIndex &parent, QVector<int> &rows, int lastColumn);
+
     FileItem *m_root_item = nullptr;
     bool m_is_positive = false;
     bool m_can_expand = false;
+
+    QVector<QPointer<FileItem>> m_changed_items;
+    bool m_flush_scheduled = false;
+
+    QElapsedTimer m_rate_timer;
+    int m_request_count = 0;
+    int m_signal_count = 0;
+    int m_requests_per_second = 0;
+    int m_signals_per_second = 0;
 };
 
 }
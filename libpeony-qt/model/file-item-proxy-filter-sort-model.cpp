@@ -37,31 +37,52 @@
 #include <QMessageBox>
 #include <QDate>
 
-#include <QLocale>
-#include <QCollator>
+#include <QtConcurrent>
 
-using namespace Peony;
+#include "file-item-sort-key.h"
+#include "file-info-manager.h"
+#include "file-info-store.h"
+
+#include <QFutureWatcher>
+
+//generate the sort keys in parallel only if there are enough items.
+#ifndef PEONY_PARALLEL_SORT_KEY_THRESHOLD
+#define PEONY_PARALLEL_SORT_KEY_THRESHOLD 2000
+#endif
 
-QLocale locale = QLocale(QLocale::system().name());
-QCollator comparer = QCollator(locale);
+//filter the rows in worker threads without blocking ui if there are too many.
+#ifndef PEONY_ASYNC_FILTER_THRESHOLD
+#define PEONY_ASYNC_FILTER_THRESHOLD 20000
+#endif
+
+using namespace Peony;
 
 FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QSortFilterProxyModel(parent)
 {
-    //enable number sort, like 100 is after 99
-    comparer.setNumericMode(true);
     auto settings = GlobalSettings::getInstance();
     m_show_hidden = settings->isExist("show-hidden")? settings->getValue("show-hidden").toBool(): false;
     m_use_default_name_sort_order = settings->isExist("chinese-first")? settings->getValue("chinese-first").toBool(): false;
     m_folder_first = settings->isExist("folder-first")? settings->getValue("folder-first").toBool(): true;
+    m_filter = compileFilter();
+
+    //the reverse index has been updated when the label of a file changed.
+    connect(FileLabelModel::getGlobalModel(), &FileLabelModel::fileLabelChanged, this, [=]() {
+        if (hasLabelConditions())
+            updateLabelCandidates();
+    });
 }
 
 void FileItemProxyFilterSortModel::setSourceModel(QAbstractItemModel *model)
 {
     if (sourceModel())
         disconnect(sourceModel());
-    QSortFilterProxyModel::setSourceModel(model);
     FileItemModel *file_item_model = static_cast<FileItemModel*>(model);
+    //connect before the base class, the bitmap has to be invalidated before
+    //the changed rows are filtered again.
+    connect(file_item_model, &QAbstractItemModel::dataChanged, this, &FileItemProxyFilterSortModel::onSourceDataChanged);
+    QSortFilterProxyModel::setSourceModel(model);
     connect(file_item_model, &FileItemModel::updated, this, &FileItemProxyFilterSortModel::update);
+    refilter();
 }
 
 FileItem *FileItemProxyFilterSortModel::itemFromIndex(const QModelIndex &proxyIndex)
@@ -83,6 +104,44 @@ const QModelIndex FileItemProxyFilterSortModel::indexFromUri(const QString &uri)
     return mapFromSource(sourceIndex);
 }
 
+void FileItemProxyFilterSortModel::sort(int column, Qt::SortOrder order)
+{
+    prepareSortKeys();
+    QSortFilterProxyModel::sort(column, order);
+}
+
+void FileItemProxyFilterSortModel::prepareSortKeys()
+{
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    if (!model)
+        return;
+
+    //only the top level items, the children of expanded items will generate
+    //their keys at the first comparison, and are updated when their data
+    //changed.
+    QVector<FileItem *> items;
+    int count = model->rowCount(QModelIndex());
+    items.reserve(count);
+    for (int i = 0; i < count; i++) {
+        auto item = model->itemFromIndex(model->index(i, 0, QModelIndex()));
+        if (item)
+            items<<item;
+    }
+
+    if (items.count() < PEONY_PARALLEL_SORT_KEY_THRESHOLD) {
+        for (auto item : items) {
+            item->updateSortKey();
+        }
+        return;
+    }
+
+    //the collation keys are the most expensive part of sorting, generate them
+    //in worker threads, the items are not touched by others until it finished.
+    QtConcurrent::blockingMap(items, [](FileItem *item) {
+        item->updateSortKey();
+    });
+}
+
 bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
     //comment these improve code to fix disorder issue
@@ -103,37 +162,39 @@ bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QMode
         FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
         auto leftItem = model->itemFromIndex(left);
         auto rightItem = model->itemFromIndex(right);
-        if (!(leftItem->hasChildren() && rightItem->hasChildren())) {
+        //the keys are checked before sorting and cached in items, they are
+        //only read here, there is no string allocated.
+        auto &leftKey = leftItem->sortKey();
+        auto &rightKey = rightItem->sortKey();
+        if (leftKey.isFolder() != rightKey.isFolder()) {
             //make folder always has a higher order.
-            if (!leftItem->hasChildren() && !rightItem->hasChildren()) {
-                goto default_sort;
-            }
             if (m_folder_first) {
-                bool lesser = leftItem->hasChildren();
+                bool lesser = leftKey.isFolder();
                 if (sortOrder() == Qt::AscendingOrder)
                     return lesser;
                 return !lesser;
             }
         }
 
-default_sort:
         switch (sortColumn()) {
         case FileItemModel::FileName: {
-            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftItem->m_info->displayName(), rightItem->m_info->displayName())) {
-                return FileOperationUtils::leftNameLesserThanRightName(leftItem->info()->displayName(), rightItem->info()->displayName());
+            //same as FileOperationUtils::leftNameIsDuplicatedFileOfRightName()
+            //and FileOperationUtils::leftNameLesserThanRightName().
+            if (leftKey.duplicateBaseName() == rightKey.duplicateBaseName()) {
+                if (leftKey.duplicateNumber() == rightKey.duplicateNumber())
+                    return leftKey.displayName() < rightKey.displayName();
+                return leftKey.duplicateNumber() < rightKey.duplicateNumber();
             }
             if (m_use_default_name_sort_order) {
-                QString leftDisplayName = leftItem->m_info->displayName();
-                QString rightDisplayName = rightItem->m_info->displayName();
-                return comparer.compare(leftDisplayName, rightDisplayName) < 0;
+                return leftKey.collationKey().compare(rightKey.collationKey()) < 0;
             }
-            return leftItem->m_info->displayName().toLower() < rightItem->m_info->displayName().toLower();
+            return leftKey.numericKey() < rightKey.numericKey();
         }
         case FileItemModel::FileSize: {
             return leftItem->m_info->size() < rightItem->m_info->size();
         }
         case FileItemModel::FileType: {
-            return leftItem->m_info->fileType() < rightItem->m_info->fileType();
+            return leftKey.fileType() < rightKey.fileType();
         }
         case FileItemModel::ModifiedDate: {
             return leftItem->m_info->modifiedTime() < rightItem->m_info->modifiedTime();
@@ -148,324 +209,277 @@ default_sort:
 
 bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    //FIXME:
     FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
     //root
     auto childIndex = model->index(sourceRow, 0, sourceParent);
     if (childIndex.isValid()) {
         auto item = static_cast<FileItem*>(childIndex.internalPointer());
-        if (!m_show_hidden) {
-            //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-            //QMessageBox::warning(nullptr, "filter", item->m_info->displayName());
-            //qDebug()<<item->m_info->displayName();
-            if (item->m_info->displayName() != nullptr) {
-                if (item->m_info->displayName().at(0) == '.')
-                    //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-                    return false;
-            }
+        //the top level rows are evaluated by refilter(), the bitmap is only
+        //valid for the same items it evaluated.
+        bool evaluated = !sourceParent.isValid()
+                && sourceRow < m_filter_items.count()
+                && m_filter_items.at(sourceRow) == item;
+        if (evaluated) {
+            if (!FileItemFilter::testBit(m_accepted_rows, sourceRow))
+                return false;
+        } else {
+            auto store = FileInfoManager::getInstance()->getStore();
+            if (!m_filter.accepts(store, item->m_info->record()))
+                return false;
         }
-        //regExp
 
-        //check the file info filter conditions
-        //qDebug()<<"start filter conditions check"<<item->m_info->displayName()<<item->m_info->type();
-        if (! checkFileTypeFilter(item->m_info->type()))
-            return false;
-        if (! checkFileModifyTimeFilter(item->m_info->modifiedTime()))
-            return false;
-        if (! checkFileSizeFilter(item->m_info->size()))
-            return false;
-        if (! checkFileNameFilter(item->m_info->displayName()))
+        if (hasLabelConditions() && !checkFileLabelFilter(item->uri()))
             return false;
+    }
+    return true;
+}
 
-        //check the file label filter conditions
-        if (m_label_name != "" || m_label_color != Qt::transparent)
+bool FileItemProxyFilterSortModel::hasLabelConditions() const
+{
+    return m_label_name != "" || m_label_color != Qt::transparent
+            || m_show_label_names.size() > 0 || m_show_label_colors.size() > 0
+            || m_blur_name != "";
+}
+
+void FileItemProxyFilterSortModel::updateLabelCandidates()
+{
+    //the files of the matched labels are taken from the reverse index of each
+    //condition, the conditions are and-ed as checkFileLabelFilter() does.
+    auto labelModel = FileLabelModel::getGlobalModel();
+    bool hasShowConditions = m_show_label_names.size() > 0 || m_show_label_colors.size() > 0;
+    auto caseSensitivity = m_case_sensitive? Qt::CaseSensitive: Qt::CaseInsensitive;
+    QSet<QString> nameFiles, colorFiles, showFiles, blurFiles;
+    for (auto item : labelModel->getAllFileLabelItems()) {
+        bool nameMatched = m_label_name != "" && item->name() == m_label_name;
+        bool colorMatched = m_label_color != Qt::transparent && item->color() == m_label_color;
+        bool showMatched = m_show_label_names.contains(item->name()) || m_show_label_colors.contains(item->color());
+        bool blurMatched = m_blur_name != "" && item->name().contains(m_blur_name, caseSensitivity);
+        if (!nameMatched && !colorMatched && !showMatched && !blurMatched)
+            continue;
+
+        auto files = labelModel->getFileUrisWithLabel(item->id()).toSet();
+        if (nameMatched)
+            nameFiles += files;
+        if (colorMatched)
+            colorFiles += files;
+        if (showMatched)
+            showFiles += files;
+        if (blurMatched)
+            blurFiles += files;
+    }
+
+    QList<QSet<QString>> conditionFiles;
+    if (m_label_name != "")
+        conditionFiles<<nameFiles;
+    if (m_label_color != Qt::transparent)
+        conditionFiles<<colorFiles;
+    if (hasShowConditions)
+        conditionFiles<<showFiles;
+    if (m_blur_name != "")
+        conditionFiles<<blurFiles;
+
+    m_label_candidate_uris.clear();
+    if (conditionFiles.isEmpty())
+        return;
+    m_label_candidate_uris = conditionFiles.takeFirst();
+    for (auto files : conditionFiles) {
+        m_label_candidate_uris.intersect(files);
+    }
+}
+
+bool FileItemProxyFilterSortModel::checkFileLabelFilter(const QString &uri) const
+{
+    //the files which are not in the reverse index of matched labels are
+    //rejected without reading their metadata, the candidates are checked with
+    //their own labels, in case the index is out of date.
+    if (!m_label_candidate_uris.contains(uri))
+        return false;
+
+    //check the file label filter conditions
+    if (m_label_name != "" || m_label_color != Qt::transparent)
+    {
+        if (m_label_name != "")
         {
-            QString uri = item->m_info->uri();
-            if (m_label_name != "")
-            {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                if (! names.contains(m_label_name))
-                    return false;
-            }
+            auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
+            if (! names.contains(m_label_name))
+                return false;
+        }
 
-            if (m_label_color != Qt::transparent)
-            {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                if (! colors.contains(m_label_color))
-                    return false;
-            }
+        if (m_label_color != Qt::transparent)
+        {
+            auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
+            if (! colors.contains(m_label_color))
+                return false;
         }
+    }
 
-        //check multiple label filter conditions, file has any one of these label is accepted
-        if(m_show_label_names.size() >0 || m_show_label_colors.size() >0)
+    //check multiple label filter conditions, file has any one of these label is accepted
+    if(m_show_label_names.size() >0 || m_show_label_colors.size() >0)
+    {
+        bool bfind = false;
+        if (m_show_label_names.size() >0 )
         {
-            bool bfind = false;
-            QString uri = item->m_info->uri();
-            if (m_show_label_names.size() >0 )
+            auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
+            for(auto temp : m_show_label_names)
             {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                for(auto temp : m_show_label_names)
+                if(names.contains(temp))
                 {
-                    if(names.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
+                    bfind = true;
+                    break;
                 }
             }
+        }
 
-            if (! bfind && m_show_label_colors.size() >0)
+        if (! bfind && m_show_label_colors.size() >0)
+        {
+            auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
+            for(auto temp : m_show_label_colors)
             {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                for(auto temp : m_show_label_colors)
+                if (colors.contains(temp))
                 {
-                    if (colors.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
+                    bfind = true;
+                    break;
                 }
             }
-
-            if (! bfind)
-                return false;
         }
 
-        //check the blur name, can use as search color labels
-        if (m_blur_name != "")
+        if (! bfind)
+            return false;
+    }
+
+    //check the blur name, can use as search color labels
+    if (m_blur_name != "")
+    {
+        auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
+        bool find = false;
+        for(auto temp : names)
         {
-            QString uri = item->m_info->uri();
-            auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-            bool find = false;
-            for(auto temp : names)
+            if ((m_case_sensitive && temp.indexOf(m_blur_name) >= 0) ||
+                    (! m_case_sensitive && temp.toLower().indexOf(m_blur_name.toLower()) >= 0))
             {
-                if ((m_case_sensitive && temp.indexOf(m_blur_name) >= 0) ||
-                        (! m_case_sensitive && temp.toLower().indexOf(m_blur_name.toLower()) >= 0))
-                {
-                    find = true;
-                    break;
-                }
+                find = true;
+                break;
             }
-            if (! find)
-                return false;
         }
+        if (! find)
+            return false;
     }
     return true;
 }
 
-bool FileItemProxyFilterSortModel::checkFileNameFilter(const QString &displayName) const
+FileItemFilter FileItemProxyFilterSortModel::compileFilter() const
 {
-    if (m_file_name_list.size() == 0)
-        return true;
-
-    for(auto key:m_file_name_list)
-    {
-        if (displayName.contains(key))
-            return true;
+    //the type conditions of default search and advance search are or-ed.
+    QList<int> fileTypes;
+    if (m_file_type_list.contains(ALL_FILE)) {
+        fileTypes<<ALL_FILE;
+    } else {
+        fileTypes = m_file_type_list;
+        if (m_show_file_type != ALL_FILE && !fileTypes.contains(m_show_file_type))
+            fileTypes<<m_show_file_type;
     }
 
-    return false;
+    FileItemFilter filter;
+    filter.compile(m_show_hidden, fileTypes, m_modify_time_list, m_file_size_list, m_file_name_list);
+    return filter;
 }
 
-bool FileItemProxyFilterSortModel::checkFileTypeFilter(QString type) const
+void FileItemProxyFilterSortModel::refilter()
 {
-    //qDebug()<<"m_show_file_type: "<<m_show_file_type<<" "<<type;
-    //multiple condition, advance search and default search
-    if (m_show_file_type == ALL_FILE && m_file_type_list.count() == 0
-        || m_file_type_list.contains(ALL_FILE))
-        return true;
-
-    //support multiple file type choose
-    QList<int> totalTypeList;
-    if (m_file_type_list.count() > 0)
-        totalTypeList.append(m_file_type_list);
-    if (! totalTypeList.contains(m_show_file_type) && m_show_file_type != ALL_FILE)
-        totalTypeList.append(m_show_file_type);
-
-    for(int i=0; i<totalTypeList.count(); i++)
-    {
-        auto cur = totalTypeList[i];
-        switch (cur)
-        {
-        case FILE_FOLDER:
-        {
-            if (type == Folder_Type)
-                return true;
-            break;
-        }
-        case PICTURE:
-        {
-            if (type.contains(Image_Type))
-                return true;
-            break;
-        }
-        case VIDEO:
-        {
-            if (type.contains(Video_Type))
-                return true;
-            break;
-        }
-        case TXT_FILE:
-        {
-            if (type.contains(Text_Type))
-                return true;
-            break;
-        }
-        case WPS_FILE:
-        {
-            if (type.contains(Wps_Type))
-                return true;
-            break;
-        }
-        case AUDIO:
-        {
-            if (type.contains(Audio_Type))
-                return true;
-            break;
-        }
-        case OTHERS:
-        {
-            //exclude classfied types, show the rest other types
-            if (type != Folder_Type && ! type.contains(Image_Type) && ! type.contains(Video_Type)
-                    && ! type.contains(Text_Type) && !type.contains(Wps_Type) && ! type.contains(Audio_Type))
-                return true;
-            break;
-        }
-        default:
-            break;
-        }
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    auto filter = compileFilter();
+    m_filter = filter;
+    if (hasLabelConditions())
+        updateLabelCandidates();
+
+    QVector<FileItem *> items;
+    QVector<int> records;
+    int count = model? model->rowCount(QModelIndex()): 0;
+    items.reserve(count);
+    records.reserve(count);
+    for (int i = 0; i < count; i++) {
+        auto item = model->itemFromIndex(model->index(i, 0, QModelIndex()));
+        items<<item;
+        records<<(item? item->m_info->record(): -1);
     }
 
-    return false;
-}
-
-bool FileItemProxyFilterSortModel::checkFileModifyTimeFilter(quint64 modifiedTime) const
-{
-    //qDebug()<<"checkFileModifyTimeFilter";
-    //have no date filter
-    if (m_modify_time_list.count() == 0 || m_modify_time_list.contains(ALL_FILE))
-        return true;
-
-    auto time = QDateTime::currentMSecsSinceEpoch();
-    auto dateTime = QDateTime::fromMSecsSinceEpoch(time);
-    //qDebug() << "cur QDateTime:" <<dateTime.toString(Qt::SystemLocaleShortDate);
-    QDate date = dateTime.date();
-    int year = date.year();
-    int month = date.month();
-    int day = date.day();
-    QDate md_date =  QDateTime::fromMSecsSinceEpoch(modifiedTime * 1000).date();
-    //qDebug() << "modify time:" <<QDateTime::fromMSecsSinceEpoch(modifiedTime *1000).toString(Qt::SystemLocaleShortDate);
-    int md_year= md_date.year();
-    int md_month = md_date.month();
-    int md_day = md_date.day();
-
-    for(int i=0; i<m_modify_time_list.size(); i++)
-    {
-        auto cur = m_modify_time_list[i];
-        switch(cur)
-        {
-        case TODAY:
-        {
-            if (year == md_year && month == md_month && day == md_day)
-                return true;
-            break;
-        }
-        case THIS_WEEK:
-        {
-            QDate md_date(md_year, md_month, md_day);
-            int week, md_week,week_year, md_week_year;
-            week = date.weekNumber(&week_year);
-            md_week = md_date.weekNumber(&md_week_year);
-            if (week == md_week && week_year == md_week_year)
-                return true;
-            break;
-        }
-        case THIS_MONTH:
-        {
-            if (year == md_year && month == md_month)
-                return true;
-            break;
-        }
-        case THIS_YEAR:
-        {
-            if (year == md_year)
-                return true;
-            break;
-        }
-        case YEAR_AGO:
-        {
-            if(year > md_year)
-                return true;
-            break;
-        }
-        default:
-            break;
-        }
+    //narrowing the filter only needs to test the rows accepted currently.
+    QVector<quint64> candidates;
+    if (filter.isNarrowerThan(m_evaluated_filter) && items == m_filter_items)
+        candidates = m_accepted_rows;
+
+    auto store = FileInfoManager::getInstance()->getStore();
+    int generation = ++m_filter_generation;
+    m_stale_items.clear();
+    m_evaluating = count >= PEONY_ASYNC_FILTER_THRESHOLD;
+    if (count < PEONY_ASYNC_FILTER_THRESHOLD) {
+        m_accepted_rows = filter.evaluate(store, records, candidates);
+        m_evaluated_filter = filter;
+        m_filter_items = items;
+        invalidateFilter();
+        return;
     }
 
-    return false;
+    auto watcher = new QFutureWatcher<QVector<quint64>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        watcher->deleteLater();
+        //there is a newer refilter() started, drop this result.
+        if (generation != m_filter_generation)
+            return;
+        m_accepted_rows = watcher->result();
+        m_evaluated_filter = filter;
+        m_filter_items = items;
+        //the rows changed while evaluating might be tested with old infos.
+        for (int i = 0; i < m_filter_items.count(); i++) {
+            if (m_stale_items.contains(m_filter_items.at(i)))
+                m_filter_items[i] = nullptr;
+        }
+        m_stale_items.clear();
+        m_evaluating = false;
+        invalidateFilter();
+    });
+    watcher->setFuture(QtConcurrent::run([=]() {
+        return filter.evaluate(store, records, candidates);
+    }));
 }
 
-bool FileItemProxyFilterSortModel::checkFileSizeFilter(quint64 size) const
+void FileItemProxyFilterSortModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    //qDebug()<<"checkFileSizeFilter: "<<m_show_file_size<<" "<<size;
-    if (m_file_size_list.count() == 0 || m_file_size_list.contains(ALL_FILE))
-        return true;
+    //this is connected before the proxy handles the change and sorts the rows
+    //again, so the keys are up to date when they are compared.
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    auto parent = topLeft.parent();
+    for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+        auto item = model->itemFromIndex(model->index(row, 0, parent));
+        if (item)
+            item->updateSortKey();
+    }
 
-    for(int i=0; i<m_file_size_list.count(); i++)
-    {
-        auto cur = m_file_size_list[i];
-        switch (cur)
-        {
-        case TINY: //[0-16K)
-        {
-            if (size < 16 * K_BASE)
-                return true;
-            break;
-        }
-        case SMALL:  //[16k-1M]
-        {
-            if(size >= 16 * K_BASE && size <=K_BASE * K_BASE)
-                return true;
-            break;
-        }
-        case MEDIUM: //(1M-100M]
-        {
-            if(size > K_BASE * K_BASE && size <= 100 * K_BASE * K_BASE)
-                return true;
-            break;
-        }
-        case BIG:  //(100M-1G]
-        {
-            if(size > 100 * K_BASE * K_BASE && size <= K_BASE * K_BASE * K_BASE)
-                return true;
-            break;
-        }
-        case LARGE: //>1G
-        {
-            if (size > K_BASE * K_BASE * K_BASE)
-                return true;
-            break;
-        }
-        default:
-            break;
+    //the infos of these rows changed in place, their bits are out of date and
+    //they are tested with the compiled filter until next refilter().
+    if (parent.isValid())
+        return;
+    int last = qMin(bottomRight.row(), m_filter_items.count() - 1);
+    for (int row = topLeft.row(); row <= last; row++) {
+        m_filter_items[row] = nullptr;
+    }
+    if (m_evaluating) {
+        for (int row = topLeft.row(); row <= bottomRight.row(); row++) {
+            m_stale_items.insert(model->itemFromIndex(model->index(row, 0, QModelIndex())));
         }
     }
-
-    return false;
 }
 
-
 void FileItemProxyFilterSortModel::update()
 {
-    invalidateFilter();
+    refilter();
 }
 
 void FileItemProxyFilterSortModel::setShowHidden(bool showHidden)
 {
     GlobalSettings::getInstance()->setValue("show-hidden", showHidden);
     m_show_hidden = showHidden;
-    invalidateFilter();
+    refilter();
 }
 
 void FileItemProxyFilterSortModel::setUseDefaultNameSortOrder(bool use)
@@ -490,7 +504,7 @@ void FileItemProxyFilterSortModel::addFileNameFilter(QString key, bool updateNow
 {
     m_file_name_list.append(key);
     if (updateNow)
-        invalidateFilter();
+        refilter();
 }
 
 void FileItemProxyFilterSortModel::addFilterCondition(int option, int classify, bool updateNow)
@@ -514,7 +528,7 @@ void FileItemProxyFilterSortModel::addFilterCondition(int option, int classify,
     }
 
     if (updateNow)
-        invalidateFilter();
+        refilter();
 }
 
 void FileItemProxyFilterSortModel::removeFilterCondition(int option, int classify, bool updateNow)
@@ -538,7 +552,7 @@ void FileItemProxyFilterSortModel::removeFilterCondition(int option, int classif
     }
 
     if (updateNow)
-        invalidateFilter();
+        refilter();
 }
 
 void FileItemProxyFilterSortModel::clearConditions()
@@ -554,14 +568,14 @@ void FileItemProxyFilterSortModel::setFilterConditions(int fileType, int modifyT
     m_show_file_type = fileType;
     m_show_file_size = fileSize;
     m_show_modify_time = modifyTime;
-    invalidateFilter();
+    refilter();
 }
 
 void FileItemProxyFilterSortModel::setFilterLabelConditions(QString name, QColor color)
 {
     m_label_name = name;
     m_label_color = color;
-    invalidateFilter();
+    refilter();
 }
 
 void FileItemProxyFilterSortModel::setMutipleLabelConditions(QStringList names, QList<QColor> colors)
@@ -577,14 +591,14 @@ void FileItemProxyFilterSortModel::setMutipleLabelConditions(QStringList names,
     {
         m_show_label_colors.append(color);
     }
-    invalidateFilter();
+    refilter();
 }
 
 void FileItemProxyFilterSortModel::setLabelBlurName(QString blurName, bool caseSensitive)
 {
     m_blur_name = blurName;
     m_case_sensitive = caseSensitive;
-    invalidateFilter();
+    refilter();
 }
 
 bool FileItemProxyFilterSortModel::startWithChinese(const QString &displayName) const
@@ -610,8 +624,8 @@ QModelIndexList FileItemProxyFilterSortModel::getAllFileIndexes()
             auto disyplayName = index.data(Qt::DisplayRole).toString();
             if (disyplayName.isEmpty()) {
                 auto uri = this->index(i, 0, QModelIndex()).data(FileItemModel::UriRole).toString();
-                //FIXME: replace BLOCKING api in ui thread.
-                disyplayName = FileUtils::getFileDisplayName(uri);
+                //the info is not queried yet, a hidden file is told by its name.
+                disyplayName = FileUtils::getUriBaseName(uri);
             }
             if (!disyplayName.startsWith(".")) {
                 l<<index;
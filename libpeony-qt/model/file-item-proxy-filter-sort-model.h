@@ -27,8 +27,10 @@
 #include <QObject>
 #include <QSortFilterProxyModel>
 #include <QColor>
+#include <QSet>
 
 #include "peony-core_global.h"
+#include "file-item-filter.h"
 
 namespace Peony {
 
@@ -104,6 +106,16 @@ public:
     QStringList getAllFileUris();
     QModelIndexList getAllFileIndexes();
 
+    /*!
+     * \brief sort
+     * <br>
+     * The sort keys of items are prepared before sorting, with worker threads
+     * if there are many items, then lessThan() only compares the cached keys.
+     * </br>
+     * \see FileItemSortKey.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
 public Q_SLOTS:
     void update();
 
@@ -112,11 +124,42 @@ protected:
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
 
 private:
+    void prepareSortKeys();
+
     bool startWithChinese(const QString &displayName) const;
-    bool checkFileTypeFilter(QString type) const;
-    bool checkFileModifyTimeFilter(quint64 modifiedTime) const;
-    bool checkFileSizeFilter(quint64 size) const;
-    bool checkFileNameFilter(const QString &displayName) const;
+    bool hasLabelConditions() const;
+    /*!
+     * \brief updateLabelCandidates
+     * <br>
+     * collect the files which might match the label conditions from the
+     * reverse index of FileLabelModel, so that the other files are rejected
+     * without parsing their labels.
+     * </br>
+     * \see FileLabelModel::getFileUrisWithLabel().
+     */
+    void updateLabelCandidates();
+    bool checkFileLabelFilter(const QString &uri) const;
+
+    FileItemFilter compileFilter() const;
+    /*!
+     * \brief refilter
+     * <br>
+     * Compile the conditions and test all the top level rows at once, in worker
+     * threads if there are many rows, then the accepted rows are published as
+     * a bitmap and used by filterAcceptsRow(). If the new conditions are
+     * narrower, only the rows accepted currently are tested again.
+     * </br>
+     * \see FileItemFilter.
+     */
+    void refilter();
+    /*!
+     * \brief onSourceDataChanged
+     * <br>
+     * A row changed in place is no longer covered by the bitmap, it is tested
+     * directly until the next refilter().
+     * </br>
+     */
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
 
 private:
     bool m_show_hidden;
@@ -133,6 +176,15 @@ private:
     QStringList m_file_name_list;
     QStringList m_show_label_names;
     QList<QColor> m_show_label_colors;
+    QSet<QString> m_label_candidate_uris;
+
+    FileItemFilter m_filter;
+    FileItemFilter m_evaluated_filter;
+    QVector<FileItem *> m_filter_items;
+    QVector<quint64> m_accepted_rows;
+    QSet<FileItem *> m_stale_items;
+    bool m_evaluating = false;
+    int m_filter_generation = 0;
 };
 
 }
@@ -0,0 +1,120 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-item-sort-key.h"
+
+#include <QCollator>
+#include <QLocale>
+#include <QThreadStorage>
+
+#define NUMERIC_KEY_WIDTH 20
+
+using namespace Peony;
+
+static QThreadStorage<QCollator *> thread_collators;
+
+/*!
+ * \brief thread_collator
+ * \return the collator of current thread.
+ * \note QCollator is not safe to be shared by threads, keys might be
+ * generated in worker threads while sorting.
+ */
+static QCollator *thread_collator()
+{
+    if (!thread_collators.hasLocalData()) {
+        auto collator = new QCollator(QLocale(QLocale::system().name()));
+        //enable number sort, like 100 is after 99
+        collator->setNumericMode(true);
+        thread_collators.setLocalData(collator);
+    }
+    return thread_collators.localData();
+}
+
+/*!
+ * \brief remove_duplicated_suffix
+ * \param name
+ * \param number, the number of last suffix.
+ * \return name without any "(n)", it is the same as removing the
+ * "\(\d+\)" regexp used by FileOperationUtils, but without regexp.
+ */
+static const QString remove_duplicated_suffix(const QString &name, int &number)
+{
+    QString base;
+    base.reserve(name.length());
+    number = 0;
+
+    int i = 0;
+    int length = name.length();
+    while (i < length) {
+        if (name.at(i) == '(') {
+            int j = i + 1;
+            while (j < length && name.at(j).isDigit())
+                j++;
+            if (j > i + 1 && j < length && name.at(j) == ')') {
+                number = name.midRef(i + 1, j - i - 1).toInt();
+                i = j + 1;
+                continue;
+            }
+        }
+        base.append(name.at(i));
+        i++;
+    }
+    return base;
+}
+
+FileItemSortKey::FileItemSortKey(const QString &displayName, const QString &fileType, bool isFolder)
+    : m_display_name(displayName),
+      m_file_type(fileType),
+      m_is_folder(isFolder),
+      m_collation_key(thread_collator()->sortKey(displayName)),
+      m_numeric_key(numericKey(displayName))
+{
+    m_duplicate_base_name = remove_duplicated_suffix(displayName, m_duplicate_number);
+}
+
+const QString FileItemSortKey::numericKey(const QString &name)
+{
+    QString key;
+    key.reserve(name.length() + NUMERIC_KEY_WIDTH);
+
+    auto lower = name.toLower();
+    int i = 0;
+    int length = lower.length();
+    while (i < length) {
+        if (!lower.at(i).isDigit()) {
+            key.append(lower.at(i));
+            i++;
+            continue;
+        }
+
+        int j = i;
+        while (j < length && lower.at(j).isDigit())
+            j++;
+        int digits = j - i;
+        if (digits < NUMERIC_KEY_WIDTH)
+            key.append(QString(NUMERIC_KEY_WIDTH - digits, '0'));
+        key.append(lower.midRef(i, digits));
+        i = j;
+    }
+    return key;
+}
@@ -0,0 +1,102 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEITEMSORTKEY_H
+#define FILEITEMSORTKEY_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QCollatorSortKey>
+
+namespace Peony {
+
+/*!
+ * \brief The FileItemSortKey class
+ * <br>
+ * FileItemSortKey holds everything FileItemProxyFilterSortModel needs to
+ * compare the names of two items. The keys are checked and generated before
+ * sorting and when the item's data changed, lessThan() only reads the cached
+ * keys and does not allocate any string.
+ * </br>
+ * <br>
+ * There are the collation key for chinese first (locale) order, a lower case
+ * key with zero padded numbers for default order, and the name without the
+ * duplicated suffix such as "(1)" with the suffix number. The type description
+ * is kept for sorting by type.
+ * </br>
+ * \see FileItem::updateSortKey(), FileItemProxyFilterSortModel::lessThan().
+ */
+class PEONYCORESHARED_EXPORT FileItemSortKey
+{
+public:
+    explicit FileItemSortKey(const QString &displayName, const QString &fileType, bool isFolder);
+
+    const QString &displayName() const {
+        return m_display_name;
+    }
+    const QString &fileType() const {
+        return m_file_type;
+    }
+    bool isFolder() const {
+        return m_is_folder;
+    }
+    const QCollatorSortKey &collationKey() const {
+        return m_collation_key;
+    }
+    const QString &numericKey() const {
+        return m_numeric_key;
+    }
+    const QString &duplicateBaseName() const {
+        return m_duplicate_base_name;
+    }
+    int duplicateNumber() const {
+        return m_duplicate_number;
+    }
+
+    bool isValidFor(const QString &displayName, const QString &fileType, bool isFolder) const {
+        return m_is_folder == isFolder && m_display_name == displayName && m_file_type == fileType;
+    }
+
+    /*!
+     * \brief numericKey
+     * \param name
+     * \return lower case name with every number padded by zero, so that the
+     * string comparison of keys is the same as numeric comparison, "file9" is
+     * lesser than "file10".
+     */
+    static const QString numericKey(const QString &name);
+
+private:
+    QString m_display_name;
+    QString m_file_type;
+    bool m_is_folder;
+    QCollatorSortKey m_collation_key;
+    QString m_numeric_key;
+    QString m_duplicate_base_name;
+    int m_duplicate_number = 0;
+};
+
+}
+
+#endif // FILEITEMSORTKEY_H
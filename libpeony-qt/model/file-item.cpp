@@ -26,11 +26,15 @@
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "file-operation-utils.h"
 
 #include "file-item-model.h"
+#include "file-item-sort-key.h"
+#include "directory-snapshot.h"
 
 #include "thumbnail-manager.h"
+#include "thumbnail-notifier.h"
 
 #include "gerror-wrapper.h"
 #include "bookmark-manager.h"
@@ -43,6 +47,12 @@
 
 #include <QMessageBox>
 #include <QUrl>
+#include <QSet>
+#include <QtConcurrent>
+#include <QFutureWatcher>
+
+#include <algorithm>
+#include <functional>
 
 using namespace Peony;
 
@@ -51,33 +61,10 @@ FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem,
     m_parent = parentItem;
     m_info = info;
     m_children = new QVector<FileItem*>();
+    m_normalized_uri = FileUtils::normalizedUri(m_info->uri());
 
     m_model = model;
 
-    m_backend_enumerator = new FileEnumerator(this);
-
-    m_thumbnail_watcher = std::make_shared<Peony::FileWatcher>("thumbnail://");
-    connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
-        auto index = m_model->indexFromUri(uri);
-        if (index.isValid()) {
-            auto item = m_model->itemFromIndex(index);
-            if (item) {
-                /*!
-                  \note
-                  fix the probabilistic jamming while thumbnailing with list view.
-
-                  we have to only trigger first column index dataChanged signal,
-                  otherwise there will be probility stucked whole program.
-
-                  i'm not sure if it is a bug of qtreeview.
-                  */
-
-                //m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                m_model->dataChanged(item->firstColumnIndex(), item->firstColumnIndex());
-            }
-        }
-    });
-
     // avoid call any method when model is deleted.
     setParent(m_model);
 }
@@ -88,19 +75,11 @@ FileItem::~FileItem()
     Q_EMIT cancelFindChildren();
     //disconnect();
 
-    if (m_info.use_count() <= 2) {
-        auto info = FileInfoManager::getInstance()->findFileInfoByUri(m_info->uri()).get();
-        if (info == m_info.get()) {
-            Peony::FileInfoManager::getInstance()->lock();
-            Peony::FileInfoManager::getInstance()->remove(m_info);
-            Peony::FileInfoManager::getInstance()->unlock();
-        }
-    }
-
     for (auto child : *m_children) {
         delete child;
     }
     m_children->clear();
+    m_child_index.clear();
 
     delete m_children;
 }
@@ -121,11 +100,15 @@ QVector<FileItem*> *FileItem::findChildrenSync()
     Q_EMIT m_model->findChildrenStarted();
     std::shared_ptr<Peony::FileEnumerator> enumerator = std::make_shared<Peony::FileEnumerator>();
     enumerator->setEnumerateDirectory(m_info->uri());
+    enumerator->setEnumerateWithInfo();
     enumerator->enumerateSync();
     auto infos = enumerator->getChildren(true);
     for (auto info : infos) {
         FileItem *child = new FileItem(info, this, m_model);
         m_children->append(child);
+        indexChild(child);
+        if (enumerator->getEnumeratedInfo(info->uri()))
+            continue;
         FileInfoJob *job = new FileInfoJob(info);
         job->setAutoDelete();
         job->querySync();
@@ -143,6 +126,8 @@ void FileItem::findChildrenAsync()
     m_expanded = true;
     Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
     enumerator->setEnumerateDirectory(m_info->uri());
+    //fill children infos with enumerated results, avoid querying every child again.
+    enumerator->setEnumerateWithInfo();
     //NOTE: entry a new root might destroyed the current enumeration work.
     //the root item will be delete, so we should cancel the previous enumeration.
     enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
@@ -184,62 +169,75 @@ void FileItem::findChildrenAsync()
             return;
         }
 
-        //FIXME: replace BLOCKING api in ui thread.
-        auto target = FileUtils::getTargetUri(m_info->uri());
-        if (!target.isEmpty()) {
-            enumerator->cancel();
-            //enumerator->deleteLater();
-            m_model->setRootUri(target);
-            return;
-        }
-        if (err) {
-            qDebug()<<err->message();
-            ca_context *caContext;
-            ca_context_create(&caContext);
-            const gchar* eventId = "dialog-warning";
-            //eventid 是/usr/share/sounds音频文件名,不带后缀
-            ca_context_play (caContext, 0,
-                             CA_PROP_EVENT_ID, eventId,
-                             CA_PROP_EVENT_DESCRIPTION, tr("Delete file Warning"), NULL);
-
-            if (err.get()->code() == G_IO_ERROR_NOT_FOUND || err.get()->code() == G_IO_ERROR_PERMISSION_DENIED) {
+        //the target of a mountable file is queried in thread.
+        AsyncFileUtils::then(AsyncFileUtils::getTargetUri(m_info->uri()), this, [=](const QString &target) {
+            if (!target.isEmpty()) {
                 enumerator->cancel();
                 //enumerator->deleteLater();
-                m_model->setRootUri(FileUtils::getParentUri(this->uri()));
-                auto fileInfo = FileInfo::fromUri(this->uri(), false);
-                if (err.get()->code() == G_IO_ERROR_NOT_FOUND && fileInfo->isSymbolLink())
-                {
-                    auto result = QMessageBox::question(nullptr, tr("Open Link failed"),
-                                          tr("File not exist, do you want to delete the link file?"));
-                    if (result == QMessageBox::Yes) {
-                        qDebug() << "Delete unused symbollink.";
-                        QStringList selections;
-                        selections.push_back(this->uri());
-                        FileOperationUtils::trash(selections, true);
+                m_model->setRootUri(target);
+                return;
+            }
+            if (err) {
+                qDebug()<<err->message();
+                ca_context *caContext;
+                ca_context_create(&caContext);
+                const gchar* eventId = "dialog-warning";
+                //eventid 是/usr/share/sounds音频文件名,不带后缀
+                ca_context_play (caContext, 0,
+                                 CA_PROP_EVENT_ID, eventId,
+                                 CA_PROP_EVENT_DESCRIPTION, tr("Delete file Warning"), NULL);
+
+                if (err.get()->code() == G_IO_ERROR_NOT_FOUND || err.get()->code() == G_IO_ERROR_PERMISSION_DENIED) {
+                    enumerator->cancel();
+                    //enumerator->deleteLater();
+                    m_model->setRootUri(FileUtils::getParentUri(this->uri()));
+                    auto fileInfo = FileInfo::fromUri(this->uri(), false);
+                    if (err.get()->code() == G_IO_ERROR_NOT_FOUND && fileInfo->isSymbolLink())
+                    {
+                        auto result = QMessageBox::question(nullptr, tr("Open Link failed"),
+                                              tr("File not exist, do you want to delete the link file?"));
+                        if (result == QMessageBox::Yes) {
+                            qDebug() << "Delete unused symbollink.";
+                            QStringList selections;
+                            selections.push_back(this->uri());
+                            FileOperationUtils::trash(selections, true);
+                        }
                     }
+                    return;
+                } else {
+                    QMessageBox::critical(nullptr, tr("Error"), err->message());
+                    enumerator->cancel();
+                    return;
                 }
-                return;
-            } else {
-                QMessageBox::critical(nullptr, tr("Error"), err->message());
-                enumerator->cancel();
-                return;
             }
-        }
-        enumerator->enumerateAsync();
+            enumerator->enumerateAsync();
+        });
     });
 
     if (!m_model->isPositiveResponse()) {
         enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed) {
             if (successed) {
                 auto infos = enumerator->getChildren(true);
-                m_async_count = infos.count();
-                if (infos.count() == 0) {
-                    Q_EMIT m_model->findChildrenFinished();
-                }
+                auto onAllChildrenQueried = [=]() {
+                    if (!m_children->isEmpty())
+                        m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
+                    Q_EMIT this->m_model->findChildrenFinished();
+                    Q_EMIT m_model->updated();
+                    for (auto info : infos) {
+                        ThumbnailManager::getInstance()->createThumbnail(info, thumbnailNotifier());
+                    }
+                };
 
+                m_async_count = 0;
                 for (auto info : infos) {
                     FileItem *child = new FileItem(info, this, m_model);
                     m_children->prepend(child);
+                    indexChild(child);
+                    //enumerated infos have been filled, do not query them again.
+                    if (enumerator->getEnumeratedInfo(info->uri()))
+                        continue;
+
+                    m_async_count++;
                     FileInfoJob *job = new FileInfoJob(info);
                     job->setAutoDelete();
                     /*
@@ -255,21 +253,20 @@ void FileItem::findChildrenAsync()
                         //whatever info was updated, we need decrease the async count.
                         m_async_count--;
                         if (m_async_count == 0) {
-                            m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
-                            Q_EMIT this->m_model->findChildrenFinished();
-                            Q_EMIT m_model->updated();
-                            for (auto info : infos) {
-                                ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-                            }
+                            onAllChildrenQueried();
                         }
                     });
 
                     connect(job, &FileInfoJob::infoUpdated, this, [=](){
-                        m_model->dataChanged(child->firstColumnIndex(), child->lastColumnIndex());
+                        m_model->notifyDataChanged(child);
                     });
 
                     job->queryAsync();
                 }
+
+                if (m_async_count == 0) {
+                    onAllChildrenQueried();
+                }
             } else {
                 Q_EMIT m_model->findChildrenFinished();
                 return;
@@ -280,45 +277,31 @@ void FileItem::findChildrenAsync()
 
             m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
             m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
-                //add new item to m_children
+            connect(m_watcher.get(), &FileWatcher::filesCreated, this, [=](const QStringList &uris) {
+                //add new items to m_children
                 //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
+                this->onChildrenAdded(uris);
+                for (auto uri : uris) {
+                    Q_EMIT this->childAdded(uri);
+                }
             });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
+            connect(m_watcher.get(), &FileWatcher::filesDeleted, this, [=](const QStringList &uris) {
                 //check bookmark and delete
-                auto info = FileInfo::fromUri(uri, false);
-                if (info->isDir())
-                {
-                    BookMarkManager::getInstance()->removeBookMark(uri);
+                for (auto uri : uris) {
+                    auto info = FileInfo::fromUri(uri, false);
+                    if (info->isDir())
+                    {
+                        BookMarkManager::getInstance()->removeBookMark(uri);
+                    }
                 }
-                //remove the crosponding child
+                //remove the crosponding children
                 //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher, true);
-                        /*
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
-                        }
-                        */
-                    });
-                    infoJob->queryAsync();
+                this->onChildrenRemoved(uris);
+                for (auto uri : uris) {
+                    Q_EMIT this->childRemoved(uri);
                 }
             });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
+            connect(m_watcher.get(), &FileWatcher::filesChanged, this, &FileItem::onChildrenChanged);
             connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
                 //clean all the children, if item index is root index, cd up.
                 //this might use FileItemModel::setRootItem()
@@ -352,18 +335,40 @@ void FileItem::findChildrenAsync()
                 return ;
             }
 
+            //insert a whole batch at once when all its infos are ready,
+            //the view can be used as soon as the first batch arrived.
+            QList<std::shared_ptr<FileInfo>> infos;
+            QList<std::shared_ptr<FileInfo>> unqueriedInfos;
             for (auto uri : uris) {
-                auto info = FileInfo::fromUri(uri);
+                auto info = enumerator->getEnumeratedInfo(uri);
+                if (!info) {
+                    info = FileInfo::fromUri(uri);
+                    unqueriedInfos<<info;
+                }
+                infos<<info;
+            }
+
+            if (unqueriedInfos.isEmpty()) {
+                appendChildren(infos);
+                return;
+            }
+
+            auto pendingCount = std::make_shared<int>(unqueriedInfos.count());
+            auto failedInfos = std::make_shared<QList<std::shared_ptr<FileInfo>>>();
+            for (auto info : unqueriedInfos) {
                 auto infoJob = new FileInfoJob(info);
                 infoJob->setAutoDelete();
-                infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-                    auto item = new FileItem(info, this, m_model);
-                    m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-                    m_children->append(item);
-                    m_model->endInsertRows();
-                    //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                    //Q_EMIT m_model->updated();
-                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+                infoJob->connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+                    if (!successed)
+                        *failedInfos<<info;
+                    (*pendingCount)--;
+                    if (*pendingCount == 0) {
+                        auto batch = infos;
+                        for (auto failedInfo : *failedInfos) {
+                            batch.removeOne(failedInfo);
+                        }
+                        appendChildren(batch);
+                    }
                 });
                 infoJob->queryAsync();
             }
@@ -379,43 +384,31 @@ void FileItem::findChildrenAsync()
 
             m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
             m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri) {
-                //add new item to m_children
+            connect(m_watcher.get(), &FileWatcher::filesCreated, this, [=](const QStringList &uris) {
+                //add new items to m_children
                 //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-                ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
+                this->onChildrenAdded(uris);
+                for (auto uri : uris) {
+                    Q_EMIT this->childAdded(uri);
+                }
             });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri) {
+            connect(m_watcher.get(), &FileWatcher::filesDeleted, this, [=](const QStringList &uris) {
                 //check bookmark and delete
-                auto info = FileInfo::fromUri(uri, false);
-                if (info->isDir())
-                {
-                    BookMarkManager::getInstance()->removeBookMark(uri);
+                for (auto uri : uris) {
+                    auto info = FileInfo::fromUri(uri, false);
+                    if (info->isDir())
+                    {
+                        BookMarkManager::getInstance()->removeBookMark(uri);
+                    }
                 }
-                //remove the crosponding child
+                //remove the crosponding children
                 //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
+                this->onChildrenRemoved(uris);
+                for (auto uri : uris) {
+                    Q_EMIT this->childRemoved(uri);
                 }
             });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
+            connect(m_watcher.get(), &FileWatcher::filesChanged, this, &FileItem::onChildrenChanged);
             connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri) {
                 //clean all the children, if item index is root index, cd up.
                 //this might use FileItemModel::setRootItem()
@@ -440,6 +433,54 @@ void FileItem::findChildrenAsync()
     enumerator->prepare();
 }
 
+void FileItem::appendChildren(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    if (infos.isEmpty())
+        return;
+
+    int first = m_children->count();
+    m_model->beginInsertRows(firstColumnIndex(), first, first + infos.count() - 1);
+    for (auto info : infos) {
+        auto item = new FileItem(info, this, m_model);
+        m_children->append(item);
+        indexChild(item);
+    }
+    m_model->endInsertRows();
+
+    for (auto info : infos) {
+        ThumbnailManager::getInstance()->createThumbnail(info, thumbnailNotifier());
+    }
+}
+
+std::shared_ptr<ThumbnailNotifier> FileItem::thumbnailNotifier()
+{
+    if (m_thumbnail_notifier)
+        return m_thumbnail_notifier;
+
+    m_thumbnail_notifier = std::make_shared<ThumbnailNotifier>();
+    connect(m_thumbnail_notifier.get(), &ThumbnailNotifier::thumbnailUpdated, this, [=](const QString &uri) {
+        auto index = m_model->indexFromUri(uri);
+        if (index.isValid()) {
+            auto item = m_model->itemFromIndex(index);
+            if (item) {
+                /*!
+                  \note
+                  fix the probabilistic jamming while thumbnailing with list view.
+
+                  we have to only trigger first column index dataChanged signal,
+                  otherwise there will be probility stucked whole program.
+
+                  i'm not sure if it is a bug of qtreeview.
+                  */
+
+                //m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
+                m_model->notifyDataChanged(item, true);
+            }
+        }
+    });
+    return m_thumbnail_notifier;
+}
+
 QModelIndex FileItem::firstColumnIndex()
 {
     return m_model->firstColumnIndex(this);
@@ -456,16 +497,37 @@ bool FileItem::hasChildren()
     return m_info->isDir() || m_info->isVolume() || m_children->count() > 0;
 }
 
+void FileItem::updateSortKey()
+{
+    auto displayName = m_info->displayName();
+    auto fileType = m_info->fileType();
+    bool isFolder = hasChildren();
+    if (!m_sort_key || !m_sort_key->isValidFor(displayName, fileType, isFolder))
+        m_sort_key = std::make_shared<FileItemSortKey>(displayName, fileType, isFolder);
+}
+
+const FileItemSortKey &FileItem::sortKey()
+{
+    if (!m_sort_key)
+        updateSortKey();
+    return *m_sort_key;
+}
+
 FileItem *FileItem::getChildFromUri(QString uri)
 {
-    for (auto item : *m_children) {
-        QUrl itemUrl = item->uri();
-        QUrl url = uri;
-        QString decodedUri = url.toDisplayString();
-        if (decodedUri == itemUrl.toDisplayString())
-            return item;
-    }
-    return nullptr;
+    return m_child_index.value(FileUtils::normalizedUri(uri), nullptr);
+}
+
+void FileItem::indexChild(FileItem *child)
+{
+    m_child_index.insert(child->m_normalized_uri, child);
+}
+
+void FileItem::unindexChild(FileItem *child)
+{
+    auto iter = m_child_index.find(child->m_normalized_uri);
+    if (iter != m_child_index.end() && iter.value() == child)
+        m_child_index.erase(iter);
 }
 
 void FileItem::onChildAdded(const QString &uri)
@@ -487,10 +549,11 @@ void FileItem::onChildAdded(const QString &uri)
         auto item = new FileItem(info, this, m_model);
         m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
         m_children->append(item);
+        indexChild(item);
         m_model->endInsertRows();
         //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
         //Q_EMIT m_model->updated();
-        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        ThumbnailManager::getInstance()->createThumbnail(info, thumbnailNotifier());
     });
     infoJob->queryAsync();
 
@@ -507,15 +570,126 @@ void FileItem::onChildRemoved(const QString &uri)
 {
     FileItem *child = getChildFromUri(uri);
     if (child) {
-        int index = m_children->indexOf(child);
+        int index = m_model->rowOf(child);
         m_model->beginRemoveRows(this->firstColumnIndex(), index, index);
-        m_children->removeOne(child);
+        m_children->remove(index);
+        unindexChild(child);
         delete child;
         m_model->endRemoveRows();
     }
     m_model->updated();
 }
 
+void FileItem::onChildrenAdded(const QStringList &uris)
+{
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto uri : uris) {
+        FileItem *child = getChildFromUri(uri);
+        if (child) {
+            //child info maybe changed, so need update again
+            child->updateInfoAsync();
+            continue;
+        }
+        infos<<FileInfo::fromUri(uri);
+    }
+
+    if (infos.isEmpty())
+        return;
+
+    //insert the whole batch with one row insertion when all its infos are ready.
+    auto pendingCount = std::make_shared<int>(infos.count());
+    auto queriedInfos = std::make_shared<QList<std::shared_ptr<FileInfo>>>();
+    for (auto info : infos) {
+        auto infoJob = new FileInfoJob(info);
+        infoJob->setAutoDelete();
+        infoJob->connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+            //the child might be added by another request during querying.
+            if (successed && !getChildFromUri(info->uri()))
+                *queriedInfos<<info;
+            (*pendingCount)--;
+            if (*pendingCount == 0) {
+                appendChildren(*queriedInfos);
+            }
+        });
+        infoJob->queryAsync();
+    }
+}
+
+void FileItem::onChildrenChanged(const QStringList &uris)
+{
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto uri : uris) {
+        FileItem *child = getChildFromUri(uri);
+        if (child)
+            infos<<child->m_info;
+    }
+
+    if (infos.isEmpty())
+        return;
+
+    //notify the model and update the thumbnails of the whole batch when all
+    //its infos are queried again.
+    auto pendingCount = std::make_shared<int>(infos.count());
+    auto queriedInfos = std::make_shared<QList<std::shared_ptr<FileInfo>>>();
+    for (auto info : infos) {
+        auto infoJob = new FileInfoJob(info);
+        infoJob->setAutoDelete();
+        infoJob->connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](bool successed) {
+            if (successed)
+                *queriedInfos<<info;
+            (*pendingCount)--;
+            if (*pendingCount > 0)
+                return;
+
+            for (auto queriedInfo : *queriedInfos) {
+                //the child might be removed during querying.
+                FileItem *child = getChildFromUri(queriedInfo->uri());
+                if (!child)
+                    continue;
+                m_model->notifyDataChanged(child, true);
+                ThumbnailManager::getInstance()->createThumbnail(queriedInfo, thumbnailNotifier(), true);
+            }
+        });
+        infoJob->queryAsync();
+    }
+}
+
+void FileItem::onChildrenRemoved(const QStringList &uris)
+{
+    QList<int> rows;
+    for (auto uri : uris) {
+        FileItem *child = getChildFromUri(uri);
+        if (child)
+            rows<<m_model->rowOf(child);
+    }
+
+    //remove the contiguous rows with one row removal, from the last row,
+    //so that the rows not removed yet are still valid.
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    auto parent = firstColumnIndex();
+    int i = 0;
+    while (i < rows.count()) {
+        int last = rows.at(i);
+        int first = last;
+        i++;
+        while (i < rows.count() && rows.at(i) == first - 1) {
+            first = rows.at(i);
+            i++;
+        }
+
+        m_model->beginRemoveRows(parent, first, last);
+        for (int row = first; row <= last; row++) {
+            auto child = m_children->at(row);
+            unindexChild(child);
+            delete child;
+        }
+        m_children->remove(first, last - first + 1);
+        m_model->endRemoveRows();
+    }
+    m_model->updated();
+}
+
 void FileItem::onDeleted(const QString &thisUri)
 {
     qDebug()<<"deleted";
@@ -530,11 +704,13 @@ void FileItem::onDeleted(const QString &thisUri)
         if (m_parent->m_info->uri() == thisUri) {
             m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
             m_parent->m_children->removeOne(this);
+            m_parent->unindexChild(this);
         } else {
             //if just clear children, there will be a small problem.
             clearChildren();
             m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
             m_parent->m_children->removeOne(this);
+            m_parent->unindexChild(this);
             m_parent->onChildAdded(m_info->uri());
         }
         this->deleteLater();
@@ -567,50 +743,87 @@ void FileItem::onRenamed(const QString &oldUri, const QString &newUri)
 
 void FileItem::onUpdateDirectoryRequest()
 {
-    auto enumerator = new FileEnumerator(this);
-    enumerator->setEnumerateDirectory(m_model->getRootUri());
-    connect(enumerator, &FileEnumerator::enumerateFinished, m_model, [=](){
-        if (m_model->getRootUri() != enumerator->getEnumerateUri())
-            return;
+    refreshChildren();
+}
 
-        auto currentUris = enumerator->getChildrenUris();
-        QStringList rawUris;
-        QStringList removedUris;
-        QStringList addedUris;
+void FileItem::refreshChildren(bool reportFinished)
+{
+    m_report_refresh_finished |= reportFinished;
+    if (m_refreshing) {
+        //a burst of requests only takes one more snapshot.
+        m_refresh_pending = true;
+        return;
+    }
+    m_refreshing = true;
 
-        for (auto child : *m_model->m_root_item->m_children) {
-            rawUris<<child->uri();
-            if (!currentUris.contains(child->uri())) {
-                removedUris<<child->uri();
-                m_model->m_root_item->onChildRemoved(child->uri());
-            }
+    auto uri = m_info->uri();
+    auto watcher = new QFutureWatcher<DirectorySnapshot>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        watcher->deleteLater();
+        m_refreshing = false;
+
+        auto snapshot = watcher->result();
+        if (snapshot.isValid())
+            applySnapshot(snapshot);
+
+        if (m_refresh_pending) {
+            m_refresh_pending = false;
+            refreshChildren();
+            return;
         }
 
-        for (auto uri : currentUris) {
-            if (!rawUris.contains(uri)) {
-                addedUris<<uri;
-                m_model->m_root_item->onChildAdded(uri);
-            }
+        if (m_report_refresh_finished) {
+            m_report_refresh_finished = false;
+            Q_EMIT m_model->findChildrenFinished();
+            Q_EMIT m_model->updated();
         }
+    });
+    watcher->setFuture(QtConcurrent::run([=]() {
+        DirectorySnapshot snapshot(uri);
+        snapshot.take();
+        return snapshot;
+    }));
+}
 
-        for (auto uri : currentUris) {
-            if (!addedUris.contains(uri) && !removedUris.contains(uri)) {
-                //m_model->m_root_item->getChildFromUri(uri)->updateInfoAsync();
-            }
+void FileItem::applySnapshot(DirectorySnapshot &snapshot)
+{
+    //an incomplete snapshot would remove the children not enumerated.
+    if (!snapshot.isValid())
+        return;
+
+    QStringList addedUris;
+    QSet<FileItem *> existedChildren;
+    existedChildren.reserve(m_children->count());
+    for (const auto &entry : snapshot.entries()) {
+        FileItem *child = getChildFromUri(entry.uri);
+        if (!child) {
+            addedUris<<entry.uri;
+            continue;
         }
+        existedChildren.insert(child);
+        //unchanged children are not touched, there is no model churn.
+        if (DirectorySnapshot::isChanged(entry, child->m_info))
+            child->updateInfoAsync();
+    }
 
-        enumerator->deleteLater();
-    });
+    QStringList removedUris;
+    for (auto child : *m_children) {
+        if (!existedChildren.contains(child))
+            removedUris<<child->uri();
+    }
 
-    enumerator->enumerateAsync();
+    if (!removedUris.isEmpty())
+        onChildrenRemoved(removedUris);
+    if (!addedUris.isEmpty())
+        onChildrenAdded(addedUris);
 }
 
 void FileItem::updateInfoSync()
 {
     FileInfoJob *job = new FileInfoJob(m_info);
     if (job->querySync()) {
-        m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
-        ThumbnailManager::getInstance()->createThumbnail(this->uri(), m_thumbnail_watcher, true);
+        m_model->notifyDataChanged(this);
+        ThumbnailManager::getInstance()->createThumbnail(m_info, thumbnailNotifier(), true);
     }
     job->deleteLater();
 }
@@ -620,8 +833,8 @@ void FileItem::updateInfoAsync()
     FileInfoJob *job = new FileInfoJob(m_info);
     job->setAutoDelete();
     job->connect(job, &FileInfoJob::infoUpdated, this, [=]() {
-        m_model->dataChanged(this->firstColumnIndex(), this->lastColumnIndex());
-        ThumbnailManager::getInstance()->createThumbnail(this->uri(), m_thumbnail_watcher, true);
+        m_model->notifyDataChanged(this);
+        ThumbnailManager::getInstance()->createThumbnail(m_info, thumbnailNotifier(), true);
     });
     job->queryAsync();
 }
@@ -634,6 +847,7 @@ void FileItem::clearChildren()
         delete child;
     }
     m_children->clear();
+    m_child_index.clear();
     m_expanded = false;
     m_watcher.reset();
     m_watcher = nullptr;
@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QVector>
+#include <QHash>
 
 namespace Peony {
 
@@ -37,6 +38,9 @@ class FileItemModel;
 class FileWatcher;
 class FileItemProxyFilterSortModel;
 class FileEnumerator;
+class FileItemSortKey;
+class ThumbnailNotifier;
+class DirectorySnapshot;
 
 /*!
  * \brief The FileItem class
@@ -92,6 +96,29 @@ public:
 
     bool hasChildren();
 
+    /*!
+     * \brief updateSortKey
+     * <br>
+     * check the cached sort key against the info, and generate it again if the
+     * display name, the type description or the folder type has been changed.
+     * It is called before sorting and when the item's data changed, not in
+     * every comparison.
+     * </br>
+     * \see FileItemProxyFilterSortModel::prepareSortKeys().
+     */
+    void updateSortKey();
+
+    /*!
+     * \brief sortKey
+     * \return the cached sort key of this item.
+     * <br>
+     * The key is not checked here, it is generated only if there is no key yet,
+     * such as an item inserted after sorting.
+     * </br>
+     * \see FileItemSortKey, updateSortKey().
+     */
+    const FileItemSortKey &sortKey();
+
 Q_SIGNALS:
     void cancelFindChildren();
     void childAdded(const QString &uri);
@@ -102,6 +129,35 @@ Q_SIGNALS:
 public Q_SLOTS:
     void onChildAdded(const QString &uri);
     void onChildRemoved(const QString &uri);
+    /*!
+     * \brief onChildrenAdded
+     * \param uris
+     * <br>
+     * Batched version of onChildAdded(), the new children are inserted with
+     * one row insertion once all their infos are queried.
+     * </br>
+     * \see FileWatcher::filesCreated().
+     */
+    void onChildrenAdded(const QStringList &uris);
+    /*!
+     * \brief onChildrenRemoved
+     * \param uris
+     * <br>
+     * Batched version of onChildRemoved(), the contiguous rows are removed
+     * with one row removal.
+     * </br>
+     */
+    void onChildrenRemoved(const QStringList &uris);
+    /*!
+     * \brief onChildrenChanged
+     * \param uris
+     * <br>
+     * The infos of the changed children are queried again, and the model is
+     * notified once for the whole batch.
+     * </br>
+     * \see FileWatcher::filesChanged().
+     */
+    void onChildrenChanged(const QStringList &uris);
     void onDeleted(const QString &thisUri);
     void onRenamed(const QString &oldUri, const QString &newUri);
 
@@ -120,6 +176,17 @@ protected:
      */
     FileItem *getChildFromUri(QString uri);
 
+    /*!
+     * \brief indexChild
+     * \param child
+     * <br>
+     * Every change of m_children should be synchronized to the uri index with
+     * indexChild() and unindexChild(), so that getChildFromUri() is O(1).
+     * </br>
+     */
+    void indexChild(FileItem *child);
+    void unindexChild(FileItem *child);
+
     /*!
      * \brief updateInfoSync
      * <br>
@@ -140,6 +207,38 @@ protected:
      */
     void updateInfoAsync();
 
+    /*!
+     * \brief appendChildren
+     * \param infos, queried infos of a batch of newly found children.
+     * <br>
+     * Insert all the children of a batch with one row insertion, this is
+     * much cheaper than inserting them one by one in a large directory.
+     * </br>
+     */
+    void appendChildren(const QList<std::shared_ptr<FileInfo>> &infos);
+
+    /*!
+     * \brief thumbnailNotifier
+     * \return the notifier passed to ThumbnailManager, it is created at
+     * the first thumbnail request of this item.
+     * \see ThumbnailNotifier.
+     */
+    std::shared_ptr<ThumbnailNotifier> thumbnailNotifier();
+
+    /*!
+     * \brief refreshChildren
+     * \param reportFinished, if true, the model will emit findChildrenFinished()
+     * when the refresh is done.
+     * <br>
+     * Take a snapshot of this directory in a worker thread, and compare it
+     * with current children. Only the children added, removed or changed are
+     * updated, so the selections, scroll position and thumbnails are kept.
+     * </br>
+     * \see DirectorySnapshot.
+     */
+    void refreshChildren(bool reportFinished = false);
+    void applySnapshot(DirectorySnapshot &snapshot);
+
 private:
     FileItem *m_parent = nullptr;
     std::shared_ptr<Peony::FileInfo> m_info;
@@ -150,7 +249,7 @@ private:
     bool m_expanded = false;
 
     std::shared_ptr<FileWatcher> m_watcher = nullptr;
-    std::shared_ptr<FileWatcher> m_thumbnail_watcher = nullptr;
+    std::shared_ptr<ThumbnailNotifier> m_thumbnail_notifier = nullptr;
 
     /*!
      * \brief m_async_count
@@ -163,11 +262,36 @@ private:
     int m_async_count = 0;
 
     /*!
-     * \brief m_backend_enumerator
-     * \note
-     * only used in directory not support monitor.
+     * \brief m_row
+     * <br>
+     * the row hint of this item in its parent, it is maintained by
+     * FileItemModel::rowOf().
+     * </br>
      */
-    FileEnumerator *m_backend_enumerator;
+    int m_row = -1;
+
+    /*!
+     * \brief m_changed_flags
+     * <br>
+     * pending dataChanged notification of this item, 1 for first column and
+     * 2 for whole row, it is cleared once the model flushed it.
+     * </br>
+     * \see FileItemModel::notifyDataChanged().
+     */
+    int m_changed_flags = 0;
+
+    std::shared_ptr<FileItemSortKey> m_sort_key;
+
+    /*!
+     * \brief m_normalized_uri
+     * \see FileUtils::normalizedUri().
+     */
+    QString m_normalized_uri;
+    QHash<QString, FileItem*> m_child_index;
+
+    bool m_refreshing = false;
+    bool m_refresh_pending = false;
+    bool m_report_refresh_finished = false;
 };
 
 }
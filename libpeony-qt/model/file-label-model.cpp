@@ -30,12 +30,27 @@
 
 #include <QMessageBox>
 
+//the count of files whose parsed labels are cached, the least recently used
+//ones are dropped when it is exceeded.
+#ifndef PEONY_FILE_LABEL_CACHE_LIMIT
+#define PEONY_FILE_LABEL_CACHE_LIMIT 10000
+#endif
+
 static FileLabelModel *global_instance = nullptr;
 
 FileLabelModel::FileLabelModel(QObject *parent)
     : QAbstractListModel(parent)
 {
     m_label_settings = new QSettings(QSettings::UserScope, "org.ukui", "peony-qt", this);
+    m_file_label_cache.setMaxCost(PEONY_FILE_LABEL_CACHE_LIMIT);
+
+    m_label_index_settings = new QSettings(QSettings::UserScope, "org.ukui", "peony-qt-file-labels", this);
+    m_save_index_timer = new QTimer(this);
+    m_save_index_timer->setSingleShot(true);
+    m_save_index_timer->setInterval(1000);
+    connect(m_save_index_timer, &QTimer::timeout, this, &FileLabelModel::saveReverseIndex);
+    loadReverseIndex();
+
     if (m_label_settings->value("lastid").isNull()) {
         //init settings
         addLabel(tr("Red"), Qt::red);
@@ -137,6 +152,7 @@ void FileLabelModel::addLabel(const QString &label, const QColor &color)
     item->m_color = color;
 
     m_labels.append(item);
+    m_label_ids.insert(item->id(), item);
 
     addId();
 
@@ -163,14 +179,18 @@ void FileLabelModel::removeLabel(int id)
 {
     beginResetModel();
 
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            m_labels.removeOne(item);
-            item->deleteLater();
-            break;
-        }
+    auto item = m_label_ids.take(id);
+    if (item) {
+        m_labels.removeOne(item);
+        item->deleteLater();
     }
 
+    m_cache_mutex.lock();
+    if (m_label_files.remove(id) > 0)
+        m_dirty_label_ids<<id;
+    m_cache_mutex.unlock();
+    scheduleSaveReverseIndex();
+
     m_label_settings->beginWriteArray("labels");
     m_label_settings->setArrayIndex(id);
     m_label_settings->setValue("visible", false);
@@ -182,50 +202,33 @@ void FileLabelModel::removeLabel(int id)
 
 void FileLabelModel::setLabelName(int id, const QString &name)
 {
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            item->setName(name);
-            int row = m_labels.indexOf(item);
-            Q_EMIT dataChanged(index(row), index(row));
-            break;
-        }
+    auto item = itemFromId(id);
+    if (item) {
+        item->setName(name);
+        int row = m_labels.indexOf(item);
+        Q_EMIT dataChanged(index(row), index(row));
     }
 }
 
 void FileLabelModel::setLabelColor(int id, const QColor &color)
 {
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            item->setColor(color);
-            int row = m_labels.indexOf(item);
-            Q_EMIT dataChanged(index(row), index(row));
-            break;
-        }
+    auto item = itemFromId(id);
+    if (item) {
+        item->setColor(color);
+        int row = m_labels.indexOf(item);
+        Q_EMIT dataChanged(index(row), index(row));
     }
 }
 
 const QList<int> FileLabelModel::getFileLabelIds(const QString &uri)
 {
-    QList<int> l;
-    auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
-        return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        l<<label.toInt();
-    }
-    return l;
+    return cachedFileLabelIds(uri);
 }
 
 const QStringList FileLabelModel::getFileLabels(const QString &uri)
 {
     QStringList l;
-    auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
-        return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        auto id = label.toInt();
+    for (auto id : cachedFileLabelIds(uri)) {
         auto item = itemFromId(id);
         if (item) {
             l<<item->name();
@@ -237,12 +240,7 @@ const QStringList FileLabelModel::getFileLabels(const QString &uri)
 const QList<QColor> FileLabelModel::getFileColors(const QString &uri)
 {
     QList<QColor> l;
-    auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
-        return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        auto id = label.toInt();
+    for (auto id : cachedFileLabelIds(uri)) {
         auto item = itemFromId(id);
         if (item) {
             l<<item->color();
@@ -253,12 +251,118 @@ const QList<QColor> FileLabelModel::getFileColors(const QString &uri)
 
 FileLabelItem *FileLabelModel::itemFromId(int id)
 {
-    for (auto item : this->m_labels) {
-        if (id == item->id()) {
-            return item;
+    return m_label_ids.value(id, nullptr);
+}
+
+const QStringList FileLabelModel::getFileUrisWithLabel(int labelId)
+{
+    QMutexLocker locker(&m_cache_mutex);
+    return m_label_files.value(labelId).toList();
+}
+
+const QStringList FileLabelModel::getFileUrisWithLabel(const QString &labelName)
+{
+    for (auto item : m_labels) {
+        if (item->name() == labelName)
+            return getFileUrisWithLabel(item->id());
+    }
+    return QStringList();
+}
+
+const QList<int> FileLabelModel::cachedFileLabelIds(const QString &uri)
+{
+    QList<int> ids;
+    auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
+    if (!metaInfo)
+        return ids;
+
+    m_cache_mutex.lock();
+    auto cache = m_file_label_cache.object(uri);
+    if (cache && cache->metaInfo.lock() == metaInfo) {
+        ids = cache->ids;
+        m_cache_mutex.unlock();
+        return ids;
+    }
+    m_cache_mutex.unlock();
+
+    //the meta info is new or refreshed, parse it again.
+    if (!metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull()) {
+        auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
+        for (auto label : labels) {
+            bool ok = false;
+            int id = label.toInt(&ok);
+            if (ok && !ids.contains(id))
+                ids<<id;
         }
     }
-    return nullptr;
+    updateFileLabelIds(uri, ids, metaInfo);
+    return ids;
+}
+
+void FileLabelModel::updateFileLabelIds(const QString &uri, const QList<int> &ids, const std::shared_ptr<Peony::FileMetaInfo> &metaInfo)
+{
+    auto cache = new FileLabelCache;
+    cache->metaInfo = metaInfo;
+    cache->ids = ids;
+
+    m_cache_mutex.lock();
+    m_file_label_cache.insert(uri, cache);
+
+    //correct the reverse index, there are only a few labels.
+    bool changed = false;
+    for (auto iter = m_label_files.begin(); iter != m_label_files.end(); ++iter) {
+        if (!ids.contains(iter.key()) && iter.value().remove(uri)) {
+            m_dirty_label_ids<<iter.key();
+            changed = true;
+        }
+    }
+    for (auto id : ids) {
+        auto &files = m_label_files[id];
+        if (!files.contains(uri)) {
+            files.insert(uri);
+            m_dirty_label_ids<<id;
+            changed = true;
+        }
+    }
+    m_cache_mutex.unlock();
+
+    if (changed)
+        scheduleSaveReverseIndex();
+}
+
+void FileLabelModel::loadReverseIndex()
+{
+    QMutexLocker locker(&m_cache_mutex);
+    m_label_index_settings->beginGroup("files");
+    for (auto key : m_label_index_settings->childKeys()) {
+        auto uris = m_label_index_settings->value(key).toStringList();
+        m_label_files.insert(key.toInt(), uris.toSet());
+    }
+    m_label_index_settings->endGroup();
+}
+
+void FileLabelModel::scheduleSaveReverseIndex()
+{
+    //the index might be changed in info jobs, start the timer in its thread.
+    QMetaObject::invokeMethod(m_save_index_timer, "start", Qt::QueuedConnection);
+}
+
+void FileLabelModel::saveReverseIndex()
+{
+    QMutexLocker locker(&m_cache_mutex);
+    m_label_index_settings->beginGroup("files");
+    for (auto id : m_dirty_label_ids) {
+        auto key = QString::number(id);
+        auto files = m_label_files.value(id);
+        if (files.isEmpty()) {
+            m_label_index_settings->remove(key);
+        } else {
+            m_label_index_settings->setValue(key, QStringList(files.toList()));
+        }
+    }
+    m_label_index_settings->endGroup();
+    m_label_index_settings->sync();
+    m_dirty_label_ids.clear();
 }
 
 FileLabelItem *FileLabelModel::itemFormIndex(const QModelIndex &index)
@@ -277,12 +381,19 @@ QList<FileLabelItem *> FileLabelModel::getAllFileLabelItems()
 void FileLabelModel::addLabelToFile(const QString &uri, int labelId)
 {
     auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
+    if (! metaInfo)
+        return;
     QStringList labelIds;
     if (metaInfo && !metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
         labelIds = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
     labelIds<<QString::number(labelId);
     labelIds.removeDuplicates();
     metaInfo->setMetaInfoStringList(PEONY_FILE_LABEL_IDS, labelIds);
+
+    auto ids = cachedFileLabelIds(uri);
+    if (!ids.contains(labelId))
+        ids<<labelId;
+    updateFileLabelIds(uri, ids, metaInfo);
     Q_EMIT fileLabelChanged(uri);
 }
 
@@ -293,12 +404,17 @@ void FileLabelModel::removeFileLabel(const QString &uri, int labelId)
         return;
     if (labelId <= 0) {
         metaInfo->removeMetaInfo(PEONY_FILE_LABEL_IDS);
+        updateFileLabelIds(uri, QList<int>(), metaInfo);
     } else {
         if (metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
             return;
         QStringList labelIds = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
         labelIds.removeOne(QString::number(labelId));
         metaInfo->setMetaInfoStringList(PEONY_FILE_LABEL_IDS, labelIds);
+
+        auto ids = cachedFileLabelIds(uri);
+        ids.removeAll(labelId);
+        updateFileLabelIds(uri, ids, metaInfo);
     }
     Q_EMIT fileLabelChanged(uri);
 }
@@ -418,6 +534,7 @@ void FileLabelModel::initLabelItems()
             item->setColor(color);
 
             m_labels.append(item);
+            m_label_ids.insert(item->id(), item);
         }
     }
     m_label_settings->endArray();
@@ -27,12 +27,35 @@
 #include <QSettings>
 
 #include <QColor>
+#include <QHash>
+#include <QCache>
+#include <QSet>
+#include <QMutex>
+#include <QTimer>
 #include <peony-core_global.h>
 
+#include <memory>
+
 #define PEONY_FILE_LABEL_IDS "peony-file-label-ids"
 
 class FileLabelItem;
 
+namespace Peony {
+class FileMetaInfo;
+}
+
+/*!
+ * \brief The FileLabelModel class
+ * <br>
+ * FileLabelModel manages the labels and the labels of files. The label ids of
+ * a file are stored in its metadata, they are parsed once and cached by uri
+ * until the metadata is queried again, the least recently used files are
+ * dropped once PEONY_FILE_LABEL_CACHE_LIMIT files are cached. The labels are
+ * indexed by id, and the files of a label are recorded in a persistent reverse
+ * index, which is kept by addLabelToFile() and removeFileLabel() and corrected
+ * every time the labels of a file are parsed.
+ * </br>
+ */
 class PEONYCORESHARED_EXPORT FileLabelModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -57,6 +80,16 @@ public:
     const QStringList getFileLabels(const QString &uri);
     const QList<QColor> getFileColors(const QString &uri);
     FileLabelItem *itemFromId(int id);
+
+    /*!
+     * \brief getFileUrisWithLabel
+     * \param labelId
+     * \return the uris of files which have the label, from the reverse index.
+     * \note the index only knows files labeled by peony-qt or the files whose
+     * metadata has been read, and the file might have been moved or deleted.
+     */
+    const QStringList getFileUrisWithLabel(int labelId);
+    const QStringList getFileUrisWithLabel(const QString &labelName);
     FileLabelItem *itemFormIndex(const QModelIndex &index);
 
     QList<FileLabelItem *> getAllFileLabelItems();
@@ -89,6 +122,18 @@ protected:
     void initLabelItems();
     void addId();
 
+    /*!
+     * \brief cachedFileLabelIds
+     * \param uri
+     * \return label ids of the file, they are parsed again only if the meta
+     * info of file has been refreshed.
+     */
+    const QList<int> cachedFileLabelIds(const QString &uri);
+    void updateFileLabelIds(const QString &uri, const QList<int> &ids, const std::shared_ptr<Peony::FileMetaInfo> &metaInfo);
+    void loadReverseIndex();
+    void scheduleSaveReverseIndex();
+    void saveReverseIndex();
+
 private:
     explicit FileLabelModel(QObject *parent = nullptr);
     ~FileLabelModel();
@@ -96,6 +141,19 @@ private:
     QSettings *m_label_settings;
 
     QList<FileLabelItem *> m_labels;
+    QHash<int, FileLabelItem *> m_label_ids;
+
+    struct FileLabelCache {
+        std::weak_ptr<Peony::FileMetaInfo> metaInfo;
+        QList<int> ids;
+    };
+    //labels might be read in info jobs, guard the caches.
+    QMutex m_cache_mutex;
+    QCache<QString, FileLabelCache> m_file_label_cache;
+    QHash<int, QSet<QString>> m_label_files;
+    QSettings *m_label_index_settings = nullptr;
+    QSet<int> m_dirty_label_ids;
+    QTimer *m_save_index_timer = nullptr;
 };
 
 class PEONYCORESHARED_EXPORT FileLabelItem : public QObject
@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Memory benchmark of the old and current layouts of FileInfo data.
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = info-store-benchmark
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += link_pkgconfig no_keywords c++11
+PKGCONFIG += glib-2.0 gio-2.0
+
+include(../../libpeony-qt.pri)
+
+SOURCES += \
+        main.cpp
@@ -0,0 +1,254 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * This benchmark compares the memory footprint and the reading time of the
+ * layout before FileInfoStore owned the file data, where every file had a
+ * FileInfo object keeping all its attributes and a duplicated store record for
+ * the view, with current layout, where FileInfo is a handle of the record.
+ *
+ * usage: info-store-benchmark [files count, default 100000]
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QColor>
+#include <QDebug>
+
+#include <file-info.h>
+#include <file-info-store.h>
+#include <file-info-manager.h>
+#include <file-meta-info.h>
+
+#include <memory>
+#include <gio/gio.h>
+
+/*!
+ * \brief The LegacyFileInfo class
+ * <br>
+ * The members of FileInfo before its attributes were moved to FileInfoStore.
+ * </br>
+ */
+class LegacyFileInfo : public QObject
+{
+public:
+    explicit LegacyFileInfo(const QString &uri, GFileInfo *gInfo) {
+        m_uri = uri;
+        m_file = g_file_new_for_uri(uri.toUtf8().constData());
+        m_is_remote = !g_file_is_native(m_file);
+        m_is_dir = g_file_info_get_file_type(gInfo) == G_FILE_TYPE_DIRECTORY;
+        m_display_name = g_file_info_get_display_name(gInfo);
+        GIcon *icon = g_file_info_get_icon(gInfo);
+        if (G_IS_THEMED_ICON(icon))
+            m_icon_name = Peony::FileInfoStore::internString(g_themed_icon_get_names(G_THEMED_ICON(icon))[0]);
+        char *path = g_file_get_path(m_file);
+        m_path = path;
+        g_free(path);
+        m_content_type = Peony::FileInfoStore::internString(g_file_info_get_content_type(gInfo));
+        m_mime_type_string = m_content_type;
+        m_file_type = Peony::FileInfoStore::typeDescription(m_mime_type_string);
+        m_size = g_file_info_get_size(gInfo);
+        m_modified_time = g_file_info_get_attribute_uint64(gInfo, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+        m_can_write = true;
+        m_meta_info = Peony::FileMetaInfo::fromGFileInfo(uri, gInfo);
+    }
+    ~LegacyFileInfo() {
+        g_object_unref(m_file);
+    }
+
+    QString m_uri = nullptr;
+    bool m_is_valid = false;
+    bool m_is_dir = false;
+    bool m_is_volume = false;
+    bool m_is_remote = false;
+    bool m_is_symbol_link = false;
+    bool m_is_virtual = false;
+    bool m_is_loaded = false;
+
+    QString m_display_name = nullptr;
+    QString m_icon_name = nullptr;
+    QString m_symbolic_icon_name = nullptr;
+    QString m_file_id = nullptr;
+    QString m_path = nullptr;
+    QString m_content_type = nullptr;
+    guint64 m_size = 0;
+    guint64 m_modified_time = 0;
+    guint64 m_access_time = 0;
+    QString m_mime_type_string = nullptr;
+    QString m_file_type = nullptr;
+
+    bool m_can_read = true;
+    bool m_can_write = false;
+    bool m_can_excute = false;
+    bool m_can_delete = false;
+    bool m_can_trash = false;
+    bool m_can_rename = false;
+    bool m_can_mount = false;
+    bool m_can_unmount = false;
+    bool m_can_eject = false;
+    bool m_can_start = false;
+    bool m_can_stop = false;
+
+    GFile *m_file = nullptr;
+    GFile *m_target_file = nullptr;
+    std::shared_ptr<Peony::FileMetaInfo> m_meta_info = nullptr;
+    QList<QColor> m_colors;
+    QMutex m_mutex;
+};
+
+static qint64 current_rss()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+
+    while (!status.atEnd()) {
+        QString line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            //VmRSS:     12345 kB
+            return line.split(" ", QString::SkipEmptyParts).at(1).toLongLong() * 1024;
+        }
+    }
+    return 0;
+}
+
+static const char *mime_types[] = {"text/plain", "image/png", "image/jpeg", "application/pdf"};
+static const char *icon_names[] = {"text-plain", "image-png", "image-jpeg", "application-pdf"};
+
+static GFileInfo *fake_file_info(int i)
+{
+    QString name = QString("file-%1.txt").arg(i);
+    GFileInfo *info = g_file_info_new();
+    g_file_info_set_name(info, name.toUtf8().constData());
+    g_file_info_set_display_name(info, name.toUtf8().constData());
+    g_file_info_set_file_type(info, G_FILE_TYPE_REGULAR);
+    g_file_info_set_content_type(info, mime_types[i%4]);
+    g_file_info_set_size(info, i*1024);
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED, 1600000000 + i);
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, true);
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, true);
+    GIcon *icon = g_themed_icon_new(icon_names[i%4]);
+    g_file_info_set_icon(info, icon);
+    g_object_unref(icon);
+    return info;
+}
+
+static QString fake_uri(const QString &layout, int i)
+{
+    return QString("file:///tmp/peony-info-store-benchmark/%1/file-%2.txt").arg(layout).arg(i);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    int count = 100000;
+    if (argc > 1)
+        count = QString(argv[1]).toInt();
+
+    QElapsedTimer timer;
+    qint64 readLength = 0;
+
+    // old layout, a full info object and a duplicated record for the view.
+    // the records live in their own store, so they do not share the new records.
+    Peony::FileInfoStore legacyStore;
+    QList<std::shared_ptr<LegacyFileInfo>> legacyInfos;
+    QVector<int> legacyRecords;
+    legacyInfos.reserve(count);
+    legacyRecords.reserve(count);
+    qint64 before = current_rss();
+    for (int i = 0; i < count; i++) {
+        GFileInfo *gInfo = fake_file_info(i);
+        auto info = std::make_shared<LegacyFileInfo>(fake_uri("old", i), gInfo);
+        g_object_unref(gInfo);
+
+        Peony::FileInfoStore::Record contents;
+        contents.displayName = info->m_display_name;
+        contents.iconName = info->m_icon_name;
+        contents.mimeType = info->m_mime_type_string;
+        contents.size = info->m_size;
+        contents.modifiedTime = info->m_modified_time;
+        contents.flags = Peony::FileInfoStore::CanRead|Peony::FileInfoStore::CanWrite;
+        int record = legacyStore.acquire(info->m_uri);
+        legacyStore.setRecord(record, contents);
+
+        legacyInfos<<info;
+        legacyRecords<<record;
+    }
+    qint64 legacyBytes = current_rss() - before;
+
+    timer.start();
+    for (auto info : legacyInfos) {
+        readLength += info->m_display_name.length();
+        readLength += info->m_icon_name.length();
+        readLength += Peony::FileInfoStore::formatSize(info->m_size).length();
+    }
+    qint64 legacyInfoReadTime = timer.elapsed();
+
+    timer.restart();
+    for (auto record : legacyRecords) {
+        readLength += legacyStore.displayName(record).length();
+        readLength += legacyStore.iconName(record).length();
+        readLength += legacyStore.fileSize(record).length();
+    }
+    qint64 legacyRecordReadTime = timer.elapsed();
+
+    // new layout, the info is a handle of its record.
+    auto store = Peony::FileInfoManager::getInstance()->getStore();
+    QList<std::shared_ptr<Peony::FileInfo>> infos;
+    infos.reserve(count);
+    before = current_rss();
+    for (int i = 0; i < count; i++) {
+        GFileInfo *gInfo = fake_file_info(i);
+        infos<<Peony::FileInfo::fromGFileInfo(fake_uri("new", i), gInfo);
+        g_object_unref(gInfo);
+    }
+    qint64 newBytes = current_rss() - before;
+
+    timer.restart();
+    for (auto info : infos) {
+        readLength += info->displayName().length();
+        readLength += info->iconName().length();
+        readLength += info->fileSize().length();
+    }
+    qint64 newInfoReadTime = timer.elapsed();
+
+    timer.restart();
+    for (auto info : infos) {
+        int record = info->record();
+        readLength += store->displayName(record).length();
+        readLength += store->iconName(record).length();
+        readLength += store->fileSize(record).length();
+    }
+    qint64 newRecordReadTime = timer.elapsed();
+
+    qInfo()<<"files:"<<count<<"read chars:"<<readLength;
+    qInfo()<<"old layout (FileInfo + record):"<<legacyBytes/count<<"bytes/file (rss),"
+           <<legacyInfoReadTime<<"ms to read infos,"<<legacyRecordReadTime<<"ms to read records";
+    qInfo()<<"new layout (handle -> record) :"<<newBytes/count<<"bytes/file (rss),"
+           <<newInfoReadTime<<"ms to read infos,"<<newRecordReadTime<<"ms to read records";
+    qInfo()<<"records:"<<store->memoryUsage()/qMax(1, store->count())<<"bytes/file (estimated)";
+
+    return 0;
+}
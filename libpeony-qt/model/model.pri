@@ -5,6 +5,8 @@ INCLUDEPATH += $$PWD
 HEADERS += \
     $$PWD/file-item.h \
     $$PWD/file-item-model.h \
+    $$PWD/file-item-sort-key.h \
+    $$PWD/file-item-filter.h \
     $$PWD/file-item-proxy-filter-sort-model.h \
     $$PWD/file-label-model.h \
     $$PWD/side-bar-abstract-item.h \
@@ -15,11 +17,14 @@ HEADERS += \
     $$PWD/side-bar-proxy-filter-sort-model.h \
     $$PWD/path-bar-model.h \
     $$PWD/path-completer.h \
+    $$PWD/path-completion-engine.h \
     $$PWD/side-bar-separator-item.h
 
 SOURCES += \
     $$PWD/file-item.cpp \
     $$PWD/file-item-model.cpp \
+    $$PWD/file-item-sort-key.cpp \
+    $$PWD/file-item-filter.cpp \
     $$PWD/file-item-proxy-filter-sort-model.cpp \
     $$PWD/file-label-model.cpp \
     $$PWD/side-bar-abstract-item.cpp \
@@ -30,4 +35,5 @@ SOURCES += \
     $$PWD/side-bar-proxy-filter-sort-model.cpp \
     $$PWD/path-bar-model.cpp \
     $$PWD/path-completer.cpp \
+    $$PWD/path-completion-engine.cpp \
     $$PWD/side-bar-separator-item.cpp
@@ -21,8 +21,7 @@
  */
 
 #include "path-bar-model.h"
-#include "file-enumerator.h"
-#include "file-info.h"
+#include "path-completion-engine.h"
 #include "file-utils.h"
 
 #include <QUrl>
@@ -31,7 +30,32 @@ using namespace Peony;
 
 PathBarModel::PathBarModel(QObject *parent) : QStringListModel (parent)
 {
+    auto engine = PathCompletionEngine::getInstance();
+    connect(engine, &PathCompletionEngine::listingReady, this, [=](const QString &uri) {
+        if (uri != m_pending_uri)
+            return;
+        m_pending_uri.clear();
+
+        QStringList uris;
+        QHash<QString, QString> displayNames;
+        if (engine->getListing(uri, uris, displayNames))
+            setListing(uri, uris, displayNames);
+    });
+    //the uri might not exist, keep current items.
+    connect(engine, &PathCompletionEngine::listingFailed, this, [=](const QString &uri) {
+        if (uri == m_pending_uri)
+            m_pending_uri.clear();
+    });
+    connect(engine, &PathCompletionEngine::listingInvalidated, this, [=](const QString &uri) {
+        if (uri == m_current_uri && m_pending_uri.isNull())
+            setRootUri(uri, true);
+    });
+}
 
+PathBarModel::~PathBarModel()
+{
+    if (!m_pending_uri.isNull())
+        PathCompletionEngine::getInstance()->cancelListing(m_pending_uri);
 }
 
 void PathBarModel::setRootPath(const QString &path, bool force)
@@ -45,13 +69,8 @@ void PathBarModel::setRootUri(const QString &uri, bool force)
         if (uri.contains("////"))
             return;
 
-        if (m_current_uri == uri)
+        if (m_current_uri == uri || m_pending_uri == uri)
             return;
-
-        auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
-        if (!g_file_query_exists(file.get()->get(), nullptr)) {
-            return;
-        }
     }
 
     //do not enumerate a search:/// directory
@@ -63,50 +82,40 @@ void PathBarModel::setRootUri(const QString &uri, bool force)
 
     //qDebug()<<"setUri"<<uri<<"raw"<<m_current_uri;
 
-    beginResetModel();
+    auto engine = PathCompletionEngine::getInstance();
 
-    m_current_uri = uri;
+    //the directory typed before is not wanted anymore.
+    if (!m_pending_uri.isNull()) {
+        engine->cancelListing(m_pending_uri);
+        m_pending_uri.clear();
+    }
 
-    FileEnumerator e;
-    e.setEnumerateDirectory(uri);
-    e.enumerateSync();
-    auto infos = e.getChildren();
-    if (infos.isEmpty()) {
-        endResetModel();
-        Q_EMIT updated();
+    QStringList uris;
+    QHash<QString, QString> displayNames;
+    if (engine->getListing(uri, uris, displayNames)) {
+        setListing(uri, uris, displayNames);
         return;
     }
 
-    m_uri_display_name_hash.clear();
-    QStringList l;
-    for (auto info : infos) {
-        //skip the independent file.
-        if (!(info->isDir() || info->isVolume()))
-            continue;
-
-        //skip the hidden file.
-        //FIXME: replace BLOCKING api in ui thread.
-        QString display_name = FileUtils::getFileDisplayName(info->uri());
-        if (display_name.startsWith("."))
-            continue;
-
-        QUrl url = info->uri();
-        l<<url.toDisplayString();
-        m_uri_display_name_hash.insert(info->uri(), display_name);
-    }
-    setStringList(l);
-    sort(0);
-    endResetModel();
+    m_pending_uri = uri;
+    engine->requestListing(uri);
+}
+
+void PathBarModel::setListing(const QString &uri, const QStringList &uris, const QHash<QString, QString> &displayNames)
+{
+    m_current_uri = uri;
+    m_uri_display_name_hash = displayNames;
+    setStringList(uris);
     Q_EMIT updated();
 }
 
 QString PathBarModel::findDisplayName(const QString &uri)
 {
     QUrl url = uri;
-    if (m_uri_display_name_hash.find(url.toDisplayString())->isNull()) {
-        //FIXME: replace BLOCKING api in ui thread.
-        return FileUtils::getFileDisplayName(uri);
-    } else {
+    if (m_uri_display_name_hash.contains(url.toDisplayString())) {
         return m_uri_display_name_hash.value(url.toDisplayString());
+    } else {
+        //the listing has not been loaded, do not query the file in ui thread.
+        return FileUtils::getUriBaseName(uri);
     }
 }
@@ -39,14 +39,18 @@ namespace Peony {
  * A completion is theoretically responsive, so the enumeration of model
  * items should be as fast as possible.
  * It must be fast and lightweight enough to keep the ui-frequency.
- * For now, it performs well at local file system, but not good enough at
- * remote fs.
+ * The directory is enumerated by PathCompletionEngine asynchronously, the model
+ * keeps its old items until the new ones are ready, and a directory set before
+ * the last one is cancelled. The items are sorted case insensitively, a completer
+ * binding with this model could use QCompleter::CaseInsensitivelySortedModel.
+ * \see PathCompletionEngine
  */
 class PEONYCORESHARED_EXPORT PathBarModel : public QStringListModel
 {
     Q_OBJECT
 public:
     explicit PathBarModel(QObject *parent = nullptr);
+    ~PathBarModel() override;
     QString findDisplayName(const QString &uri);
     QString currentDirUri() {
         return m_current_uri;
@@ -60,7 +64,10 @@ public Q_SLOTS:
     void setRootUri(const QString &uri, bool force = false);
 
 private:
+    void setListing(const QString &uri, const QStringList &uris, const QHash<QString, QString> &displayNames);
+
     QString m_current_uri = nullptr;
+    QString m_pending_uri = nullptr;
     QHash<QString, QString> m_uri_display_name_hash;
 };
 
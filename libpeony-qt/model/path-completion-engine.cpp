@@ -0,0 +1,253 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "path-completion-engine.h"
+#include "file-enumerator.h"
+#include "file-watcher.h"
+
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QUrl>
+
+#include <algorithm>
+
+using namespace Peony;
+
+static PathCompletionEngine *global_instance = nullptr;
+
+PathCompletionEngine *PathCompletionEngine::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new PathCompletionEngine;
+    }
+    return global_instance;
+}
+
+PathCompletionEngine::PathCompletionEngine(QObject *parent) : QObject(parent)
+{
+    m_pool.setMaxThreadCount(PEONY_PATH_COMPLETION_THREADS);
+    m_cache.setMaxCost(PEONY_PATH_COMPLETION_CACHE_SIZE);
+}
+
+PathCompletionEngine::~PathCompletionEngine()
+{
+    for (auto pending : m_pending_listings) {
+        g_cancellable_cancel(pending.cancellable);
+        g_object_unref(pending.cancellable);
+    }
+    m_pending_listings.clear();
+    m_pool.waitForDone();
+    m_cache.clear();
+}
+
+PathCompletionEngine::Listing::~Listing()
+{
+    if (watcher) {
+        //the listing might be dropped in the signal of watcher.
+        watcher->disconnect();
+        watcher->stopMonitor();
+        watcher->deleteLater();
+    }
+}
+
+bool PathCompletionEngine::getListing(const QString &uri, QStringList &uris, QHash<QString, QString> &displayNames)
+{
+    auto listing = m_cache.object(uri);
+    if (!listing)
+        return false;
+
+    //the listing which is not monitored might be out of date.
+    if (!listing->watcher && listing->age.hasExpired(PEONY_PATH_COMPLETION_UNMONITORED_TIMEOUT)) {
+        m_cache.remove(uri);
+        return false;
+    }
+
+    uris = listing->uris;
+    displayNames = listing->display_names;
+    return true;
+}
+
+void PathCompletionEngine::requestListing(const QString &uri)
+{
+    auto &pending = m_pending_listings[uri];
+    pending.request_count++;
+    if (pending.cancellable)
+        return;
+
+    auto cancellable = g_cancellable_new();
+    pending.cancellable = cancellable;
+    //the enumeration holds its own reference, the pending one might be dropped by cancelListing().
+    g_object_ref(cancellable);
+
+    auto watcher = new QFutureWatcher<Listing *>;
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        auto listing = watcher->result();
+        watcher->deleteLater();
+
+        bool cancelled = g_cancellable_is_cancelled(cancellable);
+        if (m_pending_listings.value(uri).cancellable == cancellable) {
+            g_object_unref(cancellable);
+            m_pending_listings.remove(uri);
+        }
+        g_object_unref(cancellable);
+
+        if (cancelled) {
+            delete listing;
+            return;
+        }
+        if (!listing) {
+            Q_EMIT listingFailed(uri);
+            return;
+        }
+        insertListing(uri, listing);
+        Q_EMIT listingReady(uri);
+    });
+    watcher->setFuture(QtConcurrent::run(&m_pool, [=]() {
+        return enumerateListing(uri, cancellable);
+    }));
+}
+
+void PathCompletionEngine::cancelListing(const QString &uri)
+{
+    if (!m_pending_listings.contains(uri))
+        return;
+
+    auto &pending = m_pending_listings[uri];
+    pending.request_count--;
+    if (pending.request_count > 0)
+        return;
+
+    g_cancellable_cancel(pending.cancellable);
+    g_object_unref(pending.cancellable);
+    m_pending_listings.remove(uri);
+}
+
+/*!
+ * \brief PathCompletionEngine::enumerateListing
+ * \param uri
+ * \param cancellable
+ * \return the sub directories of uri, or nullptr if uri can not be enumerated.
+ * <br>
+ * The type and display name of children are taken from the enumerated infos,
+ * there is no query for each child. This method is called in the pool threads.
+ * </br>
+ */
+PathCompletionEngine::Listing *PathCompletionEngine::enumerateListing(const QString &uri, GCancellable *cancellable)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+
+    //some vfs, such as computer:///, enumerate the children of their target.
+    GFileInfo *target_info = g_file_query_info(file,
+                                               G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+                                               G_FILE_QUERY_INFO_NONE,
+                                               cancellable,
+                                               nullptr);
+    if (target_info) {
+        char *target_uri = g_file_info_get_attribute_as_string(target_info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        if (target_uri) {
+            g_object_unref(file);
+            file = g_file_new_for_uri(target_uri);
+            g_free(target_uri);
+        }
+        g_object_unref(target_info);
+    }
+
+    GFileEnumerator *enumerator = g_file_enumerate_children(file,
+                                  G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                  G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
+                                  G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                  G_FILE_QUERY_INFO_NONE,
+                                  cancellable,
+                                  nullptr);
+    g_object_unref(file);
+    if (!enumerator)
+        return nullptr;
+
+    auto listing = new Listing;
+    GFileInfo *info = nullptr;
+    while ((info = g_file_enumerator_next_file(enumerator, cancellable, nullptr))) {
+        GFileType type = g_file_info_get_file_type(info);
+        //skip the independent file.
+        if (type == G_FILE_TYPE_DIRECTORY || type == G_FILE_TYPE_MOUNTABLE) {
+            QString display_name = g_file_info_get_display_name(info);
+            //skip the hidden file.
+            if (!display_name.startsWith(".")) {
+                QString display_uri = QUrl(FileEnumerator::childUri(enumerator, info)).toDisplayString();
+                listing->uris<<display_uri;
+                listing->display_names.insert(display_uri, display_name);
+            }
+        }
+        g_object_unref(info);
+    }
+
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+
+    //keep the same order as QCompleter::CaseInsensitivelySortedModel.
+    std::sort(listing->uris.begin(), listing->uris.end(), [](const QString &a, const QString &b) {
+        return QString::compare(a, b, Qt::CaseInsensitive) < 0;
+    });
+    return listing;
+}
+
+void PathCompletionEngine::insertListing(const QString &uri, Listing *listing)
+{
+    listing->age.start();
+
+    //creating a FileWatcher queries the target of uri in ui thread, which
+    //might hang on a remote or virtual location, only monitor local directories.
+    if (!uri.startsWith("file://")) {
+        m_cache.insert(uri, listing);
+        return;
+    }
+
+    auto watcher = new FileWatcher(uri);
+    watcher->setMonitorChildrenChange(true);
+    connect(watcher, &FileWatcher::fileCreated, this, [=]() {
+        invalidateListing(uri);
+    });
+    connect(watcher, &FileWatcher::fileDeleted, this, [=]() {
+        invalidateListing(uri);
+    });
+    connect(watcher, &FileWatcher::locationChanged, this, [=]() {
+        invalidateListing(uri);
+    });
+    connect(watcher, &FileWatcher::directoryDeleted, this, [=]() {
+        invalidateListing(uri);
+    });
+    connect(watcher, &FileWatcher::directoryUnmounted, this, [=]() {
+        invalidateListing(uri);
+    });
+    watcher->startMonitor();
+    listing->watcher = watcher;
+
+    m_cache.insert(uri, listing);
+}
+
+void PathCompletionEngine::invalidateListing(const QString &uri)
+{
+    if (!m_cache.remove(uri))
+        return;
+
+    Q_EMIT listingInvalidated(uri);
+}
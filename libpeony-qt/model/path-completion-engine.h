@@ -0,0 +1,158 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef PATHCOMPLETIONENGINE_H
+#define PATHCOMPLETIONENGINE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <gio/gio.h>
+
+#include "peony-core_global.h"
+
+/*!
+ * \brief PEONY_PATH_COMPLETION_CACHE_SIZE
+ * <br>
+ * The max count of directory listings kept by PathCompletionEngine,
+ * the least recently used listings are dropped when it is exceeded.
+ * </br>
+ */
+#ifndef PEONY_PATH_COMPLETION_CACHE_SIZE
+#define PEONY_PATH_COMPLETION_CACHE_SIZE 32
+#endif
+
+/*!
+ * \brief PEONY_PATH_COMPLETION_THREADS
+ * <br>
+ * The max count of directories enumerated at the same time for completions.
+ * </br>
+ */
+#ifndef PEONY_PATH_COMPLETION_THREADS
+#define PEONY_PATH_COMPLETION_THREADS 2
+#endif
+
+/*!
+ * \brief PEONY_PATH_COMPLETION_UNMONITORED_TIMEOUT
+ * <br>
+ * The listings of directories which are not local are not monitored, they are
+ * enumerated again if they are older than this milliseconds.
+ * </br>
+ */
+#ifndef PEONY_PATH_COMPLETION_UNMONITORED_TIMEOUT
+#define PEONY_PATH_COMPLETION_UNMONITORED_TIMEOUT 10000
+#endif
+
+namespace Peony {
+
+class FileWatcher;
+
+/*!
+ * \brief The PathCompletionEngine class
+ * <br>
+ * PathCompletionEngine lists the sub directories of a directory for path completions.
+ * The directories are enumerated in a thread pool, so a slow remote file system never
+ * blocks the ui thread. A request which is no longer wanted, such as the directory typed
+ * before the last keystroke, should be cancelled by cancelListing().
+ * </br>
+ * <br>
+ * The listings are cached by directory uri in a LRU cache, each cached local directory
+ * is monitored and its listing is dropped once its children changed. Other listings
+ * expire after PEONY_PATH_COMPLETION_UNMONITORED_TIMEOUT. The uris of a listing
+ * are sorted case insensitively, so QCompleter could match the prefix by binary search.
+ * </br>
+ * \note This class should only be used in ui thread.
+ * \see PathBarModel.
+ */
+class PEONYCORESHARED_EXPORT PathCompletionEngine : public QObject
+{
+    Q_OBJECT
+public:
+    static PathCompletionEngine *getInstance();
+
+    /*!
+     * \brief getListing
+     * \param uri
+     * \param uris, the display strings of sub directories' uris, sorted case insensitively.
+     * \param displayNames, the display names of sub directories, keyed by their display strings.
+     * \return true if the listing of uri is cached.
+     */
+    bool getListing(const QString &uri, QStringList &uris, QHash<QString, QString> &displayNames);
+
+    /*!
+     * \brief requestListing
+     * \param uri
+     * <br>
+     * Enumerate uri asynchronously, listingReady() is emitted when it is done.
+     * Requests of the same uri are merged, every request should be paired with a
+     * cancelListing() if the listing is not wanted anymore before it is ready.
+     * </br>
+     */
+    void requestListing(const QString &uri);
+    void cancelListing(const QString &uri);
+
+Q_SIGNALS:
+    void listingReady(const QString &uri);
+    void listingFailed(const QString &uri);
+    /*!
+     * \brief listingInvalidated
+     * \param uri
+     * <br>
+     * The children of uri changed, its cached listing was dropped.
+     * </br>
+     */
+    void listingInvalidated(const QString &uri);
+
+private:
+    explicit PathCompletionEngine(QObject *parent = nullptr);
+    ~PathCompletionEngine();
+
+    struct Listing {
+        QStringList uris;
+        QHash<QString, QString> display_names;
+        FileWatcher *watcher = nullptr;
+        QElapsedTimer age;
+
+        ~Listing();
+    };
+
+    struct PendingListing {
+        GCancellable *cancellable = nullptr;
+        int request_count = 0;
+    };
+
+    static Listing *enumerateListing(const QString &uri, GCancellable *cancellable);
+
+    void insertListing(const QString &uri, Listing *listing);
+    void invalidateListing(const QString &uri);
+
+    QThreadPool m_pool;
+    QCache<QString, Listing> m_cache;
+    QHash<QString, PendingListing> m_pending_listings;
+};
+
+}
+
+#endif // PATHCOMPLETIONENGINE_H
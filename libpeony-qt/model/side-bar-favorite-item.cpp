@@ -23,6 +23,7 @@
 #include "side-bar-favorite-item.h"
 #include "side-bar-model.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 
 #include "bookmark-manager.h"
 
@@ -65,9 +66,25 @@ SideBarFavoriteItem::SideBarFavoriteItem(QString uri,
         return;
     }
     m_uri = uri;
-    //FIXME: replace BLOCKING api in ui thread.
-    m_display_name = FileUtils::getFileDisplayName(uri);
-    m_icon_name = FileUtils::getFileIconName(uri);
+    //bookmarks might be remote, show the base name until the display name is queried.
+    m_display_name = FileUtils::getUriBaseName(uri);
+    AsyncFileUtils::then(AsyncFileUtils::getFileDisplayName(uri), this, [=](const QString &displayName) {
+        if (!displayName.isNull())
+            m_display_name = displayName;
+        notifyDataChanged();
+    });
+    AsyncFileUtils::then(AsyncFileUtils::getFileIconNames(uri), this, [=](const QStringList &iconNames) {
+        m_icon_name = AsyncFileUtils::validIconName(iconNames);
+        notifyDataChanged();
+    });
+}
+
+void SideBarFavoriteItem::notifyDataChanged()
+{
+    //the item might not be inserted into model yet.
+    auto index = firstColumnIndex();
+    if (index.isValid())
+        m_model->dataChanged(index, index);
 }
 
 SideBarAbstractItem::Type SideBarFavoriteItem::type() {
@@ -74,6 +74,7 @@ public Q_SLOTS:
 
 private:
     void syncBookMark();
+    void notifyDataChanged();
 
     SideBarFavoriteItem *m_parent = nullptr;
 
@@ -24,6 +24,7 @@
 
 #include "file-info.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "file-watcher.h"
 #include "file-info-job.h"
 #include "volume-manager.h"
@@ -60,10 +61,9 @@ SideBarFileSystemItem::SideBarFileSystemItem(QString uri,
         //connect(m_watcher.get(), &FileWatcher::fileChanged, [=]())
     } else {
         m_uri = uri;
-        //FIXME: replace BLOCKING api in ui thread.
-        m_display_name = FileUtils::getFileDisplayName(uri);
-        m_icon_name = FileUtils::getFileIconName(uri);
-        FileUtils::queryVolumeInfo(m_uri, m_volume_name, m_unix_device, m_display_name);
+        //show the base name until the display name is queried.
+        m_display_name = FileUtils::getUriBaseName(uri);
+        queryFileInfoAsync();
     }
 }
 
@@ -147,10 +147,14 @@ void SideBarFileSystemItem::findChildren()
                     m_model,
                     this);
             //check is mounted.
-            //FIXME: replace BLOCKING api in ui thread.
-            auto targetUri = FileUtils::getTargetUri(info->uri());
-            bool isUmountable = FileUtils::isFileUnmountable(info->uri());
-            item->m_is_mounted = (!targetUri.isEmpty() && (targetUri != "file:///")) || isUmountable;
+            auto targetUriFuture = AsyncFileUtils::getTargetUri(info->uri());
+            auto isUmountableFuture = AsyncFileUtils::isFileUnmountable(info->uri());
+            AsyncFileUtils::then(targetUriFuture, item, [=](const QString &targetUri) {
+                AsyncFileUtils::then(isUmountableFuture, item, [=](bool isUmountable) {
+                    item->m_is_mounted = (!targetUri.isEmpty() && (targetUri != "file:///")) || isUmountable;
+                    item->notifyDataChanged();
+                });
+            });
             m_children->append(item);
             //qDebug()<<info->uri();
         }
@@ -217,18 +221,21 @@ end:
             for (auto child : *m_children) {
                 if (child->uri() == uri) {
                     SideBarFileSystemItem *changedItem = static_cast<SideBarFileSystemItem*>(child);
-                    //FIXME: replace BLOCKING api in ui thread.
-                    if (FileUtils::getTargetUri(uri).isEmpty()) {
-                        changedItem->m_is_mounted = false;
-                        changedItem->clearChildren();
-                    } else {
-                        changedItem->m_is_mounted = true;
-                    }
-
-                    //why it would failed when send changed signal for newly mounted item?
-                    //m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->firstColumnIndex());
-                    updateFileInfo(changedItem);
-                    m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->lastColumnIndex());
+                    //the mount state just changed, do not use the cached results.
+                    AsyncFileUtils::clearCache(uri);
+                    AsyncFileUtils::then(AsyncFileUtils::getTargetUri(uri), changedItem, [=](const QString &targetUri) {
+                        if (targetUri.isEmpty()) {
+                            changedItem->m_is_mounted = false;
+                            changedItem->clearChildren();
+                        } else {
+                            changedItem->m_is_mounted = true;
+                        }
+
+                        //why it would failed when send changed signal for newly mounted item?
+                        //m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->firstColumnIndex());
+                        updateFileInfo(changedItem);
+                        m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->lastColumnIndex());
+                    });
                     break;
                 }
             }
@@ -297,10 +304,7 @@ bool SideBarFileSystemItem::isMounted()
 
 void SideBarFileSystemItem::eject(GMountUnmountFlags ejectFlag)
 {
-    //FIXME: replace BLOCKING api in ui thread.
     auto file = wrapGFile(g_file_new_for_uri(this->uri().toUtf8().constData()));
-    auto target = FileUtils::getTargetUri(m_uri);
-    auto drive = VolumeManager::getDriveFromUri(target);
     g_file_eject_mountable_with_operation(file.get()->get(),
                                           ejectFlag,
                                           nullptr,
@@ -488,14 +492,40 @@ GAsyncReadyCallback SideBarFileSystemItem::eject_cb(GFile *file, GAsyncResult *r
 
 //update udisk file info
 void SideBarFileSystemItem::updateFileInfo(SideBarFileSystemItem *pThis){
-        QString tmpName = FileUtils::getFileDisplayName(pThis->m_uri);
-
         //old's drive name -> now's volume name. fix #17968
-        FileUtils::queryVolumeInfo(pThis->m_uri,pThis->m_volume_name,pThis->m_unix_device,tmpName);
         //icon name.
-        pThis->m_icon_name = FileUtils::getFileIconName(pThis->m_uri);
+        pThis->queryFileInfoAsync();
         //mountable state. fix #19172
         auto fileInfo = FileInfo::fromUri(pThis->m_uri,false);
-        FileInfoJob fileJob(fileInfo);
-        fileJob.querySync();
+        auto fileJob = new FileInfoJob(fileInfo);
+        fileJob->setAutoDelete();
+        fileJob->queryAsync();
+}
+
+void SideBarFileSystemItem::queryFileInfoAsync()
+{
+    AsyncFileUtils::then(AsyncFileUtils::getFileDisplayName(m_uri), this, [=](const QString &displayName) {
+        if (!displayName.isNull())
+            m_display_name = displayName;
+        AsyncFileUtils::then(AsyncFileUtils::queryVolumeInfo(m_uri, m_display_name), this, [=](const AsyncFileUtils::VolumeInfo &volumeInfo) {
+            if (volumeInfo.valid) {
+                m_volume_name = volumeInfo.volume_name;
+                m_unix_device = volumeInfo.unix_device_name;
+            }
+            notifyDataChanged();
+        });
+    });
+
+    AsyncFileUtils::then(AsyncFileUtils::getFileIconNames(m_uri), this, [=](const QStringList &iconNames) {
+        m_icon_name = AsyncFileUtils::validIconName(iconNames);
+        notifyDataChanged();
+    });
+}
+
+void SideBarFileSystemItem::notifyDataChanged()
+{
+    //the item might not be inserted into model yet.
+    auto index = firstColumnIndex();
+    if (index.isValid())
+        m_model->dataChanged(index, index);
 }
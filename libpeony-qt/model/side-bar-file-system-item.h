@@ -92,6 +92,15 @@ protected:
                                         GAsyncResult *res,
                                         SideBarFileSystemItem *p_this);
     void updateFileInfo(SideBarFileSystemItem *pThis);
+    /*!
+     * \brief queryFileInfoAsync
+     * <br>
+     * Query the display name, volume info and icon of this item by AsyncFileUtils,
+     * the model is notified when they are ready.
+     * </br>
+     */
+    void queryFileInfoAsync();
+    void notifyDataChanged();
 
 private:
     SideBarFileSystemItem *m_parent = nullptr;
@@ -23,6 +23,7 @@
 #include "side-bar-personal-item.h"
 #include "side-bar-model.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include <QStandardPaths>
 
 using namespace Peony;
@@ -76,9 +77,23 @@ SideBarPersonalItem::SideBarPersonalItem(QString uri,
         return;
     }
     m_uri = uri;
-    //FIXME: replace BLOCKING api in ui thread.
-    m_display_name = FileUtils::getFileDisplayName(uri);
-    m_icon_name = FileUtils::getFileIconName(uri);
+    //show the base name until the display name is queried.
+    m_display_name = FileUtils::getUriBaseName(uri);
+    auto notifyDataChanged = [=]() {
+        //the item might not be inserted into model yet.
+        auto index = firstColumnIndex();
+        if (index.isValid())
+            m_model->dataChanged(index, index);
+    };
+    AsyncFileUtils::then(AsyncFileUtils::getFileDisplayName(uri), this, [=](const QString &displayName) {
+        if (!displayName.isNull())
+            m_display_name = displayName;
+        notifyDataChanged();
+    });
+    AsyncFileUtils::then(AsyncFileUtils::getFileIconNames(uri), this, [=](const QStringList &iconNames) {
+        m_icon_name = AsyncFileUtils::validIconName(iconNames);
+        notifyDataChanged();
+    });
 }
 
 QModelIndex SideBarPersonalItem::firstColumnIndex()
@@ -4,33 +4,47 @@ HEADERS += $$PWD/peony-core_global.h \
            $$PWD/file-info.h \
            $$PWD/file-info-job.h \
            $$PWD/file-info-manager.h \
+           $$PWD/file-info-store.h \
            $$PWD/file-enumerator.h \
+           $$PWD/directory-snapshot.h \
            $$PWD/mount-operation.h \
            $$PWD/file-watcher.h \
+           $$PWD/file-monitor-registry.h \
            $$PWD/connect-server-dialog.h \
     $$PWD/volume-manager.h \
     $$PWD/gerror-wrapper.h \
     $$PWD/gobject-template.h \
     $$PWD/file-utils.h \
+    $$PWD/async-file-utils.h \
+    $$PWD/gio-watchdog.h \
     $$PWD/thumbnail-manager.h \
+    $$PWD/thumbnail-notifier.h \
     $$PWD/linux-pwd-helper.h \
     $$PWD/file-meta-info.h \
+    $$PWD/file-meta-info-writer.h \
     $$PWD/bookmark-manager.h
 
 SOURCES += $$PWD/file-info.cpp \
            $$PWD/file-info-job.cpp \
            $$PWD/file-info-manager.cpp \
+           $$PWD/file-info-store.cpp \
            $$PWD/file-enumerator.cpp \
+           $$PWD/directory-snapshot.cpp \
            $$PWD/mount-operation.cpp \
            $$PWD/file-watcher.cpp \
+           $$PWD/file-monitor-registry.cpp \
            $$PWD/connect-server-dialog.cpp \
     $$PWD/volume-manager.cpp \
     $$PWD/gerror-wrapper.cpp \
     $$PWD/gobject-template.cpp \
     $$PWD/file-utils.cpp \
+    $$PWD/async-file-utils.cpp \
+    $$PWD/gio-watchdog.cpp \
     $$PWD/thumbnail-manager.cpp \
+    $$PWD/thumbnail-notifier.cpp \
     $$PWD/linux-pwd-helper.cpp \
     $$PWD/file-meta-info.cpp \
+    $$PWD/file-meta-info-writer.cpp \
     $$PWD/bookmark-manager.cpp
 
 FORMS += $$PWD/connect-server-dialog.ui
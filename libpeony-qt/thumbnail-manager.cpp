@@ -25,13 +25,14 @@
 
 #include "file-info-manager.h"
 
-#include "file-watcher.h"
+#include "thumbnail-notifier.h"
 #include "file-utils.h"
 
 #include "thumbnail/pdf-thumbnail.h"
 #include "thumbnail/video-thumbnail.h"
 #include "thumbnail/office-thumbnail.h"
 #include "generic-thumbnailer.h"
+#include "thumbnail-cache.h"
 #include "thumbnail-job.h"
 
 #include "global-settings.h"
@@ -39,8 +40,10 @@
 #include <QtConcurrent>
 #include <QIcon>
 #include <QUrl>
+#include <QFile>
 
 #include <QThreadPool>
+#include <QThread>
 #include <QSemaphore>
 
 #include <gio/gdesktopappinfo.h>
@@ -49,6 +52,32 @@ using namespace Peony;
 
 static ThumbnailManager *global_instance = nullptr;
 
+/*!
+ * \brief image_thumbnail
+ * \param path
+ * \return the thumbnail of an image file. the image is decoded at thumbnail size
+ * only when there is no valid thumbnail in ThumbnailCache, and the result is
+ * saved for next time.
+ */
+static QIcon image_thumbnail(const QString &path)
+{
+    //svg is scalable, it doesn't need a cached thumbnail.
+    if (path.endsWith(".svg"))
+        return GenericThumbnailer::generateThumbnail(path, true);
+
+    QImage image = ThumbnailCache::lookup(path);
+    if (image.isNull() && !ThumbnailCache::hasFailed(path)) {
+        image = GenericThumbnailer::readScaledImage(path, ThumbnailCache::Normal);
+        if (!image.isNull()) {
+            image = ThumbnailCache::insert(path, image);
+        } else if (QFile::exists(path)) {
+            ThumbnailCache::markFailed(path);
+        }
+    }
+
+    return GenericThumbnailer::generateThumbnail(image, true);
+}
+
 /*!
  * \brief ThumbnailManager::ThumbnailManager
  * \param parent
@@ -64,8 +93,16 @@ ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
 {
     GlobalSettings::getInstance();
 
-    m_thumbnail_thread_pool = new QThreadPool(this);
-    m_thumbnail_thread_pool->setMaxThreadCount(1);
+    for (int i = 0; i < LaneCount; i++) {
+        m_lanes<<new QThreadPool(this);
+    }
+    //keep a core for ui thread.
+    m_lanes.at(ImageLane)->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    //videos are decoded in process, the lane is the pool of decoders.
+    m_lanes.at(VideoLane)->setMaxThreadCount(qMax(PEONY_THUMBNAIL_VIDEO_LANE_THREADS, QThread::idealThreadCount()/2));
+    //embedded previews are read in parallel, the files which need libreoffice
+    //are queued in OfficeConvertQueue and converted in batches in its own thread.
+    m_lanes.at(OfficeLane)->setMaxThreadCount(PEONY_THUMBNAIL_OFFICE_LANE_THREADS);
 
     m_semaphore = new QSemaphore(1);
 }
@@ -100,7 +137,19 @@ void ThumbnailManager::setForbidThumbnailInView(bool forbid)
     GlobalSettings::getInstance()->setValue("do-not-thumbnail", forbid);
 }
 
-void ThumbnailManager::createVideFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::notifyThumbnailUpdated(const QString &uri, const std::weak_ptr<ThumbnailNotifier> &notifier)
+{
+    //the notifier is locked in the thread of manager, which is the thread of
+    //requesters, so a notifier is never destroyed in a worker thread.
+    QMetaObject::invokeMethod(this, [=]() {
+        auto strongPtr = notifier.lock();
+        if (strongPtr) {
+            Q_EMIT strongPtr->thumbnailUpdated(uri);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void ThumbnailManager::createVideFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier)
 {
     QIcon thumbnail;
 
@@ -108,14 +157,12 @@ void ThumbnailManager::createVideFileThumbnail(const QString &uri, std::shared_p
     thumbnail = videoThumbnail.generateThumbnail();
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        notifyThumbnailUpdated(uri, notifier);
     }
 
     return;
 }
-void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier)
 {
     QIcon thumbnail;
     QUrl url = uri;
@@ -125,20 +172,27 @@ void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::shared_pt
         //qDebug()<<url;
     }
 
-    PdfThumbnail pdfThumbnail(url.path());
-    QPixmap pix = pdfThumbnail.generateThumbnail();
+    QString path = url.path();
+    QImage image = ThumbnailCache::lookup(path);
+    if (image.isNull() && !ThumbnailCache::hasFailed(path)) {
+        PdfThumbnail pdfThumbnail(path);
+        QPixmap pix = pdfThumbnail.generateThumbnail();
+        if (!pix.isNull()) {
+            image = ThumbnailCache::insert(path, pix.toImage());
+        } else {
+            ThumbnailCache::markFailed(path);
+        }
+    }
 
-    thumbnail = GenericThumbnailer::generateThumbnail(pix, true);
+    thumbnail = GenericThumbnailer::generateThumbnail(image, true);
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        notifyThumbnailUpdated(uri, notifier);
     }
 
     return;
 }
-void ThumbnailManager::createImageFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::createImageFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier)
 {
     QUrl url = uri;
 
@@ -147,35 +201,38 @@ void ThumbnailManager::createImageFileThumbnail(const QString &uri, std::shared_
         //qDebug()<<url;
     }
 
-    QIcon thumbnail = GenericThumbnailer::generateThumbnail(url.path(), true);
+    QIcon thumbnail = image_thumbnail(url.path());
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        notifyThumbnailUpdated(uri, notifier);
     }
 
     //qApp->processEvents();
     return;
 }
 
-void ThumbnailManager::createOfficeFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::createOfficeFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier)
 {
     QIcon thumbnail;
 
+    //the callback is kept by OfficeConvertQueue until the conversion finished
+    //and called in its thread, it only holds the weak notifier.
     OfficeThumbnail officeThumbnail(uri);
-    thumbnail = officeThumbnail.generateThumbnail();;
+    thumbnail = officeThumbnail.generateThumbnail([=](const QIcon &converted) {
+        if (converted.isNull())
+            return;
+        insertOrUpdateThumbnail(uri, converted);
+        notifyThumbnailUpdated(uri, notifier);
+    });
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        notifyThumbnailUpdated(uri, notifier);
     }
 
     return;
 }
 
-void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier)
 {
     QIcon thumbnail;
     QUrl url = uri;
@@ -196,7 +253,7 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
 
     if (thumbnail.isNull()) {
         if (string.startsWith("/")) {
-            thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+            thumbnail = image_thumbnail(string);
         } else if (string.contains(".")) {
             // try getting themed icon with image suffix.
             string.chop(string.count() - string.lastIndexOf("."));
@@ -208,16 +265,15 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
 
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
-        if (watcher) {
-            watcher->fileChanged(uri);
-        }
+        notifyThumbnailUpdated(uri, notifier);
     }
 
     return;
 }
 
-void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
+void ThumbnailManager::createThumbnailInternal(const std::shared_ptr<FileInfo> &info, std::weak_ptr<ThumbnailNotifier> notifier, bool force)
 {
+    auto uri = info->uri();
     auto settings = GlobalSettings::getInstance();
     if (settings->isExist("do-not-thumbnail")) {
         bool do_not_thumbnail = settings->getValue("do-not-thumbnail").toBool();
@@ -228,26 +284,25 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
     }
 
     //NOTE: we should do createThumbnail() after we have queried the file's info.
-    auto info = FileInfo::fromUri(uri);
     //qDebug()<<"file uri:"<< uri << " mime type:" << info->mimeType();
     //qDebug()<<"file path:" << info->filePath();
     //qDebug()<<"file modify time:" << info->modifiedTime();
 
     if (!info->mimeType().isEmpty()) {
         if (info->isImageFile()) {
-            createImageFileThumbnail(uri, watcher);
+            createImageFileThumbnail(uri, notifier);
         }
         else if (info->mimeType().contains("pdf")) {
-            createPdfFileThumbnail(uri, watcher);
+            createPdfFileThumbnail(uri, notifier);
         }
         else if(info->isVideoFile()) {
-            createVideFileThumbnail(uri, watcher);
+            createVideFileThumbnail(uri, notifier);
         }
         else if (info->isOfficeFile()) {
-            createOfficeFileThumbnail(uri, watcher);
+            createOfficeFileThumbnail(uri, notifier);
         }
         else if (info->isDesktopFile()) {
-            createDesktopFileThumbnail(uri, watcher);
+            createDesktopFileThumbnail(uri, notifier);
         }
         else {
             //qDebug()<<"the file type: " << info->mimeType();
@@ -256,47 +311,125 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
     }
 }
 
-void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
+void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<ThumbnailNotifier> notifier, bool force)
 {
+    createThumbnail(FileInfo::fromUri(uri), notifier, force);
+}
+
+void ThumbnailManager::createThumbnail(const std::shared_ptr<FileInfo> &info, std::shared_ptr<ThumbnailNotifier> notifier, bool force)
+{
+    auto uri = info->uri();
     auto thumbnail = tryGetThumbnail(uri);
     if (!thumbnail.isNull()) {
         if (!force) {
-            watcher->thumbnailUpdated(uri);
-            watcher->fileChanged(uri);
+            if (notifier) {
+                Q_EMIT notifier->thumbnailUpdated(uri);
+            }
             return;
         }
     }
 
+    startJob(info, notifier, NormalPriority);
+}
+
+ThumbnailManager::ThumbnailLane ThumbnailManager::laneOf(const std::shared_ptr<FileInfo> &info)
+{
     // check if need thumbnail
-    bool needThumbnail = false;
+    if (info->mimeType().isEmpty())
+        return InvalidLane;
 
-    auto info = FileInfo::fromUri(uri);
-    if (!info->mimeType().isEmpty()) {
-        if (info->isImageFile()) {
-            needThumbnail = true;
-        }
-        else if (info->mimeType().contains("pdf")) {
-            needThumbnail = true;
-        }
-        else if(info->isVideoFile()) {
-            needThumbnail = true;
+    if (info->isImageFile() || info->mimeType().contains("pdf") || info->isDesktopFile())
+        return ImageLane;
+    if (info->isVideoFile())
+        return VideoLane;
+    if (info->isOfficeFile())
+        return OfficeLane;
+
+    return InvalidLane;
+}
+
+void ThumbnailManager::startJob(const std::shared_ptr<FileInfo> &info, std::shared_ptr<ThumbnailNotifier> notifier, int priority)
+{
+    auto lane = laneOf(info);
+    if (lane == InvalidLane)
+        return;
+
+    auto uri = info->uri();
+    QMutexLocker locker(&m_jobs_mutex);
+    for (auto job : m_pending_jobs.values(uri)) {
+        if (job->notifier().lock() == notifier) {
+            //the same request is queued already.
+            return;
         }
-        else if (info->isOfficeFile()) {
-            needThumbnail = true;
+    }
+
+    auto thumbnailJob = new ThumbnailJob(info, notifier);
+    thumbnailJob->m_lane = lane;
+    m_pending_jobs.insert(uri, thumbnailJob);
+    m_lanes.at(lane)->start(thumbnailJob, priority);
+}
+
+void ThumbnailManager::removePendingJob(ThumbnailJob *job)
+{
+    QMutexLocker locker(&m_jobs_mutex);
+    m_pending_jobs.remove(job->uri(), job);
+}
+
+void ThumbnailManager::prioritizeThumbnails(const QStringList &uris)
+{
+    QList<QPair<std::shared_ptr<FileInfo>, std::shared_ptr<ThumbnailNotifier>>> restartJobs;
+
+    m_jobs_mutex.lock();
+    for (auto uri : uris) {
+        for (auto job : m_pending_jobs.values(uri)) {
+            //if take failed, the job is running already.
+            auto lane = m_lanes.at(job->m_lane);
+            if (lane->tryTake(job)) {
+                lane->start(job, VisiblePriority);
+            }
         }
-        else if (info->isDesktopFile()) {
-            needThumbnail = true;
+        for (auto cancelledJob : m_cancelled_jobs.values(uri)) {
+            auto strongPtr = cancelledJob.second.lock();
+            if (strongPtr)
+                restartJobs<<qMakePair(cancelledJob.first, strongPtr);
         }
+        m_cancelled_jobs.remove(uri);
     }
+    m_jobs_mutex.unlock();
 
-    if (!needThumbnail)
-        return;
+    for (auto pair : restartJobs) {
+        startJob(pair.first, pair.second, VisiblePriority);
+    }
+}
 
-    auto thumbnailJob = new ThumbnailJob(uri, watcher, this);
-    m_thumbnail_thread_pool->start(thumbnailJob);
+void ThumbnailManager::cancelThumbnails(const QStringList &uris)
+{
+    QMutexLocker locker(&m_jobs_mutex);
+    for (auto uri : uris) {
+        for (auto job : m_pending_jobs.values(uri)) {
+            if (!m_lanes.at(job->m_lane)->tryTake(job))
+                continue;
+
+            m_pending_jobs.remove(uri, job);
+            m_cancelled_jobs.insert(uri, qMakePair(job->info(), job->notifier()));
+            //the job taken from thread pool is owned by us.
+            delete job;
+        }
+    }
+
+    //drop the cancelled jobs of closed views.
+    if (m_cancelled_jobs.count() > 4096) {
+        for (auto it = m_cancelled_jobs.begin(); it != m_cancelled_jobs.end();) {
+            if (it.value().second.expired()) {
+                it = m_cancelled_jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
 }
 
-void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher)
+void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<ThumbnailNotifier> notifier)
 {
     auto info = FileInfo::fromUri(uri);
     if (info->isDesktopFile() && info->canExecute()) {
@@ -304,13 +437,14 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
         //get desktop file icon.
         //async
         //qDebug()<<"desktop file"<<uri;
+        std::weak_ptr<ThumbnailNotifier> weakNotifier = notifier;
         QtConcurrent::run([=]() {
-            createDesktopFileThumbnail(uri, watcher);
+            createDesktopFileThumbnail(uri, weakNotifier);
         });
     } else {
         releaseThumbnail(uri);
-        if (watcher) {
-            watcher->thumbnailUpdated(uri);
+        if (notifier) {
+            Q_EMIT notifier->thumbnailUpdated(uri);
         }
     }
 }
@@ -28,21 +28,59 @@
 #include "file-info.h"
 
 #include <QHash>
+#include <QMultiHash>
 #include <QIcon>
 #include <QMutex>
+#include <QStringList>
+
+#ifndef PEONY_THUMBNAIL_VIDEO_LANE_THREADS
+#define PEONY_THUMBNAIL_VIDEO_LANE_THREADS 2
+#endif
+
+#ifndef PEONY_THUMBNAIL_OFFICE_LANE_THREADS
+#define PEONY_THUMBNAIL_OFFICE_LANE_THREADS 4
+#endif
 
 class QThreadPool;
 class QSemaphore;
 
 namespace Peony {
 
-class FileWatcher;
-
+class ThumbnailNotifier;
+class ThumbnailJob;
+
+/*!
+ * \brief The ThumbnailManager class
+ * <br>
+ * ThumbnailManager schedules thumbnail jobs in lanes. Each lane is a thread pool
+ * for one kind of thumbnailer, so that the slow video decoding and libreoffice
+ * jobs can not starve image jobs. The image lane uses all cores but one.
+ * </br>
+ * <br>
+ * Views report the items they are showing with prioritizeThumbnails(), these
+ * jobs are moved to the front of their lanes. Jobs of items scrolled away are
+ * cancelled by cancelThumbnails(), and they will be requested again once
+ * the items are visible.
+ * </br>
+ */
 class PEONYCORESHARED_EXPORT ThumbnailManager : public QObject
 {
     friend class ThumbnailJob;
     Q_OBJECT
 public:
+    enum ThumbnailLane {
+        InvalidLane = -1,
+        ImageLane,
+        VideoLane,
+        OfficeLane,
+        LaneCount
+    };
+
+    enum JobPriority {
+        NormalPriority = 0,
+        VisiblePriority = 1
+    };
+
     static ThumbnailManager *getInstance();
 
     void setForbidThumbnailInView(bool forbid);
@@ -51,11 +89,44 @@ public:
         return !m_hash.values(uri).isEmpty();
     }
 
-    void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
+    /*!
+     * \brief createThumbnail
+     * \param info, the info which has been queried.
+     * \param notifier
+     * \param force
+     * <br>
+     * The lane of the job is chosen by the mime type of info, there is no
+     * i/o in the calling thread. Views should use this version with the infos
+     * of their items.
+     * </br>
+     */
+    void createThumbnail(const std::shared_ptr<FileInfo> &info, std::shared_ptr<ThumbnailNotifier> notifier = nullptr, bool force = false);
+    /*!
+     * \brief createThumbnail
+     * \note the info is got by FileInfo::fromUri(), which queries the file type
+     * if the info is not cached yet.
+     */
+    void createThumbnail(const QString &uri, std::shared_ptr<ThumbnailNotifier> notifier = nullptr, bool force = false);
     void releaseThumbnail(const QString &uri);
-    void updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr);
+    void updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<ThumbnailNotifier> notifier = nullptr);
     const QIcon tryGetThumbnail(const QString &uri);
 
+    /*!
+     * \brief prioritizeThumbnails
+     * \param uris, the items which are visible in a view.
+     * <br>
+     * Pending jobs of uris are moved to the front of their lanes, and the
+     * jobs cancelled before are started again.
+     * </br>
+     */
+    void prioritizeThumbnails(const QStringList &uris);
+    /*!
+     * \brief cancelThumbnails
+     * \param uris, the items which are scrolled away.
+     * \note a job which is running will not be interrupted.
+     */
+    void cancelThumbnails(const QStringList &uris);
+
 Q_SIGNALS:
 
 public Q_SLOTS:
@@ -67,19 +138,49 @@ protected:
 private:
     explicit ThumbnailManager(QObject *parent = nullptr);
     ~ThumbnailManager();
-    void createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
-
-    void createVideFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
-    void createPdfFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
-    void createImageFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
-    void createOfficeFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
-    void createDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
+    /*!
+     * \brief createThumbnailInternal
+     * <br>
+     * it runs in the lanes, the notifier is only locked by
+     * notifyThumbnailUpdated() in the thread of manager.
+     * </br>
+     */
+    void createThumbnailInternal(const std::shared_ptr<FileInfo> &info, std::weak_ptr<ThumbnailNotifier> notifier, bool force = false);
+
+    ThumbnailLane laneOf(const std::shared_ptr<FileInfo> &info);
+    void startJob(const std::shared_ptr<FileInfo> &info, std::shared_ptr<ThumbnailNotifier> notifier, int priority);
+    /*!
+     * \brief removePendingJob
+     * \param job
+     * it is called by a job when it starts running in its lane.
+     */
+    void removePendingJob(ThumbnailJob *job);
+    /*!
+     * \brief notifyThumbnailUpdated
+     * \param uri
+     * \param notifier
+     * <br>
+     * emit thumbnailUpdated() of notifier in the thread of manager if it is
+     * still alive, it is safe to be called in any thread.
+     * </br>
+     */
+    void notifyThumbnailUpdated(const QString &uri, const std::weak_ptr<ThumbnailNotifier> &notifier);
+
+    void createVideFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier);
+    void createPdfFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier);
+    void createImageFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier);
+    void createOfficeFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier);
+    void createDesktopFileThumbnail(const QString &uri, std::weak_ptr<ThumbnailNotifier> notifier);
 
     QHash<QString, QIcon> m_hash;
     //QMutex m_mutex;
 
-    QThreadPool *m_thumbnail_thread_pool;
     QSemaphore *m_semaphore;
+
+    QList<QThreadPool *> m_lanes;
+    QMutex m_jobs_mutex;
+    QMultiHash<QString, ThumbnailJob *> m_pending_jobs;
+    QMultiHash<QString, QPair<std::shared_ptr<FileInfo>, std::weak_ptr<ThumbnailNotifier>>> m_cancelled_jobs;
 };
 
 }
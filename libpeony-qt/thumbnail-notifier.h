@@ -0,0 +1,61 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef THUMBNAILNOTIFIER_H
+#define THUMBNAILNOTIFIER_H
+
+#include <QObject>
+
+#include "peony-core_global.h"
+
+namespace Peony {
+
+/*!
+ * \brief The ThumbnailNotifier class
+ * <br>
+ * ThumbnailNotifier is the channel of thumbnail notifications between
+ * ThumbnailManager and the requesters, such as a model or a property page.
+ * A requester holds a shared notifier and passes it to
+ * ThumbnailManager::createThumbnail(), the manager only keeps a weak
+ * reference of it, so the pending jobs of a destroyed requester will be skipped.
+ * </br>
+ * <br>
+ * The notifier is only a signal, it doesn't hold any file monitor.
+ * The thumbnailUpdated() signal is emitted in the thread of ThumbnailManager,
+ * the thumbnail lanes only hold weak references, so the notifier is always
+ * destroyed in the thread of its requester.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT ThumbnailNotifier : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ThumbnailNotifier(QObject *parent = nullptr);
+
+Q_SIGNALS:
+    void thumbnailUpdated(const QString &uri);
+};
+
+}
+
+#endif // THUMBNAILNOTIFIER_H
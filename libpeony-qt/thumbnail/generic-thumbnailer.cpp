@@ -28,64 +28,223 @@
 #include <QFileInfo>
 #include<QDir>
 #include <QPainter>
+#include <QImageReader>
+#include <QTransform>
 #include <QMessageAuthenticationCode>
 #include<QDesktopServices>
 
+#include <string.h>
+
 extern void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed);
 
-QIcon GenericThumbnailer::generateThumbnail(const QUrl &url, bool shadow, const QSize &size)
+//the shadow is a 4px blurred gray border around the thumbnail.
+#define SHADOW_MARGIN 4
+#define SHADOW_RADIUS 4
+//the corners of the 9-patch, they must be larger than margin + blur radius.
+#define SHADOW_PATCH_CORNER 16
+
+/*!
+ * \brief make_shadow_patch
+ * \return a shadow image of 2*corner+1 pixels square. the corners are copied
+ * and the middle row and column are stretched when painting a shadow, so the
+ * blur is done only once rather than for each thumbnail.
+ */
+static QImage make_shadow_patch()
 {
-    QIcon icon;
-    QFile file(url.path());
-    if (!file.exists())
-        return icon;
+    int size = 2*SHADOW_PATCH_CORNER + 1;
+    QImage patch(size, size, QImage::Format_ARGB32_Premultiplied);
+    patch.fill(Qt::transparent);
+
+    QPainter p(&patch);
+    p.setPen(Qt::transparent);
+    p.setBrush(Qt::gray);
+    p.drawRect(patch.rect().adjusted(SHADOW_MARGIN, SHADOW_MARGIN, -SHADOW_MARGIN, -SHADOW_MARGIN));
+    p.end();
+
+    qt_blurImage(patch, SHADOW_RADIUS, false, false);
+    return patch;
+}
 
-    //skip svg
-    if (url.path().endsWith(".svg")) {
-        if (file.size() < 1024*1024*8)
-            icon.addFile(url.path());
-        return icon;
+static void draw_shadow(QPainter *p, const QRect &rect)
+{
+    static const QImage patch = make_shadow_patch();
+    int c = SHADOW_PATCH_CORNER;
+
+    if (rect.width() < 2*c || rect.height() < 2*c) {
+        p->drawImage(rect, patch);
+        return;
     }
 
-    QImage img(url.path());
+    int xs[] = {0, c, rect.width() - c, rect.width()};
+    int ys[] = {0, c, rect.height() - c, rect.height()};
+    int sources[] = {0, c, c + 1, 2*c + 1};
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            QRect target(rect.x() + xs[i], rect.y() + ys[j], xs[i + 1] - xs[i], ys[j + 1] - ys[j]);
+            QRect source(sources[i], sources[j], sources[i + 1] - sources[i], sources[j + 1] - sources[j]);
+            p->drawImage(target, patch, source);
+        }
+    }
+}
 
-    if (img.rect().size().width() > 128) {
-        //scale large size image.
-        if (size.isValid()) {
-            img = img.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        } else {
-            img = img.scaledToWidth(128, Qt::SmoothTransformation);
+static QImage shadowed_image(const QImage &image)
+{
+    QImage newImg(image.size(), QImage::Format_ARGB32_Premultiplied);
+    newImg.fill(Qt::transparent);
+
+    QPainter p(&newImg);
+    draw_shadow(&p, newImg.rect());
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    p.drawImage(newImg.rect().adjusted(SHADOW_MARGIN, SHADOW_MARGIN, -SHADOW_MARGIN, -SHADOW_MARGIN), image);
+    p.end();
+
+    return newImg;
+}
+
+static QImage apply_exif_orientation(const QImage &image, int orientation)
+{
+    QTransform rotate90;
+    rotate90.rotate(90);
+    QTransform rotate270;
+    rotate270.rotate(270);
+
+    switch (orientation) {
+    case 2:
+        return image.mirrored(true, false);
+    case 3:
+        return image.mirrored(true, true);
+    case 4:
+        return image.mirrored(false, true);
+    case 5:
+        return image.mirrored(false, true).transformed(rotate90);
+    case 6:
+        return image.transformed(rotate90);
+    case 7:
+        return image.mirrored(true, false).transformed(rotate90);
+    case 8:
+        return image.transformed(rotate270);
+    default:
+        return image;
+    }
+}
+
+/*!
+ * \brief read_exif_thumbnail
+ * \param path
+ * \param orientation
+ * \return the preview which most cameras embed in IFD1 of exif, it is usually
+ * 160x120 and decoding it is far cheaper than decoding the photo.
+ */
+static QImage read_exif_thumbnail(const QString &path, int *orientation)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QImage();
+
+    //APP1 segment can not be larger than 64k.
+    QByteArray data = file.read(0x10000 + 0x100);
+    auto d = reinterpret_cast<const uchar *>(data.constData());
+    qint64 n = data.size();
+    if (n < 4 || d[0] != 0xFF || d[1] != 0xD8)
+        return QImage();
+
+    QByteArray tiff;
+    qint64 pos = 2;
+    while (pos + 4 <= n && d[pos] == 0xFF) {
+        uchar marker = d[pos + 1];
+        qint64 length = (d[pos + 2] << 8) | d[pos + 3];
+        //start of scan, there is no more metadata.
+        if (marker == 0xDA || marker == 0xD9)
+            break;
+        if (marker == 0xE1 && length > 8 && pos + 2 + length <= n && memcmp(d + pos + 4, "Exif\0\0", 6) == 0) {
+            tiff = data.mid(pos + 10, length - 8);
+            break;
         }
+        pos += 2 + length;
     }
 
-    if (img.hasAlphaChannel()) {
-        //skip shadow
-        icon.addPixmap(QPixmap::fromImage(img));
-        return icon;
+    auto t = reinterpret_cast<const uchar *>(tiff.constData());
+    qint64 size = tiff.size();
+    if (size < 8)
+        return QImage();
+
+    bool littleEndian = t[0] == 'I' && t[1] == 'I';
+    auto u16 = [=](qint64 offset) -> quint32 {
+        if (offset < 0 || offset + 2 > size)
+            return 0;
+        return littleEndian? (t[offset] | t[offset + 1] << 8): (t[offset] << 8 | t[offset + 1]);
+    };
+    auto u32 = [=](qint64 offset) -> quint32 {
+        if (offset < 0 || offset + 4 > size)
+            return 0;
+        return littleEndian? (u16(offset) | u16(offset + 2) << 16): (u16(offset) << 16 | u16(offset + 2));
+    };
+
+    if (u16(2) != 42)
+        return QImage();
+
+    qint64 ifd0 = u32(4);
+    int count = u16(ifd0);
+    for (int i = 0; i < count; i++) {
+        qint64 entry = ifd0 + 2 + i*12;
+        if (u16(entry) == 0x0112)
+            *orientation = u16(entry + 8);
     }
 
-    if (shadow) {
-        QPixmap pixmap = QPixmap::fromImage(img);
-        pixmap = pixmap.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    qint64 ifd1 = u32(ifd0 + 2 + count*12);
+    if (ifd1 <= 0)
+        return QImage();
+
+    qint64 offset = 0;
+    qint64 length = 0;
+    count = u16(ifd1);
+    for (int i = 0; i < count; i++) {
+        qint64 entry = ifd1 + 2 + i*12;
+        auto tag = u16(entry);
+        if (tag == 0x0201)
+            offset = u32(entry + 8);
+        else if (tag == 0x0202)
+            length = u32(entry + 8);
+    }
 
-        QImage newImg(img.size(), QImage::Format_ARGB32);
-        newImg.fill(Qt::transparent);
-        QPainter p(&newImg);
+    if (offset <= 0 || length <= 0 || offset + length > size)
+        return QImage();
 
-        p.setPen(Qt::transparent);
-        p.setBrush(Qt::gray);
-        p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
+    return QImage::fromData(tiff.mid(offset, length), "JPEG");
+}
 
-        qt_blurImage(newImg, 4, false, false);
-        p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), pixmap);
+QImage GenericThumbnailer::readScaledImage(const QString &path, int maxSize)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QSize originalSize = reader.size();
+    if (!originalSize.isValid() || (originalSize.width() <= maxSize && originalSize.height() <= maxSize)) {
+        return reader.read();
+    }
 
-        p.end();
-        icon.addPixmap(QPixmap::fromImage(newImg));
-    } else {
-        icon.addPixmap(QPixmap::fromImage(img));
+    if (reader.format() == "jpeg") {
+        int orientation = 1;
+        QImage preview = read_exif_thumbnail(path, &orientation);
+        //some cameras pad the preview with black bars, the aspect ratio
+        //must be the same as the photo.
+        if (!preview.isNull() && qMax(preview.width(), preview.height()) >= maxSize) {
+            qreal previewRatio = qreal(preview.width())/preview.height();
+            qreal originalRatio = qreal(originalSize.width())/originalSize.height();
+            if (qAbs(previewRatio - originalRatio) < 0.05*originalRatio) {
+                return apply_exif_orientation(preview, orientation);
+            }
+        }
     }
 
-    return icon;
+    //jpeg handler decodes with DCT scaling when a scaled size is set,
+    //other formats are scaled while reading lines.
+    reader.setScaledSize(originalSize.scaled(maxSize, maxSize, Qt::KeepAspectRatio));
+    return reader.read();
+}
+
+QIcon GenericThumbnailer::generateThumbnail(const QUrl &url, bool shadow, const QSize &size)
+{
+    return generateThumbnail(url.path(), shadow, size);
 }
 
 QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, const QSize &size)
@@ -102,7 +261,17 @@ QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, co
         return icon;
     }
 
-    QImage img(path);
+    QImage img = readScaledImage(path, qMax(128, qMax(size.width(), size.height())));
+    return generateThumbnail(img, shadow, size);
+}
+
+QIcon GenericThumbnailer::generateThumbnail(const QImage &image, bool shadow, const QSize &size)
+{
+    QIcon icon;
+    if (image.isNull())
+        return icon;
+
+    QImage img = image;
     if (img.rect().size().width() > 128) {
         //scale large size image.
         if (size.isValid()) {
@@ -119,22 +288,7 @@ QIcon GenericThumbnailer::generateThumbnail(const QString &path, bool shadow, co
     }
 
     if (shadow) {
-        QPixmap pixmap = QPixmap::fromImage(img);
-        pixmap = pixmap.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-        QImage newImg(img.size(), QImage::Format_ARGB32);
-        newImg.fill(Qt::transparent);
-        QPainter p(&newImg);
-
-        p.setPen(Qt::transparent);
-        p.setBrush(Qt::gray);
-        p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
-
-        qt_blurImage(newImg, 4, false, false);
-        p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), pixmap);
-
-        p.end();
-        icon.addPixmap(QPixmap::fromImage(newImg));
+        icon.addPixmap(QPixmap::fromImage(shadowed_image(img)));
     } else {
         icon.addPixmap(QPixmap::fromImage(img));
     }
@@ -149,32 +303,14 @@ QIcon GenericThumbnailer::generateThumbnail(const QPixmap &pixmap, bool shadow,
     if (pixmap.isNull())
         return icon;
 
-    QSize realSize;
     if (size.isValid()) {
-        realSize = size;
         tmp = tmp.scaled(size);
     } else {
         tmp = tmp.scaledToWidth(128, Qt::SmoothTransformation);
-        realSize = tmp.size();
     }
 
     if (shadow) {
-        QImage newImg(realSize, QImage::Format::Format_ARGB32);
-        newImg.fill(Qt::transparent);
-
-        tmp = tmp.scaled(tmp.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-        QPainter p(&newImg);
-
-        p.setPen(Qt::transparent);
-        p.setBrush(Qt::gray);
-        p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
-
-        qt_blurImage(newImg, 4, false, false);
-        p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), tmp);
-
-        p.end();
-        icon.addPixmap(QPixmap::fromImage(newImg));
+        icon.addPixmap(QPixmap::fromImage(shadowed_image(tmp.toImage())));
     } else {
         icon.addPixmap(tmp);
     }
@@ -25,6 +25,7 @@
 
 #include <QObject>
 #include <QSize>
+#include <QImage>
 
 class GenericThumbnailer : public QObject
 {
@@ -32,7 +33,17 @@ class GenericThumbnailer : public QObject
 public:
     static QIcon generateThumbnail(const QUrl &url, bool shadow = false, const QSize &size = QSize());
     static QIcon generateThumbnail(const QString &path, bool shadow = false, const QSize &size = QSize());
+    static QIcon generateThumbnail(const QImage &image, bool shadow = false, const QSize &size = QSize());
     static QIcon generateThumbnail(const QPixmap &pixmap, bool shadow = true, const QSize &size = QSize());
+    /*!
+     * \brief readScaledImage
+     * \param path
+     * \param maxSize
+     * \return the image scaled to fit maxSize. jpeg files use the exif preview
+     * if there is a large enough one, otherwise they are decoded at reduced
+     * size, the full resolution image is never decoded.
+     */
+    static QImage readScaledImage(const QString &path, int maxSize = 128);
     static QString codeMd5(QString fileName);
     static QString codeMd5WithModifyTime(QString fileName, quint64 &modifyTime);
     static QString cachDir();
@@ -22,8 +22,16 @@
 
 #include "generic-thumbnailer.h"
 #include "office-thumbnail.h"
+#include "thumbnail-cache.h"
+#include "zip-entry-reader.h"
 #include "file-utils.h"
 #include <QFileInfo>
+#include <QDir>
+#include <QTemporaryDir>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QUrl>
 #include <QDebug>
 #include <QtConcurrent>
 #include <QImage>
@@ -41,9 +49,6 @@ OfficeThumbnail::OfficeThumbnail(const QString &uri)
     else {
         m_url = uri;
     }
-
-    auto fileInfo = FileInfo::fromUri(uri);
-    m_modifyTime = fileInfo->modifiedTime();
 }
 
 OfficeThumbnail::~OfficeThumbnail()
@@ -52,82 +57,236 @@ OfficeThumbnail::~OfficeThumbnail()
 }
 
 /*
-*函数功能：
-*1、提取office文件的缩略图，利用libreoffice将文件的首页转换为jpg图片，
-* 从而得到缩略图要显示的内容。
-*2、md5值是为了区分同名文件的情况，以及文件的是否修改，如果修改过，重新
-* 生成缩略图。
-*3、将转换后的jpg图片暂时存放到/tmp目录下，该目录时内存文件系统，读写速
-* 度快；只要系统重启，这些转换的图片就会清除，不需要主动删除，这样可以避免
-* 重复进行图片提取，缺点就是会占用一部分内存，由于桌面系统不会长时间运行，
-* 也就避免了文件堆积造成占用内存过高的情况。
-*
-* 性能测试（测试的内容有限，并不能够说明所有问题）：
-* 1、ppt的文件转换一页最慢的需要12s左右，这个时间和文件页数关系不大，但是ppt的
-* 版本对时间的影响较大；
-* 2、word文件转换一页最慢的需要17s左右，这个和文件中的内容以及格式关系很大，如果
-* 是纯文本文字，230页的文件转换也就是2-3s的时间，如果文件中图片较多，即便是只有5
-* 页的文件，转换一页消耗的时间也要5s的时间。
-* 3、excel文件暂未测试
-* 4、转pdf的时间消耗，和文件的页数成正比，页数越多，时间消耗越长，时间消耗达到分钟级。
-*
-* 后续优化思路：
-* 1、寻找office的开发api，直接操作文件，避免转换的过程
-* 2、通过并发的提升性能，经过验证libreoffice是单进程处理，不可以并发
+* OOXML文件的预览图在docProps目录，ODF文件的预览图在Thumbnails目录，
+* wmf和emf格式的预览图无法解码，不做处理。
 */
-QIcon OfficeThumbnail::generateThumbnail()
+static const char *embedded_previews[] = {
+    "Thumbnails/thumbnail.png",
+    "docProps/thumbnail.jpeg",
+    "docProps/thumbnail.jpg",
+    "docProps/thumbnail.png",
+    nullptr
+};
+
+/*!
+ * \brief The OfficeConvertQueue class
+ * <br>
+ * libreoffice can not convert files concurrently, and starting it costs
+ * seconds. The files waiting for conversion are queued and converted in
+ * batches by one libreoffice process, in a dedicated thread. The jobs of the
+ * office lane only queue their files and return, so the lane keeps reading
+ * embedded previews while a batch is converting, and the results are passed
+ * to the callbacks of queued files in the conversion thread.
+ * </br>
+ */
+class OfficeConvertQueue
 {
-    QIcon thumbnailImage;
-    QString md5Name=GenericThumbnailer::codeMd5WithModifyTime(m_url.path(), m_modifyTime);
-    QString thumbnail_dir= GenericThumbnailer::thumbnaileCachDir() + "/" + md5Name;
-    QString fileName = m_url.fileName();
-    qint16 idx = fileName.lastIndexOf(".");
-    QString fileThumbnail=thumbnail_dir + "/" + fileName.left(idx) + ".jpg";
-
-    qDebug()<<"file thumbnail:"<<fileThumbnail;
-    if (!QFile::exists(fileThumbnail)) {
-        //libreoffice --convert-to jpg:writer_jpg_Export test1.doc --outdir ./
+public:
+    typedef std::function<void(const QImage &)> Callback;
+
+    static OfficeConvertQueue *getInstance() {
+        static OfficeConvertQueue queue;
+        return &queue;
+    }
+
+    /*!
+     * \brief convert
+     * \param path
+     * \param callback, called with the first page of the document, or a null
+     * image if failed, in the conversion thread.
+     */
+    void convert(const QString &path, const Callback &callback)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_queue.contains(path))
+            m_queue<<path;
+        m_callbacks.insert(path, callback);
+
+        if (!m_converting) {
+            m_converting = true;
+            QtConcurrent::run(&m_pool, [=]() {
+                convertQueued();
+            });
+        }
+    }
+
+private:
+    OfficeConvertQueue() {
+        //only one libreoffice process at a time.
+        m_pool.setMaxThreadCount(1);
+    }
+
+    void convertQueued()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_queue.isEmpty()) {
+            QStringList batch = takeBatch();
+            locker.unlock();
+            auto results = convertBatch(batch);
+            locker.relock();
+
+            //the files queued again while converting are converted again.
+            QList<QPair<Callback, QImage>> finished;
+            for (auto file : batch) {
+                for (auto callback : m_callbacks.values(file)) {
+                    finished<<qMakePair(callback, results.value(file));
+                }
+                m_callbacks.remove(file);
+            }
+            locker.unlock();
+            for (auto pair : finished) {
+                pair.first(pair.second);
+            }
+            locker.relock();
+        }
+        m_converting = false;
+    }
+
+    /*!
+     * \brief takeBatch
+     * \return queued files, libreoffice names the output by the base name of
+     * input, so the files with a same base name are left to next batch.
+     */
+    QStringList takeBatch()
+    {
+        QStringList batch;
+        QStringList baseNames;
+        for (auto path : m_queue) {
+            QString baseName = QFileInfo(path).completeBaseName();
+            if (baseNames.contains(baseName))
+                continue;
+            baseNames<<baseName;
+            batch<<path;
+        }
+        for (auto path : batch) {
+            m_queue.removeOne(path);
+        }
+        return batch;
+    }
+
+    QHash<QString, QImage> convertBatch(const QStringList &batch)
+    {
+        QHash<QString, QImage> results;
+        QTemporaryDir outputDir(GenericThumbnailer::thumbnaileCachDir() + "/office-XXXXXX");
+        if (!outputDir.isValid())
+            return results;
+
+        //libreoffice --convert-to jpg test1.doc test2.xls --outdir ./
         QStringList list;
         list<<"--headless"  /*headless和invisible的方式可以避免出现界面以及无用的log信息，速度更快*/
             <<"--invisible"
+            /*使用单独的配置目录，避免和用户打开的libreoffice冲突，也不必每次重新初始化配置*/
+            <<"-env:UserInstallation=" + QUrl::fromLocalFile(GenericThumbnailer::thumbnaileCachDir() + "/libreoffice-profile").toString()
             <<"--convert-to"
-            <<"jpg:writer_jpg_Export"     /*转换格式jpg*/
-            <<m_url.path()                /*要转换的文件*/
+            <<"jpg"                       /*转换格式jpg，由libreoffice选择文档对应的导出过滤器*/
+            <<batch                       /*要转换的文件*/
             <<"--outdir"                  /*转换完的jpg文件存在的路径*/
-            <<thumbnail_dir;
+            <<outputDir.path();
         qDebug()<<"the libreoffice cmd: " << list;
 
         QProcess p;
-        p.start("libreoffice",list);
+        p.start("libreoffice", list);
 
-        /*
-        * 等待30s超时，30s是默认时间，可以修改
-        */
         if (!p.waitForStarted()) {
             qWarning()<<"libreoffice start failed, or timeout";
-            return thumbnailImage;
+            return results;
         }
 
         /*
-        * 等待30s超时，30s是默认时间，可以修改
+        * 每个文件等待30s超时
         */
-        if (!p.waitForFinished()) {
+        if (!p.waitForFinished(30000*batch.count())) {
             qWarning()<<"libreoffice run failed, or timeout";
-            return thumbnailImage;
+            p.kill();
+            p.waitForFinished();
         }
 
-        QString err=p.readAllStandardError();
-        QString read=p.readAll();
-        if (!err.isEmpty()) {
-            qWarning()<<"office convert jpg error: " << err;
-            return thumbnailImage;
+        for (auto path : batch) {
+            QString output = outputDir.path() + "/" + QFileInfo(path).completeBaseName() + ".jpg";
+            results.insert(path, GenericThumbnailer::readScaledImage(output, ThumbnailCache::Normal));
         }
+        return results;
+    }
+
+    QMutex m_mutex;
+    QThreadPool m_pool;
+    bool m_converting = false;
+    QStringList m_queue;
+    QMultiHash<QString, Callback> m_callbacks;
+};
+
+QImage OfficeThumbnail::readEmbeddedPreview()
+{
+    ZipEntryReader reader(m_url.path());
+    if (!reader.isValid())
+        return QImage();
+
+    for (int i = 0; embedded_previews[i]; i++) {
+        if (!reader.contains(embedded_previews[i]))
+            continue;
+
+        QImage image = QImage::fromData(reader.read(embedded_previews[i]));
+        if (!image.isNull())
+            return image;
+    }
+
+    return QImage();
+}
+
+/*
+*函数功能：
+*1、提取office文件的缩略图，OOXML(docx/xlsx/pptx)和ODF(odt/ods/odp)文件的
+* zip包中一般带有预览图，直接从zip包中读取，不需要启动任何进程，耗时在毫秒级。
+*2、没有预览图的文件(如doc/xls/ppt)利用libreoffice将文件的首页转换为jpg图片，
+* 从而得到缩略图要显示的内容。libreoffice是单进程处理，不可以并发，所以等待
+* 转换的文件在OfficeConvertQueue中排队，一次libreoffice进程转换一批文件。
+*3、缩略图存入ThumbnailCache，即~/.cache/thumbnails下的缩略图缓存，转换用的jpg
+* 图片随临时目录删除。重启之后也不需要重复进行图片提取，转换失败的文件也会被记录，
+* 文件修改之前不会再次转换。
+*
+* 性能测试（测试的内容有限，并不能够说明所有问题）：
+* 1、ppt的文件转换一页最慢的需要12s左右，这个时间和文件页数关系不大，但是ppt的
+* 版本对时间的影响较大；
+* 2、word文件转换一页最慢的需要17s左右，这个和文件中的内容以及格式关系很大，如果
+* 是纯文本文字，230页的文件转换也就是2-3s的时间，如果文件中图片较多，即便是只有5
+* 页的文件，转换一页消耗的时间也要5s的时间。
+* 3、excel文件暂未测试
+* 4、转pdf的时间消耗，和文件的页数成正比，页数越多，时间消耗越长，时间消耗达到分钟级。
+*/
+QIcon OfficeThumbnail::generateThumbnail(const std::function<void(const QIcon &)> &converted)
+{
+    QIcon thumbnailImage;
+    QImage image = ThumbnailCache::lookup(m_url.path());
+    if (!image.isNull()) {
+        thumbnailImage = GenericThumbnailer::generateThumbnail(image, true);
+        return thumbnailImage;
+    }
+
+    if (ThumbnailCache::hasFailed(m_url.path()))
+        return thumbnailImage;
+
+    image = readEmbeddedPreview();
+    if (!image.isNull()) {
+        image = ThumbnailCache::insert(m_url.path(), image);
+        thumbnailImage = GenericThumbnailer::generateThumbnail(image, true);
+        return thumbnailImage;
     }
 
-    /*
-     *不知道会不会出现无效的图片的情况，可能需要对这种情况做处理？
-    */
-    thumbnailImage = GenericThumbnailer::generateThumbnail(fileThumbnail, true);
+    //do not hold the worker until libreoffice finishes, the thumbnail is
+    //passed to converted later.
+    QString path = m_url.path();
+    OfficeConvertQueue::getInstance()->convert(path, [=](const QImage &result) {
+        if (result.isNull()) {
+            //libreoffice might be installed later, do not record the failure.
+            if (!QStandardPaths::findExecutable("libreoffice").isEmpty())
+                ThumbnailCache::markFailed(path);
+            return;
+        }
+
+        auto cached = ThumbnailCache::insert(path, result);
+        if (converted)
+            converted(GenericThumbnailer::generateThumbnail(cached, true));
+    });
 
     return thumbnailImage;
 }
@@ -28,13 +28,22 @@
 #include <QMutex>
 #include <QUrl>
 
+#include <functional>
+
 using namespace Peony;
 
 class OfficeThumbnail{
 public:
     explicit OfficeThumbnail(const QString &uri);
     ~OfficeThumbnail();
-    QIcon generateThumbnail();
+    /*!
+     * \brief generateThumbnail
+     * \param converted, called in the conversion thread if the file has to
+     * be converted by libreoffice.
+     * \return the cached or embedded thumbnail, or a null icon if the file is
+     * queued for conversion or it has failed before.
+     */
+    QIcon generateThumbnail(const std::function<void(const QIcon &)> &converted);
 
 private:
     /*
@@ -42,12 +51,12 @@ private:
     */
     void thumbnaileCachDir();
 
-    QUrl m_url;
     /*
-    * 获取文件的修改时间，如果被修改，将重新生成缩略图，
-    * 主要是为了处理修改文件首页的情况
+    * 读取OOXML和ODF文件的zip包中内嵌的预览图
     */
-    quint64 m_modifyTime = 0;
+    QImage readEmbeddedPreview();
+
+    QUrl m_url;
 };
 
 #endif // OFFICETHUMBNAIL_H
@@ -0,0 +1,117 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+/*!
+ * This benchmark measures the time of generating a shadowed thumbnail for
+ * each image and the peak rss of the process.
+ *
+ * The legacy mode decodes the full resolution image, scales it and blurs a
+ * shadow for every thumbnail. The default mode uses the scaled decoding of
+ * GenericThumbnailer and the pre-rendered shadow. Peak rss is per process,
+ * so run the two modes separately and compare:
+ *
+ * usage: thumbnail-benchmark [--legacy] image1.jpg image2.jpg ...
+ */
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPainter>
+#include <QIcon>
+#include <QDebug>
+
+#include <generic-thumbnailer.h>
+
+extern void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed);
+
+static qint64 peak_rss()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+
+    while (!status.atEnd()) {
+        QString line = status.readLine();
+        if (line.startsWith("VmHWM:")) {
+            //VmHWM:     12345 kB
+            return line.split(" ", QString::SkipEmptyParts).at(1).toLongLong() * 1024;
+        }
+    }
+    return 0;
+}
+
+static QIcon legacy_thumbnail(const QString &path)
+{
+    QIcon icon;
+    QImage img(path);
+    if (img.width() > 128)
+        img = img.scaledToWidth(128, Qt::SmoothTransformation);
+
+    QPixmap pixmap = QPixmap::fromImage(img);
+    pixmap = pixmap.scaled(img.rect().adjusted(4, 4, -4, -4).size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+    QImage newImg(img.size(), QImage::Format_ARGB32);
+    newImg.fill(Qt::transparent);
+    QPainter p(&newImg);
+
+    p.setPen(Qt::transparent);
+    p.setBrush(Qt::gray);
+    p.drawRect(newImg.rect().adjusted(4, 4, -4, -4));
+
+    qt_blurImage(newImg, 4, false, false);
+    p.drawPixmap(newImg.rect().adjusted(4, 4, -4, -4), pixmap);
+
+    p.end();
+    icon.addPixmap(QPixmap::fromImage(newImg));
+    return icon;
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    auto args = a.arguments();
+    args.removeFirst();
+    bool legacy = args.removeAll("--legacy") > 0;
+    if (args.isEmpty()) {
+        qInfo()<<"usage: thumbnail-benchmark [--legacy] image1.jpg image2.jpg ...";
+        return 0;
+    }
+
+    qint64 baseRss = peak_rss();
+
+    QElapsedTimer timer;
+    timer.start();
+    int succeed = 0;
+    for (auto path : args) {
+        QIcon icon = legacy? legacy_thumbnail(path): GenericThumbnailer::generateThumbnail(path, true);
+        if (!icon.isNull())
+            succeed++;
+    }
+    qint64 elapsed = timer.elapsed();
+
+    qInfo()<<(legacy? "legacy": "scaled")<<"mode, images:"<<args.count()<<"thumbnails:"<<succeed;
+    qInfo()<<"time  :"<<qreal(elapsed)/args.count()<<"ms/thumbnail";
+    qInfo()<<"memory:"<<(peak_rss() - baseRss)/1024/1024<<"MB peak rss above startup";
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-cache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#include <glib.h>
+
+#define THUMBNAIL_SOFTWARE "peony-qt"
+
+using namespace Peony;
+
+static quint64 modified_time(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.exists())
+        return 0;
+    return info.lastModified().toMSecsSinceEpoch()/1000;
+}
+
+static const QString make_private_dir(const QString &path)
+{
+    QDir dir(path);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+        //the spec requires the thumbnail directories only be accessible by owner.
+        QFile::setPermissions(path, QFile::ReadOwner|QFile::WriteOwner|QFile::ExeOwner);
+    }
+    return path;
+}
+
+static const QString size_dir(ThumbnailCache::Size size)
+{
+    static const QString normal = make_private_dir(ThumbnailCache::cacheDir() + "/normal");
+    static const QString large = make_private_dir(ThumbnailCache::cacheDir() + "/large");
+    return size == ThumbnailCache::Large? large: normal;
+}
+
+static const QString fail_dir()
+{
+    static const QString fail = make_private_dir(ThumbnailCache::cacheDir() + "/fail/" THUMBNAIL_SOFTWARE);
+    return fail;
+}
+
+static const QString md5_name(const QString &uri)
+{
+    return QString(QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5).toHex()) + ".png";
+}
+
+static bool is_valid_thumbnail(QImageReader &reader, const QString &uri, quint64 mtime)
+{
+    if (reader.text("Thumb::MTime").toULongLong() != mtime)
+        return false;
+
+    //Thumb::URI is required by spec, but some thumbnailers do not write it.
+    auto thumbUri = reader.text("Thumb::URI");
+    if (!thumbUri.isEmpty() && thumbUri != uri)
+        return false;
+
+    return true;
+}
+
+static bool write_thumbnail(const QString &thumbnailPath, const QString &uri, quint64 mtime, const QImage &image)
+{
+    QSaveFile file(thumbnailPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QImageWriter writer(&file, "png");
+    writer.setText("Thumb::URI", uri);
+    writer.setText("Thumb::MTime", QString::number(mtime));
+    writer.setText("Software", THUMBNAIL_SOFTWARE);
+    if (!writer.write(image)) {
+        file.cancelWriting();
+        return false;
+    }
+
+    file.setPermissions(QFile::ReadOwner|QFile::WriteOwner);
+    return file.commit();
+}
+
+QImage ThumbnailCache::lookup(const QString &path, Size size)
+{
+    if (path.isEmpty())
+        return QImage();
+
+    auto uri = canonicalUri(path);
+    QImageReader reader(size_dir(size) + "/" + md5_name(uri), "png");
+    if (!reader.canRead())
+        return QImage();
+
+    if (!is_valid_thumbnail(reader, uri, modified_time(path)))
+        return QImage();
+
+    return reader.read();
+}
+
+QImage ThumbnailCache::insert(const QString &path, const QImage &image, Size size)
+{
+    if (image.isNull())
+        return image;
+
+    auto thumbnail = scaled(image, size);
+    if (path.isEmpty())
+        return thumbnail;
+
+    auto uri = canonicalUri(path);
+    auto mtime = modified_time(path);
+    if (!write_thumbnail(thumbnailPath(path, size), uri, mtime, thumbnail))
+        qWarning()<<"failed to save thumbnail of"<<uri;
+
+    return thumbnail;
+}
+
+void ThumbnailCache::remove(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+
+    auto name = md5_name(canonicalUri(path));
+    QFile::remove(size_dir(Normal) + "/" + name);
+    QFile::remove(size_dir(Large) + "/" + name);
+    QFile::remove(fail_dir() + "/" + name);
+}
+
+bool ThumbnailCache::hasFailed(const QString &path)
+{
+    if (path.isEmpty())
+        return false;
+
+    auto uri = canonicalUri(path);
+    QImageReader reader(fail_dir() + "/" + md5_name(uri), "png");
+    if (!reader.canRead())
+        return false;
+
+    return is_valid_thumbnail(reader, uri, modified_time(path));
+}
+
+void ThumbnailCache::markFailed(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+
+    //the fail thumbnail is an empty image, only the keys make sense.
+    QImage image(1, 1, QImage::Format_ARGB32);
+    image.fill(Qt::transparent);
+
+    auto uri = canonicalUri(path);
+    write_thumbnail(fail_dir() + "/" + md5_name(uri), uri, modified_time(path), image);
+}
+
+QImage ThumbnailCache::scaled(const QImage &image, Size size)
+{
+    if (image.width() <= size && image.height() <= size)
+        return image;
+    return image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+QString ThumbnailCache::canonicalUri(const QString &path)
+{
+    //use the same escaping as other gio based applications, so that the md5
+    //of the uri matches their thumbnails.
+    char *uri = g_filename_to_uri(QFile::encodeName(path).constData(), nullptr, nullptr);
+    if (!uri)
+        return nullptr;
+    QString canonical = uri;
+    g_free(uri);
+    return canonical;
+}
+
+QString ThumbnailCache::thumbnailPath(const QString &path, Size size)
+{
+    return size_dir(size) + "/" + md5_name(canonicalUri(path));
+}
+
+QString ThumbnailCache::cacheDir()
+{
+    static const QString dir = make_private_dir(QString(g_get_user_cache_dir()) + "/thumbnails");
+    return dir;
+}
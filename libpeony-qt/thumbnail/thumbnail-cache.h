@@ -0,0 +1,94 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QImage>
+
+namespace Peony {
+
+/*!
+ * \brief The ThumbnailCache class
+ * <br>
+ * ThumbnailCache is the persistent thumbnail store shared with other desktop
+ * applications. It follows the freedesktop thumbnail managing standard:
+ * thumbnails are png files named by the md5 of the file's canonical uri in
+ * $XDG_CACHE_HOME/thumbnails/{normal,large}, and they carry the Thumb::URI
+ * and Thumb::MTime keys so that a thumbnail of a modified file is never used.
+ * </br>
+ * <br>
+ * The cached images are the plain thumbnails, the shadow of views is painted
+ * after they are loaded. Files which can not be thumbnailed are recorded in
+ * the fail directory, so they will not be decoded again until they changed.
+ * </br>
+ * \note all the methods are thread safe, they are called in thumbnail jobs.
+ * \see https://specifications.freedesktop.org/thumbnail-spec/latest/
+ */
+class PEONYCORESHARED_EXPORT ThumbnailCache
+{
+public:
+    enum Size {
+        Normal = 128,
+        Large = 256
+    };
+
+    /*!
+     * \brief lookup
+     * \param path, the local path of the thumbnailed file.
+     * \param size
+     * \return the cached thumbnail, or a null image if there is no valid one.
+     */
+    static QImage lookup(const QString &path, Size size = Normal);
+    /*!
+     * \brief insert
+     * \param path
+     * \param image, the full or scaled image of the file.
+     * \param size
+     * \return the image which has been scaled to the thumbnail size.
+     * <br>
+     * The thumbnail is written to a temporary file and renamed, other processes
+     * never see a partial png.
+     * </br>
+     */
+    static QImage insert(const QString &path, const QImage &image, Size size = Normal);
+    static void remove(const QString &path);
+
+    static bool hasFailed(const QString &path);
+    static void markFailed(const QString &path);
+
+    static QImage scaled(const QImage &image, Size size = Normal);
+
+    static QString canonicalUri(const QString &path);
+    static QString thumbnailPath(const QString &path, Size size = Normal);
+    static QString cacheDir();
+
+private:
+    explicit ThumbnailCache() {}
+};
+
+}
+
+#endif // THUMBNAILCACHE_H
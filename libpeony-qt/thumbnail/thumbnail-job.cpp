@@ -24,24 +24,24 @@
 
 #include "thumbnail-manager.h"
 
-#include "file-watcher.h"
+#include "thumbnail-notifier.h"
+#include "file-info.h"
 
 #include <QApplication>
+#include <QAtomicInt>
 #include <QDebug>
 
-static int runCount = 0;
-static int endCount = 0;
+static QAtomicInt runCount = 0;
+static QAtomicInt endCount = 0;
 
-Peony::ThumbnailJob::ThumbnailJob(const QString &uri, const std::shared_ptr<Peony::FileWatcher> watcher, QObject *parent):
+Peony::ThumbnailJob::ThumbnailJob(const std::shared_ptr<Peony::FileInfo> &info, const std::shared_ptr<Peony::ThumbnailNotifier> notifier, QObject *parent):
     QObject(parent), QRunnable()
 {
-    m_uri = uri;
-    m_watcher = watcher;
-    if (watcher) {
-        if (watcher->parent()) {
-            setParent(watcher->parent());
-        }
-    }
+    m_uri = info->uri();
+    m_info = info;
+    //the job is owned by its thread pool, the weak notifier tells if the view
+    //which requested it is still alive.
+    m_notifier = notifier;
 
     setAutoDelete(true);
 }
@@ -54,7 +54,11 @@ Peony::ThumbnailJob::~ThumbnailJob()
 
 void Peony::ThumbnailJob::run()
 {
-    if (!parent())
+    ThumbnailManager::getInstance()->removePendingJob(this);
+
+    //the notifier is not locked here, the last reference of it must not be
+    //dropped in a lane thread.
+    if (m_notifier.expired())
         return;
 
     // if all window closed, should not do a thumbnail job.
@@ -64,10 +68,7 @@ void Peony::ThumbnailJob::run()
 
     runCount++;
 
-    qDebug()<<"job start, current end:"<<endCount<<"current start request:"<<runCount;
+    //qDebug()<<"job start, current end:"<<endCount<<"current start request:"<<runCount;
 
-    setParent(nullptr);
-    auto strongPtr = m_watcher.lock();
-    if (strongPtr.get())
-        ThumbnailManager::getInstance()->createThumbnailInternal(m_uri, strongPtr);
+    ThumbnailManager::getInstance()->createThumbnailInternal(m_info, m_notifier);
 }
@@ -31,21 +31,35 @@
 
 namespace Peony {
 
-class FileWatcher;
+class ThumbnailNotifier;
+class FileInfo;
 
 class PEONYCORESHARED_EXPORT ThumbnailJob : public QObject, public QRunnable
 {
+    friend class ThumbnailManager;
     Q_OBJECT
 public:
-    explicit ThumbnailJob(const QString &uri, const std::shared_ptr<FileWatcher> watcher, QObject *parent = nullptr);
+    explicit ThumbnailJob(const std::shared_ptr<FileInfo> &info, const std::shared_ptr<ThumbnailNotifier> notifier, QObject *parent = nullptr);
     ~ThumbnailJob();
 
+    const QString uri() {
+        return m_uri;
+    }
+    std::weak_ptr<ThumbnailNotifier> notifier() {
+        return m_notifier;
+    }
+    std::shared_ptr<FileInfo> info() {
+        return m_info;
+    }
+
 public Q_SLOTS:
     void run() override;
 
 private:
     QString m_uri;
-    std::weak_ptr<FileWatcher> m_watcher;
+    std::shared_ptr<FileInfo> m_info;
+    std::weak_ptr<ThumbnailNotifier> m_notifier;
+    int m_lane = 0;
 };
 
 }
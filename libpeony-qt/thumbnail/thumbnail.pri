@@ -1,13 +1,21 @@
 INCLUDEPATH += $$PWD
 
+PKGCONFIG += libavformat libavcodec libavutil libswscale zlib
+
 HEADERS += $$PWD/pdf-thumbnail.h \
     $$PWD/generic-thumbnailer.h \
     $$PWD/thumbnail-job.h \
     $$PWD/video-thumbnail.h \
-    $$PWD/office-thumbnail.h
+    $$PWD/office-thumbnail.h \
+    $$PWD/thumbnail-cache.h \
+    $$PWD/video-frame-extractor.h \
+    $$PWD/zip-entry-reader.h
 
 SOURCES += $$PWD/pdf-thumbnail.cpp \
     $$PWD/generic-thumbnailer.cpp \
     $$PWD/thumbnail-job.cpp \
     $$PWD/video-thumbnail.cpp \
-    $$PWD/office-thumbnail.cpp
+    $$PWD/office-thumbnail.cpp \
+    $$PWD/thumbnail-cache.cpp \
+    $$PWD/video-frame-extractor.cpp \
+    $$PWD/zip-entry-reader.cpp
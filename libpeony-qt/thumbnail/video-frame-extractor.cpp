@@ -0,0 +1,253 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "video-frame-extractor.h"
+
+#include <QFile>
+#include <QTransform>
+#include <QDebug>
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+#include <libavutil/dict.h>
+}
+
+//the decoder gives up if there is still no frame after so many packets.
+#define MAX_READ_PACKETS 512
+
+static void init_libav()
+{
+    static bool initialized = [](){
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+        av_register_all();
+#endif
+        av_log_set_level(AV_LOG_QUIET);
+        return true;
+    }();
+    Q_UNUSED(initialized)
+}
+
+VideoFrameExtractor::VideoFrameExtractor(const QString &path, int timeout)
+{
+    init_libav();
+    m_path = path;
+    m_timeout_msecs = timeout;
+}
+
+VideoFrameExtractor::~VideoFrameExtractor()
+{
+    close();
+}
+
+int VideoFrameExtractor::interruptCallback(void *opaque)
+{
+    auto extractor = static_cast<VideoFrameExtractor *>(opaque);
+    if (extractor->m_timer.isValid() && extractor->m_timer.hasExpired(extractor->m_timeout_msecs)) {
+        extractor->m_timeout = true;
+        return 1;
+    }
+    return 0;
+}
+
+bool VideoFrameExtractor::open()
+{
+    //open only once, even if it failed.
+    if (m_opened)
+        return m_codec_context != nullptr;
+    m_opened = true;
+
+    m_timer.start();
+
+    m_format_context = avformat_alloc_context();
+    if (!m_format_context)
+        return false;
+    m_format_context->interrupt_callback.callback = &VideoFrameExtractor::interruptCallback;
+    m_format_context->interrupt_callback.opaque = this;
+
+    //the context is freed by avformat_open_input() if it failed.
+    if (avformat_open_input(&m_format_context, QFile::encodeName(m_path).constData(), nullptr, nullptr) < 0) {
+        m_format_context = nullptr;
+        return false;
+    }
+
+    if (avformat_find_stream_info(m_format_context, nullptr) < 0)
+        return false;
+
+    m_stream_index = av_find_best_stream(m_format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (m_stream_index < 0)
+        return false;
+
+    auto stream = m_format_context->streams[m_stream_index];
+    auto codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec)
+        return false;
+
+    m_codec_context = avcodec_alloc_context3(codec);
+    if (!m_codec_context)
+        return false;
+
+    if (avcodec_parameters_to_context(m_codec_context, stream->codecpar) < 0) {
+        avcodec_free_context(&m_codec_context);
+        return false;
+    }
+
+    //decoders run in parallel in the video lane, each of them uses one thread.
+    m_codec_context->thread_count = 1;
+    if (avcodec_open2(m_codec_context, codec, nullptr) < 0) {
+        avcodec_free_context(&m_codec_context);
+        return false;
+    }
+
+    return true;
+}
+
+void VideoFrameExtractor::close()
+{
+    if (m_codec_context)
+        avcodec_free_context(&m_codec_context);
+    if (m_format_context)
+        avformat_close_input(&m_format_context);
+    m_stream_index = -1;
+}
+
+qint64 VideoFrameExtractor::duration()
+{
+    if (!open())
+        return -1;
+
+    if (m_format_context->duration == AV_NOPTS_VALUE)
+        return -1;
+    return m_format_context->duration*1000/AV_TIME_BASE;
+}
+
+/*!
+ * \brief VideoFrameExtractor::seekPosition
+ * \return the position of the frame in milliseconds. the first frames of
+ * a video might be black, so we skip some seconds according to its length.
+ */
+qint64 VideoFrameExtractor::seekPosition()
+{
+    qint64 length = duration();
+    if (length < 0)
+        return 5000;
+
+    if (length >= 3600*1000)
+        return 15000;
+    if (length >= 60*1000)
+        return 7000;
+    if (length <= 1000)
+        return 100;
+    if (length <= 5000)
+        return 1000;
+    if (length <= 10000)
+        return 3000;
+    return 5000;
+}
+
+QImage VideoFrameExtractor::extractFrame(int maxSize)
+{
+    if (!open())
+        return QImage();
+
+    //seek to the keyframe before the position, if it failed, we decode from
+    //the beginning.
+    qint64 position = seekPosition()*AV_TIME_BASE/1000;
+    if (m_format_context->start_time != AV_NOPTS_VALUE)
+        position += m_format_context->start_time;
+    if (av_seek_frame(m_format_context, -1, position, AVSEEK_FLAG_BACKWARD) >= 0)
+        avcodec_flush_buffers(m_codec_context);
+
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    bool gotFrame = false;
+    bool flushing = false;
+
+    for (int i = 0; i < MAX_READ_PACKETS && !gotFrame && !m_timeout; i++) {
+        if (!flushing) {
+            if (av_read_frame(m_format_context, packet) < 0) {
+                //end of file, drain the frames buffered in decoder.
+                flushing = true;
+                avcodec_send_packet(m_codec_context, nullptr);
+            } else {
+                bool isVideo = packet->stream_index == m_stream_index;
+                if (isVideo)
+                    avcodec_send_packet(m_codec_context, packet);
+                av_packet_unref(packet);
+                if (!isVideo)
+                    continue;
+            }
+        }
+
+        int ret = avcodec_receive_frame(m_codec_context, frame);
+        if (ret == 0) {
+            gotFrame = true;
+        } else if (ret != AVERROR(EAGAIN) || flushing) {
+            break;
+        }
+        interruptCallback(this);
+    }
+
+    QImage image;
+    if (gotFrame && frame->width > 0 && frame->height > 0) {
+        //use the display aspect ratio rather than the coded one.
+        auto stream = m_format_context->streams[m_stream_index];
+        AVRational sar = av_guess_sample_aspect_ratio(m_format_context, stream, frame);
+        qreal displayWidth = frame->width;
+        if (sar.num > 0 && sar.den > 0)
+            displayWidth = displayWidth*sar.num/sar.den;
+
+        QSize size = QSize(qRound(displayWidth), frame->height).scaled(maxSize, maxSize, Qt::KeepAspectRatio);
+        size = size.expandedTo(QSize(1, 1));
+
+        SwsContext *sws = sws_getContext(frame->width, frame->height, AVPixelFormat(frame->format),
+                                         size.width(), size.height(), AV_PIX_FMT_RGB32,
+                                         SWS_AREA, nullptr, nullptr, nullptr);
+        if (sws) {
+            image = QImage(size, QImage::Format_RGB32);
+            uint8_t *data[4] = {image.bits(), nullptr, nullptr, nullptr};
+            int lineSize[4] = {image.bytesPerLine(), 0, 0, 0};
+            sws_scale(sws, frame->data, frame->linesize, 0, frame->height, data, lineSize);
+            sws_freeContext(sws);
+
+            //videos recorded by phones are usually rotated by metadata.
+            auto rotate = av_dict_get(stream->metadata, "rotate", nullptr, 0);
+            if (rotate) {
+                int angle = QString(rotate->value).toInt();
+                if (angle % 360 != 0) {
+                    QTransform transform;
+                    transform.rotate(angle);
+                    image = image.transformed(transform);
+                }
+            }
+        }
+    }
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+
+    if (m_timeout)
+        qWarning()<<"video thumbnail timeout:"<<m_path;
+
+    return image;
+}
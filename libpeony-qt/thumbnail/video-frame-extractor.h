@@ -0,0 +1,95 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef VIDEOFRAMEEXTRACTOR_H
+#define VIDEOFRAMEEXTRACTOR_H
+
+#include <QString>
+#include <QImage>
+#include <QElapsedTimer>
+
+/*!
+ * the longest time a video file can take, includes opening, probing, seeking
+ * and decoding.
+ */
+#ifndef PEONY_VIDEO_THUMBNAIL_TIMEOUT
+#define PEONY_VIDEO_THUMBNAIL_TIMEOUT 5000
+#endif
+
+struct AVFormatContext;
+struct AVCodecContext;
+
+/*!
+ * \brief The VideoFrameExtractor class
+ * <br>
+ * VideoFrameExtractor extracts a frame of a video with libavformat and
+ * libavcodec in current thread. It seeks to the keyframe before the position
+ * we want, decodes only that frame and scales it with libswscale, so there
+ * is no ffmpeg process for probing and converting.
+ * </br>
+ * <br>
+ * The extractors run in the video lane of ThumbnailManager, the threads of
+ * the lane are the decoder pool, so a decoder only uses one thread.
+ * </br>
+ */
+class VideoFrameExtractor
+{
+public:
+    explicit VideoFrameExtractor(const QString &path, int timeout = PEONY_VIDEO_THUMBNAIL_TIMEOUT);
+    ~VideoFrameExtractor();
+
+    /*!
+     * \brief duration
+     * \return the duration in milliseconds, or -1 if it is unknown.
+     */
+    qint64 duration();
+    /*!
+     * \brief extractFrame
+     * \param maxSize
+     * \return a frame near the beginning of the video which is scaled to fit
+     * maxSize, or a null image if failed.
+     */
+    QImage extractFrame(int maxSize = 128);
+
+    bool isTimeout() {
+        return m_timeout;
+    }
+
+private:
+    bool open();
+    void close();
+    qint64 seekPosition();
+
+    static int interruptCallback(void *opaque);
+
+    QString m_path;
+    int m_timeout_msecs = PEONY_VIDEO_THUMBNAIL_TIMEOUT;
+    QElapsedTimer m_timer;
+    bool m_timeout = false;
+    bool m_opened = false;
+
+    AVFormatContext *m_format_context = nullptr;
+    AVCodecContext *m_codec_context = nullptr;
+    int m_stream_index = -1;
+};
+
+#endif // VIDEOFRAMEEXTRACTOR_H
@@ -38,9 +38,7 @@ public:
     QIcon generateThumbnail();
 
 private:
-    QMap<QString, QString> videoInfo();
     QUrl m_url;
-    quint64 m_modifyTime = 0;
 };
 
 #endif // VIDEOTHUMBNAIL_H
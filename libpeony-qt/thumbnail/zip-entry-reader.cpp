@@ -0,0 +1,186 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "zip-entry-reader.h"
+
+#include <QtEndian>
+#include <QDebug>
+
+#include <zlib.h>
+
+#define END_OF_CENTRAL_DIRECTORY_SIGNATURE 0x06054b50
+#define CENTRAL_DIRECTORY_SIGNATURE 0x02014b50
+#define LOCAL_FILE_HEADER_SIGNATURE 0x04034b50
+
+#define END_OF_CENTRAL_DIRECTORY_SIZE 22
+#define CENTRAL_DIRECTORY_ENTRY_SIZE 46
+#define LOCAL_FILE_HEADER_SIZE 30
+//the comment of zip file is 64k at most.
+#define MAX_COMMENT_SIZE 0xFFFF
+
+#define METHOD_STORED 0
+#define METHOD_DEFLATED 8
+
+static quint16 u16(const QByteArray &data, int offset)
+{
+    return qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data.constData()) + offset);
+}
+
+static quint32 u32(const QByteArray &data, int offset)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data.constData()) + offset);
+}
+
+ZipEntryReader::ZipEntryReader(const QString &path) : m_file(path)
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+        return;
+    m_valid = readCentralDirectory();
+}
+
+ZipEntryReader::~ZipEntryReader()
+{
+    m_file.close();
+}
+
+bool ZipEntryReader::readCentralDirectory()
+{
+    qint64 fileSize = m_file.size();
+    if (fileSize < END_OF_CENTRAL_DIRECTORY_SIZE)
+        return false;
+
+    //the end record is at the tail, search it backward.
+    qint64 tailSize = qMin<qint64>(fileSize, END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE);
+    if (!m_file.seek(fileSize - tailSize))
+        return false;
+    QByteArray tail = m_file.read(tailSize);
+    if (tail.size() != tailSize)
+        return false;
+
+    int endOffset = -1;
+    for (int i = tail.size() - END_OF_CENTRAL_DIRECTORY_SIZE; i >= 0; i--) {
+        if (u32(tail, i) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            endOffset = i;
+            break;
+        }
+    }
+    if (endOffset < 0)
+        return false;
+
+    quint16 count = u16(tail, endOffset + 10);
+    quint32 directorySize = u32(tail, endOffset + 12);
+    quint32 directoryOffset = u32(tail, endOffset + 16);
+    //zip64 is not supported.
+    if (directoryOffset == 0xFFFFFFFF || qint64(directoryOffset) + directorySize > fileSize)
+        return false;
+
+    if (!m_file.seek(directoryOffset))
+        return false;
+    QByteArray directory = m_file.read(directorySize);
+    if (directory.size() != int(directorySize))
+        return false;
+
+    int pos = 0;
+    for (int i = 0; i < count; i++) {
+        if (pos + CENTRAL_DIRECTORY_ENTRY_SIZE > directory.size())
+            return false;
+        if (u32(directory, pos) != CENTRAL_DIRECTORY_SIGNATURE)
+            return false;
+
+        Entry entry;
+        quint16 flags = u16(directory, pos + 8);
+        entry.method = u16(directory, pos + 10);
+        entry.compressedSize = u32(directory, pos + 20);
+        entry.size = u32(directory, pos + 24);
+        quint16 nameLength = u16(directory, pos + 28);
+        quint16 extraLength = u16(directory, pos + 30);
+        quint16 commentLength = u16(directory, pos + 32);
+        entry.localHeaderOffset = u32(directory, pos + 42);
+
+        if (pos + CENTRAL_DIRECTORY_ENTRY_SIZE + nameLength > directory.size())
+            return false;
+        QString name = QString::fromUtf8(directory.constData() + pos + CENTRAL_DIRECTORY_ENTRY_SIZE, nameLength);
+
+        //skip encrypted entries.
+        if (!(flags & 0x1))
+            m_entries.insert(name, entry);
+
+        pos += CENTRAL_DIRECTORY_ENTRY_SIZE + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+QByteArray ZipEntryReader::read(const QString &name, qint64 maxSize)
+{
+    if (!m_valid || !m_entries.contains(name))
+        return QByteArray();
+
+    Entry entry = m_entries.value(name);
+    if (entry.size > maxSize || entry.compressedSize > maxSize)
+        return QByteArray();
+
+    if (!m_file.seek(entry.localHeaderOffset))
+        return QByteArray();
+    QByteArray header = m_file.read(LOCAL_FILE_HEADER_SIZE);
+    if (header.size() != LOCAL_FILE_HEADER_SIZE || u32(header, 0) != LOCAL_FILE_HEADER_SIGNATURE)
+        return QByteArray();
+
+    //the name and extra field of local header might differ from central directory.
+    quint16 nameLength = u16(header, 26);
+    quint16 extraLength = u16(header, 28);
+    if (!m_file.seek(entry.localHeaderOffset + LOCAL_FILE_HEADER_SIZE + nameLength + extraLength))
+        return QByteArray();
+
+    QByteArray compressed = m_file.read(entry.compressedSize);
+    if (compressed.size() != int(entry.compressedSize))
+        return QByteArray();
+
+    if (entry.method == METHOD_STORED)
+        return compressed;
+
+    if (entry.method != METHOD_DEFLATED)
+        return QByteArray();
+
+    QByteArray data(int(entry.size), Qt::Uninitialized);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    //negative window bits means raw deflate data without zlib header.
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return QByteArray();
+
+    stream.next_in = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_in = compressed.size();
+    stream.next_out = reinterpret_cast<Bytef *>(data.data());
+    stream.avail_out = data.size();
+
+    int ret = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+
+    if (ret != Z_STREAM_END || stream.total_out != entry.size) {
+        qWarning()<<"failed to inflate"<<name<<"in"<<m_file.fileName();
+        return QByteArray();
+    }
+
+    return data;
+}
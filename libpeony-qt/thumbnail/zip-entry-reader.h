@@ -0,0 +1,76 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef ZIPENTRYREADER_H
+#define ZIPENTRYREADER_H
+
+#include <QString>
+#include <QFile>
+#include <QHash>
+
+/*!
+ * \brief The ZipEntryReader class
+ * <br>
+ * ZipEntryReader reads single entries of a zip file, such as the preview
+ * images embedded in OOXML and ODF documents. Only the central directory and
+ * the asked entry are read from disk, the rest of the file is never touched.
+ * Stored and deflated entries are supported, zip64 and encrypted files are not.
+ * </br>
+ */
+class ZipEntryReader
+{
+public:
+    explicit ZipEntryReader(const QString &path);
+    ~ZipEntryReader();
+
+    bool isValid() {
+        return m_valid;
+    }
+
+    bool contains(const QString &name) {
+        return m_entries.contains(name);
+    }
+
+    /*!
+     * \brief read
+     * \param name, the full name of entry in zip, such as "docProps/thumbnail.jpeg".
+     * \param maxSize, entries larger than it will not be read.
+     * \return the uncompressed data, or an empty array if failed.
+     */
+    QByteArray read(const QString &name, qint64 maxSize = 16*1024*1024);
+
+private:
+    struct Entry {
+        quint16 method = 0;
+        quint32 compressedSize = 0;
+        quint32 size = 0;
+        quint32 localHeaderOffset = 0;
+    };
+
+    bool readCentralDirectory();
+
+    QFile m_file;
+    bool m_valid = false;
+    QHash<QString, Entry> m_entries;
+};
+
+#endif // ZIPENTRYREADER_H
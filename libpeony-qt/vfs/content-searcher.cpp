@@ -0,0 +1,324 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "content-searcher.h"
+
+#include <QtConcurrent>
+#include <QTextCodec>
+#include <QFile>
+#include <QUrl>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define READ_BLOCK_SIZE (1024 * 1024)
+
+using namespace Peony;
+
+static QByteArray ascii_lower(const char *data, int len)
+{
+    QByteArray lower(data, len);
+    for (int i = 0; i < lower.size(); i++) {
+        char c = lower.at(i);
+        if (c >= 'A' && c <= 'Z')
+            lower[i] = char(c - 'A' + 'a');
+    }
+    return lower;
+}
+
+static bool is_ascii(const QString &string)
+{
+    for (auto c : string) {
+        if (c.unicode() >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+ContentSearcher::ContentSearcher(const QRegExp &regexp)
+{
+    m_regexp = regexp;
+    m_pool.setMaxThreadCount(PEONY_CONTENT_SEARCH_THREADS);
+
+    QString pattern = m_regexp.pattern();
+    QString literal = requiredLiteral(pattern);
+    m_fold_case = m_regexp.caseSensitivity() == Qt::CaseInsensitive;
+    if (m_fold_case && !is_ascii(literal)) {
+        //only ascii letters are folded when prefiltering.
+        literal.clear();
+    }
+
+    if (!literal.isEmpty()) {
+        m_literal = QTextCodec::codecForLocale()->fromUnicode(m_fold_case? literal.toLower(): literal);
+        m_literal_only = literal == pattern;
+    }
+}
+
+ContentSearcher::~ContentSearcher()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void ContentSearcher::addFile(const QString &uri)
+{
+    QUrl url = uri;
+    if (!url.isLocalFile() || m_cancelled.load())
+        return;
+    QString path = url.toLocalFile();
+
+    m_mutex.lock();
+    m_pending_count++;
+    m_mutex.unlock();
+
+    QtConcurrent::run(&m_pool, [=]() {
+        //QRegExp is not reentrant, each file uses its own copy.
+        QRegExp regexp = m_regexp;
+        bool matched = !m_cancelled.load() && isFileMatched(path, regexp);
+
+        QMutexLocker locker(&m_mutex);
+        if (matched)
+            m_matched_uris.enqueue(uri);
+        m_pending_count--;
+        m_condition.wakeAll();
+    });
+}
+
+bool ContentSearcher::takeMatched(QString &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_matched_uris.isEmpty())
+        return false;
+    uri = m_matched_uris.dequeue();
+    return true;
+}
+
+bool ContentSearcher::waitMatched(QString &uri, GCancellable *cancellable)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_matched_uris.isEmpty() && m_pending_count > 0) {
+        if (cancellable && g_cancellable_is_cancelled(cancellable)) {
+            m_cancelled.store(1);
+            return false;
+        }
+        m_condition.wait(&m_mutex, 100);
+    }
+
+    if (m_matched_uris.isEmpty())
+        return false;
+    uri = m_matched_uris.dequeue();
+    return true;
+}
+
+void ContentSearcher::cancel()
+{
+    m_cancelled.store(1);
+}
+
+QString ContentSearcher::requiredLiteral(const QString &pattern)
+{
+    QString longest;
+    QString current;
+    auto finishCurrent = [&]() {
+        if (current.length() > longest.length())
+            longest = current;
+        current.clear();
+    };
+
+    //only the characters out of groups and character sets are taken,
+    //and any alternation out of groups makes nothing required.
+    int depth = 0;
+    for (int i = 0; i < pattern.length(); i++) {
+        QChar c = pattern.at(i);
+        if (c == '\\') {
+            finishCurrent();
+            i++;
+            continue;
+        }
+        if (c == '[') {
+            finishCurrent();
+            i++;
+            if (i < pattern.length() && pattern.at(i) == '^')
+                i++;
+            if (i < pattern.length() && pattern.at(i) == ']')
+                i++;
+            while (i < pattern.length() && pattern.at(i) != ']') {
+                if (pattern.at(i) == '\\')
+                    i++;
+                i++;
+            }
+            continue;
+        }
+        if (c == '(') {
+            finishCurrent();
+            depth++;
+            continue;
+        }
+        if (c == ')') {
+            finishCurrent();
+            depth--;
+            continue;
+        }
+        if (depth > 0)
+            continue;
+        if (c == '|')
+            return QString();
+        if (c == '{') {
+            //a counted quantifier of the previous item.
+            finishCurrent();
+            while (i < pattern.length() && pattern.at(i) != '}')
+                i++;
+            continue;
+        }
+        if (c == '.' || c == '^' || c == '$' || c == '?' || c == '*' || c == '+' || c == '}') {
+            finishCurrent();
+            continue;
+        }
+
+        QChar next = i + 1 < pattern.length()? pattern.at(i + 1): QChar();
+        if (next == '?' || next == '*' || next == '{') {
+            //the character is optional.
+            finishCurrent();
+            continue;
+        }
+        current.append(c);
+        if (next == '+')
+            finishCurrent();
+    }
+    finishCurrent();
+
+    return longest;
+}
+
+bool ContentSearcher::isFileMatched(const QString &path, QRegExp &regexp)
+{
+    //opening a fifo for reading blocks until a writer opens it, open without
+    //blocking and check the type before reading anything.
+    int fd = open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0 || st.st_size > PEONY_CONTENT_SEARCH_MAX_FILE_SIZE) {
+        close(fd);
+        return false;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0)
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    //read in large blocks, and search the complete lines of each block.
+    bool matched = false;
+    bool firstBlock = true;
+    QByteArray buffer;
+    while (!m_cancelled.load()) {
+        int offset = buffer.size();
+        buffer.resize(offset + READ_BLOCK_SIZE);
+        ssize_t n = read(fd, buffer.data() + offset, READ_BLOCK_SIZE);
+        if (n < 0 && errno == EINTR) {
+            buffer.resize(offset);
+            continue;
+        }
+        buffer.resize(offset + int(qMax(n, ssize_t(0))));
+        bool eof = n <= 0;
+
+        if (firstBlock) {
+            firstBlock = false;
+            //a text file has no '\0', skip binary files as grep does.
+            if (memchr(buffer.constData(), '\0', size_t(buffer.size())))
+                break;
+        }
+
+        int end = eof? buffer.size(): buffer.lastIndexOf('\n') + 1;
+        if (end > 0) {
+            if (isLinesMatched(buffer.constData(), end, regexp)) {
+                matched = true;
+                break;
+            }
+            buffer.remove(0, end);
+        }
+        if (eof)
+            break;
+    }
+
+    close(fd);
+    return matched;
+}
+
+bool ContentSearcher::isLinesMatched(const char *data, int len, QRegExp &regexp)
+{
+    auto codec = QTextCodec::codecForLocale();
+    auto isLineMatched = [&](const char *start, const char *end) {
+        if (end > start && *(end - 1) == '\r')
+            end--;
+        QString line = codec->toUnicode(start, int(end - start));
+        return line.contains(regexp);
+    };
+
+    const char *dataEnd = data + len;
+    if (m_literal.isEmpty()) {
+        const char *start = data;
+        while (start < dataEnd) {
+            const char *lineEnd = static_cast<const char *>(memchr(start, '\n', size_t(dataEnd - start)));
+            if (!lineEnd)
+                lineEnd = dataEnd;
+            if (isLineMatched(start, lineEnd))
+                return true;
+            start = lineEnd + 1;
+        }
+        return false;
+    }
+
+    //prefilter with the literal, glibc's memmem() is vectorized. regexp only
+    //runs on the lines containing the literal.
+    QByteArray folded;
+    const char *haystack = data;
+    if (m_fold_case) {
+        folded = ascii_lower(data, len);
+        haystack = folded.constData();
+    }
+
+    int pos = 0;
+    while (pos < len) {
+        auto hit = static_cast<const char *>(memmem(haystack + pos, size_t(len - pos), m_literal.constData(), size_t(m_literal.size())));
+        if (!hit)
+            return false;
+        if (m_literal_only)
+            return true;
+
+        int hitPos = int(hit - haystack);
+        auto lineStart = static_cast<const char *>(memrchr(data, '\n', size_t(hitPos)));
+        lineStart = lineStart? lineStart + 1: data;
+        auto lineEnd = static_cast<const char *>(memchr(data + hitPos, '\n', size_t(len - hitPos)));
+        if (!lineEnd)
+            lineEnd = dataEnd;
+        if (isLineMatched(lineStart, lineEnd))
+            return true;
+        pos = int(lineEnd - data) + 1;
+    }
+    return false;
+}
@@ -0,0 +1,129 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef CONTENTSEARCHER_H
+#define CONTENTSEARCHER_H
+
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QRegExp>
+#include <QAtomicInt>
+#include <gio/gio.h>
+
+#include "peony-core_global.h"
+
+/*!
+ * \brief PEONY_CONTENT_SEARCH_THREADS
+ * <br>
+ * The count of files searched at the same time by one content search.
+ * </br>
+ */
+#ifndef PEONY_CONTENT_SEARCH_THREADS
+#define PEONY_CONTENT_SEARCH_THREADS 4
+#endif
+
+/*!
+ * \brief PEONY_CONTENT_SEARCH_MAX_FILE_SIZE
+ * <br>
+ * Files larger than this are not searched, they are hardly text files
+ * which are expected to be found by their content.
+ * </br>
+ */
+#ifndef PEONY_CONTENT_SEARCH_MAX_FILE_SIZE
+#define PEONY_CONTENT_SEARCH_MAX_FILE_SIZE (64 * 1024 * 1024)
+#endif
+
+namespace Peony {
+
+/*!
+ * \brief The ContentSearcher class
+ * <br>
+ * This class searches the content of local files with a pool of workers, it is used by
+ * the search vfs for content_regexp. Files are added while the search vfs is walking the
+ * directories, and the matched files could be taken as soon as they are found.
+ * </br>
+ * <br>
+ * Each file is read in 1 MiB blocks and searched without QTextStream. Only regular files
+ * are read, a fifo or device never blocks a worker. Binary files (a '\0' in
+ * the first block) and files larger than PEONY_CONTENT_SEARCH_MAX_FILE_SIZE are skipped.
+ * A literal part of the regexp which every match must contain is searched with memmem()
+ * first, and the regexp only runs on the lines containing it. A file matches if one of
+ * its lines contains the regexp, as the line by line searching did before.
+ * </br>
+ */
+class PEONYCORESHARED_EXPORT ContentSearcher
+{
+public:
+    explicit ContentSearcher(const QRegExp &regexp);
+    ~ContentSearcher();
+
+    void addFile(const QString &uri);
+
+    /*!
+     * \brief takeMatched
+     * \param uri
+     * \return true if there is a matched file, and uri is set to it.
+     */
+    bool takeMatched(QString &uri);
+
+    /*!
+     * \brief waitMatched
+     * \param uri
+     * \param cancellable
+     * \return true if a file matched, false if all added files were searched
+     * without more matched files or the search was cancelled.
+     */
+    bool waitMatched(QString &uri, GCancellable *cancellable = nullptr);
+
+    void cancel();
+
+    /*!
+     * \brief requiredLiteral
+     * \param pattern
+     * \return a string which every match of pattern contains, or an empty
+     * string if it can not be found out.
+     */
+    static QString requiredLiteral(const QString &pattern);
+
+private:
+    bool isFileMatched(const QString &path, QRegExp &regexp);
+    bool isLinesMatched(const char *data, int len, QRegExp &regexp);
+
+    QRegExp m_regexp;
+    QByteArray m_literal;
+    bool m_literal_only = false;
+    bool m_fold_case = false;
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QQueue<QString> m_matched_uris;
+    int m_pending_count = 0;
+    QAtomicInt m_cancelled;
+};
+
+}
+
+#endif // CONTENTSEARCHER_H
@@ -24,6 +24,7 @@
 #include "peony-search-vfs-file.h"
 #include "file-enumerator.h"
 #include "search-vfs-manager.h"
+#include "content-searcher.h"
 #include <QDebug>
 #include <QFile>
 #include <QUrl>
@@ -71,6 +72,18 @@ static void peony_search_vfs_file_enumerator_add_directory_to_queue(PeonySearchV
     g_object_unref(e);
 }
 
+static GFileInfo *peony_search_vfs_file_enumerator_new_result_info(PeonySearchVFSFileEnumerator *enumerator, const QString &uri)
+{
+    auto search_vfs_info = g_file_info_new();
+    QString realUriSuffix = "real-uri:" + uri;
+    g_file_info_set_name(search_vfs_info, realUriSuffix.toUtf8().constData());
+
+    if (enumerator->priv->save_result) {
+        *enumerator->priv->results<<uri;
+    }
+    return search_vfs_info;
+}
+
 /* -- init -- */
 
 static void peony_search_vfs_file_enumerator_init(PeonySearchVFSFileEnumerator *self)
@@ -81,12 +94,16 @@ static void peony_search_vfs_file_enumerator_init(PeonySearchVFSFileEnumerator *
     self->priv->search_vfs_directory_uri = new QString;
     self->priv->enumerate_queue = new QQueue<QString>;
     self->priv->name_regexp_extend_list = new QList<QRegExp*>;
+    self->priv->results = new QStringList;
     self->priv->recursive = false;
     self->priv->save_result = false;
     self->priv->search_hidden = true;
     self->priv->use_regexp = true;
     self->priv->case_sensitive = true;
     self->priv->match_name_or_content = true;
+    self->priv->indexed = false;
+    self->priv->cached = false;
+    self->priv->content_searcher = nullptr;
 }
 
 static void enumerator_dispose(GObject *object);
@@ -138,6 +155,8 @@ void enumerator_dispose(GObject *object)
         delete self->priv->name_regexp;
     if (self->priv->content_regexp)
         delete self->priv->content_regexp;
+    if (self->priv->content_searcher)
+        delete self->priv->content_searcher;
     delete self->priv->search_vfs_directory_uri;
     self->priv->enumerate_queue->clear();
     delete self->priv->enumerate_queue;
@@ -146,6 +165,7 @@ void enumerator_dispose(GObject *object)
         delete self->priv->name_regexp_extend_list->at(i);
     }
     delete self->priv->name_regexp_extend_list;
+    delete self->priv->results;
 }
 
 static GFileInfo *enumerate_next_file(GFileEnumerator *enumerator,
@@ -165,7 +185,7 @@ static GFileInfo *enumerate_next_file(GFileEnumerator *enumerator,
     auto search_enumerator = PEONY_SEARCH_VFS_FILE_ENUMERATOR(enumerator);
     auto enumerate_queue = search_enumerator->priv->enumerate_queue;
 
-    if (manager->hasHistory(*search_enumerator->priv->search_vfs_directory_uri)) {
+    if (search_enumerator->priv->indexed || search_enumerator->priv->cached) {
         while (!enumerate_queue->isEmpty()) {
             auto uri = enumerate_queue->dequeue();
             auto search_vfs_info = g_file_info_new();
@@ -176,7 +196,21 @@ static GFileInfo *enumerate_next_file(GFileEnumerator *enumerator,
         return nullptr;
     }
 
-    while (!enumerate_queue->isEmpty()) {
+    auto content_searcher = search_enumerator->priv->content_searcher;
+    QString matched_uri;
+    while (!enumerate_queue->isEmpty() || content_searcher) {
+        //files matched by content are returned as soon as they are found.
+        if (content_searcher && content_searcher->takeMatched(matched_uri)) {
+            return peony_search_vfs_file_enumerator_new_result_info(search_enumerator, matched_uri);
+        }
+        if (enumerate_queue->isEmpty()) {
+            //all files are walked, wait for the files being searched.
+            if (content_searcher->waitMatched(matched_uri, cancellable)) {
+                return peony_search_vfs_file_enumerator_new_result_info(search_enumerator, matched_uri);
+            }
+            break;
+        }
+
         //BFS enumeration
         auto uri = enumerate_queue->dequeue();
         GFile *tmp = g_file_new_for_uri(uri.toUtf8().constData());
@@ -203,20 +237,20 @@ static GFileInfo *enumerate_next_file(GFileEnumerator *enumerator,
                 }
             } else {
 return_info:
-                auto search_vfs_info = g_file_info_new();
-                QString realUriSuffix = "real-uri:" + uri;
-                g_file_info_set_name(search_vfs_info, realUriSuffix.toUtf8().constData());
-
-                if (search_enumerator->priv->save_result) {
-                    auto historyResults = manager->getHistroyResults(*search_enumerator->priv->search_vfs_directory_uri);
-                    //FIXME: add lock?
-                    historyResults<<realUriSuffix;
-                }
-                return search_vfs_info;
+                return peony_search_vfs_file_enumerator_new_result_info(search_enumerator, uri);
             }
+        } else if (content_searcher && !isDir) {
+            content_searcher->addFile(uri);
         }
     }
 
+    //only the results of a completed search are cached.
+    if (search_enumerator->priv->save_result && !g_cancellable_is_cancelled(cancellable)) {
+        manager->addHistory(*search_enumerator->priv->search_vfs_directory_uri, *search_enumerator->priv->results);
+        search_enumerator->priv->save_result = false;
+        search_enumerator->priv->results->clear();
+    }
+
     return nullptr;
 }
 
@@ -353,31 +387,6 @@ gboolean peony_search_vfs_file_enumerator_is_file_match(PeonySearchVFSFileEnumer
         }
     }
 
-    if (details->content_regexp) {
-        //read file stream
-        QUrl url = uri;
-        QFile file(url.path());
-        file.open(QIODevice::Text | QIODevice::ReadOnly);
-        QTextStream stream(&file);
-        bool content_matched = false;
-        QString line;
-        line = stream.readLine();
-        while (!line.isNull()) {
-            if (line.contains(*enumerator->priv->content_regexp)) {
-                content_matched = true;
-                break;
-            }
-            line = stream.readLine();
-        }
-        file.close();
-
-        if (content_matched) {
-            if (enumerator->priv->match_name_or_content) {
-                return true;
-            }
-        }
-    }
-
     //this may never happend.
     return false;
 }
@@ -26,8 +26,13 @@
 #include <gio/gio.h>
 #include <QQueue>
 #include <QRegExp>
+#include <QStringList>
 #include "file-info.h"
 
+namespace Peony {
+class ContentSearcher;
+}
+
 G_BEGIN_DECLS
 
 #define PEONY_TYPE_SEARCH_VFS_FILE_ENUMERATOR peony_search_vfs_file_enumerator_get_type()
@@ -53,6 +58,33 @@ typedef struct {
     QRegExp *content_regexp;
     QList<QRegExp*> *name_regexp_extend_list;
     gboolean match_name_or_content;
+    /*!
+     * \brief indexed
+     * \details
+     * the enumerate_queue is filled with the results of Peony::SearchIndex,
+     * there is no need to walk the file system.
+     */
+    gboolean indexed;
+    /*!
+     * \brief cached
+     * \details
+     * the enumerate_queue is filled with the cached results of Peony::SearchVFSManager.
+     */
+    gboolean cached;
+    /*!
+     * \brief results
+     * \details
+     * the uris returned by a walking search, they are added to Peony::SearchVFSManager
+     * when the search is completed and save_result is set.
+     */
+    QStringList *results;
+    /*!
+     * \brief content_searcher
+     * \details
+     * files not matched by name are searched by content_regexp in content_searcher's
+     * threads while walking the directories.
+     */
+    Peony::ContentSearcher *content_searcher;
     QQueue<QString> *enumerate_queue;
 } PeonySearchVFSFileEnumeratorPrivate;
 
@@ -24,6 +24,8 @@
 #include "peony-search-vfs-file-enumerator.h"
 #include "file-enumerator.h"
 #include "search-vfs-manager.h"
+#include "search-index.h"
+#include "content-searcher.h"
 #include <QString>
 #include <QDebug>
 
@@ -191,16 +193,18 @@ void peony_search_vfs_file_enumerator_parse_uri(PeonySearchVFSFileEnumerator *en
     *details->search_vfs_directory_uri = uri;
 
     auto manager = Peony::SearchVFSManager::getInstance();
-    if (manager->hasHistory(uri)) {
-        auto uris = manager->getHistroyResults(uri);
-        for (auto uri: uris) {
+    QStringList cachedUris;
+    if (manager->getCachedResults(uri, cachedUris)) {
+        for (auto uri: cachedUris) {
             details->enumerate_queue->enqueue(uri);
         }
+        details->cached = true;
         //do not parse uri, not neccersary
         return;
     }
 
     QStringList args = details->search_vfs_directory_uri->split("&", QString::SkipEmptyParts);
+    QStringList searchUris;
 
     //we should judge case sensitive, then we confirm the regexp when
     //we match file in file enumeration.
@@ -272,8 +276,6 @@ void peony_search_vfs_file_enumerator_parse_uri(PeonySearchVFSFileEnumerator *en
             if (arg.endsWith("1")) {
                 details->recursive = true;
             }
-            else
-                details->save_result = false;
             continue;
         }
 
@@ -281,19 +283,7 @@ void peony_search_vfs_file_enumerator_parse_uri(PeonySearchVFSFileEnumerator *en
             QString tmp = arg;
             tmp.remove("search:///");
             tmp.remove("search_uris=");
-            QStringList uris = tmp.split(",", QString::SkipEmptyParts);
-            for (auto uri: uris) {
-                //NOTE: we should enumerate the search uris and add
-                //the children into queue first. otherwise we could
-                //not judge wether we should search recursively.
-                Peony::FileEnumerator e;
-                e.setEnumerateDirectory(uri);
-                e.enumerateSync();
-                auto uris1 = e.getChildrenUris();
-                for (auto uri1 : uris1) {
-                    details->enumerate_queue->enqueue(uri1);
-                }
-            }
+            searchUris<<tmp.split(",", QString::SkipEmptyParts);
         }
     }
 
@@ -309,6 +299,7 @@ void peony_search_vfs_file_enumerator_parse_uri(PeonySearchVFSFileEnumerator *en
         //details->content_regexp = new QRegExp;
     } else {
         details->content_regexp->setCaseSensitivity(sensitivity);
+        details->content_searcher = new Peony::ContentSearcher(*details->content_regexp);
     }
 
     if (details->name_regexp_extend_list->count() >0)
@@ -318,6 +309,45 @@ void peony_search_vfs_file_enumerator_parse_uri(PeonySearchVFSFileEnumerator *en
             details->name_regexp_extend_list->at(i)->setCaseSensitivity(sensitivity);
         }
     }
+
+    //name searching in indexed directories is answered by the index, which
+    //is started by the first search.
+    auto index = Peony::SearchIndex::getInstance();
+    index->requestStart();
+    QList<QRegExp*> patterns = *details->name_regexp_extend_list;
+    if (details->name_regexp)
+        patterns.prepend(details->name_regexp);
+    bool indexed = !details->content_regexp && !patterns.isEmpty() && !searchUris.isEmpty();
+    for (auto uri: searchUris) {
+        if (!index->canQuery(uri)) {
+            indexed = false;
+            break;
+        }
+    }
+
+    if (indexed) {
+        for (auto uri: searchUris) {
+            auto results = index->query(uri, patterns, details->use_regexp, details->recursive);
+            for (auto result : results) {
+                details->enumerate_queue->enqueue(result);
+            }
+        }
+        details->indexed = true;
+        return;
+    }
+
+    for (auto uri: searchUris) {
+        //NOTE: we should enumerate the search uris and add
+        //the children into queue first. otherwise we could
+        //not judge wether we should search recursively.
+        Peony::FileEnumerator e;
+        e.setEnumerateDirectory(uri);
+        e.enumerateSync();
+        auto uris1 = e.getChildrenUris();
+        for (auto uri1 : uris1) {
+            details->enumerate_queue->enqueue(uri1);
+        }
+    }
 }
 
 GFileEnumerator *peony_search_vfs_file_enumerate_children_internal(GFile *file,
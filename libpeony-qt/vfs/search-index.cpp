@@ -0,0 +1,795 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "search-index.h"
+
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QQueue>
+#include <QSet>
+#include <QWaitCondition>
+#include <QByteArrayMatcher>
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QLockFile>
+#include <QDataStream>
+#include <QUrl>
+#include <QDebug>
+
+#include <gio/gio.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include <algorithm>
+#include <functional>
+
+#define INDEX_MAGIC 0x50534958
+#define INDEX_VERSION 1
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+using namespace Peony;
+
+static SearchIndex *global_instance = nullptr;
+
+typedef QList<QPair<QByteArray, bool>> DirectoryChildren;
+
+static void read_directory(const QString &path, DirectoryChildren &children)
+{
+    DIR *dir = opendir(QFile::encodeName(path).constData());
+    if (!dir)
+        return;
+
+    struct dirent *ent = nullptr;
+    while ((ent = readdir(dir))) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+            continue;
+        //the file type is known from readdir() on most file systems, stat only if not.
+        bool isDir = ent->d_type == DT_DIR;
+        if (ent->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isDir = fstatat(dirfd(dir), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+        }
+        children<<qMakePair(QByteArray(ent->d_name), isDir);
+    }
+    closedir(dir);
+}
+
+static QByteArray ascii_lower(const QByteArray &name)
+{
+    //only lower ascii letters, so that the offsets of utf-8 names are not changed.
+    QByteArray lower = name;
+    for (int i = 0; i < lower.size(); i++) {
+        char c = lower.at(i);
+        if (c >= 'A' && c <= 'Z')
+            lower[i] = char(c - 'A' + 'a');
+    }
+    return lower;
+}
+
+static bool is_ascii(const QString &string)
+{
+    for (auto c : string) {
+        if (c.unicode() >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+static QString local_path(const QString &uri)
+{
+    QUrl url = uri;
+    if (!url.isLocalFile())
+        return nullptr;
+    QString path = url.toLocalFile();
+    if (path.length() > 1 && path.endsWith("/"))
+        path.chop(1);
+    return path;
+}
+
+SearchIndex *SearchIndex::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new SearchIndex;
+    }
+    return global_instance;
+}
+
+SearchIndex::SearchIndex(QObject *parent) : QObject(parent)
+{
+    m_root_path = QDir::homePath();
+    m_cache_path = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/peony/search-index";
+    m_cache_dir = QFileInfo(m_cache_path).path();
+
+    m_save_timer = new QTimer(this);
+    m_save_timer->setSingleShot(true);
+    m_save_timer->setInterval(PEONY_SEARCH_INDEX_SAVE_DELAY);
+    connect(m_save_timer, &QTimer::timeout, this, [=]() {
+        QtConcurrent::run([=]() {
+            save();
+        });
+    });
+
+    if (qApp) {
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [=]() {
+            if (m_save_timer->isActive()) {
+                m_save_timer->stop();
+                save();
+            }
+        });
+    }
+}
+
+SearchIndex::~SearchIndex()
+{
+    if (m_inotify_fd >= 0)
+        close(m_inotify_fd);
+    delete m_data;
+    delete m_lock_file;
+}
+
+void SearchIndex::requestStart()
+{
+    //the watches and timers belong to the thread of index.
+    QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+void SearchIndex::start()
+{
+    if (m_lock_file)
+        return;
+
+    //only one process crawls and watches the home directory, the others use
+    //the crawling search. the lock is taken over once its owner quits.
+    QDir().mkpath(m_cache_dir);
+    auto lockFile = new QLockFile(m_cache_path + ".lock");
+    lockFile->setStaleLockTime(0);
+    if (!lockFile->tryLock(0)) {
+        delete lockFile;
+        return;
+    }
+    m_lock_file = lockFile;
+
+    QFile limitFile("/proc/sys/fs/inotify/max_user_watches");
+    if (limitFile.open(QIODevice::ReadOnly)) {
+        int limit = limitFile.readAll().trimmed().toInt();
+        if (limit > 0)
+            m_max_watches = qMin(m_max_watches, limit/2);
+    }
+
+    m_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify_fd >= 0) {
+        m_notifier = new QSocketNotifier(m_inotify_fd, QSocketNotifier::Read, this);
+        connect(m_notifier, &QSocketNotifier::activated, this, &SearchIndex::onInotifyEvent);
+    } else {
+        qWarning()<<"search index: inotify is not available, the index will not be updated";
+    }
+
+    //answer queries with the saved index while crawling.
+    m_crawling = true;
+    auto watcher = new QFutureWatcher<IndexData *>;
+    watcher->setFuture(QtConcurrent::run([=]() {
+        return load();
+    }));
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        auto data = watcher->result();
+        watcher->deleteLater();
+        if (data)
+            swapData(data);
+        m_crawling = false;
+        crawl();
+    });
+}
+
+bool SearchIndex::canQuery(const QString &directoryUri)
+{
+    QString path = local_path(directoryUri);
+    if (path.isEmpty())
+        return false;
+
+    QReadLocker locker(&m_lock);
+    if (!m_data)
+        return false;
+    //the changes in unwatched directories are not known.
+    qint32 dirIndex = m_data->directories.value(path, -1);
+    return dirIndex >= 0 && !m_data->incomplete.contains(dirIndex);
+}
+
+QStringList SearchIndex::query(const QString &directoryUri,
+                               const QList<QRegExp *> &patterns,
+                               bool useRegexp,
+                               bool recursive)
+{
+    QStringList uris;
+    QString path = local_path(directoryUri);
+
+    QReadLocker locker(&m_lock);
+    if (!m_data || path.isEmpty())
+        return uris;
+    qint32 dirIndex = m_data->directories.value(path, -1);
+    if (dirIndex < 0)
+        return uris;
+
+    const auto &entries = m_data->entries;
+    QVector<qint32> matches;
+    for (auto regexp : patterns) {
+        if (!regexp || regexp->pattern().isEmpty())
+            continue;
+
+        QString pattern = regexp->pattern();
+        //the equality match of the crawling search is always case sensitive.
+        bool foldCase = useRegexp && regexp->caseSensitivity() == Qt::CaseInsensitive;
+        bool literal = !useRegexp || QRegExp::escape(pattern) == pattern;
+        if (literal && (!foldCase || is_ascii(pattern))) {
+            //scan the name blob for the keyword, it is much faster than matching the names one by one.
+            QByteArray needle = foldCase? ascii_lower(pattern.toUtf8()): QFile::encodeName(pattern);
+            const QByteArray &names = foldCase? m_data->lower_names: m_data->names;
+            QByteArrayMatcher matcher(needle);
+            int pos = matcher.indexIn(names, 0);
+            while (pos >= 0) {
+                auto it = std::upper_bound(entries.constBegin(), entries.constEnd(), quint32(pos), [](quint32 offset, const Entry &entry) {
+                    return offset < entry.name_offset;
+                });
+                qint32 index = qint32(it - entries.constBegin()) - 1;
+                int nameEnd = (it == entries.constEnd())? names.size(): int(it->name_offset);
+                //the name length includes the '\0' separator.
+                if (useRegexp || (int(entries.at(index).name_offset) == pos && nameEnd - pos - 1 == needle.size()))
+                    matches<<index;
+                pos = matcher.indexIn(names, nameEnd);
+            }
+        } else {
+            for (qint32 i = 0; i < entries.count(); i++) {
+                QString name = QFile::decodeName(entryName(m_data, i));
+                if ((useRegexp && name.contains(*regexp)) || name == pattern)
+                    matches<<i;
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+
+    for (auto index : matches) {
+        //a file is in the result if it and all its ancestors until the
+        //searched directory are not deleted.
+        bool found = false;
+        qint32 current = index;
+        while (current >= 0 && !(entries.at(current).flags & Deleted)) {
+            qint32 parent = entries.at(current).parent;
+            if (parent == dirIndex) {
+                found = true;
+                break;
+            }
+            if (!recursive)
+                break;
+            current = parent;
+        }
+        if (!found)
+            continue;
+
+        char *uri = g_filename_to_uri(entryPath(m_data, index).constData(), nullptr, nullptr);
+        if (uri)
+            uris<<uri;
+        g_free(uri);
+    }
+
+    return uris;
+}
+
+int SearchIndex::entryCount()
+{
+    QReadLocker locker(&m_lock);
+    return m_data? m_data->entries.count(): 0;
+}
+
+SearchIndex::IndexData *SearchIndex::load()
+{
+    QFile file(m_cache_path);
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString root;
+    qint32 entryCount = 0;
+    qint32 namesSize = 0;
+    stream>>magic>>version>>root>>entryCount>>namesSize;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION || root != m_root_path || entryCount <= 0 || namesSize <= 0)
+        return nullptr;
+
+    auto data = new IndexData;
+    data->root = root;
+    data->entries.resize(entryCount);
+    data->names.resize(namesSize);
+    int entriesSize = int(sizeof(Entry)) * entryCount;
+    if (stream.readRawData(reinterpret_cast<char *>(data->entries.data()), entriesSize) != entriesSize ||
+            stream.readRawData(data->names.data(), namesSize) != namesSize ||
+            data->names.at(namesSize - 1) != '\0') {
+        delete data;
+        return nullptr;
+    }
+    data->lower_names = ascii_lower(data->names);
+    for (qint32 i = 0; i < entryCount; i++) {
+        const Entry &entry = data->entries.at(i);
+        if (entry.flags & Deleted)
+            data->deleted_count++;
+        if (entry.parent >= 0)
+            data->children[entry.parent]<<i;
+    }
+
+    //parents are always indexed before their children.
+    QHash<qint32, QString> paths;
+    for (qint32 i = 0; i < entryCount; i++) {
+        const Entry &entry = data->entries.at(i);
+        if (entry.parent >= i || entry.name_offset >= quint32(namesSize) || (i == 0) != (entry.parent < 0)) {
+            delete data;
+            return nullptr;
+        }
+        if (!(entry.flags & Directory) || (entry.flags & Deleted))
+            continue;
+        QString path;
+        if (i == 0) {
+            path = QFile::decodeName(entryName(data, i));
+        } else if (paths.contains(entry.parent)) {
+            path = paths.value(entry.parent) + "/" + QFile::decodeName(entryName(data, i));
+        } else {
+            continue;
+        }
+        paths.insert(i, path);
+        data->directories.insert(path, i);
+    }
+
+    return data;
+}
+
+void SearchIndex::save()
+{
+    //the containers are implicitly shared, copying them is cheap, and the
+    //index is not locked while writing.
+    QString root;
+    QVector<Entry> entries;
+    QByteArray names;
+    m_lock.lockForRead();
+    if (m_data) {
+        root = m_data->root;
+        entries = m_data->entries;
+        names = m_data->names;
+    }
+    m_lock.unlock();
+
+    if (entries.isEmpty())
+        return;
+
+    QDir().mkpath(QFileInfo(m_cache_path).path());
+    QSaveFile file(m_cache_path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream<<quint32(INDEX_MAGIC)<<quint32(INDEX_VERSION)<<root<<qint32(entries.count())<<qint32(names.size());
+    stream.writeRawData(reinterpret_cast<const char *>(entries.constData()), int(sizeof(Entry)) * entries.count());
+    stream.writeRawData(names.constData(), names.size());
+    file.commit();
+}
+
+void SearchIndex::crawl()
+{
+    if (m_crawling)
+        return;
+    m_crawling = true;
+
+    auto watcher = new QFutureWatcher<IndexData *>;
+    watcher->setFuture(QtConcurrent::run([=]() {
+        IndexData *data = new IndexData;
+        data->root = m_root_path;
+        qint32 rootIndex = appendEntry(data, -1, QFile::encodeName(m_root_path), true);
+        data->directories.insert(m_root_path, rootIndex);
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(PEONY_SEARCH_INDEX_CRAWL_THREADS);
+        QMutex mutex;
+        QWaitCondition condition;
+        int running = 1;
+        QVector<qint32> unwatched;
+
+        std::function<void(const QString &, qint32)> readOne = [&](const QString &path, qint32 index) {
+            //watch before reading, so that no change is lost between them.
+            bool watched = addWatch(path) >= 0;
+            DirectoryChildren children;
+            read_directory(path, children);
+
+            QMutexLocker locker(&mutex);
+            if (!watched && m_inotify_fd >= 0)
+                unwatched<<index;
+            for (auto child : children) {
+                qint32 childIndex = appendEntry(data, index, child.first, child.second);
+                if (child.second) {
+                    QString childPath = path + "/" + QFile::decodeName(child.first);
+                    data->directories.insert(childPath, childIndex);
+                    running++;
+                    QtConcurrent::run(&pool, [&, childPath, childIndex]() {
+                        readOne(childPath, childIndex);
+                    });
+                }
+            }
+            running--;
+            condition.wakeAll();
+        };
+
+        QtConcurrent::run(&pool, [&]() {
+            readOne(m_root_path, rootIndex);
+        });
+
+        mutex.lock();
+        while (running > 0) {
+            condition.wait(&mutex);
+        }
+        mutex.unlock();
+        pool.waitForDone();
+
+        for (auto index : unwatched) {
+            markIncomplete(data, index);
+        }
+        return data;
+    }));
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        auto data = watcher->result();
+        watcher->deleteLater();
+        swapData(data);
+        m_crawling = false;
+
+        //replay the changes happened while crawling.
+        auto events = m_pending_events;
+        m_pending_events.clear();
+        for (auto event : events) {
+            handleEvent(event);
+        }
+
+        //the unwatched directories are not answered by the index, they are
+        //not rescanned periodically.
+        QtConcurrent::run([=]() {
+            save();
+        });
+    });
+}
+
+void SearchIndex::swapData(IndexData *data)
+{
+    m_lock.lockForWrite();
+    auto old = m_data;
+    m_data = data;
+    m_lock.unlock();
+
+    delete old;
+    Q_EMIT indexUpdated();
+}
+
+int SearchIndex::addWatch(const QString &path)
+{
+    if (m_inotify_fd < 0)
+        return -1;
+
+    QMutexLocker locker(&m_watch_mutex);
+    int wd = m_watch_descriptors.value(path, -1);
+    if (wd >= 0)
+        return wd;
+
+    //leave the rest of watches to the file monitors of views.
+    if (m_watch_limited)
+        return -1;
+    if (m_watch_descriptors.count() < m_max_watches)
+        wd = inotify_add_watch(m_inotify_fd, QFile::encodeName(path).constData(), WATCH_MASK);
+    if (wd < 0) {
+        qWarning()<<"search index: watch limit reached, the directories not watched are searched by crawling";
+        m_watch_limited = true;
+        return wd;
+    }
+    m_watch_paths.insert(wd, path);
+    m_watch_descriptors.insert(path, wd);
+    return wd;
+}
+
+void SearchIndex::removeWatches(const QString &path)
+{
+    QString prefix = path + "/";
+    QMutexLocker locker(&m_watch_mutex);
+    for (auto it = m_watch_paths.begin(); it != m_watch_paths.end();) {
+        if (it.value() == path || it.value().startsWith(prefix)) {
+            inotify_rm_watch(m_inotify_fd, it.key());
+            m_watch_descriptors.remove(it.value());
+            it = m_watch_paths.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void SearchIndex::onInotifyEvent()
+{
+    char buf[64 * 1024] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(m_inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+            auto event = reinterpret_cast<struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                //some changes are lost.
+                crawl();
+                continue;
+            }
+
+            m_watch_mutex.lock();
+            QString dirPath = m_watch_paths.value(event->wd);
+            if (event->mask & IN_IGNORED) {
+                m_watch_paths.remove(event->wd);
+                if (m_watch_descriptors.value(dirPath, -1) == event->wd)
+                    m_watch_descriptors.remove(dirPath);
+            }
+            m_watch_mutex.unlock();
+
+            if (dirPath.isEmpty() || event->len == 0)
+                continue;
+            //saving the index changes its own directory, which must not
+            //schedule another save.
+            if (dirPath == m_cache_dir || dirPath.startsWith(m_cache_dir + "/"))
+                continue;
+
+            PendingEvent pendingEvent;
+            pendingEvent.dir_path = dirPath;
+            pendingEvent.name = event->name;
+            pendingEvent.is_dir = event->mask & IN_ISDIR;
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                pendingEvent.created = true;
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                pendingEvent.created = false;
+            } else {
+                continue;
+            }
+
+            if (m_crawling) {
+                m_pending_events<<pendingEvent;
+            } else {
+                handleEvent(pendingEvent);
+            }
+        }
+    }
+}
+
+void SearchIndex::handleEvent(const PendingEvent &event)
+{
+    if (event.created) {
+        handleCreated(event.dir_path, event.name, event.is_dir);
+    } else {
+        handleDeleted(event.dir_path, event.name);
+    }
+}
+
+void SearchIndex::handleCreated(const QString &dirPath, const QByteArray &name, bool isDir)
+{
+    //a file moved to an existing name replaces the old one.
+    handleDeleted(dirPath, name);
+
+    m_lock.lockForWrite();
+    qint32 dirIndex = m_data? m_data->directories.value(dirPath, -1): -1;
+    if (dirIndex >= 0) {
+        qint32 index = appendEntry(m_data, dirIndex, name, isDir);
+        if (isDir)
+            m_data->directories.insert(dirPath + "/" + QFile::decodeName(name), index);
+    }
+    m_lock.unlock();
+
+    if (dirIndex < 0)
+        return;
+
+    if (isDir)
+        indexDirectory(dirPath + "/" + QFile::decodeName(name));
+    m_save_timer->start();
+}
+
+void SearchIndex::handleDeleted(const QString &dirPath, const QByteArray &name)
+{
+    QStringList deletedDirs;
+
+    m_lock.lockForWrite();
+    qint32 dirIndex = m_data? m_data->directories.value(dirPath, -1): -1;
+    if (dirIndex >= 0) {
+        for (auto child : childrenOf(m_data, dirIndex)) {
+            Entry &entry = m_data->entries[child];
+            if ((entry.flags & Deleted) || name != entryName(m_data, child))
+                continue;
+            //the children are hidden by their deleted ancestor.
+            m_data->deleted_count += hiddenCount(m_data, child);
+            entry.flags |= Deleted;
+            if (entry.flags & Directory)
+                deletedDirs<<dirPath + "/" + QFile::decodeName(name);
+        }
+        for (auto path : deletedDirs) {
+            QString prefix = path + "/";
+            for (auto it = m_data->directories.begin(); it != m_data->directories.end();) {
+                if (it.key() == path || it.key().startsWith(prefix)) {
+                    it = m_data->directories.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    m_lock.unlock();
+
+    for (auto path : deletedDirs) {
+        removeWatches(path);
+    }
+    if (dirIndex < 0)
+        return;
+
+    m_lock.lockForRead();
+    bool tooManyDeleted = m_data && m_data->deleted_count > m_data->entries.count()/PEONY_SEARCH_INDEX_TOMBSTONE_RATIO;
+    m_lock.unlock();
+    if (tooManyDeleted) {
+        //the new index has no deleted entries, it is saved after crawling.
+        crawl();
+    } else {
+        m_save_timer->start();
+    }
+}
+
+void SearchIndex::indexDirectory(const QString &path)
+{
+    typedef QList<QPair<QString, DirectoryChildren>> Directories;
+
+    auto watcher = new QFutureWatcher<Directories>;
+    watcher->setFuture(QtConcurrent::run([=]() {
+        Directories directories;
+        QQueue<QString> queue;
+        queue<<path;
+        while (!queue.isEmpty()) {
+            auto dir = queue.dequeue();
+            addWatch(dir);
+            DirectoryChildren children;
+            read_directory(dir, children);
+            for (auto child : children) {
+                if (child.second)
+                    queue<<dir + "/" + QFile::decodeName(child.first);
+            }
+            directories<<qMakePair(dir, children);
+        }
+        return directories;
+    }));
+
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        auto directories = watcher->result();
+        watcher->deleteLater();
+
+        QWriteLocker locker(&m_lock);
+        if (!m_data)
+            return;
+        for (auto directory : directories) {
+            qint32 dirIndex = m_data->directories.value(directory.first, -1);
+            if (dirIndex < 0)
+                continue;
+            //the files created while reading were added by their events.
+            QSet<QByteArray> existedNames;
+            for (auto child : childrenOf(m_data, dirIndex)) {
+                if (!(m_data->entries.at(child).flags & Deleted))
+                    existedNames<<entryName(m_data, child);
+            }
+            for (auto child : directory.second) {
+                if (existedNames.contains(child.first))
+                    continue;
+                qint32 index = appendEntry(m_data, dirIndex, child.first, child.second);
+                if (child.second)
+                    m_data->directories.insert(directory.first + "/" + QFile::decodeName(child.first), index);
+            }
+
+            m_watch_mutex.lock();
+            bool watched = m_watch_descriptors.contains(directory.first);
+            m_watch_mutex.unlock();
+            if (!watched && m_inotify_fd >= 0)
+                markIncomplete(m_data, dirIndex);
+        }
+    });
+}
+
+qint32 SearchIndex::hiddenCount(IndexData *data, qint32 index)
+{
+    //the entry and all its descendants which are not deleted yet.
+    qint32 count = 0;
+    QVector<qint32> stack;
+    stack<<index;
+    while (!stack.isEmpty()) {
+        qint32 current = stack.takeLast();
+        const Entry &entry = data->entries.at(current);
+        if (entry.flags & Deleted)
+            continue;
+        count++;
+        if (entry.flags & Directory)
+            stack<<childrenOf(data, current);
+    }
+    return count;
+}
+
+void SearchIndex::markIncomplete(IndexData *data, qint32 dirIndex)
+{
+    //the directory and all its ancestors, stop at the marked one.
+    qint32 current = dirIndex;
+    while (current >= 0 && !data->incomplete.contains(current)) {
+        data->incomplete.insert(current);
+        current = data->entries.at(current).parent;
+    }
+}
+
+qint32 SearchIndex::appendEntry(IndexData *data, qint32 parent, const QByteArray &name, bool isDir)
+{
+    Entry entry;
+    entry.parent = parent;
+    entry.name_offset = quint32(data->names.size());
+    entry.flags = isDir? Directory: 0;
+
+    data->names.append(name);
+    data->names.append('\0');
+    data->lower_names.append(ascii_lower(name));
+    data->lower_names.append('\0');
+    data->entries.append(entry);
+
+    qint32 index = data->entries.count() - 1;
+    if (parent >= 0)
+        data->children[parent]<<index;
+    return index;
+}
+
+const QVector<qint32> &SearchIndex::childrenOf(const IndexData *data, qint32 dirIndex)
+{
+    static const QVector<qint32> empty;
+    auto it = data->children.constFind(dirIndex);
+    if (it == data->children.constEnd())
+        return empty;
+    return it.value();
+}
+
+QByteArray SearchIndex::entryPath(const IndexData *data, qint32 index)
+{
+    QList<QByteArray> names;
+    while (index >= 0) {
+        names.prepend(entryName(data, index));
+        index = data->entries.at(index).parent;
+    }
+    return names.join('/');
+}
+
+const char *SearchIndex::entryName(const IndexData *data, qint32 index)
+{
+    return data->names.constData() + data->entries.at(index).name_offset;
+}
@@ -0,0 +1,250 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QRegExp>
+
+#include "peony-core_global.h"
+
+/*!
+ * \brief PEONY_SEARCH_INDEX_CRAWL_THREADS
+ * <br>
+ * The count of directories read at the same time when crawling the indexed root.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_INDEX_CRAWL_THREADS
+#define PEONY_SEARCH_INDEX_CRAWL_THREADS 4
+#endif
+
+/*!
+ * \brief PEONY_SEARCH_INDEX_SAVE_DELAY
+ * <br>
+ * The index is saved to disk this milliseconds after the last change.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_INDEX_SAVE_DELAY
+#define PEONY_SEARCH_INDEX_SAVE_DELAY 30000
+#endif
+
+/*!
+ * \brief PEONY_SEARCH_INDEX_MAX_WATCHES
+ * <br>
+ * The max count of inotify watches used by the index, it is also limited to half of
+ * fs.inotify.max_user_watches, so that GFileMonitor of views always has watches left.
+ * The directories which can not be watched are not answered by the index.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_INDEX_MAX_WATCHES
+#define PEONY_SEARCH_INDEX_MAX_WATCHES 16384
+#endif
+
+/*!
+ * \brief PEONY_SEARCH_INDEX_TOMBSTONE_RATIO
+ * <br>
+ * Deleted files are only marked in the index. When more than 1/ratio of the entries
+ * are deleted ones, the index is crawled again to drop them.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_INDEX_TOMBSTONE_RATIO
+#define PEONY_SEARCH_INDEX_TOMBSTONE_RATIO 4
+#endif
+
+class QSocketNotifier;
+class QTimer;
+class QLockFile;
+
+namespace Peony {
+
+/*!
+ * \brief The SearchIndex class
+ * <br>
+ * SearchIndex keeps the names of all files under the indexed root (the home directory),
+ * so that the search vfs can answer a name query without walking the file system.
+ * </br>
+ * <br>
+ * The index is compact: every file is an entry of its parent entry index, its name offset
+ * and flags, and all the names are stored in one '\0' separated utf-8 blob. A literal keyword
+ * is matched by one substring scan over the blob, and a regular expression is matched against
+ * the names in memory, there is no file system access in both cases.
+ * </br>
+ * <br>
+ * The index is built by a parallel crawl which reads each directory once with readdir(),
+ * and stays current by inotify deltas. It is saved to ~/.cache/peony/search-index,
+ * and loaded when it starts while a new crawl is running in background.
+ * </br>
+ * <br>
+ * The index is started by the first search, and only in one process of a user, which
+ * holds ~/.cache/peony/search-index.lock. The searches of other processes use the
+ * crawling search. The index uses at most PEONY_SEARCH_INDEX_MAX_WATCHES watches,
+ * a directory which has an unwatched descendant is not answered by the index.
+ * </br>
+ * \note The index only handles local directories under the indexed root. The search vfs
+ * falls back to the crawling search for other directories and for content searching.
+ */
+class PEONYCORESHARED_EXPORT SearchIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static SearchIndex *getInstance();
+
+    /*!
+     * \brief requestStart
+     * <br>
+     * start the index in its own thread if it is not started, it is thread
+     * safe and called by every search.
+     * </br>
+     */
+    void requestStart();
+
+    /*!
+     * \brief canQuery
+     * \param directoryUri
+     * \return true if the index is ready and directoryUri is indexed.
+     */
+    bool canQuery(const QString &directoryUri);
+
+    /*!
+     * \brief query
+     * \param directoryUri, the directory to search in.
+     * \param patterns, a file matches if its name contains one of the patterns.
+     * \param useRegexp, if false a file matches only if its name equals one of the patterns.
+     * \param recursive, search the children of sub directories.
+     * \return the uris of matched files.
+     * <br>
+     * This has the same matching rules with the crawling search of the search vfs.
+     * It is thread safe, the search vfs calls it in the enumerator's thread.
+     * </br>
+     */
+    QStringList query(const QString &directoryUri,
+                      const QList<QRegExp *> &patterns,
+                      bool useRegexp,
+                      bool recursive);
+
+    int entryCount();
+
+Q_SIGNALS:
+    void indexUpdated();
+
+public Q_SLOTS:
+    void start();
+
+protected:
+    struct Entry {
+        qint32 parent;
+        quint32 name_offset;
+        quint32 flags;
+    };
+
+    enum EntryFlag {
+        Directory = 1,
+        Deleted = 1 << 1
+    };
+
+    /*!
+     * \brief The IndexData struct
+     * <br>
+     * The whole content of an index, the crawl fills a new one and swaps it
+     * with the current one. lower_names is the ascii lower case copy of names
+     * with the same offsets, it is used by case insensitive literal queries.
+     * directories and children are lookup tables which are not saved, they
+     * are built by crawl() and load() and kept by appendEntry().
+     * deleted_count is the count of entries hidden by deletion, including the
+     * children of deleted directories. incomplete has the directories which
+     * are not watched or have unwatched descendants.
+     * </br>
+     */
+    struct IndexData {
+        QString root;
+        QVector<Entry> entries;
+        QByteArray names;
+        QByteArray lower_names;
+        QHash<QString, qint32> directories;
+        QHash<qint32, QVector<qint32>> children;
+        qint32 deleted_count = 0;
+        QSet<qint32> incomplete;
+    };
+
+    struct PendingEvent {
+        QString dir_path;
+        QByteArray name;
+        bool is_dir;
+        bool created;
+    };
+
+    IndexData *load();
+    void save();
+    void crawl();
+    void swapData(IndexData *data);
+
+    int addWatch(const QString &path);
+    void removeWatches(const QString &path);
+    void onInotifyEvent();
+    void handleEvent(const PendingEvent &event);
+    void handleCreated(const QString &dirPath, const QByteArray &name, bool isDir);
+    void handleDeleted(const QString &dirPath, const QByteArray &name);
+    void indexDirectory(const QString &path);
+
+    static qint32 hiddenCount(IndexData *data, qint32 index);
+    static void markIncomplete(IndexData *data, qint32 dirIndex);
+    static qint32 appendEntry(IndexData *data, qint32 parent, const QByteArray &name, bool isDir);
+    static const QVector<qint32> &childrenOf(const IndexData *data, qint32 dirIndex);
+    static QByteArray entryPath(const IndexData *data, qint32 index);
+    static const char *entryName(const IndexData *data, qint32 index);
+
+private:
+    explicit SearchIndex(QObject *parent = nullptr);
+    ~SearchIndex() override;
+
+    QString m_root_path;
+    QString m_cache_path;
+    QString m_cache_dir;
+
+    QReadWriteLock m_lock;
+    IndexData *m_data = nullptr;
+    bool m_crawling = false;
+    QList<PendingEvent> m_pending_events;
+
+    int m_inotify_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    QMutex m_watch_mutex;
+    QHash<int, QString> m_watch_paths;
+    QHash<QString, int> m_watch_descriptors;
+    int m_max_watches = PEONY_SEARCH_INDEX_MAX_WATCHES;
+    bool m_watch_limited = false;
+
+    QLockFile *m_lock_file = nullptr;
+
+    QTimer *m_save_timer = nullptr;
+};
+
+}
+
+#endif // SEARCHINDEX_H
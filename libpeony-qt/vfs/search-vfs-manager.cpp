@@ -22,10 +22,35 @@
 
 #include "search-vfs-manager.h"
 
+#include <QUrl>
+#include <QRegExp>
+#include <QDateTime>
+#include <QHash>
+#include <QMutexLocker>
+
 using namespace Peony;
 
 static SearchVFSManager* global_manager = nullptr;
 
+/*!
+ * \brief parseSearchArgs
+ * \param normalizedUri
+ * \return the arguments of a normalized search uri, keyed by the argument name.
+ */
+static QHash<QString, QString> parseSearchArgs(const QString &normalizedUri)
+{
+    QHash<QString, QString> args;
+    auto string = normalizedUri;
+    string.remove("search:///");
+    for (auto arg : string.split("&", QString::SkipEmptyParts)) {
+        int index = arg.indexOf("=");
+        if (index < 0)
+            continue;
+        args.insert(arg.left(index), arg.mid(index + 1));
+    }
+    return args;
+}
+
 SearchVFSManager *SearchVFSManager::getInstance()
 {
     if (!global_manager) {
@@ -36,41 +61,182 @@ SearchVFSManager *SearchVFSManager::getInstance()
 
 SearchVFSManager::SearchVFSManager(QObject *parent) : QObject(parent)
 {
-
+    m_results_cache.setMaxCost(PEONY_SEARCH_RESULT_CACHE_SIZE);
 }
 
 SearchVFSManager::~SearchVFSManager()
 {
-    m_search_dir_results_hash.clear();
+    m_results_cache.clear();
+}
+
+QString SearchVFSManager::normalizeSearchUri(const QString &searchUri)
+{
+    auto string = searchUri;
+    string.remove("search:///");
+
+    QStringList args;
+    for (auto arg : string.split("&", QString::SkipEmptyParts)) {
+        //empty arguments and the save flag do not change the results.
+        if (arg.endsWith("=") || arg.startsWith("save="))
+            continue;
+        if (arg.startsWith("search_uris=")) {
+            auto uris = arg.mid(QString("search_uris=").length()).split(",", QString::SkipEmptyParts);
+            for (auto &uri : uris) {
+                if (uri.endsWith("/") && !uri.endsWith(":///"))
+                    uri.chop(1);
+            }
+            uris.sort();
+            uris.removeDuplicates();
+            arg = "search_uris=" + uris.join(",");
+        }
+        args<<arg;
+    }
+    args.sort();
+    args.removeDuplicates();
+    return "search:///" + args.join("&");
 }
 
 void SearchVFSManager::clearHistory()
 {
-    m_mutex.lock();
-    m_search_dir_results_hash.clear();
-    m_mutex.unlock();
+    QMutexLocker locker(&m_mutex);
+    m_results_cache.clear();
 }
 
 void SearchVFSManager::clearHistoryOne(const QString &searchUri)
 {
-    m_mutex.lock();
-    m_search_dir_results_hash.remove(searchUri);
-    m_mutex.unlock();
+    //the searches which only differ in the name keyword might be refined
+    //to this one again, their results are out of date too.
+    auto key = normalizeSearchUri(searchUri);
+    auto args = parseSearchArgs(key);
+    args.remove("name_regexp");
+
+    QMutexLocker locker(&m_mutex);
+    m_results_cache.remove(key);
+    for (auto cachedKey : m_results_cache.keys()) {
+        auto cachedArgs = parseSearchArgs(cachedKey);
+        cachedArgs.remove("name_regexp");
+        if (cachedArgs == args)
+            m_results_cache.remove(cachedKey);
+    }
 }
 
 bool SearchVFSManager::hasHistory(const QString &searchUri)
 {
-    return m_search_dir_results_hash.contains(searchUri);
+    QMutexLocker locker(&m_mutex);
+    return cachedResult(normalizeSearchUri(searchUri));
 }
 
 void SearchVFSManager::addHistory(const QString &searchUri, const QStringList &results)
 {
-    m_mutex.lock();
-    m_search_dir_results_hash.insert(searchUri, results);
-    m_mutex.unlock();
+    QMutexLocker locker(&m_mutex);
+    insertResults(normalizeSearchUri(searchUri), results);
 }
 
 QStringList SearchVFSManager::getHistroyResults(const QString &searchUri)
 {
-    return m_search_dir_results_hash.value(searchUri);
+    QMutexLocker locker(&m_mutex);
+    auto result = cachedResult(normalizeSearchUri(searchUri));
+    return result? result->uris: QStringList();
+}
+
+bool SearchVFSManager::getCachedResults(const QString &searchUri, QStringList &results)
+{
+    auto key = normalizeSearchUri(searchUri);
+    QMutexLocker locker(&m_mutex);
+    if (auto result = cachedResult(key)) {
+        results = result->uris;
+        return true;
+    }
+    return refineResults(key, results);
+}
+
+SearchVFSManager::SearchResult *SearchVFSManager::cachedResult(const QString &key)
+{
+    auto result = m_results_cache.object(key);
+    if (!result)
+        return nullptr;
+    if (QDateTime::currentMSecsSinceEpoch() - result->time > PEONY_SEARCH_RESULT_CACHE_TIMEOUT) {
+        m_results_cache.remove(key);
+        return nullptr;
+    }
+    return result;
+}
+
+/*!
+ * \brief SearchVFSManager::refineResults
+ * \param key
+ * \param results
+ * \return true if a cached search is refined to key.
+ * <br>
+ * A search is refined from a cached one when they only differ in the name keyword,
+ * both keywords are literal and the new one contains the cached one. Every file
+ * matching the new keyword matches the cached one, so the cached results are
+ * filtered instead of walking the file system again. Searches with content or
+ * extend patterns are never refined.
+ * </br>
+ */
+bool SearchVFSManager::refineResults(const QString &key, QStringList &results)
+{
+    auto args = parseSearchArgs(key);
+    auto keyword = args.value("name_regexp");
+    if (keyword.isEmpty() || QRegExp::escape(keyword) != keyword)
+        return false;
+    if (args.contains("content_regexp") || args.contains("extend_regexp"))
+        return false;
+    if (args.value("use_regexp") == "0")
+        return false;
+
+    auto caseSensitivity = args.value("case_sensitive") == "1"? Qt::CaseInsensitive: Qt::CaseSensitive;
+    args.remove("name_regexp");
+
+    //prefer the longest cached keyword, it has the least results to filter.
+    QString baseKey;
+    QString baseKeyword;
+    for (auto cachedKey : m_results_cache.keys()) {
+        auto cachedArgs = parseSearchArgs(cachedKey);
+        auto cachedKeyword = cachedArgs.take("name_regexp");
+        if (cachedArgs != args)
+            continue;
+        if (cachedKeyword.isEmpty() || QRegExp::escape(cachedKeyword) != cachedKeyword)
+            continue;
+        if (!keyword.contains(cachedKeyword, caseSensitivity))
+            continue;
+        if (cachedKeyword.length() > baseKeyword.length()) {
+            baseKey = cachedKey;
+            baseKeyword = cachedKeyword;
+        }
+    }
+    if (baseKey.isNull())
+        return false;
+
+    auto base = cachedResult(baseKey);
+    if (!base)
+        return false;
+
+    QStringList refined;
+    for (auto uri : base->uris) {
+        if (QUrl(uri).fileName().contains(keyword, caseSensitivity))
+            refined<<uri;
+    }
+    auto time = base->time;
+    insertResults(key, refined);
+    //the refined results are as old as the results they come from.
+    if (auto result = m_results_cache.object(key))
+        result->time = time;
+
+    results = refined;
+    return true;
+}
+
+void SearchVFSManager::insertResults(const QString &key, const QStringList &results)
+{
+    //approximate bytes of the list, QCache drops least recently used results over max cost.
+    int cost = 0;
+    for (auto uri : results) {
+        cost += uri.size() * int(sizeof(QChar)) + 32;
+    }
+    auto result = new SearchResult;
+    result->uris = results;
+    result->time = QDateTime::currentMSecsSinceEpoch();
+    m_results_cache.insert(key, result, cost);
 }
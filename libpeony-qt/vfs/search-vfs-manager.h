@@ -24,17 +24,64 @@
 #define SEARCHVFSMANAGER_H
 
 #include <QObject>
-#include <QHash>
+#include <QCache>
 #include <QMutex>
 
+/*!
+ * \brief PEONY_SEARCH_RESULT_CACHE_SIZE
+ * <br>
+ * The max bytes of cached search results, the least recently used results
+ * are dropped when it is exceeded.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_RESULT_CACHE_SIZE
+#define PEONY_SEARCH_RESULT_CACHE_SIZE (16 * 1024 * 1024)
+#endif
+
+/*!
+ * \brief PEONY_SEARCH_RESULT_CACHE_TIMEOUT
+ * <br>
+ * Cached results older than this milliseconds are not used, the files
+ * might have been changed.
+ * </br>
+ */
+#ifndef PEONY_SEARCH_RESULT_CACHE_TIMEOUT
+#define PEONY_SEARCH_RESULT_CACHE_TIMEOUT 300000
+#endif
+
 namespace Peony {
 
+/*!
+ * \brief The SearchVFSManager class
+ * <br>
+ * SearchVFSManager caches the results of completed searches, so that running
+ * a search again replays the results without walking the file system. A search
+ * refined from a cached one, such as typing more characters of a keyword, is
+ * answered by filtering the cached results.
+ * </br>
+ * <br>
+ * Caching is opt-in, only the searches with save=1 in their uris are added,
+ * such as the searches typed in the location bar.
+ * </br>
+ * <br>
+ * The cache is keyed by normalized search uris, bounded by PEONY_SEARCH_RESULT_CACHE_SIZE
+ * bytes and thread safe, the search vfs enumerators use it in their threads.
+ * </br>
+ */
 class SearchVFSManager : public QObject
 {
     Q_OBJECT
 public:
     static SearchVFSManager *getInstance();
 
+    /*!
+     * \brief normalizeSearchUri
+     * \param searchUri
+     * \return the uri with sorted arguments and search uris, and without empty
+     * arguments, the searches which have the same normalized uri are the same.
+     */
+    static QString normalizeSearchUri(const QString &searchUri);
+
 public Q_SLOTS:
     void clearHistory();
     /*!
@@ -42,19 +89,39 @@ public Q_SLOTS:
      * \param searchUri
      * \details
      * if we refresh the directory, we should clean the history of the
-     * directory and search again.
+     * directory and search again. The searches with the same arguments
+     * except the name keyword are cleaned too, or the search could be
+     * refined from one of them.
      */
     void clearHistoryOne(const QString &searchUri);
     void addHistory(const QString &searchUri, const QStringList &results);
     bool hasHistory(const QString &serachUri);
-    QStringList getHistroyResults(const QString &searchUri) ;
+    QStringList getHistroyResults(const QString &searchUri);
+
+    /*!
+     * \brief getCachedResults
+     * \param searchUri
+     * \param results
+     * \return true if searchUri is cached or refined from a cached search,
+     * and results is set to the result uris.
+     */
+    bool getCachedResults(const QString &searchUri, QStringList &results);
 
 private:
     explicit SearchVFSManager(QObject *parent = nullptr);
     ~SearchVFSManager();
 
+    struct SearchResult {
+        QStringList uris;
+        qint64 time;
+    };
+
+    SearchResult *cachedResult(const QString &key);
+    bool refineResults(const QString &key, QStringList &results);
+    void insertResults(const QString &key, const QStringList &results);
+
     QMutex m_mutex;
-    QHash<QString, QStringList> m_search_dir_results_hash;
+    QCache<QString, SearchResult> m_results_cache;
 };
 
 }
@@ -24,6 +24,7 @@
 #include "peony-search-vfs-file.h"
 #include "peony-search-vfs-file-enumerator.h"
 #include "search-vfs-manager.h"
+#include "search-index.h"
 
 #include <gio/gio.h>
 #include <QDebug>
@@ -60,6 +61,9 @@ void SearchVFSRegister::registSearchVFS()
 
     //init manager
     Peony::SearchVFSManager::getInstance();
+    //create the file name index in ui thread, it is not started until the
+    //first search, see SearchIndex::requestStart().
+    Peony::SearchIndex::getInstance();
 
     GVfs *vfs;
     const gchar * const *schemes;
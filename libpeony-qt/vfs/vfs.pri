@@ -5,6 +5,8 @@ HEADERS += $$PWD/peony-search-vfs-file.h \
            $$PWD/peony-search-vfs-file-enumerator.h \
            $$PWD/search-vfs-register.h \
     $$PWD/search-vfs-manager.h \
+    $$PWD/search-index.h \
+    $$PWD/content-searcher.h \
     $$PWD/search-vfs-uri-parser.h \
     $$PWD/vfs-plugin-manager.h \
     $$PWD/recent-vfs-manager.h
@@ -13,6 +15,8 @@ SOURCES += $$PWD/peony-search-vfs-file.cpp \
            $$PWD/peony-search-vfs-file-enumerator.cpp \
            $$PWD/search-vfs-register.cpp \
     $$PWD/search-vfs-manager.cpp \
+    $$PWD/search-index.cpp \
+    $$PWD/content-searcher.cpp \
     $$PWD/search-vfs-uri-parser.cpp \
     $$PWD/vfs-plugin-manager.cpp \
     $$PWD/recent-vfs-manager.cpp
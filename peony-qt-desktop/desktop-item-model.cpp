@@ -22,7 +22,6 @@
 
 #include "desktop-item-model.h"
 
-#include "file-enumerator.h"
 #include "file-info.h"
 #include "file-info-job.h"
 #include "file-info-manager.h"
@@ -32,8 +31,13 @@
 #include "file-trash-operation.h"
 #include "file-copy-operation.h"
 #include "file-operation-utils.h"
+#include "file-utils.h"
+#include "async-file-utils.h"
+#include "directory-snapshot.h"
 
 #include "thumbnail-manager.h"
+#include "thumbnail-notifier.h"
+#include "global-settings.h"
 
 #include "file-meta-info.h"
 
@@ -47,6 +51,8 @@
 #include <QUrl>
 
 #include <QTimer>
+#include <QtConcurrent>
+#include <QFutureWatcher>
 
 #include <QMessageBox>
 
@@ -57,14 +63,12 @@ using namespace Peony;
 DesktopItemModel::DesktopItemModel(QObject *parent)
     : QAbstractListModel(parent)
 {
-    m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///, this");
+    m_thumbnail_notifier = std::make_shared<ThumbnailNotifier>();
 
-    connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-        for (auto info : m_files) {
-            if (info->uri() == uri) {
-                auto index = indexFromUri(uri);
-                Q_EMIT this->dataChanged(index, index);
-            }
+    connect(m_thumbnail_notifier.get(), &ThumbnailNotifier::thumbnailUpdated, this, [=](const QString &uri) {
+        auto index = indexFromUri(uri);
+        if (index.isValid()) {
+            Q_EMIT this->dataChanged(index, index);
         }
     });
 
@@ -98,200 +102,61 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
 
     m_desktop_watcher = std::make_shared<FileWatcher>("file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation), this);
     m_desktop_watcher->setMonitorChildrenChange(true);
-    this->connect(m_desktop_watcher.get(), &FileWatcher::fileCreated, [=](const QString &uri) {
-        qDebug()<<"desktop file created"<<uri;
-
-        auto info = FileInfo::fromUri(uri, true);
-        bool exsited = false;
-        for (auto file : m_files) {
-            if (file->uri() == info->uri()) {
-                exsited = true;
-                break;
-            }
-        }
-
-        if (m_new_file_info_query_queue.contains(uri)) {
-            exsited = true;
-        } else {
-            m_new_file_info_query_queue<<uri;
-        }
-
-        if (!exsited) {
-            auto job = new FileInfoJob(info);
-            job->setAutoDelete();
-            connect(job, &FileInfoJob::infoUpdated, [=]() {
-                // locate new item =====
-
-                auto view = PeonyDesktopApplication::getIconView();
-                auto itemRectHash = view->getCurrentItemRects();
-                auto grid = view->gridSize();
-                auto viewRect = view->rect();
-
-                QRegion notEmptyRegion;
-                for (auto rect : itemRectHash.values()) {
-                    notEmptyRegion += rect;
-                }
-
-                if (!view->isRenaming()) {
-                    view->setFileMetaInfoPos(uri, QPoint(-1, -1));
-                } else {
-                    view->setRenaming(false);
-                }
-
-                auto metaInfoPos = view->getFileMetaInfoPos(uri);
-                if (metaInfoPos.x() >= 0) {
-                    // check if overlapped, it might happend whild drag out and in desktop view.
-                    auto indexRect = QRect(metaInfoPos, itemRectHash.values().first().size());
-                    if (notEmptyRegion.contains(indexRect.center())) {
-
-                        // move index to closest empty grid.
-                        auto next = indexRect;
-                        bool isEmptyPos = false;
-                        while (!isEmptyPos) {
-                            next.translate(0, grid.height());
-                            if (next.bottom() > viewRect.bottom()) {
-                                int top = next.y();
-                                while (true) {
-                                    if (top < grid.height()) {
-                                        break;
-                                    }
-                                    top-=grid.height();
-                                }
-                                //put item to next column first row
-                                next.moveTo(next.x() + grid.width(), top);
-                            }
-                            if (notEmptyRegion.contains(next.center()))
-                                continue;
-
-                            isEmptyPos = true;
-                            itemRectHash.insert(info->uri(), next);
-                            notEmptyRegion += next;
-
-                            // handle position locate in DesktopIconView::itemInserted().
-                            view->setFileMetaInfoPos(info->uri(), next.topLeft());
-                        }
-                    }
-
-                    this->beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
-                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-                    m_files<<info;
-                    m_new_file_info_query_queue.removeOne(uri);
-                    //this->insertRows(m_files.indexOf(info), 1);
-                    this->endInsertRows();
-
-                    // end locate new item=======
-
-                    //this->endResetModel();
-                    Q_EMIT this->requestUpdateItemPositions();
-                    Q_EMIT this->requestLayoutNewItem(info->uri());
-                    Q_EMIT this->fileCreated(uri);
-                    return;
-                }
-
-                // aligin exsited rect
-                int marginTop = notEmptyRegion.boundingRect().top();
-                while (marginTop - grid.height() > 0) {
-                    marginTop -= grid.height();
-                }
-
-                int marginLeft = notEmptyRegion.boundingRect().left();
-                while (marginLeft - grid.width() > 0) {
-                    marginLeft -= grid.width();
-                }
-
-                auto indexRect = QRect(QPoint(marginLeft, marginTop), itemRectHash.isEmpty()? QSize(): itemRectHash.values().first().size());
-                if (notEmptyRegion.contains(indexRect.center())) {
-
-                    // move index to closest empty grid.
-                    auto next = indexRect;
-                    bool isEmptyPos = false;
-                    while (!isEmptyPos) {
-                        next.translate(0, grid.height());
-                        if (next.bottom() > viewRect.bottom()) {
-                            int top = next.y();
-                            while (true) {
-                                if (top < grid.height()) {
-                                    break;
-                                }
-                                top-=grid.height();
-                            }
-                            //put item to next column first row
-                            next.moveTo(next.x() + grid.width(), top);
-                        }
-                        if (notEmptyRegion.contains(next.center()))
-                            continue;
-
-                        isEmptyPos = true;
-                        itemRectHash.insert(info->uri(), next);
-                        notEmptyRegion += next;
-
-                        view->setFileMetaInfoPos(info->uri(), next.topLeft());
-                    }
-                } else {
-                    view->setFileMetaInfoPos(info->uri(), indexRect.topLeft());
-                }
-
-                //this->beginResetModel();
-                this->beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
-                ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
-                m_files<<info;
-                m_new_file_info_query_queue.removeOne(uri);
-                //this->insertRows(m_files.indexOf(info), 1);
-                this->endInsertRows();
-
-                // end locate new item=======
-
-                //this->endResetModel();
-                Q_EMIT this->requestUpdateItemPositions();
-                Q_EMIT this->requestLayoutNewItem(info->uri());
-                Q_EMIT this->fileCreated(uri);
-            });
-            job->queryAsync();
+    this->connect(m_desktop_watcher.get(), &FileWatcher::filesCreated, this, [=](const QStringList &uris) {
+        for (auto uri : uris) {
+            onFileCreated(uri);
         }
     });
 
-    this->connect(m_desktop_watcher.get(), &FileWatcher::fileDeleted, [=](const QString &uri) {
-        m_new_file_info_query_queue.removeOne(uri);
+    this->connect(m_desktop_watcher.get(), &FileWatcher::filesDeleted, this, [=](const QStringList &uris) {
         auto view = PeonyDesktopApplication::getIconView();
-        view->removeItemRect(uri);
-
-        auto itemRectHash = view->getCurrentItemRects();
-
-        for (auto info : m_files) {
-            if (info->uri() == uri) {
-                //this->beginResetModel();
-                this->beginRemoveRows(QModelIndex(), m_files.indexOf(info), m_files.indexOf(info));
-                m_files.removeOne(info);
+        bool removed = false;
+        for (auto uri : uris) {
+            m_new_file_info_query_queue.removeOne(uri);
+            view->removeItemRect(uri);
+
+            int row = rowFromUri(uri);
+            if (row >= 0) {
+                auto info = m_files.at(row);
+                this->beginRemoveRows(QModelIndex(), row, row);
+                removeFile(row);
                 this->endRemoveRows();
-                //this->endResetModel();
-                Q_EMIT this->requestClearIndexWidget();
-                Q_EMIT this->requestUpdateItemPositions();
                 FileInfoManager::getInstance()->remove(info);
+                removed = true;
             }
         }
-    });
 
-    this->connect(m_desktop_watcher.get(), &FileWatcher::fileChanged, [=](const QString &uri) {
-        auto view = PeonyDesktopApplication::getIconView();
-        auto itemRectHash = view->getCurrentItemRects();
+        //layout once for the whole batch.
+        if (removed) {
+            Q_EMIT this->requestClearIndexWidget();
+            Q_EMIT this->requestUpdateItemPositions();
+        }
+    });
 
-        for (auto info : m_files) {
-            if (info->uri() == uri) {
-                auto job = new FileInfoJob(info);
-                job->setAutoDelete();
-                connect(job, &FileInfoJob::infoUpdated, this, [=]() {
-                    ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
-                    this->dataChanged(indexFromUri(uri), indexFromUri(uri));
-                    Q_EMIT this->requestClearIndexWidget();
+    this->connect(m_desktop_watcher.get(), &FileWatcher::filesChanged, this, [=](const QStringList &uris) {
+        for (auto uri : uris) {
+            int row = rowFromUri(uri);
+            if (row < 0)
+                continue;
 
-                });
-                job->queryAsync();
-                this->dataChanged(indexFromUri(uri), indexFromUri(uri));
-                return;
-            }
+            auto info = m_files.at(row);
+            auto job = new FileInfoJob(info);
+            job->setAutoDelete();
+            connect(job, &FileInfoJob::infoUpdated, this, [=]() {
+                ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
+                auto index = indexFromUri(uri);
+                if (index.isValid())
+                    Q_EMIT this->dataChanged(index, index);
+                Q_EMIT this->requestClearIndexWidget();
+            });
+            job->queryAsync();
         }
     });
 
+    //too many events in a coalescing window are dropped by the watcher,
+    //take a snapshot of the desktop again instead.
+    this->connect(m_desktop_watcher.get(), &FileWatcher::requestUpdateDirectory, this, &DesktopItemModel::refresh);
+
     //when system app uninstalled, delete link in desktop if exist
     QString system_app_path = "file:///usr/share/applications/";
     m_system_app_watcher = std::make_shared<FileWatcher>(system_app_path, this);
@@ -308,8 +173,9 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
             for (auto info : m_files) {
                 if (info->uri().endsWith(fileName)) {
                     //this->beginResetModel();
-                    this->beginRemoveRows(QModelIndex(), m_files.indexOf(info), m_files.indexOf(info));
-                    m_files.removeOne(info);
+                    int row = m_files.indexOf(info);
+                    this->beginRemoveRows(QModelIndex(), row, row);
+                    removeFile(row);
                     this->endRemoveRows();
                     //this->endResetModel();
                     Q_EMIT this->requestClearIndexWidget();
@@ -339,8 +205,9 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
             for (auto info : m_files) {
                 if (info->uri().endsWith(fileName)) {
                     //this->beginResetModel();
-                    this->beginRemoveRows(QModelIndex(), m_files.indexOf(info), m_files.indexOf(info));
-                    m_files.removeOne(info);
+                    int row = m_files.indexOf(info);
+                    this->beginRemoveRows(QModelIndex(), row, row);
+                    removeFile(row);
                     this->endRemoveRows();
                     //this->endResetModel();
                     Q_EMIT this->requestClearIndexWidget();
@@ -355,6 +222,153 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
     });
 }
 
+void DesktopItemModel::onFileCreated(const QString &uri)
+{
+    qDebug()<<"desktop file created"<<uri;
+
+    auto info = FileInfo::fromUri(uri, true);
+    bool exsited = rowFromUri(info->uri()) >= 0;
+
+    if (m_new_file_info_query_queue.contains(uri)) {
+        exsited = true;
+    } else {
+        m_new_file_info_query_queue<<uri;
+    }
+
+    if (!exsited) {
+        auto job = new FileInfoJob(info);
+        job->setAutoDelete();
+        connect(job, &FileInfoJob::infoUpdated, [=]() {
+            // locate new item =====
+
+            auto view = PeonyDesktopApplication::getIconView();
+            auto itemRectHash = view->getCurrentItemRects();
+            auto grid = view->gridSize();
+            auto viewRect = view->rect();
+
+            QRegion notEmptyRegion;
+            for (auto rect : itemRectHash.values()) {
+                notEmptyRegion += rect;
+            }
+
+            if (!view->isRenaming()) {
+                view->setFileMetaInfoPos(uri, QPoint(-1, -1));
+            } else {
+                view->setRenaming(false);
+            }
+
+            auto metaInfoPos = view->getFileMetaInfoPos(uri);
+            if (metaInfoPos.x() >= 0) {
+                // check if overlapped, it might happend whild drag out and in desktop view.
+                auto indexRect = QRect(metaInfoPos, itemRectHash.values().first().size());
+                if (notEmptyRegion.contains(indexRect.center())) {
+
+                    // move index to closest empty grid.
+                    auto next = indexRect;
+                    bool isEmptyPos = false;
+                    while (!isEmptyPos) {
+                        next.translate(0, grid.height());
+                        if (next.bottom() > viewRect.bottom()) {
+                            int top = next.y();
+                            while (true) {
+                                if (top < grid.height()) {
+                                    break;
+                                }
+                                top-=grid.height();
+                            }
+                            //put item to next column first row
+                            next.moveTo(next.x() + grid.width(), top);
+                        }
+                        if (notEmptyRegion.contains(next.center()))
+                            continue;
+
+                        isEmptyPos = true;
+                        itemRectHash.insert(info->uri(), next);
+                        notEmptyRegion += next;
+
+                        // handle position locate in DesktopIconView::itemInserted().
+                        view->setFileMetaInfoPos(info->uri(), next.topLeft());
+                    }
+                }
+
+                this->beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
+                ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
+                appendFile(info);
+                m_new_file_info_query_queue.removeOne(uri);
+                //this->insertRows(m_files.indexOf(info), 1);
+                this->endInsertRows();
+
+                // end locate new item=======
+
+                //this->endResetModel();
+                Q_EMIT this->requestUpdateItemPositions();
+                Q_EMIT this->requestLayoutNewItem(info->uri());
+                Q_EMIT this->fileCreated(uri);
+                return;
+            }
+
+            // aligin exsited rect
+            int marginTop = notEmptyRegion.boundingRect().top();
+            while (marginTop - grid.height() > 0) {
+                marginTop -= grid.height();
+            }
+
+            int marginLeft = notEmptyRegion.boundingRect().left();
+            while (marginLeft - grid.width() > 0) {
+                marginLeft -= grid.width();
+            }
+
+            auto indexRect = QRect(QPoint(marginLeft, marginTop), itemRectHash.isEmpty()? QSize(): itemRectHash.values().first().size());
+            if (notEmptyRegion.contains(indexRect.center())) {
+
+                // move index to closest empty grid.
+                auto next = indexRect;
+                bool isEmptyPos = false;
+                while (!isEmptyPos) {
+                    next.translate(0, grid.height());
+                    if (next.bottom() > viewRect.bottom()) {
+                        int top = next.y();
+                        while (true) {
+                            if (top < grid.height()) {
+                                break;
+                            }
+                            top-=grid.height();
+                        }
+                        //put item to next column first row
+                        next.moveTo(next.x() + grid.width(), top);
+                    }
+                    if (notEmptyRegion.contains(next.center()))
+                        continue;
+
+                    isEmptyPos = true;
+                    itemRectHash.insert(info->uri(), next);
+                    notEmptyRegion += next;
+
+                    view->setFileMetaInfoPos(info->uri(), next.topLeft());
+                }
+            } else {
+                view->setFileMetaInfoPos(info->uri(), indexRect.topLeft());
+            }
+
+            //this->beginResetModel();
+            this->beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
+            ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
+            appendFile(info);
+            m_new_file_info_query_queue.removeOne(uri);
+            //this->insertRows(m_files.indexOf(info), 1);
+            this->endInsertRows();
+
+            // end locate new item=======
+
+            //this->endResetModel();
+            Q_EMIT this->requestUpdateItemPositions();
+            Q_EMIT this->requestLayoutNewItem(info->uri());
+            Q_EMIT this->fileCreated(uri);
+        });
+        job->queryAsync();
+    }
+}
+
 DesktopItemModel::~DesktopItemModel()
 {
     FileInfoManager::getInstance()->clear();
@@ -362,45 +376,53 @@ DesktopItemModel::~DesktopItemModel()
 
 void DesktopItemModel::refresh()
 {
+    //the kept files are not queried again, their thumbnails have to be
+    //regenerated explicitly if the preference changed.
+    auto settings = GlobalSettings::getInstance();
+    bool doNotThumbnail = settings->getValue(FORBID_THUMBNAIL_IN_VIEW).toBool();
     ThumbnailManager::getInstance()->syncThumbnailPreferences();
-    beginResetModel();
-    //removeRows(0, m_files.count());
-    FileInfoManager::getInstance()->clear();
-    //m_trash_watcher->stopMonitor();
-    //m_desktop_watcher->stopMonitor();
-    for (auto info : m_files) {
-        ThumbnailManager::getInstance()->releaseThumbnail(info->uri());
-    }
-    m_files.clear();
+    if (settings->getValue(FORBID_THUMBNAIL_IN_VIEW).toBool() != doNotThumbnail)
+        m_thumbnail_preference_changed = true;
 
     auto desktopUri = "file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation);
-    //FIXME: replace BLOCKING api in ui thread.
-    if (!FileUtils::isFileExsit(desktopUri)) {
+    //check the desktop directory in thread.
+    auto checkDesktop = [=]() {
+        return QtConcurrent::run([=]() {
+            return FileUtils::isFileExsit(desktopUri);
+        });
+    };
+    AsyncFileUtils::then(checkDesktop(), this, [=](bool exists) {
+        if (exists) {
+            takeSnapshot(desktopUri);
+            return;
+        }
         // try get correct desktop path delay.
-        //FIXME: replace BLOCKING api in ui thread.
         QTimer::singleShot(1000, this, [=](){
-            if (!FileUtils::isFileExsit(desktopUri)) {
-                endResetModel();
-                Q_EMIT refreshed();
-                refresh();
-            } else {
-                m_enumerator = new FileEnumerator(this);
-                m_enumerator->setAutoDelete();
-                m_enumerator->setEnumerateDirectory(desktopUri);
-                m_enumerator->connect(m_enumerator, &FileEnumerator::enumerateFinished, this, &DesktopItemModel::onEnumerateFinished);
-                m_enumerator->enumerateAsync();
-                endResetModel();
-            }
+            AsyncFileUtils::then(checkDesktop(), this, [=](bool exists) {
+                if (!exists) {
+                    Q_EMIT refreshed();
+                    refresh();
+                } else {
+                    takeSnapshot(desktopUri);
+                }
+            });
         });
-        return;
-    }
+    });
+}
 
-    m_enumerator = new FileEnumerator(this);
-    m_enumerator->setAutoDelete();
-    m_enumerator->setEnumerateDirectory(desktopUri);
-    m_enumerator->connect(m_enumerator, &FileEnumerator::enumerateFinished, this, &DesktopItemModel::onEnumerateFinished);
-    m_enumerator->enumerateAsync();
-    endResetModel();
+void DesktopItemModel::takeSnapshot(const QString &desktopUri)
+{
+    auto watcher = new QFutureWatcher<DirectorySnapshot>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [=]() {
+        watcher->deleteLater();
+        auto snapshot = watcher->result();
+        applySnapshot(snapshot);
+    });
+    watcher->setFuture(QtConcurrent::run([=]() {
+        DirectorySnapshot snapshot(desktopUri);
+        snapshot.take();
+        return snapshot;
+    }));
 }
 
 int DesktopItemModel::rowCount(const QModelIndex &parent) const
@@ -444,14 +466,16 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-void DesktopItemModel::onEnumerateFinished()
+/*!
+ * \brief DesktopItemModel::applySnapshot
+ * \param snapshot
+ * <br>
+ * Only the files added, removed or changed since last refresh are updated,
+ * the other files keep their rows, positions and thumbnails.
+ * </br>
+ */
+void DesktopItemModel::applySnapshot(DirectorySnapshot &snapshot)
 {
-    //beginResetModel();
-    FileInfoManager::getInstance()->clear();
-    beginRemoveRows(QModelIndex(), 0, m_files.count() - 1);
-    m_files.clear();
-    endRemoveRows();
-
     auto computer = FileInfo::fromUri("computer:///", true);
     auto personal = FileInfo::fromPath(QStandardPaths::writableLocation(QStandardPaths::HomeLocation), true);
     auto trash = FileInfo::fromUri("trash:///", true);
@@ -462,22 +486,84 @@ void DesktopItemModel::onEnumerateFinished()
     infos<<trash;
     infos<<personal;
 
-    infos<<m_enumerator->getChildren(true);
+    QStringList fixedUris;
+    for (auto info : infos) {
+        fixedUris<<info->uri();
+    }
+
+    //only diff a complete snapshot. if the snapshot failed, keep current
+    //files, an incomplete one would remove the files not enumerated.
+    if (snapshot.isValid()) {
+        auto view = PeonyDesktopApplication::getIconView();
+        bool removed = false;
+        for (int row = m_files.count() - 1; row >= 0; row--) {
+            auto info = m_files.at(row);
+            if (fixedUris.contains(info->uri()) || snapshot.find(info->uri()))
+                continue;
+
+            view->removeItemRect(info->uri());
+            beginRemoveRows(QModelIndex(), row, row);
+            removeFile(row);
+            endRemoveRows();
+            FileInfoManager::getInstance()->remove(info);
+            removed = true;
+        }
+        if (removed) {
+            Q_EMIT this->requestClearIndexWidget();
+            Q_EMIT this->requestUpdateItemPositions();
+        }
+
+        for (const auto &entry : snapshot.entries()) {
+            int row = rowFromUri(entry.uri);
+            if (row < 0) {
+                infos<<FileInfo::fromUri(entry.uri, true);
+                continue;
+            }
+
+            auto info = m_files.at(row);
+            if (!DirectorySnapshot::isChanged(entry, info))
+                continue;
+
+            auto uri = entry.uri;
+            auto job = new FileInfoJob(info);
+            job->setAutoDelete();
+            connect(job, &FileInfoJob::infoUpdated, this, [=]() {
+                ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
+                this->dataChanged(indexFromUri(uri), indexFromUri(uri));
+            });
+            job->queryAsync();
+        }
+    }
+
+    if (m_thumbnail_preference_changed) {
+        m_thumbnail_preference_changed = false;
+        for (auto info : m_files) {
+            auto uri = info->uri();
+            ThumbnailManager::getInstance()->releaseThumbnail(uri);
+            if (info->isDesktopFile()) {
+                ThumbnailManager::getInstance()->updateDesktopFileThumbnail(uri, m_thumbnail_notifier);
+            } else {
+                ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
+            }
+            this->dataChanged(indexFromUri(uri), indexFromUri(uri));
+        }
+    }
 
-    //qDebug()<<m_files.count();
-    //this->endResetModel();
     for (auto info : infos) {
+        if (rowFromUri(info->uri()) >= 0)
+            continue;
+
         beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
         auto syncJob = new FileInfoJob(info);
         syncJob->querySync();
         syncJob->deleteLater();
-        m_files<<info;
+        appendFile(info);
         endInsertRows();
 
         if (info->isDesktopFile()) {
-            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
+            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_notifier);
         } else {
-            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+            ThumbnailManager::getInstance()->createThumbnail(info, m_thumbnail_notifier);
         }
     }
     for (auto info : m_files) {
@@ -507,12 +593,44 @@ void DesktopItemModel::onEnumerateFinished()
 
 const QModelIndex DesktopItemModel::indexFromUri(const QString &uri)
 {
-    for (auto info : m_files) {
-        if (info->uri() == uri) {
-            return index(m_files.indexOf(info));
-        }
+    int row = rowFromUri(uri);
+    if (row < 0)
+        return QModelIndex();
+    return index(row);
+}
+
+void DesktopItemModel::appendFile(const std::shared_ptr<FileInfo> &info)
+{
+    auto normalizedUri = FileUtils::normalizedUri(info->uri());
+    m_uri_rows.insert(normalizedUri, m_files.count());
+    m_normalized_uris<<normalizedUri;
+    m_files<<info;
+}
+
+void DesktopItemModel::removeFile(int row)
+{
+    if (row < 0 || row >= m_files.count())
+        return;
+
+    m_uri_rows.remove(m_normalized_uris.at(row));
+    m_normalized_uris.removeAt(row);
+    m_files.removeAt(row);
+    //the following rows are shifted.
+    for (int i = row; i < m_files.count(); i++) {
+        m_uri_rows.insert(m_normalized_uris.at(i), i);
     }
-    return QModelIndex();
+}
+
+void DesktopItemModel::clearFiles()
+{
+    m_files.clear();
+    m_normalized_uris.clear();
+    m_uri_rows.clear();
+}
+
+int DesktopItemModel::rowFromUri(const QString &uri)
+{
+    return m_uri_rows.value(FileUtils::normalizedUri(uri), -1);
 }
 
 const QString DesktopItemModel::indexUri(const QModelIndex &index)
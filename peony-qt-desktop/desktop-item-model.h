@@ -25,13 +25,15 @@
 
 #include <QAbstractListModel>
 #include <QQueue>
+#include <QHash>
 #include <memory>
 
 namespace Peony {
 
-class FileEnumerator;
+class DirectorySnapshot;
 class FileInfo;
 class FileWatcher;
+class ThumbnailNotifier;
 
 class DesktopItemModel : public QAbstractListModel
 {
@@ -83,21 +85,48 @@ Q_SIGNALS:
 public Q_SLOTS:
     void refresh();
 
-protected Q_SLOTS:
-    void onEnumerateFinished();
-
 private:
-    FileEnumerator *m_enumerator;
+    void takeSnapshot(const QString &desktopUri);
+    void applySnapshot(DirectorySnapshot &snapshot);
+    /*!
+     * \brief onFileCreated
+     * \param uri
+     * <br>
+     * query the info of a new desktop file, and place it at the first empty
+     * grid once the info is ready.
+     * </br>
+     * \see FileWatcher::filesCreated().
+     */
+    void onFileCreated(const QString &uri);
+
+    /*!
+     * \brief appendFile
+     * \param info
+     * <br>
+     * m_files should only be changed by appendFile(), removeFile() and
+     * clearFiles(), they keep the uri index synchronized, so that finding a
+     * file by uri does not walk all files.
+     * </br>
+     */
+    void appendFile(const std::shared_ptr<FileInfo> &info);
+    void removeFile(int row);
+    void clearFiles();
+    int rowFromUri(const QString &uri);
+
     QList<std::shared_ptr<FileInfo>> m_files;
+    QStringList m_normalized_uris;
+    QHash<QString, int> m_uri_rows;
     std::shared_ptr<FileWatcher> m_trash_watcher;
     std::shared_ptr<FileWatcher> m_desktop_watcher;
-    std::shared_ptr<FileWatcher> m_thumbnail_watcher; //just handle the thumbnail created.
+    std::shared_ptr<ThumbnailNotifier> m_thumbnail_notifier; //just handle the thumbnail created.
 
     std::shared_ptr<FileWatcher> m_system_app_watcher;
     std::shared_ptr<FileWatcher> m_andriod_app_watcher;
 
     QQueue<QString> m_info_query_queue;
     QQueue<QString> m_new_file_info_query_queue;
+
+    bool m_thumbnail_preference_changed = false;
 };
 
 }
@@ -1,7 +1,10 @@
 TEMPLATE = subdirs
 SUBDIRS = src libpeony-qt \ # plugin #libpeony-qt/test \ #plugin-iface
     #libpeony-qt/model/model-test \
+    #libpeony-qt/model/info-store-benchmark \
+    #libpeony-qt/thumbnail/thumbnail-benchmark \
     #libpeony-qt/file-operation/file-operation-test \
+    #libpeony-qt/file-operation/file-copy-benchmark \
     #peony-qt-plugin-test \
     peony-qt-desktop
 
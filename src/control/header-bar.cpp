@@ -148,6 +148,8 @@ HeaderBar::HeaderBar(MainWindow *parent) : QToolBar(parent)
         else
         {
             auto targetUri = Peony::SearchVFSUriParser::parseSearchKey(path, key, true, false, "", m_search_recursive);
+            //typing more characters refines the cached results of the shorter keyword.
+            targetUri += "&save=1";
             Q_EMIT this->updateLocationRequest(targetUri, false);
         }
     });
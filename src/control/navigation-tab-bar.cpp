@@ -24,6 +24,7 @@
 #include "x11-window-manager.h"
 
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "search-vfs-uri-parser.h"
 
 #include <QToolButton>
@@ -107,28 +108,11 @@ void NavigationTabBar::addPages(const QStringList &uri)
 
 void NavigationTabBar::updateLocation(int index, const QString &uri)
 {
-    //FIXME: replace BLOCKING api in ui thread.
-    auto iconName = Peony::FileUtils::getFileIconName(uri);
-    auto displayName = Peony::FileUtils::getFileDisplayName(uri);
-    //qDebug() << "updateLocation text:" <<displayName <<uri;
-    if (uri.startsWith("search:///"))
-    {
-        QString nameRegexp = Peony::SearchVFSUriParser::getSearchUriNameRegexp(uri);
-        QString targetDirectory = Peony::SearchVFSUriParser::getSearchUriTargetDirectory(uri);
-        displayName = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
-    }
-
-    //elide text if it is too long
-    if (displayName.length() > ELIDE_TEXT_LENGTH)
-    {
-        int  charWidth = fontMetrics().averageCharWidth();
-        displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
-    }
-
-    setTabText(index, displayName);
-    setTabIcon(index, QIcon::fromTheme(iconName));
+    //show the base name until the display name is queried.
+    setTabText(index, tabTitle(uri, Peony::FileUtils::getUriBaseName(uri)));
     setTabData(index, uri);
     relayoutFloatButton(false);
+    queryTabInfo(uri);
 
     Q_EMIT this->locationUpdated(uri);
 }
@@ -136,11 +120,9 @@ void NavigationTabBar::updateLocation(int index, const QString &uri)
 void NavigationTabBar::addPage(const QString &uri, bool jumpToNewTab)
 {
     if (!uri.isNull()) {
-        //FIXME: replace BLOCKING api in ui thread.
-        auto iconName = Peony::FileUtils::getFileIconName(uri);
-        auto displayName = Peony::FileUtils::getFileDisplayName(uri);
-        addTab(QIcon::fromTheme(iconName), displayName);
+        addTab(tabTitle(uri, Peony::FileUtils::getUriBaseName(uri)));
         setTabData(count() - 1, uri);
+        queryTabInfo(uri);
         if (jumpToNewTab)
             setCurrentIndex(count() - 1);
         Q_EMIT this->pageAdded(uri);
@@ -154,6 +136,47 @@ void NavigationTabBar::addPage(const QString &uri, bool jumpToNewTab)
     }
 }
 
+void NavigationTabBar::queryTabInfo(const QString &uri)
+{
+    Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::getFileDisplayName(uri), this, [=](const QString &displayName) {
+        if (displayName.isEmpty())
+            return;
+        for (int i = 0; i < count(); i++) {
+            if (tabData(i).toString() == uri)
+                setTabText(i, tabTitle(uri, displayName));
+        }
+        relayoutFloatButton(false);
+    });
+
+    Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::getFileIconNames(uri), this, [=](const QStringList &iconNames) {
+        auto icon = QIcon::fromTheme(Peony::AsyncFileUtils::validIconName(iconNames));
+        for (int i = 0; i < count(); i++) {
+            if (tabData(i).toString() == uri)
+                setTabIcon(i, icon);
+        }
+    });
+}
+
+QString NavigationTabBar::tabTitle(const QString &uri, const QString &displayName)
+{
+    QString title = displayName;
+    //qDebug() << "updateLocation text:" <<displayName <<uri;
+    if (uri.startsWith("search:///"))
+    {
+        QString nameRegexp = Peony::SearchVFSUriParser::getSearchUriNameRegexp(uri);
+        QString targetDirectory = Peony::SearchVFSUriParser::getSearchUriTargetDirectory(uri);
+        title = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
+    }
+
+    //elide text if it is too long
+    if (title.length() > ELIDE_TEXT_LENGTH)
+    {
+        int  charWidth = fontMetrics().averageCharWidth();
+        title = fontMetrics().elidedText(title, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
+    }
+    return title;
+}
+
 void NavigationTabBar::tabRemoved(int index)
 {
     //qDebug()<<"tab removed"<<index;
@@ -212,17 +235,18 @@ void NavigationTabBar::dropEvent(QDropEvent *e)
     if (e->source() != this) {
         if (e->mimeData()->hasUrls()) {
             for (auto url : e->mimeData()->urls()) {
-                //FIXME: replace BLOCKING api in ui thread.
-                if (Peony::FileUtils::isFileDirectory(url.url())) {
-                    addPageRequest(url.url(), true);
-                }
+                QString uri = url.url();
+                Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::isFileDirectory(uri), this, [=](bool isDirectory) {
+                    if (isDirectory)
+                        addPageRequest(uri, true);
+                });
             }
         } else if (e->mimeData()->hasFormat("peony/tab-index")) {
-            auto uri = e->mimeData()->data("peony/tab-index");
-            //FIXME: replace BLOCKING api in ui thread.
-            if (Peony::FileUtils::isFileDirectory(uri)) {
-                addPageRequest(uri, true);
-            }
+            QString uri = e->mimeData()->data("peony/tab-index");
+            Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::isFileDirectory(uri), this, [=](bool isDirectory) {
+                if (isDirectory)
+                    addPageRequest(uri, true);
+            });
         }
 
         //finish the drag, remove old tab page from old tab.
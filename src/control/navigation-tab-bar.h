@@ -63,6 +63,17 @@ protected:
     void resizeEvent(QResizeEvent *e) override;
 
 private:
+    /*!
+     * \brief queryTabInfo
+     * \param uri
+     * <br>
+     * Query the display name and icon of uri asynchronously, and update the tabs
+     * of uri when they are ready.
+     * </br>
+     */
+    void queryTabInfo(const QString &uri);
+    QString tabTitle(const QString &uri, const QString &displayName);
+
     QToolButton *m_float_button;
 
     QTimer m_drag_timer;
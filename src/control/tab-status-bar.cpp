@@ -136,14 +136,12 @@ void TabStatusBar::update()
         g_free(format_size);
     }
     else {
-        //FIXME: replace BLOCKING api in ui thread.
-        auto displayName = Peony::FileUtils::getFileDisplayName(uri);
-        //qDebug() << "status bar text:" <<displayName <<uri;
+        //only search uris show a description, do not query the display name.
         if (uri.startsWith("search:///"))
         {
             QString nameRegexp = Peony::SearchVFSUriParser::getSearchUriNameRegexp(uri);
             QString targetDirectory = Peony::SearchVFSUriParser::getSearchUriTargetDirectory(uri);
-            displayName = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
+            QString displayName = tr("Search \"%1\" in \"%2\"").arg(nameRegexp).arg(targetDirectory);
             m_label->setText(displayName);
         }
         else {
@@ -47,6 +47,7 @@
 
 #include "directory-view-container.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "peony-main-window-style.h"
 
 #include "directory-view-factory-manager.h"
@@ -643,19 +644,25 @@ void TabWidget::updateSearchPathButton(const QString &uri)
         if (! getCurrentUri().isNull())
             curUri = getCurrentUri();
     }
-    //FIXME: replace BLOCKING api in ui thread.
-    auto iconName = Peony::FileUtils::getFileIconName(curUri);
-    auto displayName = Peony::FileUtils::getFileDisplayName(curUri);
-    qDebug() << "iconName:" <<iconName <<displayName<<curUri;
-    m_search_path->setIcon(QIcon::fromTheme(iconName));
-
-    //elide text if it is too long
-    if (displayName.length() > ELIDE_TEXT_LENGTH)
-    {
-        int  charWidth = fontMetrics().averageCharWidth();
-        displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
-    }
-    m_search_path->setText(displayName);
+    m_search_path_uri = curUri;
+    Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::getFileIconNames(curUri), this, [=](const QStringList &iconNames) {
+        if (m_search_path_uri == curUri)
+            m_search_path->setIcon(QIcon::fromTheme(Peony::AsyncFileUtils::validIconName(iconNames)));
+    });
+
+    Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::getFileDisplayName(curUri), this, [=](const QString &name) {
+        if (m_search_path_uri != curUri)
+            return;
+
+        //elide text if it is too long
+        QString displayName = name;
+        if (displayName.length() > ELIDE_TEXT_LENGTH)
+        {
+            int  charWidth = fontMetrics().averageCharWidth();
+            displayName = fontMetrics().elidedText(displayName, Qt::ElideRight, ELIDE_TEXT_LENGTH * charWidth);
+        }
+        m_search_path->setText(displayName);
+    });
 }
 
 void TabWidget::updateSearchList()
@@ -222,6 +222,7 @@ private:
     QPushButton *m_clear_button;
     QPushButton *m_recover_button;
     QPushButton *m_search_path;
+    QString m_search_path_uri;
     QPushButton *m_search_close;
     QPushButton *m_search_child;
     QPushButton *m_search_more;
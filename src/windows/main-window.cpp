@@ -56,6 +56,7 @@
 #include "file-operation-manager.h"
 #include "file-operation-utils.h"
 #include "file-utils.h"
+#include "async-file-utils.h"
 #include "create-template-operation.h"
 #include "file-operation-error-dialog.h"
 #include "clipboard-utils.h"
@@ -585,11 +586,15 @@ void MainWindow::setShortCuts()
 void MainWindow::updateTabPageTitle()
 {
     m_tab->updateTabPageTitle();
-    //FIXME: replace BLOCKING api in ui thread.
-    auto show = Peony::FileUtils::getFileDisplayName(getCurrentUri());
-    QString title = show + "-" + tr("File Manager");
-    //qDebug() << "updateTabPageTitle:" <<title;
-    setWindowTitle(title);
+    auto uri = getCurrentUri();
+    Peony::AsyncFileUtils::then(Peony::AsyncFileUtils::getFileDisplayName(uri), this, [=](const QString &show) {
+        //the location might be changed before the display name is queried.
+        if (getCurrentUri() != uri)
+            return;
+        QString title = show + "-" + tr("File Manager");
+        //qDebug() << "updateTabPageTitle:" <<title;
+        setWindowTitle(title);
+    });
 }
 
 void MainWindow::createFolderOperation()